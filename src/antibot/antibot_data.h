@@ -5,12 +5,35 @@
 
 enum
 {
-	ANTIBOT_ABI_VERSION = 11,
+	ANTIBOT_ABI_VERSION = 12,
 
 	ANTIBOT_MSGFLAG_NONVITAL = 1,
 	ANTIBOT_MSGFLAG_FLUSH = 2,
 
 	ANTIBOT_MAX_CLIENTS = 128,
+	ANTIBOT_MAX_TICK_EVENTS = 1024,
+	ANTIBOT_MAX_VERDICT_LENGTH = 128,
+};
+
+// Game events passed to `AntibotOnTick`, each corresponds to the per-event
+// callback of the same name.
+enum
+{
+	ANTIBOT_EVENT_PLAYER_INIT,
+	ANTIBOT_EVENT_PLAYER_DESTROY,
+	ANTIBOT_EVENT_SPAWN,
+	ANTIBOT_EVENT_HAMMER_FIRE_RELOADING,
+	ANTIBOT_EVENT_HAMMER_FIRE,
+	ANTIBOT_EVENT_HAMMER_HIT, // m_Arg: target id
+	ANTIBOT_EVENT_DIRECT_INPUT,
+	ANTIBOT_EVENT_CHARACTER_TICK,
+	ANTIBOT_EVENT_HOOK_ATTACH, // m_Arg: 1 if a player was hooked, 0 otherwise
+};
+
+enum
+{
+	ANTIBOT_VERDICT_REPORT,
+	ANTIBOT_VERDICT_KICK,
 };
 
 struct CAntibotMapData
@@ -69,6 +92,20 @@ struct CAntibotCharacterData
 	int m_WeaponChangeTick;
 };
 
+struct CAntibotEvent
+{
+	int m_Type;
+	int m_ClientId;
+	int m_Arg;
+};
+
+struct CAntibotVerdict
+{
+	int m_Type;
+	int m_ClientId;
+	char m_aMessage[ANTIBOT_MAX_VERDICT_LENGTH];
+};
+
 struct CAntibotVersion
 {
 	int m_AbiVersion;
@@ -80,6 +117,7 @@ struct CAntibotVersion
 	int m_SizeInputData;
 	int m_SizeMapData;
 	int m_SizeRoundData;
+	int m_SizeTickData;
 };
 
 #define ANTIBOT_VERSION \
@@ -92,6 +130,7 @@ struct CAntibotVersion
 		sizeof(CAntibotInputData), \
 		sizeof(CAntibotMapData), \
 		sizeof(CAntibotRoundData), \
+		sizeof(CAntibotTickData), \
 	}
 
 struct CAntibotData
@@ -114,5 +153,17 @@ struct CAntibotRoundData
 	CAntibotCharacterData m_aCharacters[ANTIBOT_MAX_CLIENTS];
 	CAntibotMapData m_Map;
 };
+// Game events of one tick in the order they happened. The round data is
+// updated once before the frame is passed to the module.
+struct CAntibotTickData
+{
+	int m_Tick;
+	int m_NumEvents;
+	CAntibotEvent m_aEvents[ANTIBOT_MAX_TICK_EVENTS];
+
+	// Filled by the module, applied by the server after `AntibotOnTick`.
+	int m_NumVerdicts;
+	CAntibotVerdict m_aVerdicts[ANTIBOT_MAX_CLIENTS];
+};
 
 #endif // ANTIBOT_ANTIBOT_DATA_H
@@ -26,6 +26,10 @@ ANTIBOTAPI void AntibotOnHammerHit(int ClientId, int TargetId);
 ANTIBOTAPI void AntibotOnDirectInput(int ClientId);
 ANTIBOTAPI void AntibotOnCharacterTick(int ClientId);
 ANTIBOTAPI void AntibotOnHookAttach(int ClientId, bool Player);
+// Returns true if the game events above should be collected and passed to
+// `AntibotOnTick` once per tick instead of calling the callbacks above.
+ANTIBOTAPI bool AntibotWantsTickEvents(void);
+ANTIBOTAPI void AntibotOnTick(CAntibotTickData *pTickData);
 ANTIBOTAPI void AntibotOnEngineTick(void);
 ANTIBOTAPI void AntibotOnEngineClientJoin(int ClientId);
 ANTIBOTAPI void AntibotOnEngineClientDrop(int ClientId, const char *pReason);
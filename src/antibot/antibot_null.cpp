@@ -41,6 +41,8 @@ void AntibotOnHammerHit(int /*ClientId*/, int /*TargetId*/) {}
 void AntibotOnDirectInput(int /*ClientId*/) {}
 void AntibotOnCharacterTick(int /*ClientId*/) {}
 void AntibotOnHookAttach(int /*ClientId*/, bool /*Player*/) {}
+bool AntibotWantsTickEvents(void) { return true; }
+void AntibotOnTick(CAntibotTickData * /*pTickData*/) {}
 void AntibotOnEngineTick(void) {}
 void AntibotOnEngineClientJoin(int /*ClientId*/) {}
 void AntibotOnEngineClientDrop(int /*ClientId*/, const char * /*pReason*/) {}
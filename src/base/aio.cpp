@@ -1,5 +1,7 @@
 #include "aio.h"
 
+#include "dbg.h"
+#include "detect.h"
 #include "io.h"
 #include "lock.h"
 #include "mem.h"
@@ -7,6 +9,19 @@
 #include "thread.h"
 
 #include <cstdlib>
+#include <vector>
+
+#if defined(CONF_PLATFORM_LINUX) && __has_include(<linux/io_uring.h>)
+#define CONF_AIO_IO_URING 1
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 #define ASYNC_BUFSIZE (8 * 1024)
 #define ASYNC_LOCAL_BUFSIZE (64 * 1024)
@@ -26,6 +41,21 @@ struct ASYNCIO
 	int error;
 	unsigned char finish;
 	unsigned char refcount;
+
+#if defined(CONF_AIO_IO_URING)
+	// the file is written through the shared io_uring instead of a thread
+	bool uring;
+	bool closed;
+	int fd;
+	// end of the data of the write in flight, equal to `read_pos` if there is none
+	unsigned int submit_pos;
+	bool in_flight;
+	// set while `aio_wait` or `aio_free` wait for the write in flight
+	bool waiting;
+	struct iovec iov[2];
+	// buffers replaced while the kernel was still reading from them
+	std::vector<unsigned char *> retired_buffers;
+#endif
 };
 
 enum
@@ -69,6 +99,12 @@ static void aio_handle_free_and_unlock(ASYNCIO *aio) RELEASE(aio->lock)
 	aio->lock.unlock();
 	if(do_free)
 	{
+#if defined(CONF_AIO_IO_URING)
+		for(unsigned char *retired_buffer : aio->retired_buffers)
+		{
+			free(retired_buffer);
+		}
+#endif
 		free(aio->buffer);
 		sphore_destroy(&aio->sphore);
 		delete aio;
@@ -135,29 +171,293 @@ static void aio_thread(void *user)
 	}
 }
 
-ASYNCIO *aio_new(IOHANDLE io)
+#if defined(CONF_AIO_IO_URING)
+/*
+	All files written with io_uring share one ring. The thread queueing data
+	submits a write directly if the file has no write in flight. Data queued
+	while a write is in flight is submitted as one batch by the completion
+	thread once the write has finished. With at most one write in flight per
+	file, the writes keep their order without a writer thread per file.
+*/
+
+enum
 {
-	ASYNCIO *aio = new ASYNCIO;
-	if(!aio)
+	AIO_URING_ENTRIES = 64,
+};
+
+class CAioUring
+{
+	int m_Fd = -1;
+	CLock m_SubmitLock;
+	unsigned *m_pSqTail;
+	unsigned m_SqMask;
+	unsigned *m_pSqArray;
+	io_uring_sqe *m_pSqes;
+	unsigned *m_pCqHead;
+	unsigned *m_pCqTail;
+	unsigned m_CqMask;
+	io_uring_cqe *m_pCqes;
+
+	static int Enter(int Fd, unsigned ToSubmit, unsigned MinComplete, unsigned Flags)
 	{
-		return nullptr;
+		return syscall(__NR_io_uring_enter, Fd, ToSubmit, MinComplete, Flags, nullptr, 0);
+	}
+
+public:
+	bool Init()
+	{
+		io_uring_params Params;
+		mem_zero(&Params, sizeof(Params));
+		m_Fd = syscall(__NR_io_uring_setup, AIO_URING_ENTRIES, &Params);
+		if(m_Fd < 0)
+		{
+			// e.g. kernels older than 5.1 or io_uring disabled by seccomp or sysctl
+			return false;
+		}
+		// writing at the current file position requires kernel 5.6
+		if(!(Params.features & IORING_FEAT_SINGLE_MMAP) || !(Params.features & IORING_FEAT_RW_CUR_POS))
+		{
+			close(m_Fd);
+			return false;
+		}
+		const size_t SqSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+		const size_t CqSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+		void *pRing = mmap(nullptr, SqSize > CqSize ? SqSize : CqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+		void *pSqes = mmap(nullptr, Params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES);
+		if(pRing == MAP_FAILED || pSqes == MAP_FAILED)
+		{
+			close(m_Fd);
+			return false;
+		}
+		unsigned char *pRingBytes = (unsigned char *)pRing;
+		m_pSqTail = (unsigned *)(pRingBytes + Params.sq_off.tail);
+		m_SqMask = *(unsigned *)(pRingBytes + Params.sq_off.ring_mask);
+		m_pSqArray = (unsigned *)(pRingBytes + Params.sq_off.array);
+		m_pSqes = (io_uring_sqe *)pSqes;
+		m_pCqHead = (unsigned *)(pRingBytes + Params.cq_off.head);
+		m_pCqTail = (unsigned *)(pRingBytes + Params.cq_off.tail);
+		m_CqMask = *(unsigned *)(pRingBytes + Params.cq_off.ring_mask);
+		m_pCqes = (io_uring_cqe *)(pRingBytes + Params.cq_off.cqes);
+		return true;
+	}
+
+	// Returns `false` if the write could not be submitted.
+	bool SubmitWrite(ASYNCIO *aio, int num_iov) REQUIRES(!m_SubmitLock)
+	{
+		const CLockScope LockScope(m_SubmitLock);
+		// every entry is submitted right away, so the queue is always empty here
+		const unsigned Tail = *m_pSqTail;
+		const unsigned Index = Tail & m_SqMask;
+		io_uring_sqe *pSqe = &m_pSqes[Index];
+		mem_zero(pSqe, sizeof(*pSqe));
+		pSqe->opcode = IORING_OP_WRITEV;
+		pSqe->fd = aio->fd;
+		pSqe->addr = (uintptr_t)aio->iov;
+		pSqe->len = num_iov;
+		// write at the current file position
+		pSqe->off = (uint64_t)-1;
+		pSqe->user_data = (uintptr_t)aio;
+		// never write inline in the submitting thread
+		pSqe->flags = IOSQE_ASYNC;
+		m_pSqArray[Index] = Index;
+		std::atomic_ref<unsigned>(*m_pSqTail).store(Tail + 1, std::memory_order_release);
+
+		int Result;
+		do
+		{
+			Result = Enter(m_Fd, 1, 0, 0);
+		} while(Result < 0 && errno == EINTR);
+		if(Result != 1)
+		{
+			// the kernel has not consumed the entry
+			std::atomic_ref<unsigned>(*m_pSqTail).store(Tail, std::memory_order_release);
+			return false;
+		}
+		return true;
+	}
+
+	// Waits for completions and passes them to `aio_uring_complete`, never returns.
+	void Run();
+};
+
+static void aio_uring_complete(ASYNCIO *aio, int result);
+
+void CAioUring::Run()
+{
+	while(true)
+	{
+		if(Enter(m_Fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+		{
+			dbg_assert_failed("io_uring_enter failed: %d", errno);
+		}
+		unsigned Head = *m_pCqHead;
+		const unsigned Tail = std::atomic_ref<unsigned>(*m_pCqTail).load(std::memory_order_acquire);
+		for(; Head != Tail; Head++)
+		{
+			const io_uring_cqe Cqe = m_pCqes[Head & m_CqMask];
+			std::atomic_ref<unsigned>(*m_pCqHead).store(Head + 1, std::memory_order_release);
+			aio_uring_complete((ASYNCIO *)(uintptr_t)Cqe.user_data, Cqe.res);
+		}
+	}
+}
+
+static void aio_uring_thread(void *user)
+{
+	((CAioUring *)user)->Run();
+}
+
+static CAioUring *aio_uring()
+{
+	// shared by all files and never destroyed, the completion thread runs
+	// until the process exits
+	static CAioUring *s_pUring = []() -> CAioUring * {
+		CAioUring *pUring = new CAioUring;
+		if(!pUring->Init())
+		{
+			delete pUring;
+			return nullptr;
+		}
+		thread_init_and_detach(aio_uring_thread, pUring, "aio uring");
+		return pUring;
+	}();
+	return s_pUring;
+}
+
+// Submits the queued data if there is no write in flight.
+static void aio_uring_submit(ASYNCIO *aio) REQUIRES(aio->lock)
+{
+	if(aio->in_flight || aio->read_pos == aio->write_pos)
+	{
+		return;
+	}
+	struct BUFFERS buffers;
+	buffer_ptrs(aio, &buffers);
+	aio->iov[0].iov_base = buffers.buf1;
+	aio->iov[0].iov_len = buffers.len1;
+	aio->iov[1].iov_base = buffers.buf2;
+	aio->iov[1].iov_len = buffers.len2;
+	const int num_iov = buffers.buf2 ? 2 : 1;
+	aio->submit_pos = aio->write_pos;
+	aio->in_flight = true;
+	if(!aio_uring()->SubmitWrite(aio, num_iov))
+	{
+		// write synchronously if the ring is busy
+		for(int i = 0; i < num_iov; i++)
+		{
+			const unsigned char *data = (const unsigned char *)aio->iov[i].iov_base;
+			size_t len = aio->iov[i].iov_len;
+			while(len > 0)
+			{
+				const ssize_t written = write(aio->fd, data, len);
+				if(written <= 0)
+				{
+					if(written < 0 && errno == EINTR)
+						continue;
+					aio->error = 1;
+					break;
+				}
+				data += written;
+				len -= written;
+			}
+		}
+		aio->read_pos = aio->submit_pos;
+		aio->in_flight = false;
+	}
+}
+
+static void aio_uring_complete(ASYNCIO *aio, int result)
+{
+	const CLockScope LockScope(aio->lock);
+	const unsigned int submitted = (aio->submit_pos + aio->buffer_size - aio->read_pos) % aio->buffer_size;
+	unsigned int written = submitted;
+	if(result > 0 && (unsigned)result < submitted)
+	{
+		// short write, the rest is submitted again
+		written = result;
+	}
+	else if(result == -ECANCELED || result == -EINTR || result == -EAGAIN)
+	{
+		// requests are canceled when the submitting thread exits, submit
+		// them again from the completion thread
+		written = 0;
+	}
+	else if(result <= 0 && submitted > 0)
+	{
+		aio->error = 1;
+	}
+	aio->read_pos = (aio->read_pos + written) % aio->buffer_size;
+	aio->in_flight = false;
+	for(unsigned char *retired_buffer : aio->retired_buffers)
+	{
+		free(retired_buffer);
+	}
+	aio->retired_buffers.clear();
+
+	aio_uring_submit(aio);
+	if(!aio->in_flight && aio->waiting)
+	{
+		sphore_signal(&aio->sphore);
 	}
+}
+
+// Submits all queued data and waits until it is written.
+static void aio_uring_wait_idle(ASYNCIO *aio) REQUIRES(aio->lock)
+{
+	while(true)
+	{
+		aio_uring_submit(aio);
+		if(!aio->in_flight)
+		{
+			if(aio->read_pos == aio->write_pos)
+			{
+				break;
+			}
+			continue;
+		}
+		aio->waiting = true;
+		aio->lock.unlock();
+		sphore_wait(&aio->sphore);
+		aio->lock.lock();
+		aio->waiting = false;
+	}
+}
+#endif
+
+static ASYNCIO *aio_alloc(IOHANDLE io)
+{
+	ASYNCIO *aio = new ASYNCIO;
 	aio->io = io;
-	sphore_init(&aio->sphore);
 	aio->thread = nullptr;
-
 	aio->buffer = (unsigned char *)malloc(ASYNC_BUFSIZE);
 	if(!aio->buffer)
 	{
-		sphore_destroy(&aio->sphore);
 		delete aio;
 		return nullptr;
 	}
+	sphore_init(&aio->sphore);
 	aio->buffer_size = ASYNC_BUFSIZE;
 	aio->read_pos = 0;
 	aio->write_pos = 0;
 	aio->error = 0;
 	aio->finish = ASYNCIO_RUNNING;
+#if defined(CONF_AIO_IO_URING)
+	aio->uring = false;
+	aio->closed = false;
+	aio->fd = -1;
+	aio->submit_pos = 0;
+	aio->in_flight = false;
+	aio->waiting = false;
+#endif
+	return aio;
+}
+
+ASYNCIO *aio_new_thread(IOHANDLE io)
+{
+	ASYNCIO *aio = aio_alloc(io);
+	if(!aio)
+	{
+		return nullptr;
+	}
 	aio->refcount = 2;
 
 	aio->thread = thread_init(aio_thread, aio, "aio");
@@ -171,6 +471,39 @@ ASYNCIO *aio_new(IOHANDLE io)
 	return aio;
 }
 
+ASYNCIO *aio_new_io_uring(IOHANDLE io)
+{
+#if defined(CONF_AIO_IO_URING)
+	if(!aio_uring())
+	{
+		return nullptr;
+	}
+	ASYNCIO *aio = aio_alloc(io);
+	if(!aio)
+	{
+		return nullptr;
+	}
+	aio->refcount = 1;
+	aio->uring = true;
+	// the data is written to the file descriptor directly
+	io_flush(io);
+	aio->fd = fileno((FILE *)io);
+	return aio;
+#else
+	return nullptr;
+#endif
+}
+
+ASYNCIO *aio_new(IOHANDLE io)
+{
+	ASYNCIO *aio = aio_new_io_uring(io);
+	if(aio)
+	{
+		return aio;
+	}
+	return aio_new_thread(io);
+}
+
 static unsigned int buffer_len(ASYNCIO *aio)
 {
 	if(aio->write_pos >= aio->read_pos)
@@ -199,6 +532,14 @@ void aio_lock(ASYNCIO *aio) ACQUIRE(aio->lock)
 
 void aio_unlock(ASYNCIO *aio) RELEASE(aio->lock)
 {
+#if defined(CONF_AIO_IO_URING)
+	if(aio->uring)
+	{
+		aio_uring_submit(aio);
+		aio->lock.unlock();
+		return;
+	}
+#endif
 	aio->lock.unlock();
 	sphore_signal(&aio->sphore);
 }
@@ -245,7 +586,21 @@ void aio_write_unlocked(ASYNCIO *aio, const void *buffer, unsigned size)
 		mem_copy(next_buffer + next_len, buffer, size);
 		next_len += size;
 
+#if defined(CONF_AIO_IO_URING)
+		if(aio->in_flight)
+		{
+			// the kernel is still reading the old buffer
+			aio->submit_pos = (aio->submit_pos + aio->buffer_size - aio->read_pos) % aio->buffer_size;
+			aio->retired_buffers.push_back(aio->buffer);
+		}
+		else
+		{
+			aio->submit_pos = 0;
+			free(aio->buffer);
+		}
+#else
 		free(aio->buffer);
+#endif
 		aio->buffer = next_buffer;
 		aio->buffer_size = next_size;
 		aio->read_pos = 0;
@@ -293,6 +648,23 @@ void aio_close(ASYNCIO *aio)
 
 void aio_wait(ASYNCIO *aio)
 {
+#if defined(CONF_AIO_IO_URING)
+	if(aio->uring)
+	{
+		CLockScope ls(aio->lock);
+		aio_uring_wait_idle(aio);
+		if(aio->finish == ASYNCIO_CLOSE && !aio->closed)
+		{
+			io_close(aio->io);
+			aio->closed = true;
+		}
+		else if(aio->finish == ASYNCIO_RUNNING)
+		{
+			aio->finish = ASYNCIO_EXIT;
+		}
+		return;
+	}
+#endif
 	void *thread;
 	{
 		CLockScope ls(aio->lock);
@@ -310,6 +682,13 @@ void aio_wait(ASYNCIO *aio)
 void aio_free(ASYNCIO *aio)
 {
 	aio->lock.lock();
+#if defined(CONF_AIO_IO_URING)
+	if(aio->uring)
+	{
+		// the kernel must not access the buffer after it is freed
+		aio_uring_wait_idle(aio);
+	}
+#endif
 	if(aio->thread)
 	{
 		thread_detach(aio->thread);
@@ -6,6 +6,9 @@
 /**
  * Wraps a @link IOHANDLE @endlink for asynchronous writing.
  *
+ * Uses io_uring on Linux if the kernel supports it, a writer thread
+ * otherwise.
+ *
  * @ingroup File-IO
  *
  * @param io Handle to the file.
@@ -14,6 +17,34 @@
  */
 ASYNCIO *aio_new(IOHANDLE io);
 
+/**
+ * Wraps a @link IOHANDLE @endlink for asynchronous writing with a
+ * dedicated writer thread.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ *
+ * @return The handle for asynchronous writing.
+ */
+ASYNCIO *aio_new_thread(IOHANDLE io);
+
+/**
+ * Wraps a @link IOHANDLE @endlink for asynchronous writing with io_uring.
+ * All such handles share one ring and one completion thread.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ *
+ * @return The handle for asynchronous writing, or `nullptr` if io_uring
+ * is not available.
+ *
+ * @remark The file must not be written to through the @link IOHANDLE @endlink
+ * while the handle for asynchronous writing is in use.
+ */
+ASYNCIO *aio_new_io_uring(IOHANDLE io);
+
 /**
  * Locks the `ASYNCIO` structure so it can't be written into by
  * other threads.
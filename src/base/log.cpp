@@ -1,12 +1,21 @@
 #include "aio.h"
 #include "color.h"
 #include "logger.h"
+#include "sphore.h"
 #include "system.h"
+#include "thread.h"
 #include "windows.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #if defined(CONF_FAMILY_WINDOWS)
 #include <fcntl.h>
@@ -23,6 +32,8 @@
 std::atomic<ILogger *> global_logger = nullptr;
 thread_local ILogger *scope_logger = nullptr;
 thread_local bool in_logger = false;
+// logger whose messages are formatted by the deferred logging thread
+static std::atomic<ILogger *> deferred_logger = nullptr;
 
 void log_set_global_logger(ILogger *logger)
 {
@@ -36,6 +47,7 @@ void log_set_global_logger(ILogger *logger)
 
 void log_global_logger_finish()
 {
+	log_stop_deferred();
 	ILogger *logger = global_logger.load(std::memory_order_acquire);
 	if(logger)
 		logger->GlobalFinish();
@@ -73,6 +85,22 @@ void log_set_scope_logger(ILogger *logger)
 	}
 }
 
+static void log_message_init(CLogMessage *pMsg, LEVEL level, bool have_color, LOG_COLOR color, time_t time, const char *sys)
+{
+	pMsg->m_Level = level;
+	pMsg->m_HaveColor = have_color;
+	pMsg->m_Color = color;
+	str_timestamp_ex(time, pMsg->m_aTimestamp, sizeof(pMsg->m_aTimestamp), TimestampFormat::SPACE);
+	pMsg->m_TimestampLength = str_length(pMsg->m_aTimestamp);
+	str_copy(pMsg->m_aSystem, sys);
+	pMsg->m_SystemLength = str_length(pMsg->m_aSystem);
+
+	str_format(pMsg->m_aLine, sizeof(pMsg->m_aLine), "%s %c %s: ", pMsg->m_aTimestamp, "EWIDT"[level], pMsg->m_aSystem);
+	pMsg->m_LineMessageOffset = str_length(pMsg->m_aLine);
+}
+
+[[gnu::format(printf, 5, 0)]] static bool log_deferred_push(LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args);
+
 [[gnu::format(printf, 5, 0)]] static void log_log_impl(LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
 {
 	// Make sure we're not logging recursively.
@@ -91,18 +119,14 @@ void log_set_scope_logger(ILogger *logger)
 		return;
 	}
 
-	CLogMessage Msg;
-	Msg.m_Level = level;
-	Msg.m_HaveColor = have_color;
-	Msg.m_Color = color;
-	str_timestamp_format(Msg.m_aTimestamp, sizeof(Msg.m_aTimestamp), TimestampFormat::SPACE);
-	Msg.m_TimestampLength = str_length(Msg.m_aTimestamp);
-	str_copy(Msg.m_aSystem, sys);
-	Msg.m_SystemLength = str_length(Msg.m_aSystem);
-
-	str_format(Msg.m_aLine, sizeof(Msg.m_aLine), "%s %c %s: ", Msg.m_aTimestamp, "EWIDT"[level], Msg.m_aSystem);
-	Msg.m_LineMessageOffset = str_length(Msg.m_aLine);
+	if(scope_logger == deferred_logger.load(std::memory_order_relaxed) && log_deferred_push(level, have_color, color, sys, fmt, args))
+	{
+		in_logger = false;
+		return;
+	}
 
+	CLogMessage Msg;
+	log_message_init(&Msg, level, have_color, color, time(nullptr), sys);
 	char *pMessage = Msg.m_aLine + Msg.m_LineMessageOffset;
 	int MessageSize = sizeof(Msg.m_aLine) - Msg.m_LineMessageOffset;
 	str_format_v(pMessage, MessageSize, fmt, args);
@@ -137,6 +161,672 @@ void log_log_color(LEVEL level, LOG_COLOR color, const char *sys, const char *fm
 	va_end(args);
 }
 
+/*
+	Deferred formatting
+
+	Messages for the deferred logger are not formatted by the logging thread.
+	It copies the format string and the raw arguments into its own
+	single-producer ring buffer instead, strings are copied, everything else
+	is stored in 8 byte slots. A background thread collects the records of
+	all rings in batches, orders them by their sequence number, formats them
+	and passes them to the logger. Records are dropped and counted if the
+	ring buffer of a thread is full.
+*/
+
+enum
+{
+	DEFERRED_RING_SIZE = 64 * 1024,
+	DEFERRED_MAX_RECORD_SIZE = 8 * 1024,
+	// longer conversion specifications are formatted eagerly
+	DEFERRED_MAX_SPEC_LENGTH = 32,
+};
+
+enum class EDeferredRecord : uint8_t
+{
+	// skips the rest of the ring buffer
+	PADDING,
+	// format string followed by the arguments
+	FORMAT,
+	// already formatted message, for unsupported format strings
+	TEXT,
+};
+
+class CDeferredRecordHeader
+{
+public:
+	uint32_t m_Size;
+	EDeferredRecord m_Type;
+	LEVEL m_Level;
+	bool m_HaveColor;
+	LOG_COLOR m_Color;
+	uint64_t m_Sequence;
+	int64_t m_Time;
+};
+static_assert(sizeof(CDeferredRecordHeader) % 8 == 0);
+
+class CDeferredRing
+{
+	alignas(64) std::atomic<uint64_t> m_Head = 0;
+	alignas(64) std::atomic<uint64_t> m_Tail = 0;
+
+public:
+	std::atomic<uint64_t> m_Dropped = 0;
+	std::atomic<bool> m_Orphaned = false;
+	alignas(8) unsigned char m_aData[DEFERRED_RING_SIZE];
+
+	// Only called by the owning thread.
+	bool Push(const unsigned char *pRecord, uint32_t Size)
+	{
+		const uint64_t Tail = m_Tail.load(std::memory_order_relaxed);
+		const uint64_t Head = m_Head.load(std::memory_order_acquire);
+		const uint32_t Contiguous = DEFERRED_RING_SIZE - Tail % DEFERRED_RING_SIZE;
+		const uint32_t Padding = Contiguous < Size ? Contiguous : 0;
+		if(DEFERRED_RING_SIZE - (Tail - Head) < (uint64_t)Size + Padding)
+		{
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		if(Padding)
+		{
+			CDeferredRecordHeader *pPadding = (CDeferredRecordHeader *)&m_aData[Tail % DEFERRED_RING_SIZE];
+			pPadding->m_Size = Padding;
+			pPadding->m_Type = EDeferredRecord::PADDING;
+		}
+		mem_copy(&m_aData[(Tail + Padding) % DEFERRED_RING_SIZE], pRecord, Size);
+		m_Tail.store(Tail + Padding + Size, std::memory_order_release);
+		return true;
+	}
+
+	// Only called by the deferred logging thread.
+	uint64_t Head() const { return m_Head.load(std::memory_order_relaxed); }
+	uint64_t Tail() const { return m_Tail.load(std::memory_order_acquire); }
+	void Consume(uint64_t Head) { m_Head.store(Head, std::memory_order_release); }
+	const CDeferredRecordHeader *Record(uint64_t Position) const { return (const CDeferredRecordHeader *)&m_aData[Position % DEFERRED_RING_SIZE]; }
+};
+
+// Marks the ring buffer of a thread as orphaned when the thread exits.
+class CDeferredRingOwner
+{
+public:
+	std::shared_ptr<CDeferredRing> m_pRing;
+	~CDeferredRingOwner()
+	{
+		if(m_pRing)
+			m_pRing->m_Orphaned.store(true, std::memory_order_release);
+	}
+};
+
+class CDeferredState
+{
+public:
+	CLock m_RingsLock;
+	std::vector<std::shared_ptr<CDeferredRing>> m_vpRings GUARDED_BY(m_RingsLock);
+	std::atomic<uint64_t> m_Sequence = 0;
+	std::atomic<uint64_t> m_Dropped = 0;
+	std::atomic<bool> m_Stop = false;
+	// set while the deferred logging thread waits for the wakeup signal
+	std::atomic<bool> m_Sleeping = false;
+	CSemaphore m_Wakeup;
+	void *m_pThread = nullptr;
+};
+
+static CDeferredState deferred;
+thread_local CDeferredRingOwner deferred_ring_owner;
+thread_local bool is_deferred_thread = false;
+alignas(8) thread_local unsigned char deferred_staging[DEFERRED_MAX_RECORD_SIZE];
+
+class CDeferredSpec
+{
+public:
+	// length of the conversion specification including the '%'
+	int m_Length;
+	// offset of the length modifier
+	int m_ModifierOffset;
+	bool m_WidthStar;
+	bool m_PrecisionStar;
+	// fixed precision or -1
+	int m_Precision;
+	// 'H' for "hh", 'L' for "ll", otherwise the length modifier or 0
+	char m_Modifier;
+	char m_Conversion;
+
+	int NumStars() const { return m_WidthStar + m_PrecisionStar; }
+	bool IsInteger() const
+	{
+		return m_Conversion == 'd' || m_Conversion == 'i' || m_Conversion == 'u' || m_Conversion == 'o' || m_Conversion == 'x' || m_Conversion == 'X';
+	}
+};
+
+// Parses the conversion specification starting at the '%' of `fmt`.
+// Returns `false` for specifications that cannot be deferred.
+static bool log_deferred_parse_spec(const char *fmt, CDeferredSpec *spec)
+{
+	const char *p = fmt + 1;
+	spec->m_WidthStar = false;
+	spec->m_PrecisionStar = false;
+	spec->m_Precision = -1;
+	while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+		p++;
+	if(*p == '*')
+	{
+		spec->m_WidthStar = true;
+		p++;
+	}
+	while(*p >= '0' && *p <= '9')
+		p++;
+	if(*p == '.')
+	{
+		p++;
+		if(*p == '*')
+		{
+			spec->m_PrecisionStar = true;
+			p++;
+		}
+		else
+		{
+			spec->m_Precision = 0;
+			while(*p >= '0' && *p <= '9')
+				spec->m_Precision = std::min(spec->m_Precision * 10 + (*p++ - '0'), (int)sizeof(CLogMessage::m_aLine));
+		}
+	}
+	spec->m_ModifierOffset = p - fmt;
+	spec->m_Modifier = 0;
+	if((p[0] == 'h' || p[0] == 'l') && p[1] == p[0])
+	{
+		spec->m_Modifier = p[0] == 'h' ? 'H' : 'L';
+		p += 2;
+	}
+	else if(*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't')
+	{
+		spec->m_Modifier = *p++;
+	}
+	spec->m_Conversion = *p;
+	spec->m_Length = p + 1 - fmt;
+	if(spec->m_Length > DEFERRED_MAX_SPEC_LENGTH)
+		return false;
+	switch(spec->m_Conversion)
+	{
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		return true;
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		return spec->m_Modifier == 0 || spec->m_Modifier == 'l';
+	case 'c':
+	case 's':
+	case 'p':
+		return spec->m_Modifier == 0;
+	case '%':
+		return spec->m_Length == 2;
+	default:
+		// positional arguments, `%n` and unknown conversions
+		return false;
+	}
+}
+
+class CDeferredWriter
+{
+public:
+	unsigned char *m_pData;
+	uint32_t m_Size;
+
+	bool Value(int64_t Value)
+	{
+		if(m_Size + sizeof(Value) > DEFERRED_MAX_RECORD_SIZE)
+			return false;
+		mem_copy(m_pData + m_Size, &Value, sizeof(Value));
+		m_Size += sizeof(Value);
+		return true;
+	}
+	bool Value(double Value)
+	{
+		int64_t Bits;
+		mem_copy(&Bits, &Value, sizeof(Bits));
+		return this->Value(Bits);
+	}
+	// Copies at most `MaxLength` bytes, padded to 8 bytes.
+	bool String(const char *pString, int MaxLength)
+	{
+		const void *pEnd = std::memchr(pString, '\0', MaxLength);
+		const uint32_t Length = pEnd ? (const char *)pEnd - pString : MaxLength;
+		const uint32_t PaddedSize = (Length + 1 + 7) & ~7u;
+		if(m_Size + PaddedSize > DEFERRED_MAX_RECORD_SIZE)
+			return false;
+		mem_copy(m_pData + m_Size, pString, Length);
+		mem_zero(m_pData + m_Size + Length, PaddedSize - Length);
+		m_Size += PaddedSize;
+		return true;
+	}
+};
+
+class CDeferredReader
+{
+public:
+	const unsigned char *m_pData;
+	uint32_t m_Offset;
+
+	int64_t Value()
+	{
+		int64_t Value;
+		mem_copy(&Value, m_pData + m_Offset, sizeof(Value));
+		m_Offset += sizeof(Value);
+		return Value;
+	}
+	double Double()
+	{
+		const int64_t Bits = Value();
+		double Value;
+		mem_copy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+	const char *String()
+	{
+		const char *pString = (const char *)m_pData + m_Offset;
+		m_Offset += (str_length(pString) + 1 + 7) & ~7u;
+		return pString;
+	}
+};
+
+[[gnu::format(printf, 2, 0)]] static bool log_deferred_write_args(CDeferredWriter *writer, const char *fmt, va_list args)
+{
+	// longer strings would be cut off by the message anyway
+	const int MaxStringLength = sizeof(CLogMessage::m_aLine);
+	for(const char *p = fmt; *p; p++)
+	{
+		if(*p != '%')
+			continue;
+		CDeferredSpec Spec;
+		if(!log_deferred_parse_spec(p, &Spec))
+			return false;
+		p += Spec.m_Length - 1;
+		int Precision = Spec.m_Precision;
+		if(Spec.m_WidthStar && !writer->Value((int64_t)va_arg(args, int)))
+			return false;
+		if(Spec.m_PrecisionStar)
+		{
+			Precision = va_arg(args, int);
+			if(!writer->Value((int64_t)Precision))
+				return false;
+		}
+		bool Written = true;
+		switch(Spec.m_Conversion)
+		{
+		case 'd':
+		case 'i':
+		{
+			int64_t Value;
+			switch(Spec.m_Modifier)
+			{
+			case 'H': Value = (signed char)va_arg(args, int); break;
+			case 'h': Value = (short)va_arg(args, int); break;
+			case 'l': Value = va_arg(args, long); break;
+			case 'L': Value = va_arg(args, long long); break;
+			case 'z': Value = va_arg(args, std::make_signed_t<size_t>); break;
+			case 'j': Value = va_arg(args, intmax_t); break;
+			case 't': Value = va_arg(args, ptrdiff_t); break;
+			default: Value = va_arg(args, int); break;
+			}
+			Written = writer->Value(Value);
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		{
+			uint64_t Value;
+			switch(Spec.m_Modifier)
+			{
+			case 'H': Value = (unsigned char)va_arg(args, unsigned); break;
+			case 'h': Value = (unsigned short)va_arg(args, unsigned); break;
+			case 'l': Value = va_arg(args, unsigned long); break;
+			case 'L': Value = va_arg(args, unsigned long long); break;
+			case 'z': Value = va_arg(args, size_t); break;
+			case 'j': Value = va_arg(args, uintmax_t); break;
+			case 't': Value = (std::make_unsigned_t<ptrdiff_t>)va_arg(args, ptrdiff_t); break;
+			default: Value = va_arg(args, unsigned); break;
+			}
+			Written = writer->Value((int64_t)Value);
+			break;
+		}
+		case 'c':
+			Written = writer->Value((int64_t)va_arg(args, int));
+			break;
+		case 'p':
+			Written = writer->Value((int64_t)(uintptr_t)va_arg(args, void *));
+			break;
+		case 's':
+		{
+			const char *pString = va_arg(args, const char *);
+			Written = writer->String(pString ? pString : "(null)", Precision >= 0 ? std::min(Precision, MaxStringLength) : MaxStringLength);
+			break;
+		}
+		case '%':
+			break;
+		default:
+			Written = writer->Value(va_arg(args, double));
+			break;
+		}
+		if(!Written)
+			return false;
+	}
+	return true;
+}
+
+static CDeferredRing *log_deferred_ring()
+{
+	if(!deferred_ring_owner.m_pRing)
+	{
+		deferred_ring_owner.m_pRing = std::make_shared<CDeferredRing>();
+		const CLockScope LockScope(deferred.m_RingsLock);
+		deferred.m_vpRings.push_back(deferred_ring_owner.m_pRing);
+	}
+	return deferred_ring_owner.m_pRing.get();
+}
+
+static void log_deferred_wakeup()
+{
+	// pairs with the fence in `log_deferred_thread`
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(deferred.m_Sleeping.load(std::memory_order_relaxed) && deferred.m_Sleeping.exchange(false))
+	{
+		deferred.m_Wakeup.Signal();
+	}
+}
+
+static bool log_deferred_push(LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
+{
+	// the deferred logging thread must not wait for itself
+	if(is_deferred_thread)
+	{
+		return false;
+	}
+
+	CDeferredWriter Writer = {deferred_staging, sizeof(CDeferredRecordHeader)};
+	Writer.String(sys, sizeof(CLogMessage::m_aSystem) - 1);
+	const uint32_t FormatOffset = Writer.m_Size;
+	EDeferredRecord Type = EDeferredRecord::FORMAT;
+	va_list args_copy;
+	va_copy(args_copy, args);
+	const bool Deferred = Writer.String(fmt, DEFERRED_MAX_RECORD_SIZE) && log_deferred_write_args(&Writer, fmt, args_copy);
+	va_end(args_copy);
+	if(!Deferred)
+	{
+		char aMessage[sizeof(CLogMessage::m_aLine)];
+		str_format_v(aMessage, sizeof(aMessage), fmt, args);
+		Type = EDeferredRecord::TEXT;
+		Writer.m_Size = FormatOffset;
+		Writer.String(aMessage, sizeof(aMessage));
+	}
+
+	CDeferredRecordHeader *pHeader = (CDeferredRecordHeader *)deferred_staging;
+	pHeader->m_Size = Writer.m_Size;
+	pHeader->m_Type = Type;
+	pHeader->m_Level = level;
+	pHeader->m_HaveColor = have_color;
+	pHeader->m_Color = color;
+	pHeader->m_Sequence = deferred.m_Sequence.fetch_add(1, std::memory_order_relaxed);
+	pHeader->m_Time = time(nullptr);
+	if(log_deferred_ring()->Push(deferred_staging, Writer.m_Size))
+	{
+		log_deferred_wakeup();
+	}
+	return true;
+}
+
+template<typename T>
+static int log_deferred_format_arg(char *buffer, int buffer_size, const char *spec, int num_stars, const int *stars, T value)
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+	switch(num_stars)
+	{
+	case 0:
+		return std::snprintf(buffer, buffer_size, spec, value);
+	case 1:
+		return std::snprintf(buffer, buffer_size, spec, stars[0], value);
+	default:
+		return std::snprintf(buffer, buffer_size, spec, stars[0], stars[1], value);
+	}
+#pragma GCC diagnostic pop
+}
+
+static void log_deferred_format(const CDeferredRecordHeader *pHeader, CLogMessage *pMsg)
+{
+	CDeferredReader Reader = {(const unsigned char *)pHeader, sizeof(CDeferredRecordHeader)};
+	log_message_init(pMsg, pHeader->m_Level, pHeader->m_HaveColor, pHeader->m_Color, pHeader->m_Time, Reader.String());
+	char *pMessage = pMsg->m_aLine + pMsg->m_LineMessageOffset;
+	const int MessageSize = sizeof(pMsg->m_aLine) - pMsg->m_LineMessageOffset;
+	const char *pFormat = Reader.String();
+	if(pHeader->m_Type == EDeferredRecord::TEXT)
+	{
+		str_copy(pMessage, pFormat, MessageSize);
+		pMsg->m_LineLength = str_length(pMsg->m_aLine);
+		return;
+	}
+
+	int Length = 0;
+	for(const char *p = pFormat; *p && Length < MessageSize - 1;)
+	{
+		if(*p != '%')
+		{
+			const char *pNext = str_find(p, "%");
+			const int Literal = std::min<int>(pNext ? pNext - p : str_length(p), MessageSize - 1 - Length);
+			mem_copy(pMessage + Length, p, Literal);
+			Length += Literal;
+			p += Literal;
+			continue;
+		}
+
+		CDeferredSpec Spec;
+		log_deferred_parse_spec(p, &Spec);
+		// all integers are stored with 64 bits
+		char aSpec[DEFERRED_MAX_SPEC_LENGTH + 2];
+		mem_copy(aSpec, p, Spec.m_ModifierOffset);
+		int SpecLength = Spec.m_ModifierOffset;
+		if(Spec.IsInteger())
+		{
+			aSpec[SpecLength++] = 'l';
+			aSpec[SpecLength++] = 'l';
+		}
+		aSpec[SpecLength++] = Spec.m_Conversion;
+		aSpec[SpecLength] = '\0';
+		p += Spec.m_Length;
+
+		int aStars[2];
+		for(int i = 0; i < Spec.NumStars(); i++)
+			aStars[i] = Reader.Value();
+		char *pOut = pMessage + Length;
+		const int OutSize = MessageSize - Length;
+		int Written;
+		switch(Spec.m_Conversion)
+		{
+		case 'd':
+		case 'i':
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, (long long)Reader.Value());
+			break;
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, (unsigned long long)Reader.Value());
+			break;
+		case 'c':
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, (int)Reader.Value());
+			break;
+		case 'p':
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, (void *)(uintptr_t)Reader.Value());
+			break;
+		case 's':
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, Reader.String());
+			break;
+		case '%':
+			pOut[0] = '%';
+			Written = 1;
+			break;
+		default:
+			Written = log_deferred_format_arg(pOut, OutSize, aSpec, Spec.NumStars(), aStars, Reader.Double());
+			break;
+		}
+		Length += std::clamp(Written, 0, OutSize - 1);
+	}
+	pMessage[Length] = '\0';
+	str_utf8_fix_truncation(pMessage);
+	pMsg->m_LineLength = str_length(pMsg->m_aLine);
+}
+
+static bool log_deferred_pending()
+{
+	const CLockScope LockScope(deferred.m_RingsLock);
+	return std::any_of(deferred.m_vpRings.begin(), deferred.m_vpRings.end(), [](const std::shared_ptr<CDeferredRing> &pRing) {
+		return pRing->Head() != pRing->Tail();
+	});
+}
+
+// Formats and logs the records of all threads, returns `true` if there were any.
+static bool log_deferred_drain(ILogger *logger)
+{
+	std::vector<std::shared_ptr<CDeferredRing>> vpRings;
+	{
+		const CLockScope LockScope(deferred.m_RingsLock);
+		vpRings = deferred.m_vpRings;
+	}
+
+	std::vector<const CDeferredRecordHeader *> vpRecords;
+	std::vector<uint64_t> vTails(vpRings.size());
+	std::vector<bool> vOrphaned(vpRings.size());
+	for(size_t i = 0; i < vpRings.size(); i++)
+	{
+		// a ring cannot get new records after being orphaned
+		vOrphaned[i] = vpRings[i]->m_Orphaned.load(std::memory_order_acquire);
+		vTails[i] = vpRings[i]->Tail();
+		for(uint64_t Position = vpRings[i]->Head(); Position != vTails[i];)
+		{
+			const CDeferredRecordHeader *pRecord = vpRings[i]->Record(Position);
+			if(pRecord->m_Type != EDeferredRecord::PADDING)
+				vpRecords.push_back(pRecord);
+			Position += pRecord->m_Size;
+		}
+	}
+	std::sort(vpRecords.begin(), vpRecords.end(), [](const CDeferredRecordHeader *pA, const CDeferredRecordHeader *pB) {
+		return pA->m_Sequence < pB->m_Sequence;
+	});
+
+	CLogMessage Msg;
+	for(const CDeferredRecordHeader *pRecord : vpRecords)
+	{
+		log_deferred_format(pRecord, &Msg);
+		logger->Log(&Msg);
+	}
+
+	uint64_t Dropped = 0;
+	std::vector<std::shared_ptr<CDeferredRing>> vpFinished;
+	for(size_t i = 0; i < vpRings.size(); i++)
+	{
+		vpRings[i]->Consume(vTails[i]);
+		Dropped += vpRings[i]->m_Dropped.exchange(0, std::memory_order_relaxed);
+		if(vOrphaned[i])
+			vpFinished.push_back(vpRings[i]);
+	}
+	if(!vpFinished.empty())
+	{
+		const CLockScope LockScope(deferred.m_RingsLock);
+		for(const auto &pRing : vpFinished)
+			deferred.m_vpRings.erase(std::find(deferred.m_vpRings.begin(), deferred.m_vpRings.end(), pRing));
+	}
+	if(Dropped > 0)
+	{
+		deferred.m_Dropped.fetch_add(Dropped, std::memory_order_relaxed);
+		log_message_init(&Msg, LEVEL_WARN, false, LOG_COLOR{0, 0, 0}, time(nullptr), "log");
+		str_format(Msg.m_aLine + Msg.m_LineMessageOffset, sizeof(Msg.m_aLine) - Msg.m_LineMessageOffset, "dropped %" PRIu64 " deferred log messages", Dropped);
+		Msg.m_LineLength = str_length(Msg.m_aLine);
+		logger->Log(&Msg);
+	}
+	return !vpRecords.empty() || Dropped > 0;
+}
+
+static void log_deferred_thread(void *user)
+{
+	ILogger *logger = (ILogger *)user;
+	is_deferred_thread = true;
+	// messages of the logger itself are dropped like on other threads
+	in_logger = true;
+	while(true)
+	{
+		if(log_deferred_drain(logger))
+		{
+			// let more messages accumulate to write them in batches
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if(deferred.m_Stop.load())
+		{
+			break;
+		}
+		deferred.m_Sleeping.store(true);
+		// pairs with the fence in `log_deferred_wakeup`
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(log_deferred_pending() || deferred.m_Stop.load())
+		{
+			// a producer that cleared the flag has signaled or is about to
+			if(!deferred.m_Sleeping.exchange(false))
+				deferred.m_Wakeup.Wait();
+			continue;
+		}
+		deferred.m_Wakeup.Wait();
+	}
+}
+
+void log_start_deferred(ILogger *logger)
+{
+	dbg_assert(logger != nullptr, "deferred logger must not be null");
+	dbg_assert(deferred.m_pThread == nullptr, "deferred logging has already been started");
+	deferred.m_Stop.store(false);
+	deferred.m_pThread = thread_init(log_deferred_thread, logger, "deferred log");
+	deferred_logger.store(logger, std::memory_order_release);
+}
+
+void log_stop_deferred()
+{
+	ILogger *logger = deferred_logger.exchange(nullptr);
+	if(!logger)
+	{
+		return;
+	}
+	deferred.m_Stop.store(true);
+	log_deferred_wakeup();
+	if(is_deferred_thread)
+	{
+		// called by a logger on the deferred logging thread, e.g. on assertion failure
+		thread_detach(deferred.m_pThread);
+		deferred.m_pThread = nullptr;
+		return;
+	}
+	thread_wait(deferred.m_pThread);
+	deferred.m_pThread = nullptr;
+
+	// messages of threads that logged while the thread was stopping
+	const bool WasInLogger = in_logger;
+	in_logger = true;
+	log_deferred_drain(logger);
+	in_logger = WasInLogger;
+}
+
+uint64_t log_deferred_dropped()
+{
+	return deferred.m_Dropped.load(std::memory_order_relaxed);
+}
+
 bool CLogFilter::Filters(const CLogMessage *pMessage)
 {
 	return pMessage->m_Level > m_MaxLevel.load(std::memory_order_relaxed);
@@ -150,6 +150,42 @@ void log_set_global_logger_default();
  */
 void log_global_logger_finish();
 
+/**
+ * @ingroup Log
+ *
+ * Formats the messages for the given logger on a background thread.
+ *
+ * Threads logging to this logger only copy the format string and the
+ * arguments into a per-thread ring buffer, which makes logging cheap for
+ * latency sensitive threads. Messages are dropped and counted if the ring
+ * buffer of a thread is full. Messages for other loggers, e.g. scope loggers,
+ * are still formatted and logged immediately.
+ *
+ * The logger must be thread-safe, it is called from the background thread.
+ *
+ * @param logger The logger to defer messages for, usually the global logger.
+ *
+ * @see log_stop_deferred
+ */
+void log_start_deferred(ILogger *logger);
+
+/**
+ * @ingroup Log
+ *
+ * Stops formatting messages on the background thread after logging all
+ * pending messages. Called by `log_global_logger_finish`.
+ *
+ * @see log_start_deferred
+ */
+void log_stop_deferred();
+
+/**
+ * @ingroup Log
+ *
+ * @return Number of deferred messages dropped because a ring buffer was full.
+ */
+uint64_t log_deferred_dropped();
+
 /**
  * @ingroup Log
  *
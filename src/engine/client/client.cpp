@@ -88,6 +88,8 @@ using namespace std::chrono_literals;
 
 static constexpr ColorRGBA CLIENT_NETWORK_PRINT_COLOR = ColorRGBA(0.7f, 1, 0.7f, 1.0f);
 static constexpr ColorRGBA CLIENT_NETWORK_PRINT_ERROR_COLOR = ColorRGBA(1.0f, 0.25f, 0.25f, 1.0f);
+// maps below this size are downloaded with a single request
+static constexpr int MAP_DOWNLOAD_RANGED_MIN_SIZE = 1024 * 1024;
 
 CClient::CClient() :
 	m_DemoPlayer(&m_SnapshotDelta, true, [&]() { UpdateDemoIntraTimers(); }),
@@ -457,6 +459,7 @@ void CClient::OnEnterGame(bool Dummy)
 	m_aapSnapshots[Dummy][SNAP_CURRENT] = nullptr;
 	m_aapSnapshots[Dummy][SNAP_PREV] = nullptr;
 	m_aSnapshotStorage[Dummy].PurgeAll();
+	m_SnapshotDecoder.Reset(Dummy);
 	m_aReceivedSnapshots[Dummy] = 0;
 	m_aSnapshotParts[Dummy] = 0;
 	m_aSnapshotIncomingDataSize[Dummy] = 0;
@@ -916,11 +919,13 @@ int CClient::SnapNumItems(int SnapId) const
 void CClient::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	m_SnapshotDecoder.SetStaticsize(ItemType, Size);
 }
 
 void CClient::SnapSetStaticsize7(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize7(ItemType, Size);
+	m_SnapshotDecoder.SetStaticsize7(ItemType, Size);
 }
 
 void CClient::RenderDebug()
@@ -994,9 +999,23 @@ void CClient::RenderDebug()
 		str_format(aBuffer, sizeof(aBuffer), "%5s %20s: %8s %8s %8s", "ID", "Name", "Rate", "Updates", "R/U");
 		Graphics()->QuadsText(2, OffsetY + Row * 12, FontSize, aBuffer);
 		Row++;
+		// snapshots received from the server are unpacked by the decoder
+		const auto &&GetDataRate = [&](int Index, uint64_t *pRate, uint64_t *pUpdates) {
+			if(m_DemoPlayer.IsPlaying())
+			{
+				*pRate = m_SnapshotDelta.GetDataRate(Index);
+				*pUpdates = m_SnapshotDelta.GetDataUpdates(Index);
+			}
+			else
+			{
+				m_SnapshotDecoder.DataRate(Index, pRate, pUpdates);
+			}
+		};
+		uint64_t Rate, Updates;
 		for(int i = 0; i < NUM_NETOBJTYPES; i++)
 		{
-			if(m_SnapshotDelta.GetDataRate(i))
+			GetDataRate(i, &Rate, &Updates);
+			if(Rate)
 			{
 				str_format(
 					aBuffer,
@@ -1004,15 +1023,16 @@ void CClient::RenderDebug()
 					"%5d %20s: %8" PRIu64 " %8" PRIu64 " %8" PRIu64,
 					i,
 					GameClient()->GetItemName(i),
-					m_SnapshotDelta.GetDataRate(i) / 8, m_SnapshotDelta.GetDataUpdates(i),
-					(m_SnapshotDelta.GetDataRate(i) / m_SnapshotDelta.GetDataUpdates(i)) / 8);
+					Rate / 8, Updates,
+					(Rate / Updates) / 8);
 				Graphics()->QuadsText(2, OffsetY + Row * 12, FontSize, aBuffer);
 				Row++;
 			}
 		}
 		for(int i = CSnapshot::MAX_TYPE; i > (CSnapshot::MAX_TYPE - 64); i--)
 		{
-			if(m_SnapshotDelta.GetDataRate(i) && m_aapSnapshots[g_Config.m_ClDummy][IClient::SNAP_CURRENT])
+			GetDataRate(i, &Rate, &Updates);
+			if(Rate && m_aapSnapshots[g_Config.m_ClDummy][IClient::SNAP_CURRENT])
 			{
 				const int Type = m_aapSnapshots[g_Config.m_ClDummy][IClient::SNAP_CURRENT]->m_pAltSnap->GetExternalItemType(i);
 				if(Type == UUID_INVALID)
@@ -1023,9 +1043,9 @@ void CClient::RenderDebug()
 						"%5d %20s: %8" PRIu64 " %8" PRIu64 " %8" PRIu64,
 						i,
 						"Unknown UUID",
-						m_SnapshotDelta.GetDataRate(i) / 8,
-						m_SnapshotDelta.GetDataUpdates(i),
-						(m_SnapshotDelta.GetDataRate(i) / m_SnapshotDelta.GetDataUpdates(i)) / 8);
+						Rate / 8,
+						Updates,
+						(Rate / Updates) / 8);
 					Graphics()->QuadsText(2, OffsetY + Row * 12, FontSize, aBuffer);
 					Row++;
 				}
@@ -1037,9 +1057,9 @@ void CClient::RenderDebug()
 						"%5d %20s: %8" PRIu64 " %8" PRIu64 " %8" PRIu64,
 						Type,
 						GameClient()->GetItemName(Type),
-						m_SnapshotDelta.GetDataRate(i) / 8,
-						m_SnapshotDelta.GetDataUpdates(i),
-						(m_SnapshotDelta.GetDataRate(i) / m_SnapshotDelta.GetDataUpdates(i)) / 8);
+						Rate / 8,
+						Updates,
+						(Rate / Updates) / 8);
 					Graphics()->QuadsText(2, OffsetY + Row * 12, FontSize, aBuffer);
 					Row++;
 				}
@@ -1685,6 +1705,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 				// start map download
 				FormatMapDownloadFilename(pMap, MapSha256, MapCrc, false, m_aMapdownloadFilename, sizeof(m_aMapdownloadFilename));
 				FormatMapDownloadFilename(pMap, MapSha256, MapCrc, true, m_aMapdownloadFilenameTemp, sizeof(m_aMapdownloadFilenameTemp));
+				str_format(m_aMapdownloadFilenamePart, sizeof(m_aMapdownloadFilenamePart), "%s.part", m_aMapdownloadFilename);
 
 				char aBuf[256];
 				str_format(aBuf, sizeof(aBuf), "starting to download map to '%s'", m_aMapdownloadFilenameTemp);
@@ -1697,17 +1718,18 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 
 				if(MapSha256.has_value())
 				{
-					char aUrl[256];
-					char aEscaped[256];
-					EscapeUrl(aEscaped, m_aMapdownloadFilename + 15); // cut off downloadedmaps/
-					bool UseConfigUrl = str_comp(g_Config.m_ClMapDownloadUrl, "https://maps.ddnet.org") != 0 || m_aMapDownloadUrl[0] == '\0';
-					str_format(aUrl, sizeof(aUrl), "%s/%s", UseConfigUrl ? g_Config.m_ClMapDownloadUrl : m_aMapDownloadUrl, aEscaped);
-
-					m_pMapdownloadTask = HttpGetFile(pMapUrl ? pMapUrl : aUrl, Storage(), m_aMapdownloadFilenameTemp, IStorage::TYPE_SAVE);
-					m_pMapdownloadTask->Timeout(CTimeout{g_Config.m_ClMapDownloadConnectTimeoutMs, 0, g_Config.m_ClMapDownloadLowSpeedLimit, g_Config.m_ClMapDownloadLowSpeedTime});
-					m_pMapdownloadTask->MaxResponseSize(MapSize);
-					m_pMapdownloadTask->ExpectSha256(MapSha256.value());
-					Http()->Run(m_pMapdownloadTask);
+					if(pMapUrl)
+					{
+						str_copy(m_aMapdownloadUrl, pMapUrl);
+					}
+					else
+					{
+						char aEscaped[256];
+						EscapeUrl(aEscaped, m_aMapdownloadFilename + 15); // cut off downloadedmaps/
+						bool UseConfigUrl = str_comp(g_Config.m_ClMapDownloadUrl, "https://maps.ddnet.org") != 0 || m_aMapDownloadUrl[0] == '\0';
+						str_format(m_aMapdownloadUrl, sizeof(m_aMapdownloadUrl), "%s/%s", UseConfigUrl ? g_Config.m_ClMapDownloadUrl : m_aMapDownloadUrl, aEscaped);
+					}
+					StartMapHttpDownload(g_Config.m_ClMapDownloadConnections > 1 && MapSize > MAP_DOWNLOAD_RANGED_MIN_SIZE);
 				}
 				else
 				{
@@ -2055,201 +2077,29 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 				if((NumParts < CSnapshot::MAX_PARTS && m_aSnapshotParts[Conn] == (((uint64_t)(1) << NumParts) - 1)) ||
 					(NumParts == CSnapshot::MAX_PARTS && m_aSnapshotParts[Conn] == std::numeric_limits<uint64_t>::max()))
 				{
-					unsigned char aTmpBuffer2[CSnapshot::MAX_SIZE];
-					unsigned char aTmpBuffer3[CSnapshot::MAX_SIZE];
-					CSnapshot *pTmpBuffer3 = (CSnapshot *)aTmpBuffer3; // Fix compiler warning for strict-aliasing
-
 					// reset snapshotting
 					m_aSnapshotParts[Conn] = 0;
 
-					// find snapshot that we should use as delta
-					const CSnapshot *pDeltaShot = CSnapshot::EmptySnapshot();
-					if(DeltaTick >= 0)
-					{
-						int DeltashotSize = m_aSnapshotStorage[Conn].Get(DeltaTick, nullptr, &pDeltaShot, nullptr);
-
-						if(DeltashotSize < 0)
-						{
-							// couldn't find the delta snapshots that the server used
-							// to compress this snapshot. force the server to resync
-							if(g_Config.m_Debug)
-							{
-								m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "client", "error, couldn't find the delta snapshot");
-							}
-
-							// ack snapshot
-							m_aAckGameTick[Conn] = -1;
-							SendInput();
-							return;
-						}
-					}
-
-					// decompress snapshot
-					const void *pDeltaData = m_SnapshotDelta.EmptyDelta();
-					int DeltaSize = sizeof(int) * 3;
-
-					if(m_aSnapshotIncomingDataSize[Conn])
-					{
-						int IntSize = CVariableInt::Decompress(m_aaSnapshotIncomingData[Conn], m_aSnapshotIncomingDataSize[Conn], aTmpBuffer2, sizeof(aTmpBuffer2));
-
-						if(IntSize < 0) // failure during decompression
-							return;
-
-						pDeltaData = aTmpBuffer2;
-						DeltaSize = IntSize;
-					}
-
-					// unpack delta
-					const int SnapSize = m_SnapshotDelta.UnpackDelta(pDeltaShot, pTmpBuffer3, pDeltaData, DeltaSize, IsSixup());
-					if(SnapSize < 0)
-					{
-						dbg_msg("client", "delta unpack failed. error=%d", SnapSize);
-						return;
-					}
-					if(!pTmpBuffer3->IsValid(SnapSize))
-					{
-						dbg_msg("client", "snapshot invalid. SnapSize=%d, DeltaSize=%d", SnapSize, DeltaSize);
-						return;
-					}
-
-					if(Msg != NETMSG_SNAPEMPTY && pTmpBuffer3->Crc() != Crc)
-					{
-						log_error("client", "snapshot crc error #%d - tick=%d wantedcrc=%d gotcrc=%d compressed_size=%d delta_tick=%d",
-							m_SnapCrcErrors, GameTick, Crc, pTmpBuffer3->Crc(), m_aSnapshotIncomingDataSize[Conn], DeltaTick);
-
-						m_SnapCrcErrors++;
-						if(m_SnapCrcErrors > 10)
-						{
-							// to many errors, send reset
-							m_aAckGameTick[Conn] = -1;
-							SendInput();
-							m_SnapCrcErrors = 0;
-						}
-						return;
-					}
-					else
-					{
-						if(m_SnapCrcErrors)
-							m_SnapCrcErrors--;
-					}
-
-					// purge old snapshots
-					int PurgeTick = DeltaTick;
-					if(m_aapSnapshots[Conn][SNAP_PREV] && m_aapSnapshots[Conn][SNAP_PREV]->m_Tick < PurgeTick)
-						PurgeTick = m_aapSnapshots[Conn][SNAP_PREV]->m_Tick;
-					if(m_aapSnapshots[Conn][SNAP_CURRENT] && m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick < PurgeTick)
-						PurgeTick = m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick;
-					m_aSnapshotStorage[Conn].PurgeUntil(PurgeTick);
-
-					// create a verified and unpacked snapshot
-					int AltSnapSize = -1;
-					unsigned char aAltSnapBuffer[CSnapshot::MAX_SIZE];
-					CSnapshot *pAltSnapBuffer = (CSnapshot *)aAltSnapBuffer;
-
-					if(IsSixup())
-					{
-						unsigned char aTmpTransSnapBuffer[CSnapshot::MAX_SIZE];
-						CSnapshot *pTmpTransSnapBuffer = (CSnapshot *)aTmpTransSnapBuffer;
-						mem_copy(pTmpTransSnapBuffer, pTmpBuffer3, CSnapshot::MAX_SIZE);
-						AltSnapSize = GameClient()->TranslateSnap(pAltSnapBuffer, pTmpTransSnapBuffer, Conn, Dummy);
-					}
-					else
-					{
-						AltSnapSize = UnpackAndValidateSnapshot(pTmpBuffer3, pAltSnapBuffer);
-					}
-
-					if(AltSnapSize < 0)
+					// unpacked on the decoder thread, see `ProcessDecodedSnapshot`
+					CSnapshotDecoder::CJob *pJob = m_SnapshotDecoder.NewJob();
+					if(!pJob)
 					{
-						dbg_msg("client", "unpack snapshot and validate failed. error=%d", AltSnapSize);
+						// the server sends the next snapshot relative to the last acked one
+						log_debug("client", "snapshot decoder is busy, dropping snapshot. tick=%d", GameTick);
 						return;
 					}
 
-					// add new
-					m_aSnapshotStorage[Conn].Add(GameTick, time_get(), SnapSize, pTmpBuffer3, AltSnapSize, pAltSnapBuffer);
-
-					if(!Dummy)
-					{
-						GameClient()->ProcessDemoSnapshot(pTmpBuffer3);
-
-						unsigned char aSnapSeven[CSnapshot::MAX_SIZE];
-						CSnapshot *pSnapSeven = (CSnapshot *)aSnapSeven;
-						int DemoSnapSize = SnapSize;
-						if(IsSixup())
-						{
-							DemoSnapSize = GameClient()->OnDemoRecSnap7(pTmpBuffer3, pSnapSeven, Conn);
-							if(DemoSnapSize < 0)
-							{
-								dbg_msg("sixup", "demo snapshot failed. error=%d", DemoSnapSize);
-							}
-						}
-
-						if(DemoSnapSize >= 0)
-						{
-							// add snapshot to demo
-							for(auto &DemoRecorder : m_aDemoRecorder)
-							{
-								if(DemoRecorder.IsRecording())
-								{
-									// write snapshot
-									DemoRecorder.RecordSnapshot(GameTick, IsSixup() ? pSnapSeven : pTmpBuffer3, DemoSnapSize);
-								}
-							}
-						}
-					}
-
-					// apply snapshot, cycle pointers
-					m_aReceivedSnapshots[Conn]++;
-
-					// we got two snapshots until we see us self as connected
-					if(m_aReceivedSnapshots[Conn] == 2)
-					{
-						// start at 200ms and work from there
-						if(!Dummy)
-						{
-							m_PredictedTime.Init(GameTick * time_freq() / GameTickSpeed());
-							m_PredictedTime.SetAdjustSpeed(CSmoothTime::ADJUSTDIRECTION_UP, 1000.0f);
-							m_PredictedTime.UpdateMargin(PredictionMargin() * time_freq() / 1000);
-						}
-						m_aGameTime[Conn].Init((GameTick - 1) * time_freq() / GameTickSpeed());
-						m_aapSnapshots[Conn][SNAP_PREV] = m_aSnapshotStorage[Conn].m_pFirst;
-						m_aapSnapshots[Conn][SNAP_CURRENT] = m_aSnapshotStorage[Conn].m_pLast;
-						m_aPrevGameTick[Conn] = m_aapSnapshots[Conn][SNAP_PREV]->m_Tick;
-						m_aCurGameTick[Conn] = m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick;
-						if(Conn == CONN_MAIN)
-						{
-							m_LocalStartTime = time_get();
-#if defined(CONF_VIDEORECORDER)
-							IVideo::SetLocalStartTime(m_LocalStartTime);
-#endif
-						}
-						if(!Dummy)
-						{
-							GameClient()->OnNewSnapshot();
-						}
-						SetState(IClient::STATE_ONLINE);
-						if(Conn == CONN_MAIN)
-						{
-							DemoRecorder_HandleAutoStart();
-						}
-					}
-
-					// adjust game time
-					if(m_aReceivedSnapshots[Conn] > 2)
-					{
-						int64_t Now = m_aGameTime[Conn].Get(time_get());
-						int64_t TickStart = GameTick * time_freq() / GameTickSpeed();
-						int64_t TimeLeft = (TickStart - Now) * 1000 / time_freq();
-						m_aGameTime[Conn].Update(&m_aGametimeMarginGraphs[Conn], (GameTick - 1) * time_freq() / GameTickSpeed(), TimeLeft, CSmoothTime::ADJUSTDIRECTION_DOWN);
-					}
-
-					if(m_aReceivedSnapshots[Conn] > GameTickSpeed() && !m_aDidPostConnect[Conn])
-					{
-						OnPostConnect(Conn);
-						m_aDidPostConnect[Conn] = true;
-					}
-
-					// ack snapshot
-					m_aAckGameTick[Conn] = GameTick;
+					pJob->m_Conn = Conn;
+					pJob->m_GameTick = GameTick;
+					pJob->m_DeltaTick = DeltaTick;
+					pJob->m_PurgeTick = SnapshotPurgeTick(Conn, DeltaTick);
+					pJob->m_CheckCrc = Msg != NETMSG_SNAPEMPTY;
+					pJob->m_Crc = Crc;
+					pJob->m_Sixup = IsSixup();
+					pJob->m_ReceiveTime = time_get();
+					pJob->m_DataSize = m_aSnapshotIncomingDataSize[Conn];
+					mem_copy(pJob->m_aData, m_aaSnapshotIncomingData[Conn], pJob->m_DataSize);
+					m_SnapshotDecoder.Submit();
 				}
 			}
 		}
@@ -2320,6 +2170,197 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 	}
 }
 
+int CClient::SnapshotPurgeTick(int Conn, int DeltaTick) const
+{
+	int PurgeTick = DeltaTick;
+	if(m_aapSnapshots[Conn][SNAP_PREV] && m_aapSnapshots[Conn][SNAP_PREV]->m_Tick < PurgeTick)
+		PurgeTick = m_aapSnapshots[Conn][SNAP_PREV]->m_Tick;
+	if(m_aapSnapshots[Conn][SNAP_CURRENT] && m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick < PurgeTick)
+		PurgeTick = m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick;
+	return PurgeTick;
+}
+
+void CClient::ProcessDecodedSnapshots()
+{
+	while(CSnapshotDecoder::CJob *pJob = m_SnapshotDecoder.DecodedJob())
+	{
+		ProcessDecodedSnapshot(pJob);
+		m_SnapshotDecoder.PopDecodedJob();
+	}
+}
+
+void CClient::ProcessDecodedSnapshot(CSnapshotDecoder::CJob *pJob)
+{
+	const int Conn = pJob->m_Conn;
+	const bool Dummy = g_Config.m_ClDummy ^ Conn;
+	const int GameTick = pJob->m_GameTick;
+	const int DeltaTick = pJob->m_DeltaTick;
+
+	// the snapshots were reset or a newer snapshot was acked in the meantime
+	if(!m_SnapshotDecoder.IsCurrent(pJob) || State() < IClient::STATE_LOADING || GameTick <= m_aAckGameTick[Conn])
+	{
+		return;
+	}
+
+	switch(pJob->m_Result)
+	{
+	case CSnapshotDecoder::RESULT_SUCCESS:
+		break;
+	case CSnapshotDecoder::RESULT_MISSING_DELTA:
+		// couldn't find the delta snapshots that the server used
+		// to compress this snapshot. force the server to resync
+		if(g_Config.m_Debug)
+		{
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "client", "error, couldn't find the delta snapshot");
+		}
+
+		// ack snapshot
+		m_aAckGameTick[Conn] = -1;
+		SendInput();
+		return;
+	case CSnapshotDecoder::RESULT_DECOMPRESS_FAILED:
+		return;
+	case CSnapshotDecoder::RESULT_UNPACK_FAILED:
+		dbg_msg("client", "delta unpack failed. error=%d", pJob->m_UnpackError);
+		return;
+	case CSnapshotDecoder::RESULT_INVALID:
+		dbg_msg("client", "snapshot invalid. SnapSize=%d, DeltaSize=%d", pJob->m_SnapSize, pJob->m_DeltaSize);
+		return;
+	case CSnapshotDecoder::RESULT_CRC_MISMATCH:
+		log_error("client", "snapshot crc error #%d - tick=%d wantedcrc=%d gotcrc=%d compressed_size=%d delta_tick=%d",
+			m_SnapCrcErrors, GameTick, pJob->m_Crc, pJob->Snapshot()->Crc(), pJob->m_DataSize, DeltaTick);
+
+		m_SnapCrcErrors++;
+		if(m_SnapCrcErrors > 10)
+		{
+			// to many errors, send reset
+			m_aAckGameTick[Conn] = -1;
+			SendInput();
+			m_SnapCrcErrors = 0;
+		}
+		return;
+	}
+
+	if(m_SnapCrcErrors)
+		m_SnapCrcErrors--;
+
+	CSnapshot *pSnapshot = pJob->Snapshot();
+	const int SnapSize = pJob->m_SnapSize;
+
+	// purge old snapshots
+	m_aSnapshotStorage[Conn].PurgeUntil(SnapshotPurgeTick(Conn, DeltaTick));
+
+	// create a verified and unpacked snapshot
+	int AltSnapSize = -1;
+	unsigned char aAltSnapBuffer[CSnapshot::MAX_SIZE];
+	CSnapshot *pAltSnapBuffer = (CSnapshot *)aAltSnapBuffer;
+
+	if(IsSixup())
+	{
+		unsigned char aTmpTransSnapBuffer[CSnapshot::MAX_SIZE];
+		CSnapshot *pTmpTransSnapBuffer = (CSnapshot *)aTmpTransSnapBuffer;
+		mem_copy(pTmpTransSnapBuffer, pSnapshot, CSnapshot::MAX_SIZE);
+		AltSnapSize = GameClient()->TranslateSnap(pAltSnapBuffer, pTmpTransSnapBuffer, Conn, Dummy);
+	}
+	else
+	{
+		AltSnapSize = UnpackAndValidateSnapshot(pSnapshot, pAltSnapBuffer);
+	}
+
+	if(AltSnapSize < 0)
+	{
+		dbg_msg("client", "unpack snapshot and validate failed. error=%d", AltSnapSize);
+		return;
+	}
+
+	// add new
+	m_aSnapshotStorage[Conn].Add(GameTick, pJob->m_ReceiveTime, SnapSize, pSnapshot, AltSnapSize, pAltSnapBuffer);
+
+	if(!Dummy)
+	{
+		GameClient()->ProcessDemoSnapshot(pSnapshot);
+
+		unsigned char aSnapSeven[CSnapshot::MAX_SIZE];
+		CSnapshot *pSnapSeven = (CSnapshot *)aSnapSeven;
+		int DemoSnapSize = SnapSize;
+		if(IsSixup())
+		{
+			DemoSnapSize = GameClient()->OnDemoRecSnap7(pSnapshot, pSnapSeven, Conn);
+			if(DemoSnapSize < 0)
+			{
+				dbg_msg("sixup", "demo snapshot failed. error=%d", DemoSnapSize);
+			}
+		}
+
+		if(DemoSnapSize >= 0)
+		{
+			// add snapshot to demo
+			for(auto &DemoRecorder : m_aDemoRecorder)
+			{
+				if(DemoRecorder.IsRecording())
+				{
+					// write snapshot
+					DemoRecorder.RecordSnapshot(GameTick, IsSixup() ? pSnapSeven : pSnapshot, DemoSnapSize);
+				}
+			}
+		}
+	}
+
+	// apply snapshot, cycle pointers
+	m_aReceivedSnapshots[Conn]++;
+
+	// we got two snapshots until we see us self as connected
+	if(m_aReceivedSnapshots[Conn] == 2)
+	{
+		// start at 200ms and work from there
+		if(!Dummy)
+		{
+			m_PredictedTime.Init(GameTick * time_freq() / GameTickSpeed());
+			m_PredictedTime.SetAdjustSpeed(CSmoothTime::ADJUSTDIRECTION_UP, 1000.0f);
+			m_PredictedTime.UpdateMargin(PredictionMargin() * time_freq() / 1000);
+		}
+		m_aGameTime[Conn].Init((GameTick - 1) * time_freq() / GameTickSpeed());
+		m_aapSnapshots[Conn][SNAP_PREV] = m_aSnapshotStorage[Conn].m_pFirst;
+		m_aapSnapshots[Conn][SNAP_CURRENT] = m_aSnapshotStorage[Conn].m_pLast;
+		m_aPrevGameTick[Conn] = m_aapSnapshots[Conn][SNAP_PREV]->m_Tick;
+		m_aCurGameTick[Conn] = m_aapSnapshots[Conn][SNAP_CURRENT]->m_Tick;
+		if(Conn == CONN_MAIN)
+		{
+			m_LocalStartTime = time_get();
+#if defined(CONF_VIDEORECORDER)
+			IVideo::SetLocalStartTime(m_LocalStartTime);
+#endif
+		}
+		if(!Dummy)
+		{
+			GameClient()->OnNewSnapshot();
+		}
+		SetState(IClient::STATE_ONLINE);
+		if(Conn == CONN_MAIN)
+		{
+			DemoRecorder_HandleAutoStart();
+		}
+	}
+
+	// adjust game time, relative to when the snapshot was received
+	if(m_aReceivedSnapshots[Conn] > 2)
+	{
+		int64_t Now = m_aGameTime[Conn].Get(pJob->m_ReceiveTime);
+		int64_t TickStart = GameTick * time_freq() / GameTickSpeed();
+		int64_t TimeLeft = (TickStart - Now) * 1000 / time_freq();
+		m_aGameTime[Conn].Update(&m_aGametimeMarginGraphs[Conn], (GameTick - 1) * time_freq() / GameTickSpeed(), TimeLeft, CSmoothTime::ADJUSTDIRECTION_DOWN);
+	}
+
+	if(m_aReceivedSnapshots[Conn] > GameTickSpeed() && !m_aDidPostConnect[Conn])
+	{
+		OnPostConnect(Conn);
+		m_aDidPostConnect[Conn] = true;
+	}
+
+	// ack snapshot
+	m_aAckGameTick[Conn] = GameTick;
+}
+
 int CClient::UnpackAndValidateSnapshot(CSnapshot *pFrom, CSnapshot *pTo)
 {
 	CUnpacker Unpacker;
@@ -2359,6 +2400,31 @@ int CClient::UnpackAndValidateSnapshot(CSnapshot *pFrom, CSnapshot *pTo)
 	return Builder.Finish(pTo);
 }
 
+void CClient::StartMapHttpDownload(bool Ranged)
+{
+	const CTimeout Timeout{g_Config.m_ClMapDownloadConnectTimeoutMs, 0, g_Config.m_ClMapDownloadLowSpeedLimit, g_Config.m_ClMapDownloadLowSpeedTime};
+	if(Ranged)
+	{
+		// large maps are downloaded in pieces over several connections and
+		// continue from the part file after an interrupted download
+		m_pMapdownloadRangedTask = std::make_shared<CHttpRangedDownload>(m_aMapdownloadUrl, Storage(), m_aMapdownloadFilenamePart, m_aMapdownloadFilenameTemp, IStorage::TYPE_SAVE, m_MapdownloadTotalsize, m_MapdownloadSha256.value());
+		m_pMapdownloadRangedTask->Timeout(Timeout);
+		m_pMapdownloadRangedTask->Connections(g_Config.m_ClMapDownloadConnections);
+		m_pMapdownloadRangedTask->JobPool(Engine()->JobPool());
+		m_pMapdownloadRangedTask->Start(Http());
+		if(m_pMapdownloadRangedTask->ResumedSize() > 0)
+			log_info("webdl", "resuming map download at %" PRId64 " of %d bytes", m_pMapdownloadRangedTask->ResumedSize(), m_MapdownloadTotalsize);
+	}
+	else
+	{
+		m_pMapdownloadTask = HttpGetFile(m_aMapdownloadUrl, Storage(), m_aMapdownloadFilenameTemp, IStorage::TYPE_SAVE);
+		m_pMapdownloadTask->Timeout(Timeout);
+		m_pMapdownloadTask->MaxResponseSize(m_MapdownloadTotalsize);
+		m_pMapdownloadTask->ExpectSha256(m_MapdownloadSha256.value());
+		Http()->Run(m_pMapdownloadTask);
+	}
+}
+
 void CClient::ResetMapDownload(bool ResetActive)
 {
 	if(m_pMapdownloadTask)
@@ -2367,6 +2433,12 @@ void CClient::ResetMapDownload(bool ResetActive)
 		m_pMapdownloadTask = nullptr;
 	}
 
+	if(m_pMapdownloadRangedTask)
+	{
+		m_pMapdownloadRangedTask->Abort();
+		m_pMapdownloadRangedTask = nullptr;
+	}
+
 	if(m_MapdownloadFileTemp)
 	{
 		io_close(m_MapdownloadFileTemp);
@@ -2387,7 +2459,9 @@ void CClient::ResetMapDownload(bool ResetActive)
 		m_MapdownloadAmount = 0;
 		m_aMapdownloadFilename[0] = '\0';
 		m_aMapdownloadFilenameTemp[0] = '\0';
+		m_aMapdownloadFilenamePart[0] = '\0';
 		m_aMapdownloadName[0] = '\0';
+		m_aMapdownloadUrl[0] = '\0';
 	}
 }
 
@@ -2409,11 +2483,14 @@ void CClient::FinishMapDownload()
 	const char *pError = LoadMap(m_aMapdownloadName, m_aMapdownloadFilename, m_MapdownloadSha256, m_MapdownloadCrc);
 	if(!pError)
 	{
+		// left behind by a ranged download that fell back to another one
+		if(Storage()->FileExists(m_aMapdownloadFilenamePart, IStorage::TYPE_SAVE))
+			Storage()->RemoveFile(m_aMapdownloadFilenamePart, IStorage::TYPE_SAVE);
 		ResetMapDownload(true);
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "client/network", "loading done");
 		SendReady(CONN_MAIN);
 	}
-	else if(m_pMapdownloadTask) // fallback
+	else if(m_pMapdownloadTask || m_pMapdownloadRangedTask) // fallback
 	{
 		ResetMapDownload(false);
 		SendMapRequest();
@@ -2632,6 +2709,8 @@ void CClient::PumpNetwork()
 			}
 		}
 	}
+
+	ProcessDecodedSnapshots();
 }
 
 void CClient::OnDemoPlayerSnapshot(void *pData, int Size)
@@ -2919,7 +2998,21 @@ void CClient::Update()
 		}
 	}
 
-	if(m_pMapdownloadTask)
+	if(m_pMapdownloadRangedTask)
+	{
+		if(m_pMapdownloadRangedTask->State() == EHttpState::DONE)
+			FinishMapDownload();
+		else if(m_pMapdownloadRangedTask->State() == EHttpState::ERROR)
+		{
+			dbg_msg("webdl", "ranged http download failed, falling back to a single request");
+			ResetMapDownload(false);
+			// the part file is not continued by the single request
+			if(Storage()->FileExists(m_aMapdownloadFilenamePart, IStorage::TYPE_SAVE))
+				Storage()->RemoveFile(m_aMapdownloadFilenamePart, IStorage::TYPE_SAVE);
+			StartMapHttpDownload(false);
+		}
+	}
+	else if(m_pMapdownloadTask)
 	{
 		if(m_pMapdownloadTask->State() == EHttpState::DONE)
 			FinishMapDownload();
@@ -3089,6 +3182,7 @@ void CClient::Run()
 		ShowMessageBox({.m_pTitle = "Network Error", .m_pMessage = aNetworkError});
 		return;
 	}
+	m_SnapshotDecoder.Init();
 
 	if(!m_Http.Init(std::chrono::seconds{1}))
 	{
@@ -3429,6 +3523,7 @@ void CClient::Run()
 
 	m_Fifo.Shutdown();
 	m_Http.Shutdown();
+	m_SnapshotDecoder.Shutdown();
 	Engine()->ShutdownJobs();
 
 	GameClient()->RenderShutdownMessage();
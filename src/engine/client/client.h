@@ -22,6 +22,7 @@
 #include <engine/shared/fifo.h>
 #include <engine/shared/http.h>
 #include <engine/shared/network.h>
+#include <engine/shared/snapshot_decoder.h>
 #include <engine/textrender.h>
 #include <engine/warning.h>
 
@@ -141,8 +142,12 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	// map download
 	char m_aMapDownloadUrl[256] = "";
 	std::shared_ptr<CHttpRequest> m_pMapdownloadTask = nullptr;
+	std::shared_ptr<CHttpRangedDownload> m_pMapdownloadRangedTask = nullptr;
+	char m_aMapdownloadUrl[256] = "";
 	char m_aMapdownloadFilename[256] = "";
 	char m_aMapdownloadFilenameTemp[256] = "";
+	// continued by ranged downloads, removed once the map is downloaded otherwise
+	char m_aMapdownloadFilenamePart[IO_MAX_PATH_LENGTH] = "";
 	char m_aMapdownloadName[256] = "";
 	IOHANDLE m_MapdownloadFileTemp = nullptr;
 	int m_MapdownloadChunk = 0;
@@ -205,6 +210,7 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	char m_aaaDemorecSnapshotData[NUM_SNAPSHOT_TYPES][2][CSnapshot::MAX_SIZE];
 
 	CSnapshotDelta m_SnapshotDelta;
+	CSnapshotDecoder m_SnapshotDecoder;
 
 	std::deque<std::shared_ptr<CDemoEdit>> m_EditJobs;
 
@@ -380,9 +386,13 @@ public:
 	void ProcessConnlessPacket(CNetChunk *pPacket);
 	void ProcessServerInfo(int Type, NETADDR *pFrom, const void *pData, int DataSize);
 	void ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy);
+	int SnapshotPurgeTick(int Conn, int DeltaTick) const;
+	void ProcessDecodedSnapshots();
+	void ProcessDecodedSnapshot(CSnapshotDecoder::CJob *pJob);
 
 	int UnpackAndValidateSnapshot(CSnapshot *pFrom, CSnapshot *pTo);
 
+	void StartMapHttpDownload(bool Ranged);
 	void ResetMapDownload(bool ResetActive);
 	void FinishMapDownload();
 
@@ -397,8 +407,18 @@ public:
 	int ConnectNetTypes() const override;
 	const char *ConnectAddressString() const override { return m_aConnectAddressStr; }
 	const char *MapDownloadName() const override { return m_aMapdownloadName; }
-	int MapDownloadAmount() const override { return !m_pMapdownloadTask ? m_MapdownloadAmount : (int)m_pMapdownloadTask->Current(); }
-	int MapDownloadTotalsize() const override { return !m_pMapdownloadTask ? m_MapdownloadTotalsize : (int)m_pMapdownloadTask->Size(); }
+	int MapDownloadAmount() const override
+	{
+		if(m_pMapdownloadRangedTask)
+			return (int)m_pMapdownloadRangedTask->Current();
+		return !m_pMapdownloadTask ? m_MapdownloadAmount : (int)m_pMapdownloadTask->Current();
+	}
+	int MapDownloadTotalsize() const override
+	{
+		if(m_pMapdownloadRangedTask)
+			return (int)m_pMapdownloadRangedTask->Size();
+		return !m_pMapdownloadTask ? m_MapdownloadTotalsize : (int)m_pMapdownloadTask->Size();
+	}
 
 	void PumpNetwork();
 
@@ -28,33 +28,36 @@
 #include <set>
 #include <vector>
 
-class CSortWrap
-{
-	typedef bool (CServerBrowser::*SortFunc)(int, int) const;
-	SortFunc m_pfnSort;
-	CServerBrowser *m_pThis;
-
-public:
-	CSortWrap(CServerBrowser *pServer, SortFunc Func) :
-		m_pfnSort(Func), m_pThis(pServer) {}
-	bool operator()(int a, int b) { return (g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b)); }
-};
-
-static bool MatchesPart(const char *a, const char *b)
+static NETADDR CommunityAddressKey(const NETADDR &Addr)
 {
-	return str_utf8_find_nocase(a, b) != nullptr;
+	NETADDR AddressKey = Addr;
+	AddressKey.type &= ~NETTYPE_TW7;
+	return AddressKey;
 }
 
-static bool MatchesExactly(const char *a, const char *b)
+void CServerSearchKeys::Update(const CServerInfo &Info)
 {
-	return str_comp(a, &b[1]) == 0;
+	str_utf8_tolower(Info.m_aName, m_aName, sizeof(m_aName));
+	str_utf8_tolower(Info.m_aMap, m_aMap, sizeof(m_aMap));
+	str_utf8_tolower(Info.m_aGameType, m_aGameType, sizeof(m_aGameType));
+
+	const int NumClients = minimum(Info.m_NumClients, (int)MAX_CLIENTS);
+	m_vClientNames.resize(NumClients);
+	m_vClientClans.resize(NumClients);
+	for(int p = 0; p < NumClients; p++)
+	{
+		char aName[sizeof(Info.m_aClients[p].m_aName) * 2];
+		char aClan[sizeof(Info.m_aClients[p].m_aClan) * 2];
+		str_utf8_tolower(Info.m_aClients[p].m_aName, aName, sizeof(aName));
+		str_utf8_tolower(Info.m_aClients[p].m_aClan, aClan, sizeof(aClan));
+		m_vClientNames[p] = aName;
+		m_vClientClans[p] = aClan;
+	}
 }
 
-static NETADDR CommunityAddressKey(const NETADDR &Addr)
+bool CServerSearchKeys::Matches(const char *pFoldedKey, const char *pFoldedNeedle)
 {
-	NETADDR AddressKey = Addr;
-	AddressKey.type &= ~NETTYPE_TW7;
-	return AddressKey;
+	return str_find(pFoldedKey, pFoldedNeedle) != nullptr;
 }
 
 CServerBrowser::CServerBrowser() :
@@ -417,196 +420,251 @@ bool CServerBrowser::SortCompareNumPlayersAndPing(int Index1, int Index2) const
 		return pIndex1->m_Info.m_Latency > pIndex2->m_Info.m_Latency;
 }
 
-void CServerBrowser::Filter()
+bool CServerBrowser::SortCompare(int Index1, int Index2) const
 {
-	m_NumSortedPlayers = 0;
-
-	m_vSortedServerlist.clear();
-	m_vSortedServerlist.reserve(m_vpServerlist.size());
+	typedef bool (CServerBrowser::*SortFunc)(int, int) const;
+	SortFunc pfnSort = nullptr;
+	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
+		pfnSort = &CServerBrowser::SortCompareNumPlayersAndPing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
+		pfnSort = &CServerBrowser::SortCompareName;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		pfnSort = &CServerBrowser::SortComparePing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
+		pfnSort = &CServerBrowser::SortCompareMap;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMFRIENDS)
+		pfnSort = &CServerBrowser::SortCompareNumFriends;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
+		pfnSort = &CServerBrowser::SortCompareNumPlayers;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
+		pfnSort = &CServerBrowser::SortCompareGametype;
 
-	for(auto &Community : m_vCommunities)
-	{
-		Community.m_NumPlayers = 0;
-	}
+	if(!pfnSort)
+		return false;
+	return g_Config.m_BrSortOrder ? (this->*pfnSort)(Index2, Index1) : (this->*pfnSort)(Index1, Index2);
+}
 
-	// filter the servers
-	for(int ServerIndex = 0; ServerIndex < (int)m_vpServerlist.size(); ServerIndex++)
-	{
-		CServerInfo &Info = m_vpServerlist[ServerIndex]->m_Info;
-		bool Filtered = false;
+bool CServerBrowser::ParseSearchTokens()
+{
+	if(m_ParsedFilterString == g_Config.m_BrFilterString && m_ParsedExcludeString == g_Config.m_BrExcludeString)
+		return false;
 
-		if(g_Config.m_BrFilterEmpty && Info.m_NumFilteredPlayers == 0)
-			Filtered = true;
-		else if(g_Config.m_BrFilterFull && Players(Info) == Max(Info))
-			Filtered = true;
-		else if(g_Config.m_BrFilterPw && Info.m_Flags & SERVER_FLAG_PASSWORD)
-			Filtered = true;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = true;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = true;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = true;
-		else if(g_Config.m_BrFilterUnfinishedMap && Info.m_HasRank == CServerInfo::RANK_RANKED)
-			Filtered = true;
-		else if(g_Config.m_BrFilterLogin && Info.m_RequiresLogin)
-			Filtered = true;
-		else
+	auto &&ParseTokens = [](const char *pSearch, std::vector<CSearchToken> &vTokens) {
+		vTokens.clear();
+		char aToken[maximum(sizeof(g_Config.m_BrFilterString), sizeof(g_Config.m_BrExcludeString))];
+		char aTokenTrimmed[sizeof(aToken)];
+		char aTokenFolded[sizeof(aToken) * 2];
+		while((pSearch = str_next_token(pSearch, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aToken, sizeof(aToken))))
 		{
-			if(!Communities().empty())
+			str_copy(aTokenTrimmed, str_utf8_skip_whitespaces(aToken));
+			str_utf8_trim_right(aTokenTrimmed);
+
+			if(aTokenTrimmed[0] == '\0')
 			{
-				if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES)
-				{
-					Filtered = CommunitiesFilter().Filtered(Info.m_aCommunityId);
-				}
-				if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES ||
-					(m_ServerlistType >= IServerBrowser::TYPE_FAVORITE_COMMUNITY_1 && m_ServerlistType <= IServerBrowser::TYPE_FAVORITE_COMMUNITY_5))
-				{
-					Filtered = Filtered || CountriesFilter().Filtered(Info.m_aCommunityCountry);
-					Filtered = Filtered || TypesFilter().Filtered(Info.m_aCommunityType);
-				}
+				continue;
 			}
-
-			if(!Filtered && g_Config.m_BrFilterCountry)
+			CSearchToken Token;
+			Token.m_Exact = false;
+			const int TokenLen = str_length(aTokenTrimmed);
+			if(TokenLen >= 2 && aTokenTrimmed[0] == '"' && aTokenTrimmed[TokenLen - 1] == '"')
 			{
-				Filtered = true;
-				// match against player country
-				for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				// a pair of quotes without anything in between matches nothing useful
+				if(TokenLen == 2)
 				{
-					if(Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = false;
-						break;
-					}
+					continue;
 				}
+				aTokenTrimmed[TokenLen - 1] = '\0';
+				Token.m_Exact = true;
 			}
+			Token.m_Original = aTokenTrimmed;
+			str_utf8_tolower(aTokenTrimmed, aTokenFolded, sizeof(aTokenFolded));
+			Token.m_Folded = aTokenFolded;
+			vTokens.push_back(std::move(Token));
+		}
+	};
+
+	m_ParsedFilterString = g_Config.m_BrFilterString;
+	m_ParsedExcludeString = g_Config.m_BrExcludeString;
+	ParseTokens(g_Config.m_BrFilterString, m_vFilterTokens);
+	ParseTokens(g_Config.m_BrExcludeString, m_vExcludeTokens);
+	return true;
+}
+
+bool CServerBrowser::IsFiltered(int ServerIndex)
+{
+	CServerInfo &Info = m_vpServerlist[ServerIndex]->m_Info;
+	const CServerSearchKeys &Keys = m_vServerViewStates[ServerIndex].m_SearchKeys;
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != '\0')
+	auto &&Matches = [](const char *pOriginal, const char *pFolded, const CSearchToken &Token) {
+		if(Token.m_Exact)
+			return str_comp(pOriginal, &Token.m_Original[1]) == 0;
+		return CServerSearchKeys::Matches(pFolded, Token.m_Folded.c_str());
+	};
+
+	bool Filtered = false;
+
+	if(g_Config.m_BrFilterEmpty && Info.m_NumFilteredPlayers == 0)
+		Filtered = true;
+	else if(g_Config.m_BrFilterFull && Players(Info) == Max(Info))
+		Filtered = true;
+	else if(g_Config.m_BrFilterPw && Info.m_Flags & SERVER_FLAG_PASSWORD)
+		Filtered = true;
+	else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(Info.m_aAddress, g_Config.m_BrFilterServerAddress))
+		Filtered = true;
+	else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = true;
+	else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = true;
+	else if(g_Config.m_BrFilterUnfinishedMap && Info.m_HasRank == CServerInfo::RANK_RANKED)
+		Filtered = true;
+	else if(g_Config.m_BrFilterLogin && Info.m_RequiresLogin)
+		Filtered = true;
+	else
+	{
+		if(!Communities().empty())
+		{
+			if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES)
+			{
+				Filtered = CommunitiesFilter().Filtered(Info.m_aCommunityId);
+			}
+			if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES ||
+				(m_ServerlistType >= IServerBrowser::TYPE_FAVORITE_COMMUNITY_1 && m_ServerlistType <= IServerBrowser::TYPE_FAVORITE_COMMUNITY_5))
 			{
-				Info.m_QuickSearchHit = 0;
+				Filtered = Filtered || CountriesFilter().Filtered(Info.m_aCommunityCountry);
+				Filtered = Filtered || TypesFilter().Filtered(Info.m_aCommunityType);
+			}
+		}
 
-				const char *pStr = g_Config.m_BrFilterString;
-				char aFilterStr[sizeof(g_Config.m_BrFilterString)];
-				char aFilterStrTrimmed[sizeof(g_Config.m_BrFilterString)];
-				while((pStr = str_next_token(pStr, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aFilterStr, sizeof(aFilterStr))))
+		if(!Filtered && g_Config.m_BrFilterCountry)
+		{
+			Filtered = true;
+			// match against player country
+			for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+			{
+				if(Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
 				{
-					str_copy(aFilterStrTrimmed, str_utf8_skip_whitespaces(aFilterStr));
-					str_utf8_trim_right(aFilterStrTrimmed);
+					Filtered = false;
+					break;
+				}
+			}
+		}
 
-					if(aFilterStrTrimmed[0] == '\0')
-					{
-						continue;
-					}
-					auto MatchesFn = MatchesPart;
-					const int FilterLen = str_length(aFilterStrTrimmed);
-					if(aFilterStrTrimmed[0] == '"' && aFilterStrTrimmed[FilterLen - 1] == '"')
-					{
-						aFilterStrTrimmed[FilterLen - 1] = '\0';
-						MatchesFn = MatchesExactly;
-					}
+		if(!Filtered && g_Config.m_BrFilterString[0] != '\0')
+		{
+			Info.m_QuickSearchHit = 0;
 
-					// match against server name
-					if(MatchesFn(Info.m_aName, aFilterStrTrimmed))
-					{
-						Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-					}
+			for(const CSearchToken &Token : m_vFilterTokens)
+			{
+				// match against server name
+				if(Matches(Info.m_aName, Keys.m_aName, Token))
+				{
+					Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+				}
 
-					// match against players
-					for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				// match against players
+				for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				{
+					if(Matches(Info.m_aClients[p].m_aName, Keys.m_vClientNames[p].c_str(), Token) ||
+						Matches(Info.m_aClients[p].m_aClan, Keys.m_vClientClans[p].c_str(), Token))
 					{
-						if(MatchesFn(Info.m_aClients[p].m_aName, aFilterStrTrimmed) ||
-							MatchesFn(Info.m_aClients[p].m_aClan, aFilterStrTrimmed))
+						if(g_Config.m_BrFilterConnectingPlayers &&
+							str_comp(Info.m_aClients[p].m_aName, "(connecting)") == 0 &&
+							Info.m_aClients[p].m_aClan[0] == '\0')
 						{
-							if(g_Config.m_BrFilterConnectingPlayers &&
-								str_comp(Info.m_aClients[p].m_aName, "(connecting)") == 0 &&
-								Info.m_aClients[p].m_aClan[0] == '\0')
-							{
-								continue;
-							}
-							Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-							break;
+							continue;
 						}
-					}
-
-					// match against map
-					if(MatchesFn(Info.m_aMap, aFilterStrTrimmed))
-					{
-						Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+						Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+						break;
 					}
 				}
 
-				if(!Info.m_QuickSearchHit)
-					Filtered = true;
+				// match against map
+				if(Matches(Info.m_aMap, Keys.m_aMap, Token))
+				{
+					Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+				}
 			}
 
-			if(!Filtered && g_Config.m_BrExcludeString[0] != '\0')
+			if(!Info.m_QuickSearchHit)
+				Filtered = true;
+		}
+
+		if(!Filtered && g_Config.m_BrExcludeString[0] != '\0')
+		{
+			for(const CSearchToken &Token : m_vExcludeTokens)
 			{
-				const char *pStr = g_Config.m_BrExcludeString;
-				char aExcludeStr[sizeof(g_Config.m_BrExcludeString)];
-				char aExcludeStrTrimmed[sizeof(g_Config.m_BrExcludeString)];
-				while((pStr = str_next_token(pStr, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aExcludeStr, sizeof(aExcludeStr))))
+				// match against server name, map and gametype
+				if(Matches(Info.m_aName, Keys.m_aName, Token) ||
+					Matches(Info.m_aMap, Keys.m_aMap, Token) ||
+					Matches(Info.m_aGameType, Keys.m_aGameType, Token))
 				{
-					str_copy(aExcludeStrTrimmed, str_utf8_skip_whitespaces(aExcludeStr));
-					str_utf8_trim_right(aExcludeStrTrimmed);
+					Filtered = true;
+					break;
+				}
+			}
+		}
+	}
 
-					if(aExcludeStrTrimmed[0] == '\0')
-					{
-						continue;
-					}
-					auto MatchesFn = MatchesPart;
-					const int FilterLen = str_length(aExcludeStrTrimmed);
-					if(aExcludeStrTrimmed[0] == '"' && aExcludeStrTrimmed[FilterLen - 1] == '"')
-					{
-						aExcludeStrTrimmed[FilterLen - 1] = '\0';
-						MatchesFn = MatchesExactly;
-					}
+	return Filtered;
+}
 
-					// match against server name
-					if(MatchesFn(Info.m_aName, aExcludeStrTrimmed))
-					{
-						Filtered = true;
-						break;
-					}
+void CServerBrowser::EvaluateServer(int ServerIndex)
+{
+	CServerInfo &Info = m_vpServerlist[ServerIndex]->m_Info;
+	CServerViewState &State = m_vServerViewStates[ServerIndex];
 
-					// match against map
-					if(MatchesFn(Info.m_aMap, aExcludeStrTrimmed))
-					{
-						Filtered = true;
-						break;
-					}
+	if(State.m_SearchKeysOutdated)
+	{
+		State.m_SearchKeys.Update(Info);
+		State.m_SearchKeysOutdated = false;
+	}
 
-					// match against gametype
-					if(MatchesFn(Info.m_aGameType, aExcludeStrTrimmed))
-					{
-						Filtered = true;
-						break;
-					}
-				}
-			}
-		}
+	const bool Filtered = IsFiltered(ServerIndex);
+	UpdateServerFriends(&Info);
 
-		UpdateServerFriends(&Info);
+	State.m_Listed = !Filtered && (!g_Config.m_BrFilterFriends || Info.m_FriendState != IFriends::FRIEND_NO);
+	State.m_NumSortedPlayers = State.m_Listed ? Info.m_NumFilteredPlayers : 0;
+	m_NumSortedPlayers += State.m_NumSortedPlayers;
 
-		if(!Filtered)
+	State.m_NumCommunityPlayers = 0;
+	if(Info.m_NumClients > 0)
+	{
+		auto Community = std::find_if(m_vCommunities.begin(), m_vCommunities.end(), [&Info](const auto &Elem) {
+			return str_comp(Elem.Id(), Info.m_aCommunityId) == 0;
+		});
+		if(Community != m_vCommunities.end())
 		{
-			if(!g_Config.m_BrFilterFriends || Info.m_FriendState != IFriends::FRIEND_NO)
-			{
-				m_NumSortedPlayers += Info.m_NumFilteredPlayers;
-				m_vSortedServerlist.push_back(ServerIndex);
-			}
+			Community->m_NumPlayers += Info.m_NumClients;
+			State.m_NumCommunityPlayers = Info.m_NumClients;
 		}
+	}
+}
+
+void CServerBrowser::Filter()
+{
+	m_NumSortedPlayers = 0;
 
-		if(Info.m_NumClients > 0)
+	m_vSortedServerlist.clear();
+	m_vSortedServerlist.reserve(m_vpServerlist.size());
+
+	for(auto &Community : m_vCommunities)
+	{
+		Community.m_NumPlayers = 0;
+	}
+
+	ParseSearchTokens();
+
+	// filter the servers
+	for(int ServerIndex = 0; ServerIndex < (int)m_vpServerlist.size(); ServerIndex++)
+	{
+		m_vServerViewStates[ServerIndex].m_Dirty = false;
+		EvaluateServer(ServerIndex);
+		if(m_vServerViewStates[ServerIndex].m_Listed)
 		{
-			auto Community = std::find_if(m_vCommunities.begin(), m_vCommunities.end(), [Info](const auto &Elem) {
-				return str_comp(Elem.Id(), Info.m_aCommunityId) == 0;
-			});
-			if(Community != m_vCommunities.end())
-			{
-				Community->m_NumPlayers += Info.m_NumClients;
-			}
+			m_vSortedServerlist.push_back(ServerIndex);
 		}
 	}
+	m_vDirtyServers.clear();
 
 	std::stable_sort(m_vCommunities.begin(), m_vCommunities.end(), [](const CCommunity &Lhs, const CCommunity &Rhs) {
 		return Lhs.NumPlayers() > Rhs.NumPlayers();
@@ -642,24 +700,95 @@ void CServerBrowser::Sort()
 	Filter();
 
 	// sort
-	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareNumPlayersAndPing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortComparePing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareMap));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMFRIENDS)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareNumFriends));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareNumPlayers));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), CSortWrap(this, &CServerBrowser::SortCompareGametype));
+	std::stable_sort(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), [this](int Index1, int Index2) {
+		return SortCompare(Index1, Index2);
+	});
 
 	m_Sorthash = SortHash();
 }
 
+bool CServerBrowser::SortCompareStable(int Index1, int Index2) const
+{
+	// equal servers are ordered by index, same as after the stable sort of a full resort
+	if(SortCompare(Index1, Index2))
+		return true;
+	if(SortCompare(Index2, Index1))
+		return false;
+	return Index1 < Index2;
+}
+
+void CServerBrowser::MarkDirty(const CServerEntry *pEntry)
+{
+	CServerViewState &State = m_vServerViewStates[pEntry->m_Info.m_ServerIndex];
+	State.m_SearchKeysOutdated = true;
+	if(!State.m_Dirty)
+	{
+		State.m_Dirty = true;
+		m_vDirtyServers.push_back(pEntry->m_Info.m_ServerIndex);
+	}
+}
+
+void CServerBrowser::UpdateDirty()
+{
+	// the search strings can be changed without requesting a resort
+	if(ParseSearchTokens())
+	{
+		Sort();
+		return;
+	}
+
+	// take all changed servers out of the view first, the remaining ones stay in order
+	m_vSortedServerlist.erase(std::remove_if(m_vSortedServerlist.begin(), m_vSortedServerlist.end(), [this](int ServerIndex) {
+		return m_vServerViewStates[ServerIndex].m_Dirty;
+	}),
+		m_vSortedServerlist.end());
+	for(int ServerIndex : m_vDirtyServers)
+	{
+		CServerViewState &State = m_vServerViewStates[ServerIndex];
+		if(State.m_Listed)
+		{
+			m_NumSortedPlayers -= State.m_NumSortedPlayers;
+		}
+		if(State.m_NumCommunityPlayers > 0)
+		{
+			const CServerInfo &Info = m_vpServerlist[ServerIndex]->m_Info;
+			auto Community = std::find_if(m_vCommunities.begin(), m_vCommunities.end(), [&Info](const auto &Elem) {
+				return str_comp(Elem.Id(), Info.m_aCommunityId) == 0;
+			});
+			if(Community != m_vCommunities.end())
+			{
+				Community->m_NumPlayers -= State.m_NumCommunityPlayers;
+			}
+		}
+	}
+
+	// then evaluate them again and merge them into the view at their sorted position
+	std::vector<int> vListed;
+	for(int ServerIndex : m_vDirtyServers)
+	{
+		m_vServerViewStates[ServerIndex].m_Dirty = false;
+		UpdateServerFilteredPlayers(&m_vpServerlist[ServerIndex]->m_Info);
+		EvaluateServer(ServerIndex);
+		if(m_vServerViewStates[ServerIndex].m_Listed)
+		{
+			vListed.push_back(ServerIndex);
+		}
+	}
+	m_vDirtyServers.clear();
+
+	auto &&Compare = [this](int Index1, int Index2) {
+		return SortCompareStable(Index1, Index2);
+	};
+	std::sort(vListed.begin(), vListed.end(), Compare);
+	const size_t NumRemaining = m_vSortedServerlist.size();
+	m_vSortedServerlist.insert(m_vSortedServerlist.end(), vListed.begin(), vListed.end());
+	std::inplace_merge(m_vSortedServerlist.begin(), m_vSortedServerlist.begin() + NumRemaining, m_vSortedServerlist.end(), Compare);
+
+	std::stable_sort(m_vCommunities.begin(), m_vCommunities.end(), [](const CCommunity &Lhs, const CCommunity &Rhs) {
+		return Lhs.NumPlayers() > Rhs.NumPlayers();
+	});
+}
+
 void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
 {
 	if(pEntry->m_pPrevReq || pEntry->m_pNextReq || m_pFirstReqServer == pEntry)
@@ -864,8 +993,10 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR *pAddrs, int Num
 	if(m_vpServerlist.capacity() == 0)
 	{
 		m_vpServerlist.reserve(128);
+		m_vServerViewStates.reserve(128);
 	}
 	m_vpServerlist.push_back(pEntry);
+	m_vServerViewStates.emplace_back();
 
 	return pEntry;
 }
@@ -895,6 +1026,9 @@ CServerBrowser::CServerEntry *CServerBrowser::ReplaceEntry(CServerEntry *pEntry,
 		m_ByAddr[pAddrs[i]] = pEntry->m_Info.m_ServerIndex;
 	}
 
+	// the community might have changed, which the incremental update cannot account for
+	RequestResort();
+
 	return pEntry;
 }
 
@@ -963,6 +1097,7 @@ void CServerBrowser::OnServerInfoUpdate(const NETADDR &Addr, int Token, const CS
 		}
 	}
 
+	bool OtherLatenciesChanged = false;
 	if(m_ServerlistType == IServerBrowser::TYPE_LAN)
 	{
 		SetInfo(pEntry, *pInfo);
@@ -986,11 +1121,19 @@ void CServerBrowser::OnServerInfoUpdate(const NETADDR &Addr, int Token, const CS
 			net_addr_str(&Addr, aAddr, sizeof(aAddr), true);
 			dbg_msg("serverbrowser", "received ping response from %s", aAddr);
 			SetLatency(Addr, Latency);
+			OtherLatenciesChanged = true;
 		}
 		pEntry->m_RequestTime = -1; // Request has been answered
 	}
 	RemoveRequest(pEntry);
-	RequestResort();
+
+	// only this server has to be filtered and sorted again, unless the ping
+	// response updated the latency of other servers as well
+	MarkDirty(pEntry);
+	if(OtherLatenciesChanged)
+	{
+		RequestResort();
+	}
 }
 
 void CServerBrowser::Refresh(int Type, bool Force)
@@ -1262,6 +1405,8 @@ void CServerBrowser::CleanUp()
 	// clear out everything
 	m_vSortedServerlist.clear();
 	m_vpServerlist.clear();
+	m_vServerViewStates.clear();
+	m_vDirtyServers.clear();
 	m_ServerlistHeap.Reset();
 	m_NumSortedPlayers = 0;
 	m_ByAddr.clear();
@@ -1363,6 +1508,10 @@ void CServerBrowser::Update()
 		Sort();
 		m_NeedResort = false;
 	}
+	else if(!m_vDirtyServers.empty())
+	{
+		UpdateDirty();
+	}
 }
 
 const json_value *CServerBrowser::LoadDDNetInfo()
@@ -14,6 +14,8 @@
 #include <map>
 #include <optional>
 #include <set>
+#include <string>
+#include <vector>
 
 typedef struct _json_value json_value;
 class CNetClient;
@@ -142,6 +144,31 @@ public:
 	const char *TypeName() const { return m_aTypeName; }
 };
 
+/**
+ * Case-folded copies of the server info fields that the quick search
+ * matches against, so filtering does not have to fold them again for
+ * every search token on every resort.
+ */
+class CServerSearchKeys
+{
+public:
+	// lowercasing may increase the length of UTF-8 strings
+	char m_aName[sizeof(CServerInfo::m_aName) * 2];
+	char m_aMap[sizeof(CServerInfo::m_aMap) * 2];
+	char m_aGameType[sizeof(CServerInfo::m_aGameType) * 2];
+	std::vector<std::string> m_vClientNames;
+	std::vector<std::string> m_vClientClans;
+
+	void Update(const CServerInfo &Info);
+
+	/**
+	 * Checks whether the already case-folded search key contains the
+	 * case-folded needle, equivalent to `str_utf8_find_nocase` on the
+	 * original strings.
+	 */
+	static bool Matches(const char *pFoldedKey, const char *pFoldedNeedle);
+};
+
 class CFavoriteCommunityFilterList : public IFilterList
 {
 public:
@@ -319,6 +346,9 @@ public:
 	bool IsRegistered(const NETADDR &Addr);
 
 private:
+	// feeds server infos and compares the incremental with a full sort
+	friend class CTestServerBrowserView;
+
 	CNetClient *m_pNetClient = nullptr;
 	IConfigManager *m_pConfigManager = nullptr;
 	IConsole *m_pConsole = nullptr;
@@ -337,6 +367,33 @@ private:
 	CHeap m_ServerlistHeap;
 	std::vector<CServerEntry *> m_vpServerlist;
 	std::vector<int> m_vSortedServerlist;
+
+	// state of a server in the maintained filtered and sorted view, indexed like m_vpServerlist
+	class CServerViewState
+	{
+	public:
+		bool m_Listed = false;
+		bool m_Dirty = false;
+		bool m_SearchKeysOutdated = true;
+		int m_NumSortedPlayers = 0; // contribution to m_NumSortedPlayers
+		int m_NumCommunityPlayers = 0; // contribution to the player count of the server's community
+		CServerSearchKeys m_SearchKeys;
+	};
+	std::vector<CServerViewState> m_vServerViewStates;
+	std::vector<int> m_vDirtyServers;
+
+	// parsed and case-folded tokens of br_filter_string and br_exclude_string
+	class CSearchToken
+	{
+	public:
+		std::string m_Original;
+		std::string m_Folded;
+		bool m_Exact;
+	};
+	std::vector<CSearchToken> m_vFilterTokens;
+	std::vector<CSearchToken> m_vExcludeTokens;
+	std::string m_ParsedFilterString;
+	std::string m_ParsedExcludeString;
 	std::unordered_map<NETADDR, int> m_ByAddr;
 
 	std::vector<CCommunity> m_vCommunities;
@@ -387,6 +444,13 @@ private:
 	void Filter();
 	void Sort();
 	int SortHash() const;
+	bool SortCompare(int Index1, int Index2) const;
+	bool SortCompareStable(int Index1, int Index2) const;
+	bool ParseSearchTokens();
+	bool IsFiltered(int ServerIndex);
+	void EvaluateServer(int ServerIndex);
+	void MarkDirty(const CServerEntry *pEntry);
+	void UpdateDirty();
 
 	void CleanUp();
 
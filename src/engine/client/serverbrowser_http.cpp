@@ -50,7 +50,7 @@ static int ClassifyAge(int AgeSeconds)
 class CChooseMaster
 {
 public:
-	typedef bool (*VALIDATOR)(json_value *pJson);
+	typedef bool (*VALIDATOR)(const unsigned char *pData, size_t DataSize);
 
 	enum
 	{
@@ -259,15 +259,10 @@ void CChooseMaster::CJob::Run()
 		{
 			continue;
 		}
-		json_value *pJson = pGet->ResultJson();
-		if(!pJson)
-		{
-			continue;
-		}
-
-		bool ParseFailure = m_pData->m_pfnValidator(pJson);
-		json_value_free(pJson);
-		if(ParseFailure)
+		unsigned char *pResult;
+		size_t ResultLength;
+		pGet->Result(&pResult, &ResultLength);
+		if(m_pData->m_pfnValidator(pResult, ResultLength))
 		{
 			continue;
 		}
@@ -305,6 +300,27 @@ void CChooseMaster::CJob::Run()
 	m_pData->m_BestIndex.store(BestIndex);
 }
 
+class CServerListRequest : public CHttpRequest
+{
+	CServerListParser m_Parser;
+
+protected:
+	bool OnResponseData(const char *pData, size_t DataSize) override
+	{
+		return !m_Parser.Feed(pData, DataSize);
+	}
+
+public:
+	CServerListRequest(const char *pUrl) :
+		CHttpRequest(pUrl)
+	{
+		WriteToNothing();
+	}
+
+	// Only usable after the request is done.
+	CServerListParser &Parser() { return m_Parser; }
+};
+
 class CServerBrowserHttp : public IServerBrowserHttp
 {
 public:
@@ -334,13 +350,12 @@ private:
 		STATE_NO_MASTER,
 	};
 
-	static bool Validate(json_value *pJson);
-	static bool Parse(json_value *pJson, std::vector<CServerInfo> *pvServers);
+	static bool Validate(const unsigned char *pData, size_t DataSize);
 
 	IHttp *m_pHttp;
 
 	int m_State = STATE_WANTREFRESH;
-	std::shared_ptr<CHttpRequest> m_pGetServers;
+	std::shared_ptr<CServerListRequest> m_pGetServers;
 	std::unique_ptr<CChooseMaster> m_pChooseMaster;
 
 	std::vector<CServerInfo> m_vServers;
@@ -375,7 +390,7 @@ void CServerBrowserHttp::Update()
 			}
 			return;
 		}
-		m_pGetServers = HttpGet(pBestUrl);
+		m_pGetServers = std::make_shared<CServerListRequest>(pBestUrl);
 		// 10 seconds connection timeout, lower than 8KB/s for 10 seconds to fail.
 		m_pGetServers->Timeout(CTimeout{10000, 0, 8000, 10});
 		m_pHttp->Run(m_pGetServers);
@@ -388,14 +403,10 @@ void CServerBrowserHttp::Update()
 			return;
 		}
 		m_State = STATE_DONE;
-		std::shared_ptr<CHttpRequest> pGetServers = nullptr;
+		std::shared_ptr<CServerListRequest> pGetServers = nullptr;
 		std::swap(m_pGetServers, pGetServers);
 
-		bool Success = true;
-		json_value *pJson = pGetServers->State() == EHttpState::DONE ? pGetServers->ResultJson() : nullptr;
-		Success = Success && pJson;
-		Success = Success && !Parse(pJson, &m_vServers);
-		json_value_free(pJson);
+		bool Success = pGetServers->State() == EHttpState::DONE && !pGetServers->Parser().Finish();
 		if(!Success)
 		{
 			log_error("serverbrowser_http", "failed getting serverlist, trying to find best URL");
@@ -404,6 +415,8 @@ void CServerBrowserHttp::Update()
 		}
 		else
 		{
+			m_vServers = std::move(pGetServers->Parser().Servers());
+
 			// Try to find new master if the current one returns
 			// results that are 5 minutes old.
 			int Age = SanitizeAge(pGetServers->ResultAgeSeconds());
@@ -434,95 +447,325 @@ static bool ServerbrowserParseUrl(NETADDR *pOut, const char *pUrl)
 		return true;
 	return false;
 }
-bool CServerBrowserHttp::Validate(json_value *pJson)
+bool CServerBrowserHttp::Validate(const unsigned char *pData, size_t DataSize)
 {
-	std::vector<CServerInfo> vServers;
-	return Parse(pJson, &vServers);
+	CServerListParser Parser;
+	return Parser.Feed((const char *)pData, DataSize) || Parser.Finish();
 }
-bool CServerBrowserHttp::Parse(json_value *pJson, std::vector<CServerInfo> *pvServers)
-{
-	std::vector<CServerInfo> vServers;
 
-	const json_value &Json = *pJson;
-	const json_value &Servers = Json["servers"];
-	if(Servers.type != json_array)
+static bool ParseServerJson(const json_value &Server, std::vector<CServerInfo> *pvServers)
+{
+	const json_value &Addresses = Server["addresses"];
+	const json_value &Info = Server["info"];
+	const json_value &Location = Server["location"];
+	int ParsedLocation = CServerInfo::LOC_UNKNOWN;
+	CServerInfo2 ParsedInfo;
+	if(Addresses.type != json_array || (Location.type != json_string && Location.type != json_none))
 	{
 		return true;
 	}
-	for(unsigned int i = 0; i < Servers.u.array.length; i++)
+	if(Location.type == json_string)
 	{
-		const json_value &Server = Servers[i];
-		const json_value &Addresses = Server["addresses"];
-		const json_value &Info = Server["info"];
-		const json_value &Location = Server["location"];
-		int ParsedLocation = CServerInfo::LOC_UNKNOWN;
-		CServerInfo2 ParsedInfo;
-		if(Addresses.type != json_array || (Location.type != json_string && Location.type != json_none))
+		if(CServerInfo::ParseLocation(&ParsedLocation, Location))
 		{
 			return true;
 		}
-		if(Location.type == json_string)
+	}
+	if(CServerInfo2::FromJson(&ParsedInfo, &Info))
+	{
+		// Only skip the current server on parsing
+		// failure; the server info is "user input" by
+		// the game server and can be set to arbitrary
+		// values.
+		return false;
+	}
+	CServerInfo SetInfo = ParsedInfo;
+	SetInfo.m_Location = ParsedLocation;
+	SetInfo.m_NumAddresses = 0;
+	bool GotVersion6 = false;
+	for(unsigned int a = 0; a < Addresses.u.array.length; a++)
+	{
+		const json_value &Address = Addresses[a];
+		if(Address.type != json_string)
 		{
-			if(CServerInfo::ParseLocation(&ParsedLocation, Location))
-			{
-				return true;
-			}
+			return true;
+		}
+		if(str_startswith(Addresses[a], "tw-0.6+udp://"))
+		{
+			GotVersion6 = true;
+			break;
+		}
+	}
+	for(unsigned int a = 0; a < Addresses.u.array.length; a++)
+	{
+		const json_value &Address = Addresses[a];
+		if(Address.type != json_string)
+		{
+			return true;
 		}
-		if(CServerInfo2::FromJson(&ParsedInfo, &Info))
+		if(GotVersion6 && str_startswith(Addresses[a], "tw-0.7+udp://"))
 		{
-			// Only skip the current server on parsing
-			// failure; the server info is "user input" by
-			// the game server and can be set to arbitrary
-			// values.
 			continue;
 		}
-		CServerInfo SetInfo = ParsedInfo;
-		SetInfo.m_Location = ParsedLocation;
-		SetInfo.m_NumAddresses = 0;
-		bool GotVersion6 = false;
-		for(unsigned int a = 0; a < Addresses.u.array.length; a++)
+		NETADDR ParsedAddr;
+		if(ServerbrowserParseUrl(&ParsedAddr, Addresses[a]))
 		{
-			const json_value &Address = Addresses[a];
-			if(Address.type != json_string)
+			// Skip unknown addresses.
+			continue;
+		}
+		if(SetInfo.m_NumAddresses < (int)std::size(SetInfo.m_aAddresses))
+		{
+			SetInfo.m_aAddresses[SetInfo.m_NumAddresses] = ParsedAddr;
+			SetInfo.m_NumAddresses += 1;
+		}
+	}
+	if(SetInfo.m_NumAddresses > 0)
+	{
+		pvServers->push_back(SetInfo);
+	}
+	return false;
+}
+
+static bool IsJsonWhitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+CServerListParser::CServerListParser()
+{
+	m_Key.reserve(16);
+}
+
+bool CServerListParser::BeginValue(char c)
+{
+	m_ValueDepth = 0;
+	m_ValueInString = false;
+	m_ValueEscape = false;
+	if(c == '{' || c == '[')
+	{
+		m_Value = EValue::STRUCTURE;
+		m_ValueDepth = 1;
+	}
+	else if(c == '"')
+	{
+		m_Value = EValue::STRING;
+	}
+	else if(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+	{
+		m_Value = EValue::LITERAL;
+	}
+	else
+	{
+		return true;
+	}
+	return false;
+}
+
+bool CServerListParser::ContinueValue(char c)
+{
+	switch(m_Value)
+	{
+	case EValue::STRING:
+		if(m_ValueEscape)
+			m_ValueEscape = false;
+		else if(c == '\\')
+			m_ValueEscape = true;
+		else if(c == '"')
+			m_Value = EValue::NONE;
+		return true;
+	case EValue::LITERAL:
+		if(IsJsonWhitespace(c) || c == ',' || c == '}' || c == ']')
+		{
+			m_Value = EValue::NONE;
+			return false;
+		}
+		return true;
+	case EValue::STRUCTURE:
+		if(m_ValueInString)
+		{
+			if(m_ValueEscape)
+				m_ValueEscape = false;
+			else if(c == '\\')
+				m_ValueEscape = true;
+			else if(c == '"')
+				m_ValueInString = false;
+		}
+		else if(c == '"')
+		{
+			m_ValueInString = true;
+		}
+		else if(c == '{' || c == '[')
+		{
+			m_ValueDepth++;
+		}
+		else if(c == '}' || c == ']')
+		{
+			m_ValueDepth--;
+			if(m_ValueDepth == 0)
+				m_Value = EValue::NONE;
+		}
+		return true;
+	case EValue::NONE:
+		break;
+	}
+	dbg_assert_failed("no value to continue");
+}
+
+bool CServerListParser::ParseServer()
+{
+	json_value *pJson = json_parse(m_vServer.data(), m_vServer.size());
+	if(!pJson)
+	{
+		return true;
+	}
+	const bool Failure = ParseServerJson(*pJson, &m_vServers);
+	json_value_free(pJson);
+	return Failure;
+}
+
+bool CServerListParser::Feed(const char *pData, size_t DataSize)
+{
+	// start of the current server within this part of the list
+	size_t ServerStart = 0;
+	for(size_t i = 0; i < DataSize && m_State != EState::INVALID; i++)
+	{
+		const char c = pData[i];
+		if(m_Value != EValue::NONE)
+		{
+			const bool Consumed = ContinueValue(c);
+			if(m_Value != EValue::NONE)
 			{
-				return true;
+				continue;
 			}
-			if(str_startswith(Addresses[a], "tw-0.6+udp://"))
+			if(m_InServers)
 			{
-				GotVersion6 = true;
-				break;
+				m_vServer.insert(m_vServer.end(), pData + ServerStart, pData + i + (Consumed ? 1 : 0));
+				if(ParseServer())
+				{
+					m_State = EState::INVALID;
+					break;
+				}
+				m_State = EState::SERVERS_COMMA;
 			}
-		}
-		for(unsigned int a = 0; a < Addresses.u.array.length; a++)
-		{
-			const json_value &Address = Addresses[a];
-			if(Address.type != json_string)
+			else
 			{
-				return true;
+				m_State = EState::ROOT_COMMA;
 			}
-			if(GotVersion6 && str_startswith(Addresses[a], "tw-0.7+udp://"))
+			if(Consumed)
 			{
 				continue;
 			}
-			NETADDR ParsedAddr;
-			if(ServerbrowserParseUrl(&ParsedAddr, Addresses[a]))
+		}
+
+		if(m_InKey)
+		{
+			if(m_KeyEscape)
+				m_KeyEscape = false;
+			else if(c == '\\')
+				m_KeyEscape = true;
+			else if(c == '"')
 			{
-				// Skip unknown addresses.
+				m_InKey = false;
+				m_State = EState::ROOT_COLON;
 				continue;
 			}
-			if(SetInfo.m_NumAddresses < (int)std::size(SetInfo.m_aAddresses))
-			{
-				SetInfo.m_aAddresses[SetInfo.m_NumAddresses] = ParsedAddr;
-				SetInfo.m_NumAddresses += 1;
-			}
+			// only the "servers" key is of interest
+			if(m_Key.size() < 16)
+				m_Key.push_back(c);
+			continue;
 		}
-		if(SetInfo.m_NumAddresses > 0)
+
+		if(IsJsonWhitespace(c))
 		{
-			vServers.push_back(SetInfo);
+			continue;
+		}
+
+		switch(m_State)
+		{
+		case EState::ROOT:
+			m_State = c == '{' ? EState::ROOT_FIRST_KEY : EState::INVALID;
+			break;
+		case EState::ROOT_FIRST_KEY:
+		case EState::ROOT_KEY:
+			if(c == '"')
+			{
+				m_Key.clear();
+				m_InKey = true;
+			}
+			else if(c == '}' && m_State == EState::ROOT_FIRST_KEY)
+				m_State = EState::END;
+			else
+				m_State = EState::INVALID;
+			break;
+		case EState::ROOT_COLON:
+			m_State = c == ':' ? EState::ROOT_VALUE : EState::INVALID;
+			break;
+		case EState::ROOT_VALUE:
+			// Only the first "servers" member counts, like for lookups in a parsed document.
+			if(!m_GotServers && m_Key == "servers")
+			{
+				m_GotServers = true;
+				m_InServers = true;
+				m_State = c == '[' ? EState::SERVERS_FIRST : EState::INVALID;
+			}
+			else if(BeginValue(c))
+			{
+				m_State = EState::INVALID;
+			}
+			break;
+		case EState::ROOT_COMMA:
+			if(c == ',')
+				m_State = EState::ROOT_KEY;
+			else if(c == '}')
+				m_State = EState::END;
+			else
+				m_State = EState::INVALID;
+			break;
+		case EState::SERVERS_FIRST:
+		case EState::SERVERS:
+			if(c == '{')
+			{
+				BeginValue(c);
+				m_vServer.clear();
+				ServerStart = i;
+			}
+			else if(c == ']' && m_State == EState::SERVERS_FIRST)
+			{
+				m_InServers = false;
+				m_State = EState::ROOT_COMMA;
+			}
+			else
+				m_State = EState::INVALID;
+			break;
+		case EState::SERVERS_COMMA:
+			if(c == ',')
+				m_State = EState::SERVERS;
+			else if(c == ']')
+			{
+				m_InServers = false;
+				m_State = EState::ROOT_COMMA;
+			}
+			else
+				m_State = EState::INVALID;
+			break;
+		case EState::END:
+		case EState::INVALID:
+			m_State = EState::INVALID;
+			break;
 		}
 	}
-	*pvServers = vServers;
-	return false;
+
+	// keep the part of the current server that is in this part of the list
+	if(m_State != EState::INVALID && m_InServers && m_Value != EValue::NONE)
+	{
+		m_vServer.insert(m_vServer.end(), pData + ServerStart, pData + DataSize);
+	}
+	return m_State == EState::INVALID;
+}
+
+bool CServerListParser::Finish()
+{
+	return m_State != EState::END || !m_GotServers;
 }
 
 static const char *DEFAULT_SERVERLIST_URLS[] = {
@@ -2,7 +2,11 @@
 #define ENGINE_CLIENT_SERVERBROWSER_HTTP_H
 #include <base/types.h>
 
-class CServerInfo;
+#include <engine/serverbrowser.h>
+
+#include <string>
+#include <vector>
+
 class IEngine;
 class IStorage;
 class IHttp;
@@ -24,5 +28,79 @@ public:
 	virtual const CServerInfo &Server(int Index) const = 0;
 };
 
+/**
+ * Parses the server list returned by the master servers while it is being
+ * received. The elements of the "servers" array are split off and parsed
+ * one by one, so the list never exists as one large JSON document.
+ */
+class CServerListParser
+{
+public:
+	CServerListParser();
+
+	/**
+	 * Parses the next part of the server list.
+	 *
+	 * @return `true` on failure, `false` otherwise.
+	 */
+	bool Feed(const char *pData, size_t DataSize);
+
+	/**
+	 * Must be called after the whole server list was fed.
+	 *
+	 * @return `true` on failure, `false` if a complete server list was parsed.
+	 */
+	bool Finish();
+
+	std::vector<CServerInfo> &Servers() { return m_vServers; }
+
+private:
+	enum class EState
+	{
+		ROOT,
+		ROOT_FIRST_KEY,
+		ROOT_KEY,
+		ROOT_COLON,
+		ROOT_VALUE,
+		ROOT_COMMA,
+		SERVERS_FIRST,
+		SERVERS,
+		SERVERS_COMMA,
+		END,
+		INVALID,
+	};
+
+	enum class EValue
+	{
+		NONE,
+		STRUCTURE,
+		STRING,
+		LITERAL,
+	};
+
+	EState m_State = EState::ROOT;
+	bool m_GotServers = false;
+	bool m_InServers = false;
+
+	// key of the current member of the root object
+	std::string m_Key;
+	bool m_InKey = false;
+	bool m_KeyEscape = false;
+
+	// value that is currently skipped or, inside the servers array, captured
+	EValue m_Value = EValue::NONE;
+	int m_ValueDepth = 0;
+	bool m_ValueInString = false;
+	bool m_ValueEscape = false;
+	std::vector<char> m_vServer;
+
+	std::vector<CServerInfo> m_vServers;
+
+	bool BeginValue(char c);
+	// returns whether the character was part of the value
+	bool ContinueValue(char c);
+	bool ParseServer();
+};
+
 IServerBrowserHttp *CreateServerBrowserHttp(IEngine *pEngine, IStorage *pStorage, IHttp *pHttp, const char *pPreviousBestUrl);
 #endif // ENGINE_CLIENT_SERVERBROWSER_HTTP_H
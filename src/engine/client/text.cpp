@@ -17,6 +17,7 @@
 #include <chrono>
 #include <cstddef>
 #include <limits>
+#include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -320,6 +321,8 @@ private:
 	uint8_t *m_apTextureData[NUM_FONT_TEXTURES];
 	CAtlas m_TextureAtlas;
 	std::unordered_map<std::tuple<FT_Face, int, int>, SGlyph, SGlyphKeyHash, SGlyphKeyEquals> m_Glyphs;
+	// Incremented whenever glyphs or faces change, see Generation
+	unsigned m_Generation = 0;
 
 	// Font faces
 	FT_Face m_DefaultFace = nullptr;
@@ -614,13 +617,29 @@ public:
 		return m_IconFace;
 	}
 
+	FT_Face SelectedFace() const
+	{
+		return m_SelectedFace;
+	}
+
+	/**
+	 * Changes whenever previously returned glyphs or the face selection
+	 * become invalid, so text layouts based on them must not be reused.
+	 */
+	unsigned Generation() const
+	{
+		return m_Generation;
+	}
+
 	void AddFace(FT_Face Face)
 	{
 		m_vFtFaces.push_back(Face);
+		m_Generation++;
 	}
 
 	bool SetDefaultFaceByName(const char *pFamilyName)
 	{
+		m_Generation++;
 		m_DefaultFace = GetFaceByName(pFamilyName);
 		if(!m_DefaultFace)
 		{
@@ -636,6 +655,7 @@ public:
 
 	bool SetIconFaceByName(const char *pFamilyName)
 	{
+		m_Generation++;
 		m_IconFace = GetFaceByName(pFamilyName);
 		if(!m_IconFace)
 		{
@@ -659,6 +679,7 @@ public:
 			return true;
 		}
 		m_vFallbackFaces.push_back(Face);
+		m_Generation++;
 		return true;
 	}
 
@@ -701,6 +722,7 @@ public:
 
 		m_TextureAtlas.Clear(m_TextureDimension);
 		m_Glyphs.clear();
+		m_Generation++;
 	}
 
 	const SGlyph *GetGlyph(int Chr, int FontSize)
@@ -941,6 +963,123 @@ void CTextCursor::SetPosition(vec2 Position)
 	m_Y = Position.y;
 }
 
+// Everything the layout of a text depends on, except the pixel aligned
+// start position that the layout is relative to.
+struct STextLayoutKey
+{
+	std::string m_Text;
+	FT_Face m_Face;
+	unsigned m_RenderFlags;
+	int m_Flags;
+	int m_MaxLines;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	float m_FontSize;
+	float m_LineSpacing;
+	float m_LineWidth;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	vec2 m_FakeToScreen;
+	// offset of the cursor to the start position, non-zero with pixel alignment
+	vec2 m_SubPixelOffset;
+	vec2 m_LineStartOffset;
+	// only set for rendered text, the color is part of the quads
+	ColorRGBA m_Color;
+
+	bool operator==(const STextLayoutKey &Other) const = default;
+};
+
+struct STextLayoutKeyHash
+{
+	size_t operator()(const STextLayoutKey &Key) const
+	{
+		size_t Hash = std::hash<std::string>()(Key.m_Text);
+		const auto &&Combine = [&Hash](size_t Value) {
+			Hash = Hash * 31 + Value;
+		};
+		Combine(std::hash<FT_Face>()(Key.m_Face));
+		Combine(Key.m_RenderFlags);
+		Combine(Key.m_Flags);
+		Combine(Key.m_MaxLines);
+		Combine(Key.m_LineCount);
+		Combine(Key.m_GlyphCount);
+		Combine(Key.m_CharCount);
+		for(float Value : {Key.m_FontSize, Key.m_LineSpacing, Key.m_LineWidth, Key.m_MaxCharacterHeight, Key.m_LongestLineWidth, Key.m_FakeToScreen.x, Key.m_FakeToScreen.y, Key.m_SubPixelOffset.x, Key.m_SubPixelOffset.y, Key.m_LineStartOffset.x, Key.m_LineStartOffset.y, Key.m_Color.r, Key.m_Color.g, Key.m_Color.b, Key.m_Color.a})
+			Combine(std::hash<float>()(Value));
+		return Hash;
+	}
+};
+
+// Result of laying out a text, positions are relative to the start position.
+struct STextLayout
+{
+	std::vector<STextCharQuad> m_vCharacterQuads;
+
+	vec2 m_End;
+	int m_Flags;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	float m_AlignedFontSize;
+	float m_AlignedLineSpacing;
+	bool m_Truncated;
+};
+
+/**
+ * Layouts of recently rendered texts.
+ *
+ * Texts that were not used while the current generation filled up are
+ * dropped with the previous generation.
+ */
+class CTextLayoutCache
+{
+	static constexpr size_t MAX_LAYOUTS_PER_GENERATION = 1024;
+
+	using TLayoutMap = std::unordered_map<STextLayoutKey, STextLayout, STextLayoutKeyHash>;
+	TLayoutMap m_CurrentLayouts;
+	TLayoutMap m_PreviousLayouts;
+
+	void StartGenerationIfFull()
+	{
+		if(m_CurrentLayouts.size() < MAX_LAYOUTS_PER_GENERATION)
+			return;
+		std::swap(m_CurrentLayouts, m_PreviousLayouts);
+		m_CurrentLayouts.clear();
+	}
+
+public:
+	const STextLayout *Find(const STextLayoutKey &Key)
+	{
+		const auto Current = m_CurrentLayouts.find(Key);
+		if(Current != m_CurrentLayouts.end())
+			return &Current->second;
+
+		const auto Previous = m_PreviousLayouts.find(Key);
+		if(Previous == m_PreviousLayouts.end())
+			return nullptr;
+
+		// move the layout into the current generation to keep it alive
+		auto Node = m_PreviousLayouts.extract(Previous);
+		StartGenerationIfFull();
+		return &m_CurrentLayouts.insert(std::move(Node)).position->second;
+	}
+
+	void Add(STextLayoutKey &&Key, STextLayout &&Layout)
+	{
+		StartGenerationIfFull();
+		m_CurrentLayouts.insert_or_assign(std::move(Key), std::move(Layout));
+	}
+
+	void Clear()
+	{
+		m_CurrentLayouts.clear();
+		m_PreviousLayouts.clear();
+	}
+};
+
 struct SFontLanguageVariant
 {
 	char m_aLanguageFile[IO_MAX_PATH_LENGTH];
@@ -977,6 +1116,11 @@ class CTextRender : public IEngineTextRender
 
 	std::chrono::nanoseconds m_CursorRenderTime;
 
+	CTextLayoutCache m_LayoutCache;
+	unsigned m_LayoutCacheGeneration = 0;
+	// TextEx is used recursively to measure words while breaking lines
+	int m_TextExDepth = 0;
+
 	int GetFreeTextContainerIndex()
 	{
 		if(m_FirstFreeTextContainerIndex == -1)
@@ -1023,6 +1167,13 @@ class CTextRender : public IEngineTextRender
 		return *m_vpTextContainers[Index.m_Index];
 	}
 
+	static bool IsLayoutCacheable(const CTextCursor *pCursor)
+	{
+		return pCursor->m_CalculateSelectionMode == TEXT_CURSOR_SELECTION_MODE_NONE &&
+		       pCursor->m_CursorMode == TEXT_CURSOR_CURSOR_MODE_NONE &&
+		       pCursor->m_vColorSplits.empty();
+	}
+
 	int WordLength(const char *pText) const
 	{
 		const char *pCursor = pText;
@@ -1440,10 +1591,15 @@ public:
 
 	void TextEx(CTextCursor *pCursor, const char *pText, int Length = -1) override
 	{
+		// only cache the layout of complete texts, not of the words measured while laying them out
+		const bool UseLayoutCache = m_TextExDepth == 0 && IsLayoutCacheable(pCursor);
+
 		const unsigned OldRenderFlags = m_RenderFlags;
 		m_RenderFlags |= TEXT_RENDER_FLAG_ONE_TIME_USE;
 		STextContainerIndex TextCont;
-		CreateTextContainer(TextCont, pCursor, pText, Length);
+		m_TextExDepth++;
+		CreateTextContainer(TextCont, pCursor, pText, Length, UseLayoutCache);
+		m_TextExDepth--;
 		m_RenderFlags = OldRenderFlags;
 		if(TextCont.Valid())
 		{
@@ -1458,6 +1614,11 @@ public:
 	}
 
 	bool CreateTextContainer(STextContainerIndex &TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length = -1) override
+	{
+		return CreateTextContainer(TextContainerIndex, pCursor, pText, Length, false);
+	}
+
+	bool CreateTextContainer(STextContainerIndex &TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length, bool UseLayoutCache)
 	{
 		dbg_assert(!TextContainerIndex.Valid(), "Text container index was not cleared.");
 
@@ -1481,7 +1642,10 @@ public:
 		else
 			TextContainer.m_RenderFlags = m_RenderFlags;
 
-		AppendTextContainer(TextContainerIndex, pCursor, pText, Length);
+		if(UseLayoutCache)
+			AppendCachedTextLayout(TextContainerIndex, pCursor, pText, Length);
+		else
+			AppendTextContainer(TextContainerIndex, pCursor, pText, Length);
 
 		const bool IsRendered = (pCursor->m_Flags & TEXTFLAG_RENDER) != 0;
 
@@ -1509,6 +1673,110 @@ public:
 		}
 	}
 
+	// Like AppendTextContainer on an empty container, but reuses the layout
+	// of the last text with the same key instead of laying it out again.
+	void AppendCachedTextLayout(STextContainerIndex TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length)
+	{
+		if(m_LayoutCacheGeneration != m_pGlyphMap->Generation())
+		{
+			m_LayoutCache.Clear();
+			m_LayoutCacheGeneration = m_pGlyphMap->Generation();
+		}
+
+		STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
+		dbg_assert(TextContainer.m_StringInfo.m_vCharacterQuads.empty(), "Cached text layouts can only be used for new text containers");
+
+		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+		const vec2 FakeToScreen = vec2(Graphics()->ScreenWidth() / (ScreenX1 - ScreenX0), Graphics()->ScreenHeight() / (ScreenY1 - ScreenY0));
+
+		const bool IsRendered = (pCursor->m_Flags & TEXTFLAG_RENDER) != 0;
+		const vec2 CursorPos = vec2(pCursor->m_X, pCursor->m_Y);
+		const vec2 Origin = (TextContainer.m_RenderFlags & TEXT_RENDER_FLAG_NO_PIXEL_ALIGNMENT) != 0 ? CursorPos : vec2(TextContainer.m_AlignedStartX, TextContainer.m_AlignedStartY);
+
+		if(Length < 0)
+			Length = str_length(pText);
+		else
+			Length = minimum(Length, str_length(pText));
+
+		STextLayoutKey Key;
+		Key.m_Text.assign(pText, Length);
+		Key.m_Face = m_pGlyphMap->SelectedFace();
+		Key.m_RenderFlags = TextContainer.m_RenderFlags;
+		Key.m_Flags = pCursor->m_Flags;
+		Key.m_MaxLines = pCursor->m_MaxLines;
+		Key.m_LineCount = pCursor->m_LineCount;
+		Key.m_GlyphCount = pCursor->m_GlyphCount;
+		Key.m_CharCount = pCursor->m_CharCount;
+		Key.m_FontSize = pCursor->m_FontSize;
+		Key.m_LineSpacing = pCursor->m_LineSpacing;
+		Key.m_LineWidth = pCursor->m_LineWidth;
+		Key.m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+		Key.m_LongestLineWidth = pCursor->m_LongestLineWidth;
+		Key.m_FakeToScreen = FakeToScreen;
+		Key.m_SubPixelOffset = CursorPos - Origin;
+		Key.m_LineStartOffset = vec2(pCursor->m_StartX, pCursor->m_StartY) - CursorPos;
+		Key.m_Color = IsRendered ? m_Color : ColorRGBA(0.0f, 0.0f, 0.0f, 0.0f);
+
+		const STextLayout *pLayout = m_LayoutCache.Find(Key);
+		if(pLayout == nullptr)
+		{
+			const bool WasTruncated = pCursor->m_Truncated;
+			pCursor->m_Truncated = false;
+			AppendTextContainer(TextContainerIndex, pCursor, pText, Length);
+
+			STextLayout Layout;
+			Layout.m_vCharacterQuads = TextContainer.m_StringInfo.m_vCharacterQuads;
+			for(STextCharQuad &Quad : Layout.m_vCharacterQuads)
+			{
+				for(STextCharQuadVertex &Vertex : Quad.m_aVertices)
+				{
+					Vertex.m_X -= Origin.x;
+					Vertex.m_Y -= Origin.y;
+				}
+			}
+			Layout.m_End = vec2(pCursor->m_X, pCursor->m_Y) - Origin;
+			Layout.m_Flags = pCursor->m_Flags;
+			Layout.m_LineCount = pCursor->m_LineCount;
+			Layout.m_GlyphCount = pCursor->m_GlyphCount;
+			Layout.m_CharCount = pCursor->m_CharCount;
+			Layout.m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+			Layout.m_LongestLineWidth = pCursor->m_LongestLineWidth;
+			Layout.m_AlignedFontSize = pCursor->m_AlignedFontSize;
+			Layout.m_AlignedLineSpacing = pCursor->m_AlignedLineSpacing;
+			Layout.m_Truncated = pCursor->m_Truncated;
+			pCursor->m_Truncated |= WasTruncated;
+			m_LayoutCache.Add(std::move(Key), std::move(Layout));
+			return;
+		}
+
+		str_append(TextContainer.m_aDebugText, pText);
+
+		TextContainer.m_StringInfo.m_vCharacterQuads = pLayout->m_vCharacterQuads;
+		for(STextCharQuad &Quad : TextContainer.m_StringInfo.m_vCharacterQuads)
+		{
+			for(STextCharQuadVertex &Vertex : Quad.m_aVertices)
+			{
+				Vertex.m_X += Origin.x;
+				Vertex.m_Y += Origin.y;
+			}
+		}
+
+		pCursor->m_X = Origin.x + pLayout->m_End.x;
+		pCursor->m_Y = Origin.y + pLayout->m_End.y;
+		pCursor->m_Flags = pLayout->m_Flags;
+		pCursor->m_LineCount = pLayout->m_LineCount;
+		pCursor->m_GlyphCount = pLayout->m_GlyphCount;
+		pCursor->m_CharCount = pLayout->m_CharCount;
+		pCursor->m_MaxCharacterHeight = pLayout->m_MaxCharacterHeight;
+		pCursor->m_LongestLineWidth = pLayout->m_LongestLineWidth;
+		pCursor->m_AlignedFontSize = pLayout->m_AlignedFontSize;
+		pCursor->m_AlignedLineSpacing = pLayout->m_AlignedLineSpacing;
+		pCursor->m_Truncated |= pLayout->m_Truncated;
+
+		TextContainer.m_BoundingBox = pCursor->BoundingBox();
+	}
+
 	void AppendTextContainer(STextContainerIndex TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length = -1) override
 	{
 		STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
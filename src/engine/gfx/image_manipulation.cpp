@@ -3,6 +3,36 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#include <cstring>
+#include <vector>
+
+// RGBA pixels are processed as 32-bit words without data dependent branches,
+// so that the compiler can vectorize the loops over them.
+#if defined(CONF_ARCH_ENDIAN_BIG)
+static constexpr uint32_t PIXEL_ALPHA_MASK = 0x000000ff;
+static constexpr int PIXEL_ALPHA_SHIFT = 0;
+#else
+static constexpr uint32_t PIXEL_ALPHA_MASK = 0xff000000;
+static constexpr int PIXEL_ALPHA_SHIFT = 24;
+#endif
+
+static inline uint32_t LoadPixel(const uint8_t *pImage, size_t Index)
+{
+	uint32_t Pixel;
+	std::memcpy(&Pixel, pImage + Index * 4, sizeof(Pixel));
+	return Pixel;
+}
+
+static inline void StorePixel(uint8_t *pImage, size_t Index, uint32_t Pixel)
+{
+	std::memcpy(pImage + Index * 4, &Pixel, sizeof(Pixel));
+}
+
+static inline uint32_t PixelAlpha(uint32_t Pixel)
+{
+	return (Pixel >> PIXEL_ALPHA_SHIFT) & 0xff;
+}
+
 bool ConvertToRgba(uint8_t *pDest, const CImageInfo &SourceImage)
 {
 	if(SourceImage.m_Format == CImageInfo::FORMAT_RGBA)
@@ -10,43 +40,44 @@ bool ConvertToRgba(uint8_t *pDest, const CImageInfo &SourceImage)
 		mem_copy(pDest, SourceImage.m_pData, SourceImage.DataSize());
 		return true;
 	}
-	else
+
+	const uint8_t *pSrc = SourceImage.m_pData;
+	const size_t NumPixels = SourceImage.m_Width * SourceImage.m_Height;
+	if(SourceImage.m_Format == CImageInfo::FORMAT_RGB)
 	{
-		const size_t SrcChannelCount = CImageInfo::PixelSize(SourceImage.m_Format);
-		const size_t DstChannelCount = CImageInfo::PixelSize(CImageInfo::FORMAT_RGBA);
-		for(size_t Y = 0; Y < SourceImage.m_Height; ++Y)
+		for(size_t i = 0; i < NumPixels; ++i)
 		{
-			for(size_t X = 0; X < SourceImage.m_Width; ++X)
-			{
-				size_t ImgOffsetSrc = (Y * SourceImage.m_Width * SrcChannelCount) + (X * SrcChannelCount);
-				size_t ImgOffsetDest = (Y * SourceImage.m_Width * DstChannelCount) + (X * DstChannelCount);
-				if(SourceImage.m_Format == CImageInfo::FORMAT_RGB)
-				{
-					mem_copy(&pDest[ImgOffsetDest], &SourceImage.m_pData[ImgOffsetSrc], SrcChannelCount);
-					pDest[ImgOffsetDest + 3] = 255;
-				}
-				else if(SourceImage.m_Format == CImageInfo::FORMAT_RA)
-				{
-					pDest[ImgOffsetDest + 0] = SourceImage.m_pData[ImgOffsetSrc];
-					pDest[ImgOffsetDest + 1] = SourceImage.m_pData[ImgOffsetSrc];
-					pDest[ImgOffsetDest + 2] = SourceImage.m_pData[ImgOffsetSrc];
-					pDest[ImgOffsetDest + 3] = SourceImage.m_pData[ImgOffsetSrc + 1];
-				}
-				else if(SourceImage.m_Format == CImageInfo::FORMAT_R)
-				{
-					pDest[ImgOffsetDest + 0] = 255;
-					pDest[ImgOffsetDest + 1] = 255;
-					pDest[ImgOffsetDest + 2] = 255;
-					pDest[ImgOffsetDest + 3] = SourceImage.m_pData[ImgOffsetSrc];
-				}
-				else
-				{
-					dbg_assert_failed("SourceImage.m_Format invalid");
-				}
-			}
+			pDest[i * 4 + 0] = pSrc[i * 3 + 0];
+			pDest[i * 4 + 1] = pSrc[i * 3 + 1];
+			pDest[i * 4 + 2] = pSrc[i * 3 + 2];
+			pDest[i * 4 + 3] = 255;
 		}
-		return false;
 	}
+	else if(SourceImage.m_Format == CImageInfo::FORMAT_RA)
+	{
+		for(size_t i = 0; i < NumPixels; ++i)
+		{
+			pDest[i * 4 + 0] = pSrc[i * 2];
+			pDest[i * 4 + 1] = pSrc[i * 2];
+			pDest[i * 4 + 2] = pSrc[i * 2];
+			pDest[i * 4 + 3] = pSrc[i * 2 + 1];
+		}
+	}
+	else if(SourceImage.m_Format == CImageInfo::FORMAT_R)
+	{
+		for(size_t i = 0; i < NumPixels; ++i)
+		{
+			pDest[i * 4 + 0] = 255;
+			pDest[i * 4 + 1] = 255;
+			pDest[i * 4 + 2] = 255;
+			pDest[i * 4 + 3] = pSrc[i];
+		}
+	}
+	else
+	{
+		dbg_assert_failed("SourceImage.m_Format invalid");
+	}
+	return false;
 }
 
 bool ConvertToRgbaAlloc(uint8_t *&pDest, const CImageInfo &SourceImage)
@@ -90,67 +121,75 @@ void ConvertToGrayscale(const CImageInfo &Image)
 static constexpr int DILATE_BPP = 4; // RGBA assumed
 static constexpr uint8_t DILATE_ALPHA_THRESHOLD = 10;
 
-static void Dilate(int w, int h, const uint8_t *pSrc, uint8_t *pDest)
+static inline bool IsDilateOpaque(uint32_t Pixel)
 {
-	const int aDirX[] = {0, -1, 1, 0};
-	const int aDirY[] = {-1, 0, 0, 1};
+	return PixelAlpha(Pixel) > DILATE_ALPHA_THRESHOLD;
+}
+
+// A transparent pixel takes the color of the first opaque neighbour in the
+// order up, left, right, down and becomes opaque.
+static inline uint32_t DilatePixel(uint32_t Pixel, uint32_t Up, uint32_t Left, uint32_t Right, uint32_t Down)
+{
+	uint32_t Result = Pixel;
+	Result = IsDilateOpaque(Down) ? Down | PIXEL_ALPHA_MASK : Result;
+	Result = IsDilateOpaque(Right) ? Right | PIXEL_ALPHA_MASK : Result;
+	Result = IsDilateOpaque(Left) ? Left | PIXEL_ALPHA_MASK : Result;
+	Result = IsDilateOpaque(Up) ? Up | PIXEL_ALPHA_MASK : Result;
+	return IsDilateOpaque(Pixel) ? Pixel : Result;
+}
 
-	int m = 0;
+static void Dilate(int w, int h, const uint8_t *pSrc, uint8_t *pDest)
+{
 	for(int y = 0; y < h; y++)
 	{
-		for(int x = 0; x < w; x++, m += DILATE_BPP)
+		// neighbours outside of the image are clamped to the border
+		const uint8_t *pRow = pSrc + (size_t)y * w * DILATE_BPP;
+		const uint8_t *pRowUp = pSrc + (size_t)maximum(y - 1, 0) * w * DILATE_BPP;
+		const uint8_t *pRowDown = pSrc + (size_t)minimum(y + 1, h - 1) * w * DILATE_BPP;
+		uint8_t *pDestRow = pDest + (size_t)y * w * DILATE_BPP;
+
+		const auto &&DilateBorder = [&](int x) {
+			const int Left = maximum(x - 1, 0);
+			const int Right = minimum(x + 1, w - 1);
+			StorePixel(pDestRow, x, DilatePixel(LoadPixel(pRow, x), LoadPixel(pRowUp, x), LoadPixel(pRow, Left), LoadPixel(pRow, Right), LoadPixel(pRowDown, x)));
+		};
+		DilateBorder(0);
+		for(int x = 1; x < w - 1; x++)
 		{
-			for(int i = 0; i < DILATE_BPP; ++i)
-				pDest[m + i] = pSrc[m + i];
-			if(pSrc[m + DILATE_BPP - 1] > DILATE_ALPHA_THRESHOLD)
-				continue;
-
-			// --- Implementation Note ---
-			// The sum and counter variable can be used to compute a smoother dilated image.
-			// In this reference implementation, the loop breaks as soon as Counter == 1.
-			// We break the loop here to match the selection of the previously used algorithm.
-			int aSumOfOpaque[] = {0, 0, 0};
-			int Counter = 0;
-			for(int c = 0; c < 4; c++)
-			{
-				const int ClampedX = std::clamp(x + aDirX[c], 0, w - 1);
-				const int ClampedY = std::clamp(y + aDirY[c], 0, h - 1);
-				const int SrcIndex = ClampedY * w * DILATE_BPP + ClampedX * DILATE_BPP;
-				if(pSrc[SrcIndex + DILATE_BPP - 1] > DILATE_ALPHA_THRESHOLD)
-				{
-					for(int p = 0; p < DILATE_BPP - 1; ++p)
-						aSumOfOpaque[p] += pSrc[SrcIndex + p];
-					++Counter;
-					break;
-				}
-			}
-
-			if(Counter > 0)
-			{
-				for(int i = 0; i < DILATE_BPP - 1; ++i)
-				{
-					aSumOfOpaque[i] /= Counter;
-					pDest[m + i] = (uint8_t)aSumOfOpaque[i];
-				}
-
-				pDest[m + DILATE_BPP - 1] = 255;
-			}
+			StorePixel(pDestRow, x, DilatePixel(LoadPixel(pRow, x), LoadPixel(pRowUp, x), LoadPixel(pRow, x - 1), LoadPixel(pRow, x + 1), LoadPixel(pRowDown, x)));
 		}
+		if(w > 1)
+			DilateBorder(w - 1);
 	}
 }
 
 static void CopyColorValues(int w, int h, const uint8_t *pSrc, uint8_t *pDest)
 {
-	int m = 0;
-	for(int y = 0; y < h; y++)
+	const size_t NumPixels = (size_t)w * h;
+	for(size_t i = 0; i < NumPixels; i++)
 	{
-		for(int x = 0; x < w; x++, m += DILATE_BPP)
-		{
-			if(pDest[m + DILATE_BPP - 1] == 0)
-			{
-				mem_copy(&pDest[m], &pSrc[m], DILATE_BPP - 1);
-			}
-		}
+		const uint32_t Dest = LoadPixel(pDest, i);
+		StorePixel(pDest, i, (Dest & PIXEL_ALPHA_MASK) == 0 ? LoadPixel(pSrc, i) & ~PIXEL_ALPHA_MASK : Dest);
+	}
+}
+
+void ClearTransparentPixels(uint8_t *pImageBuff, int w, int h)
+{
+	const size_t NumPixels = (size_t)w * h;
+	for(size_t i = 0; i < NumPixels; i++)
+	{
+		const uint32_t Pixel = LoadPixel(pImageBuff, i);
+		StorePixel(pImageBuff, i, (Pixel & PIXEL_ALPHA_MASK) == 0 ? 0 : Pixel);
+	}
+}
+
+void CopyOpaquePixels(uint8_t *pDest, const uint8_t *pSrc, int w, int h)
+{
+	const size_t NumPixels = (size_t)w * h;
+	for(size_t i = 0; i < NumPixels; i++)
+	{
+		const uint32_t Pixel = LoadPixel(pSrc, i);
+		StorePixel(pDest, i, (Pixel & PIXEL_ALPHA_MASK) == 0 ? 0 : Pixel);
 	}
 }
 
@@ -216,55 +255,45 @@ static float CubicHermite(float A, float B, float C, float D, float t)
 	return (a * t * t * t) + (b * t * t) + (c * t) + d;
 }
 
-static void GetPixelClamped(const uint8_t *pSourceImage, int x, int y, uint32_t W, uint32_t H, size_t BPP, uint8_t aSample[4])
-{
-	x = std::clamp<int>(x, 0, (int)W - 1);
-	y = std::clamp<int>(y, 0, (int)H - 1);
-
-	mem_copy(aSample, &pSourceImage[x * BPP + (W * BPP * y)], BPP);
-}
-
-static void SampleBicubic(const uint8_t *pSourceImage, float u, float v, uint32_t W, uint32_t H, size_t BPP, uint8_t aSample[4])
+// The sample positions and clamped source offsets only depend on the
+// destination column and row, so they are computed once instead of per pixel.
+static void ResizeImage(const uint8_t *pSourceImage, uint32_t SW, uint32_t SH, uint8_t *pDestinationImage, uint32_t W, uint32_t H, size_t BPP)
 {
-	float X = (u * W) - 0.5f;
-	const int RoundedX = (int)X;
-	const float FractionX = X - std::floor(X);
-
-	float Y = (v * H) - 0.5f;
-	const int RoundedY = (int)Y;
-	const float FractionY = Y - std::floor(Y);
-
-	uint8_t aaaSamples[4][4][4];
-	for(int y = 0; y < 4; ++y)
+	std::vector<size_t> vColumnOffsets((size_t)W * 4);
+	std::vector<float> vFractionsX(W);
+	for(int x = 0; x < (int)W; ++x)
 	{
-		for(int x = 0; x < 4; ++x)
-		{
-			GetPixelClamped(pSourceImage, RoundedX + x - 1, RoundedY + y - 1, W, H, BPP, aaaSamples[x][y]);
-		}
+		float u = (float)x / (float)(W - 1);
+		float X = (u * SW) - 0.5f;
+		const int RoundedX = (int)X;
+		vFractionsX[x] = X - std::floor(X);
+		for(int i = 0; i < 4; ++i)
+			vColumnOffsets[x * 4 + i] = std::clamp<int>(RoundedX + i - 1, 0, (int)SW - 1) * BPP;
 	}
 
-	for(size_t i = 0; i < BPP; i++)
-	{
-		float aRows[4];
-		for(int y = 0; y < 4; ++y)
-		{
-			aRows[y] = CubicHermite(aaaSamples[0][y][i], aaaSamples[1][y][i], aaaSamples[2][y][i], aaaSamples[3][y][i], FractionX);
-		}
-		aSample[i] = (uint8_t)std::clamp<float>(CubicHermite(aRows[0], aRows[1], aRows[2], aRows[3], FractionY), 0.0f, 255.0f);
-	}
-}
-
-static void ResizeImage(const uint8_t *pSourceImage, uint32_t SW, uint32_t SH, uint8_t *pDestinationImage, uint32_t W, uint32_t H, size_t BPP)
-{
 	for(int y = 0; y < (int)H; ++y)
 	{
 		float v = (float)y / (float)(H - 1);
+		float Y = (v * SH) - 0.5f;
+		const int RoundedY = (int)Y;
+		const float FractionY = Y - std::floor(Y);
+		const uint8_t *apRows[4];
+		for(int i = 0; i < 4; ++i)
+			apRows[i] = &pSourceImage[(size_t)std::clamp<int>(RoundedY + i - 1, 0, (int)SH - 1) * SW * BPP];
+
+		uint8_t *pDestinationRow = &pDestinationImage[(size_t)W * BPP * y];
 		for(int x = 0; x < (int)W; ++x)
 		{
-			float u = (float)x / (float)(W - 1);
-			uint8_t aSample[4];
-			SampleBicubic(pSourceImage, u, v, SW, SH, BPP, aSample);
-			mem_copy(&pDestinationImage[x * BPP + ((W * BPP) * y)], aSample, BPP);
+			const size_t *pOffsets = &vColumnOffsets[x * 4];
+			for(size_t i = 0; i < BPP; i++)
+			{
+				float aRows[4];
+				for(int r = 0; r < 4; ++r)
+				{
+					aRows[r] = CubicHermite(apRows[r][pOffsets[0] + i], apRows[r][pOffsets[1] + i], apRows[r][pOffsets[2] + i], apRows[r][pOffsets[3] + i], vFractionsX[x]);
+				}
+				pDestinationRow[x * BPP + i] = (uint8_t)std::clamp<float>(CubicHermite(aRows[0], aRows[1], aRows[2], aRows[3], FractionY), 0.0f, 255.0f);
+			}
 		}
 	}
 }
@@ -19,6 +19,10 @@ void ConvertToGrayscale(const CImageInfo &Image);
 void DilateImage(uint8_t *pImageBuff, int w, int h);
 void DilateImage(const CImageInfo &Image);
 void DilateImageSub(uint8_t *pImageBuff, int w, int h, int x, int y, int SubWidth, int SubHeight);
+// Clears the color of fully transparent pixels
+void ClearTransparentPixels(uint8_t *pImageBuff, int w, int h);
+// Copies the pixels that are not fully transparent and clears all others
+void CopyOpaquePixels(uint8_t *pDest, const uint8_t *pSrc, int w, int h);
 
 // Returned buffer is allocated with malloc, must be freed by caller
 uint8_t *ResizeImage(const uint8_t *pImageData, int Width, int Height, int NewWidth, int NewHeight, int BPP);
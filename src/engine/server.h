@@ -82,39 +82,128 @@ public:
 	 */
 	virtual int GetClientVersion(int ClientId) const = 0;
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) = 0;
+	/**
+	 * Sends a message to multiple clients. It is packed at most once for
+	 * each protocol version instead of once per client.
+	 *
+	 * @param pMsg Message, the message id is translated for sixup clients.
+	 * @param Flags Message flags, the message is recorded once in the server
+	 * demos and in the demos of the recipients.
+	 * @param Recipients Clients to send the message to.
+	 *
+	 * @return `0` on success, `-1` if the message could not be packed.
+	 */
+	virtual int SendMsgBroadcast(CMsgPacker *pMsg, int Flags, const CClientMask &Recipients) = 0;
 
 	template<class T>
 		requires(!protocol7::is_sixup<T>::value)
 	int SendPackMsg(const T *pMsg, int Flags, int ClientId)
+	{
+		if(ClientId == -1)
+			return SendPackMsgBroadcast(pMsg, Flags, IngameClients());
+		return SendPackMsgTranslate(pMsg, Flags, ClientId);
+	}
+
+	template<class T>
+		requires(protocol7::is_sixup<T>::value)
+	int SendPackMsg(const T *pMsg, int Flags, int ClientId)
 	{
 		int Result = 0;
 		if(ClientId == -1)
+			Result = SendPackMsgBroadcast(pMsg, Flags, IngameClients());
+		else if(IsSixup(ClientId))
+			Result = SendPackMsgOne(pMsg, Flags, ClientId);
+
+		return Result;
+	}
+
+	// Sends the message to all ingame clients in the mask, recipients that
+	// need their client ids translated still get their own copy.
+	template<class T>
+	int SendPackMsgBroadcast(const T *pMsg, int Flags, CClientMask Recipients)
+	{
+		int Result = 0;
+		Recipients &= IngameClients();
+		for(int i = 0; i < MaxClients(); i++)
 		{
-			for(int i = 0; i < MaxClients(); i++)
-				if(ClientIngame(i))
-					Result = SendPackMsgTranslate(pMsg, Flags, i);
-		}
-		else
-		{
-			Result = SendPackMsgTranslate(pMsg, Flags, ClientId);
+			if(!Recipients.test(i))
+				continue;
+			if(protocol7::is_sixup<T>::value && !IsSixup(i))
+			{
+				Recipients.reset(i);
+			}
+			else if(!IsSixup(i) && GetClientVersion(i) < VERSION_DDNET_OLD)
+			{
+				Result = SendPackMsgTranslate(pMsg, Flags, i);
+				Recipients.reset(i);
+			}
 		}
+		if(Recipients.any())
+			Result = SendPackMsgBroadcastUntranslated(pMsg, Flags, Recipients);
 		return Result;
 	}
 
+	CClientMask IngameClients()
+	{
+		CClientMask Mask;
+		for(int i = 0; i < MaxClients(); i++)
+			if(ClientIngame(i))
+				Mask.set(i);
+		return Mask;
+	}
+
+	CClientMask SixupClients(const CClientMask &Recipients)
+	{
+		CClientMask Mask;
+		for(int i = 0; i < MaxClients(); i++)
+			if(Recipients.test(i) && IsSixup(i))
+				Mask.set(i);
+		return Mask;
+	}
+
 	template<class T>
-		requires(protocol7::is_sixup<T>::value)
-	int SendPackMsg(const T *pMsg, int Flags, int ClientId)
+	int SendPackMsgBroadcastUntranslated(const T *pMsg, int Flags, const CClientMask &Recipients)
 	{
+		CMsgPacker Packer(T::ms_MsgId, false, protocol7::is_sixup<T>::value);
+		if(pMsg->Pack(&Packer))
+			return -1;
+		return SendMsgBroadcast(&Packer, Flags, Recipients);
+	}
+
+	int SendPackMsgBroadcastUntranslated(const CNetMsg_Sv_Chat *pMsg, int Flags, const CClientMask &Recipients)
+	{
+		const CClientMask Sixup = SixupClients(Recipients);
 		int Result = 0;
-		if(ClientId == -1)
+		if((Recipients & ~Sixup).any())
+			Result = SendPackMsgBroadcastUntranslated<CNetMsg_Sv_Chat>(pMsg, Flags, Recipients & ~Sixup);
+		if(Sixup.any())
 		{
-			for(int i = 0; i < MaxClients(); i++)
-				if(ClientIngame(i) && IsSixup(i))
-					Result = SendPackMsgOne(pMsg, Flags, i);
+			protocol7::CNetMsg_Sv_Chat Msg7;
+			Msg7.m_ClientId = pMsg->m_ClientId;
+			Msg7.m_pMessage = pMsg->m_pMessage;
+			Msg7.m_Mode = pMsg->m_Team > 0 ? protocol7::CHAT_TEAM : protocol7::CHAT_ALL;
+			Msg7.m_TargetId = -1;
+			Result = SendPackMsgBroadcastUntranslated(&Msg7, Flags, Sixup);
 		}
-		else if(IsSixup(ClientId))
-			Result = SendPackMsgOne(pMsg, Flags, ClientId);
+		return Result;
+	}
 
+	int SendPackMsgBroadcastUntranslated(const CNetMsg_Sv_RaceFinish *pMsg, int Flags, const CClientMask &Recipients)
+	{
+		const CClientMask Sixup = SixupClients(Recipients);
+		int Result = 0;
+		if((Recipients & ~Sixup).any())
+			Result = SendPackMsgBroadcastUntranslated<CNetMsg_Sv_RaceFinish>(pMsg, Flags, Recipients & ~Sixup);
+		if(Sixup.any())
+		{
+			protocol7::CNetMsg_Sv_RaceFinish Msg7;
+			Msg7.m_ClientId = pMsg->m_ClientId;
+			Msg7.m_Diff = pMsg->m_Diff;
+			Msg7.m_Time = pMsg->m_Time;
+			Msg7.m_RecordPersonal = pMsg->m_RecordPersonal;
+			Msg7.m_RecordServer = pMsg->m_RecordServer;
+			Result = SendPackMsgBroadcastUntranslated(&Msg7, Flags, Sixup);
+		}
 		return Result;
 	}
 
@@ -290,6 +379,8 @@ public:
 
 	virtual void SetErrorShutdown(const char *pReason) = 0;
 	virtual void ExpireServerInfo() = 0;
+	// Like `ExpireServerInfo`, but only the given client's info changed.
+	virtual void ExpireClientServerInfo(int ClientId) = 0;
 
 	virtual void FillAntibot(CAntibotRoundData *pData) = 0;
 
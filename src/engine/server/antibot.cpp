@@ -8,12 +8,17 @@
 #include <engine/kernel.h>
 #include <engine/server.h>
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 class IEngineAntibot;
 
 #ifdef CONF_ANTIBOT
 CAntibot::CAntibot() :
-	m_pServer(0), m_pConsole(0), m_pGameServer(0), m_Initialized(false)
+	m_pServer(0), m_pConsole(0), m_pGameServer(0), m_Initialized(false), m_TickEvents(false)
 {
+	m_TickData.m_NumEvents = 0;
 }
 CAntibot::~CAntibot()
 {
@@ -80,6 +85,8 @@ void CAntibot::Init()
 	m_Data.m_pUser = this;
 	AntibotInit(&m_Data);
 
+	m_TickEvents = AntibotWantsTickEvents();
+	m_TickData.m_NumEvents = 0;
 	m_Initialized = true;
 }
 void CAntibot::RoundStart(IGameServer *pGameServer)
@@ -87,11 +94,18 @@ void CAntibot::RoundStart(IGameServer *pGameServer)
 	m_pGameServer = pGameServer;
 	mem_zero(&m_RoundData, sizeof(m_RoundData));
 	m_RoundData.m_Map.m_pTiles = 0;
+	m_TickData.m_NumEvents = 0;
 	AntibotRoundStart(&m_RoundData);
 	Update();
 }
 void CAntibot::RoundEnd()
 {
+	if(m_TickData.m_NumEvents > 0)
+	{
+		Update();
+		SendTickEvents();
+	}
+
 	// Let the external module clean up first
 	AntibotRoundEnd();
 
@@ -114,49 +128,127 @@ void CAntibot::Update()
 		AntibotUpdateData();
 	}
 }
+void CAntibot::AddTickEvent(int Type, int ClientId, int Arg)
+{
+	if(m_TickData.m_NumEvents == (int)std::size(m_TickData.m_aEvents))
+	{
+		Update();
+		SendTickEvents();
+	}
+	CAntibotEvent &Event = m_TickData.m_aEvents[m_TickData.m_NumEvents++];
+	Event.m_Type = Type;
+	Event.m_ClientId = ClientId;
+	Event.m_Arg = Arg;
+}
+void CAntibot::SendTickEvents()
+{
+	m_TickData.m_Tick = Server()->Tick();
+	m_TickData.m_NumVerdicts = 0;
+	AntibotOnTick(&m_TickData);
+	m_TickData.m_NumEvents = 0;
+
+	// kicking can send the events of the dropped player, which overwrites the verdicts
+	const int NumVerdicts = std::clamp(m_TickData.m_NumVerdicts, 0, (int)std::size(m_TickData.m_aVerdicts));
+	if(NumVerdicts == 0)
+		return;
+	std::vector<CAntibotVerdict> vVerdicts(m_TickData.m_aVerdicts, m_TickData.m_aVerdicts + NumVerdicts);
+	for(CAntibotVerdict &Verdict : vVerdicts)
+	{
+		Verdict.m_aMessage[sizeof(Verdict.m_aMessage) - 1] = '\0';
+		if(Verdict.m_Type == ANTIBOT_VERDICT_KICK)
+			Kick(Verdict.m_ClientId, Verdict.m_aMessage, this);
+		else if(Verdict.m_Type == ANTIBOT_VERDICT_REPORT)
+			Report(Verdict.m_ClientId, Verdict.m_aMessage, this);
+	}
+}
 
 void CAntibot::OnPlayerInit(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_PLAYER_INIT, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnPlayerInit(ClientId);
 }
 void CAntibot::OnPlayerDestroy(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_PLAYER_DESTROY, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnPlayerDestroy(ClientId);
 }
 void CAntibot::OnSpawn(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_SPAWN, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnSpawn(ClientId);
 }
 void CAntibot::OnHammerFireReloading(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_HAMMER_FIRE_RELOADING, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnHammerFireReloading(ClientId);
 }
 void CAntibot::OnHammerFire(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_HAMMER_FIRE, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnHammerFire(ClientId);
 }
 void CAntibot::OnHammerHit(int ClientId, int TargetId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_HAMMER_HIT, ClientId, TargetId);
+		return;
+	}
 	Update();
 	AntibotOnHammerHit(ClientId, TargetId);
 }
 void CAntibot::OnDirectInput(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_DIRECT_INPUT, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnDirectInput(ClientId);
 }
 void CAntibot::OnCharacterTick(int ClientId)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_CHARACTER_TICK, ClientId);
+		return;
+	}
 	Update();
 	AntibotOnCharacterTick(ClientId);
 }
 void CAntibot::OnHookAttach(int ClientId, bool Player)
 {
+	if(m_TickEvents)
+	{
+		AddTickEvent(ANTIBOT_EVENT_HOOK_ATTACH, ClientId, Player);
+		return;
+	}
 	Update();
 	AntibotOnHookAttach(ClientId, Player);
 }
@@ -164,16 +256,23 @@ void CAntibot::OnHookAttach(int ClientId, bool Player)
 void CAntibot::OnEngineTick()
 {
 	Update();
+	if(m_TickEvents)
+		SendTickEvents();
 	AntibotOnEngineTick();
 }
 void CAntibot::OnEngineClientJoin(int ClientId)
 {
 	Update();
+	// keep the events of a previous client with the same id before the join
+	if(m_TickData.m_NumEvents > 0)
+		SendTickEvents();
 	AntibotOnEngineClientJoin(ClientId);
 }
 void CAntibot::OnEngineClientDrop(int ClientId, const char *pReason)
 {
 	Update();
+	if(m_TickData.m_NumEvents > 0)
+		SendTickEvents();
 	AntibotOnEngineClientDrop(ClientId, pReason);
 }
 bool CAntibot::OnEngineClientMessage(int ClientId, const void *pData, int Size, int Flags)
@@ -212,7 +311,7 @@ bool CAntibot::OnEngineSimulateClientMessage(int *pClientId, void *pBuffer, int
 }
 #else
 CAntibot::CAntibot() :
-	m_pServer(nullptr), m_pConsole(nullptr), m_pGameServer(nullptr), m_Initialized(false)
+	m_pServer(nullptr), m_pConsole(nullptr), m_pGameServer(nullptr), m_Initialized(false), m_TickEvents(false)
 {
 }
 CAntibot::~CAntibot() = default;
@@ -19,7 +19,13 @@ class CAntibot : public IEngineAntibot
 	CAntibotRoundData m_RoundData;
 	bool m_Initialized;
 
+	// game events collected for `AntibotOnTick` if the module wants them
+	bool m_TickEvents;
+	CAntibotTickData m_TickData;
+
 	void Update();
+	void AddTickEvent(int Type, int ClientId, int Arg = 0);
+	void SendTickEvents();
 	static void Kick(int ClientId, const char *pMessage, void *pUser);
 	static void Log(const char *pMessage, void *pUser);
 	static void Report(int ClientId, const char *pMessage, void *pUser);
@@ -96,7 +96,8 @@ int main(int argc, const char **argv)
 	vpLoggers.push_back(pFutureConsoleLogger);
 	std::shared_ptr<CFutureLogger> pFutureAssertionLogger = std::make_shared<CFutureLogger>();
 	vpLoggers.push_back(pFutureAssertionLogger);
-	log_set_global_logger(log_logger_collection(std::move(vpLoggers)).release());
+	ILogger *pGlobalLogger = log_logger_collection(std::move(vpLoggers)).release();
+	log_set_global_logger(pGlobalLogger);
 
 	if(MysqlInit() != 0)
 	{
@@ -177,6 +178,7 @@ int main(int argc, const char **argv)
 	pConfigManager->SetReadOnly("sv_port", true);
 	pConfigManager->SetReadOnly("bindaddr", true);
 	pConfigManager->SetReadOnly("logfile", true);
+	pConfigManager->SetReadOnly("log_deferred", true);
 
 	if(g_Config.m_Logfile[0])
 	{
@@ -199,11 +201,18 @@ int main(int argc, const char **argv)
 
 	auto pServerLogger = std::make_shared<CServerLogger>(pServer);
 	pEngine->SetAdditionalLogger(pServerLogger);
+	pServer->SetServerLogger(pServerLogger.get());
+
+	if(g_Config.m_LogDeferred)
+	{
+		log_start_deferred(pGlobalLogger);
+	}
 
 	// run the server
 	log_trace("server", "initialization finished after %.2fms, starting...", (time_get() - MainStart) * 1000.0f / (float)time_freq());
 	int Ret = pServer->Run();
 
+	log_stop_deferred();
 	pServerLogger->OnServerDeletion();
 	// free
 	delete pKernel;
@@ -0,0 +1,94 @@
+#include "map_transfer.h"
+
+#include <base/math.h>
+#include <base/time.h>
+
+void CMapTransferWindow::Start(int Chunk, int InitialWindow)
+{
+	m_Active = true;
+	m_Acked = Chunk;
+	m_NextChunk = Chunk;
+	m_Window = std::clamp<float>(InitialWindow, MIN_WINDOW, MAX_WINDOW);
+	m_Threshold = MAX_WINDOW;
+	m_MinRtt = -1;
+	m_SmoothedRtt = -1;
+	m_LastDecrease = 0;
+}
+
+void CMapTransferWindow::OnRequest(int Chunk, int InitialWindow, int64_t Now)
+{
+	// requests arrive in order, anything else means that the client
+	// restarted its download
+	if(!m_Active || Chunk != m_Acked + 1 || Chunk > m_NextChunk)
+	{
+		Start(Chunk, InitialWindow);
+		return;
+	}
+	m_Acked = Chunk;
+
+	const int64_t Rtt = Now - m_aSendTime[(Chunk - 1) % MAX_WINDOW];
+	m_MinRtt = m_MinRtt < 0 ? Rtt : minimum(m_MinRtt, Rtt);
+	m_SmoothedRtt = m_SmoothedRtt < 0 ? Rtt : (7 * m_SmoothedRtt + Rtt) / 8;
+
+	const int64_t TargetDelay = maximum(m_MinRtt, time_freq() * TARGET_DELAY_MS / 1000);
+	if(Rtt - m_MinRtt > TargetDelay)
+	{
+		// back off at most once per round trip, the chunks sent before
+		// the last decrease queue up as well
+		if(Now - m_LastDecrease > m_SmoothedRtt)
+		{
+			m_Window = maximum<float>(MIN_WINDOW, m_Window * 0.7f);
+			m_Threshold = m_Window;
+			m_LastDecrease = Now;
+		}
+	}
+	else if(m_Window < m_Threshold)
+	{
+		m_Window = minimum<float>(MAX_WINDOW, m_Window + 1.0f);
+	}
+	else
+	{
+		m_Window = minimum<float>(MAX_WINDOW, m_Window + 1.0f / m_Window);
+	}
+}
+
+int CMapTransferWindow::NextChunk(int NumChunks) const
+{
+	if(!m_Active || m_NextChunk >= NumChunks || InFlight() >= (int)m_Window)
+		return -1;
+	return m_NextChunk;
+}
+
+void CMapTransferWindow::OnSent(int Chunk, int64_t Now)
+{
+	m_aSendTime[Chunk % MAX_WINDOW] = Now;
+	m_NextChunk = Chunk + 1;
+}
+
+void CMapTransferLimiter::SetRate(int64_t BytesPerSecond, int64_t Now)
+{
+	if(BytesPerSecond == m_BytesPerSecond)
+		return;
+	m_BytesPerSecond = BytesPerSecond;
+	m_Tokens = 0;
+	m_LastRefill = Now;
+}
+
+bool CMapTransferLimiter::Consume(int Bytes, int64_t Now)
+{
+	if(!Limited())
+		return true;
+
+	// allow bursts of 100ms
+	const int64_t Elapsed = minimum(Now - m_LastRefill, time_freq());
+	const int64_t Refill = Elapsed * m_BytesPerSecond / time_freq();
+	if(Refill > 0)
+	{
+		m_Tokens = minimum(m_Tokens + Refill, m_BytesPerSecond / 10);
+		m_LastRefill = Now;
+	}
+	if(m_Tokens <= 0)
+		return false;
+	m_Tokens -= Bytes;
+	return true;
+}
@@ -0,0 +1,67 @@
+#ifndef ENGINE_SERVER_MAP_TRANSFER_H
+#define ENGINE_SERVER_MAP_TRANSFER_H
+
+#include <cstdint>
+
+// Send-ahead window of a map download over the game connection. The client
+// requests chunk N once it received chunk N - 1, so every request
+// acknowledges a chunk. The window grows while the round trip time of the
+// acknowledged chunks stays close to the smallest one seen and shrinks once
+// chunks start to queue up or get lost and resent.
+class CMapTransferWindow
+{
+public:
+	enum
+	{
+		MIN_WINDOW = 2,
+		// the resend buffer of the connection must hold all unacknowledged chunks
+		MAX_WINDOW = 24,
+		// queueing delay tolerated on top of the smallest round trip time
+		TARGET_DELAY_MS = 25,
+	};
+
+private:
+	bool m_Active = false;
+	// chunks before this one were received by the client
+	int m_Acked = 0;
+	int m_NextChunk = 0;
+	float m_Window = 0.0f;
+	float m_Threshold = 0.0f;
+	int64_t m_MinRtt = -1;
+	int64_t m_SmoothedRtt = -1;
+	int64_t m_LastDecrease = 0;
+	int64_t m_aSendTime[MAX_WINDOW];
+
+public:
+	void Reset() { m_Active = false; }
+	// Starts the transfer at `Chunk`, also used when the client restarts
+	// its download.
+	void Start(int Chunk, int InitialWindow);
+	// Handles the client's request of `Chunk`.
+	void OnRequest(int Chunk, int InitialWindow, int64_t Now);
+	// Returns the next chunk that fits into the window or -1.
+	int NextChunk(int NumChunks) const;
+	void OnSent(int Chunk, int64_t Now);
+
+	bool Active() const { return m_Active; }
+	int Window() const { return (int)m_Window; }
+	int InFlight() const { return m_NextChunk - m_Acked; }
+	int64_t SmoothedRtt() const { return m_SmoothedRtt; }
+};
+
+// Token bucket shared by all map downloads to cap the upload bandwidth.
+class CMapTransferLimiter
+{
+	int64_t m_BytesPerSecond = 0;
+	int64_t m_Tokens = 0;
+	int64_t m_LastRefill = 0;
+
+public:
+	// 0 disables the limit.
+	void SetRate(int64_t BytesPerSecond, int64_t Now);
+	// Returns whether `Bytes` may be sent now and takes them from the bucket.
+	bool Consume(int Bytes, int64_t Now);
+	bool Limited() const { return m_BytesPerSecond > 0; }
+};
+
+#endif
@@ -5,6 +5,8 @@
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
+
 CNameBan::CNameBan(const char *pName, const char *pReason, int Distance, bool IsSubstring) :
 	m_Distance(Distance), m_IsSubstring(IsSubstring)
 {
@@ -37,11 +39,13 @@ void CNameBans::Ban(const char *pName, const char *pReason, const int Distance,
 			str_copy(Ban.m_aReason, pReason);
 			Ban.m_Distance = Distance;
 			Ban.m_IsSubstring = IsSubstring;
+			m_IndexValid = false;
 			return;
 		}
 	}
 
 	m_vNameBans.emplace_back(pName, pReason, Distance, IsSubstring);
+	m_IndexValid = false;
 	if(m_pConsole)
 	{
 		char aBuf[256];
@@ -71,6 +75,7 @@ void CNameBans::Unban(const char *pName)
 			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 		}
 		m_vNameBans.erase(ToRemove, m_vNameBans.end());
+		m_IndexValid = false;
 	}
 }
 
@@ -87,8 +92,65 @@ void CNameBans::Dump() const
 	}
 }
 
+static uint64_t HashPieceAppend(uint64_t Hash, int Codepoint)
+{
+	return (Hash ^ (uint32_t)Codepoint) * 0x100000001b3ull;
+}
+
+static uint64_t HashPiece(const int *pCodepoints, int Length)
+{
+	uint64_t Hash = 0xcbf29ce484222325ull;
+	for(int i = 0; i < Length; i++)
+		Hash = HashPieceAppend(Hash, pCodepoints[i]);
+	return Hash;
+}
+
+void CNameBans::BuildIndex() const
+{
+	m_PieceBans.clear();
+	m_PieceLengths = 0;
+	m_vShortBans.clear();
+	m_SubstringMatcher.Clear();
+	m_vSubstringBans.clear();
+	m_LastEmptySubstringBan = -1;
+	for(int i = 0; i < (int)m_vNameBans.size(); i++)
+	{
+		const CNameBan &Ban = m_vNameBans[i];
+		if(Ban.m_Distance >= Ban.m_SkeletonLength)
+		{
+			m_vShortBans.push_back(i);
+		}
+		else if(Ban.m_Distance >= 0)
+		{
+			const int NumPieces = Ban.m_Distance + 1;
+			int Start = 0;
+			for(int Piece = 0; Piece < NumPieces; Piece++)
+			{
+				const int End = (int)((int64_t)Ban.m_SkeletonLength * (Piece + 1) / NumPieces);
+				m_PieceBans[HashPiece(&Ban.m_aSkeleton[Start], End - Start)].push_back(i);
+				m_PieceLengths |= (uint64_t)1 << (End - Start - 1);
+				Start = End;
+			}
+		}
+
+		if(Ban.m_IsSubstring)
+		{
+			// an empty substring is found in every non-empty name
+			if(Ban.m_aName[0] == '\0')
+				m_LastEmptySubstringBan = i;
+			m_SubstringMatcher.Add(Ban.m_aName);
+			m_vSubstringBans.push_back(i);
+		}
+	}
+	m_SubstringMatcher.Build();
+	m_IndexValid = true;
+}
+
 const CNameBan *CNameBans::IsBanned(const char *pName) const
 {
+	if(!m_IndexValid)
+		BuildIndex();
+
 	char aTrimmed[MAX_NAME_LENGTH];
 	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
 	str_utf8_trim_right(aTrimmed);
@@ -97,14 +159,40 @@ const CNameBan *CNameBans::IsBanned(const char *pName) const
 	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
 	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
 
-	const CNameBan *pResult = nullptr;
-	for(const CNameBan &Ban : m_vNameBans)
+	// collect the bans with a piece in the skeleton
+	std::vector<int> vCandidates = m_vShortBans;
+	for(int Start = 0; Start < SkeletonLength; Start++)
+	{
+		uint64_t Hash = 0xcbf29ce484222325ull;
+		for(int Length = 1; Start + Length <= SkeletonLength && Length <= 64 && (m_PieceLengths >> (Length - 1)) != 0; Length++)
+		{
+			Hash = HashPieceAppend(Hash, aSkeleton[Start + Length - 1]);
+			if(!(m_PieceLengths & ((uint64_t)1 << (Length - 1))))
+				continue;
+			const auto It = m_PieceBans.find(Hash);
+			if(It != m_PieceBans.end())
+				vCandidates.insert(vCandidates.end(), It->second.begin(), It->second.end());
+		}
+	}
+	std::sort(vCandidates.begin(), vCandidates.end());
+	vCandidates.erase(std::unique(vCandidates.begin(), vCandidates.end()), vCandidates.end());
+
+	// the ban added last wins if multiple bans match
+	int Result = -1;
+	for(const int Candidate : vCandidates)
 	{
-		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
-		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring && str_utf8_find_nocase(pName, Ban.m_aName)))
-			pResult = &Ban;
+		const CNameBan &Ban = m_vNameBans[Candidate];
+		if(absolute(Ban.m_SkeletonLength - SkeletonLength) > Ban.m_Distance)
+			continue;
+		if(str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer)) <= Ban.m_Distance)
+			Result = Candidate;
 	}
-	return pResult;
+	if(pName[0] != '\0')
+		Result = maximum(Result, m_LastEmptySubstringBan);
+	m_SubstringMatcher.FindAll(pName, [&](int Pattern, const char *, const char *) {
+		Result = maximum(Result, m_vSubstringBans[Pattern]);
+	});
+	return Result == -1 ? nullptr : &m_vNameBans[Result];
 }
 
 void CNameBans::ConNameBan(IConsole::IResult *pResult, void *pUser)
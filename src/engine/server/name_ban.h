@@ -3,7 +3,10 @@
 
 #include <engine/console.h>
 #include <engine/shared/protocol.h>
+#include <engine/shared/substring_matcher.h>
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 enum
@@ -30,6 +33,22 @@ class CNameBans
 	IConsole *m_pConsole = nullptr;
 	std::vector<CNameBan> m_vNameBans;
 
+	// index for IsBanned, rebuilt lazily after the bans changed
+	mutable bool m_IndexValid = false;
+	// The skeleton of every ban is split into distance + 1 pieces. At least
+	// one of them is left unchanged by the edits and found in the skeleton of
+	// a matching name, so only bans with such a piece need to be checked.
+	mutable std::unordered_map<uint64_t, std::vector<int>> m_PieceBans;
+	mutable uint64_t m_PieceLengths = 0; // bit n - 1 set if a piece has length n
+	// bans with fewer codepoints than pieces, checked for every name
+	mutable std::vector<int> m_vShortBans;
+	// substring bans, pattern index to ban index
+	mutable CSubstringMatcher m_SubstringMatcher;
+	mutable std::vector<int> m_vSubstringBans;
+	mutable int m_LastEmptySubstringBan = -1;
+
+	void BuildIndex() const;
+
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
@@ -6,6 +6,7 @@
 #include "databases/connection.h"
 #include "databases/connection_pool.h"
 #include "register.h"
+#include "server_logger.h"
 
 #include <base/bytes.h>
 #include <base/fs.h>
@@ -226,8 +227,10 @@ void CServer::CClient::Reset()
 	m_SnapRate = CClient::SNAPRATE_INIT;
 	m_Score = -1;
 	m_NextMapChunk = 0;
+	m_MapTransfer.Reset();
 	m_Flags = 0;
 	m_RedirectDropTime = 0;
+	m_ServerInfo.m_Dirty = true;
 }
 
 CServer::CServer()
@@ -262,6 +265,14 @@ CServer::CServer()
 	m_ServerInfoFirstRequest = 0;
 	m_ServerInfoNumRequests = 0;
 
+	m_ServerInfoStatsSince = time_get();
+	m_ServerInfoRequests = 0;
+	m_ServerInfoLimitedRequests = 0;
+	m_ServerInfoSentPackets = 0;
+	m_ServerInfoSentBytes = 0;
+	m_ServerInfoUpdates = 0;
+	m_ServerInfoEntryUpdates = 0;
+
 #ifdef CONF_FAMILY_UNIX
 	m_ConnLoggingSocketCreated = false;
 #endif
@@ -401,6 +412,7 @@ bool CServer::SetClientNameImpl(int ClientId, const char *pNameRequest, bool Set
 	{
 		// set the client name
 		str_copy(m_aClients[ClientId].m_aName, aNameTry);
+		m_aClients[ClientId].m_ServerInfo.m_Dirty = true;
 		GameServer()->TeehistorianRecordPlayerName(ClientId, m_aClients[ClientId].m_aName);
 	}
 
@@ -439,10 +451,11 @@ bool CServer::SetClientClanImpl(int ClientId, const char *pClanRequest, bool Set
 
 	bool Changed = str_comp(m_aClients[ClientId].m_aClan, aTrimmedClan) != 0;
 
-	if(Set)
+	if(Set && Changed)
 	{
 		// set the client clan
 		str_copy(m_aClients[ClientId].m_aClan, aTrimmedClan);
+		m_aClients[ClientId].m_ServerInfo.m_Dirty = true;
 	}
 
 	return Changed;
@@ -473,6 +486,9 @@ void CServer::SetClientCountry(int ClientId, int Country)
 	if(ClientId < 0 || ClientId >= MAX_CLIENTS || m_aClients[ClientId].m_State < CClient::STATE_READY)
 		return;
 
+	if(m_aClients[ClientId].m_Country != Country)
+		m_aClients[ClientId].m_ServerInfo.m_Dirty = true;
+
 	m_aClients[ClientId].m_Country = Country;
 }
 
@@ -482,7 +498,7 @@ void CServer::SetClientScore(int ClientId, std::optional<int> Score)
 		return;
 
 	if(m_aClients[ClientId].m_Score != Score)
-		ExpireServerInfo();
+		ExpireClientServerInfo(ClientId);
 
 	m_aClients[ClientId].m_Score = Score;
 }
@@ -979,6 +995,69 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientId)
 	return 0;
 }
 
+int CServer::SendMsgBroadcast(CMsgPacker *pMsg, int Flags, const CClientMask &Recipients)
+{
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(CNetChunk));
+	if(Flags & MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags & MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+
+	// each protocol version is only packed once and only if a recipient uses it
+	CPacker aPackers[2];
+	bool aPacked[2] = {false, false};
+	bool aFailed[2] = {false, false};
+	const auto &&GetPacker = [&](bool Sixup) -> CPacker * {
+		if(!aPacked[Sixup] && !aFailed[Sixup])
+		{
+			if(RepackMsg(pMsg, aPackers[Sixup], Sixup))
+				aPacked[Sixup] = true;
+			else
+				aFailed[Sixup] = true;
+		}
+		return aPacked[Sixup] ? &aPackers[Sixup] : nullptr;
+	};
+
+	bool Sent = false;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!Recipients.test(i) || m_aClients[i].m_State == CClient::STATE_EMPTY)
+			continue;
+
+		// the message may not exist in the protocol of this client, the others still get it
+		CPacker *pPack = GetPacker(m_aClients[i].m_Sixup);
+		if(!pPack)
+			continue;
+		Packet.m_ClientId = i;
+		Packet.m_pData = pPack->Data();
+		Packet.m_DataSize = pPack->Size();
+		if(Antibot()->OnEngineServerMessage(i, Packet.m_pData, Packet.m_DataSize, Flags))
+			continue;
+
+		Sent = true;
+		if(!(Flags & MSGFLAG_NORECORD) && m_aDemoRecorder[i].IsRecording())
+			m_aDemoRecorder[i].RecordMessage(Packet.m_pData, Packet.m_DataSize);
+		if(!(Flags & MSGFLAG_NOSEND))
+			m_NetServer.Send(&Packet);
+	}
+
+	// the server demos get the message once instead of once per recipient
+	if(Sent && !(Flags & MSGFLAG_NORECORD) && (m_aDemoRecorder[RECORDER_MANUAL].IsRecording() || m_aDemoRecorder[RECORDER_AUTO].IsRecording()))
+	{
+		CPacker *pPack = GetPacker(false);
+		if(pPack)
+		{
+			if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording())
+				m_aDemoRecorder[RECORDER_MANUAL].RecordMessage(pPack->Data(), pPack->Size());
+			if(m_aDemoRecorder[RECORDER_AUTO].IsRecording())
+				m_aDemoRecorder[RECORDER_AUTO].RecordMessage(pPack->Data(), pPack->Size());
+		}
+	}
+
+	return aFailed[false] || aFailed[true] ? -1 : 0;
+}
+
 void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 {
 	CNetChunk Packet;
@@ -998,8 +1077,58 @@ void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 	m_NetServer.Send(&Packet);
 }
 
+void CServer::DoGameTick()
+{
+	GameServer()->OnPreTickTeehistorian();
+	UpdateDebugDummies(false);
+
+	for(int c = 0; c < MAX_CLIENTS; c++)
+	{
+		if(m_aClients[c].m_State != CClient::STATE_INGAME)
+			continue;
+		bool ClientHadInput = false;
+		for(auto &Input : m_aClients[c].m_aInputs)
+		{
+			if(Input.m_GameTick == Tick() + 1)
+			{
+				GameServer()->OnClientPredictedEarlyInput(c, Input.m_aData);
+				ClientHadInput = true;
+				break;
+			}
+		}
+		if(!ClientHadInput)
+			GameServer()->OnClientPredictedEarlyInput(c, nullptr);
+	}
+
+	m_CurrentGameTick++;
+
+	// apply new input
+	for(int c = 0; c < MAX_CLIENTS; c++)
+	{
+		if(m_aClients[c].m_State != CClient::STATE_INGAME)
+			continue;
+		bool ClientHadInput = false;
+		for(auto &Input : m_aClients[c].m_aInputs)
+		{
+			if(Input.m_GameTick == Tick())
+			{
+				GameServer()->OnClientPredictedInput(c, Input.m_aData);
+				ClientHadInput = true;
+				break;
+			}
+		}
+		if(!ClientHadInput)
+			GameServer()->OnClientPredictedInput(c, nullptr);
+	}
+
+	const int64_t OnTickStart = time_get();
+	GameServer()->OnTick();
+	m_OnTickDuration = time_get() - OnTickStart;
+}
+
 void CServer::DoSnapshot()
 {
+	m_OnSnapDuration = 0;
 	bool IsGlobalSnap = Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0;
 
 	if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording() || m_aDemoRecorder[RECORDER_AUTO].IsRecording())
@@ -1042,7 +1171,9 @@ void CServer::DoSnapshot()
 			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
 
 			// only snap events on global ticks
+			const int64_t OnSnapStart = time_get();
 			GameServer()->OnSnap(i, IsGlobalSnap, m_aDemoRecorder[i].IsRecording());
+			m_OnSnapDuration += time_get() - OnSnapStart;
 
 			// finish snapshot
 			char aData[CSnapshot::MAX_SIZE];
@@ -1365,6 +1496,7 @@ void CServer::SendMap(int ClientId)
 	}
 
 	m_aClients[ClientId].m_NextMapChunk = 0;
+	m_aClients[ClientId].m_MapTransfer.Reset();
 }
 
 void CServer::SendMapData(int ClientId, int Chunk)
@@ -1403,6 +1535,42 @@ void CServer::SendMapData(int ClientId, int Chunk)
 	}
 }
 
+bool CServer::SendNextMapData(int ClientId, int64_t Now)
+{
+	const int MapType = IsSixup(ClientId) ? MAP_TYPE_SIXUP : MAP_TYPE_SIX;
+	const int ChunkSize = NET_MAX_CHUNK_SIZE - 128;
+	const int NumChunks = (m_aCurrentMapSize[MapType] + ChunkSize - 1) / ChunkSize;
+	CMapTransferWindow &Transfer = m_aClients[ClientId].m_MapTransfer;
+	const int Chunk = Transfer.NextChunk(NumChunks);
+	if(Chunk < 0 || !m_MapTransferLimiter.Consume(ChunkSize, Now))
+		return false;
+	SendMapData(ClientId, Chunk);
+	Transfer.OnSent(Chunk, Now);
+	return true;
+}
+
+void CServer::PumpMapTransfers()
+{
+	const int64_t Now = time_get();
+	m_MapTransferLimiter.SetRate((int64_t)Config()->m_SvMapDownloadRate * 1024, Now);
+
+	// send one chunk per client and round to share the bandwidth limit,
+	// starting with another client every time
+	const int FirstClient = m_MapTransferFirstClient;
+	m_MapTransferFirstClient = (m_MapTransferFirstClient + 1) % MAX_CLIENTS;
+	bool Sent = true;
+	while(Sent)
+	{
+		Sent = false;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const int ClientId = (FirstClient + i) % MAX_CLIENTS;
+			if(m_aClients[ClientId].m_State == CClient::STATE_CONNECTING && m_aClients[ClientId].m_MapTransfer.Active())
+				Sent |= SendNextMapData(ClientId, Now);
+		}
+	}
+}
+
 void CServer::SendMapReload(int ClientId)
 {
 	CMsgPacker Msg(NETMSG_MAP_RELOAD, true);
@@ -1785,6 +1953,12 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			{
 				return;
 			}
+			if(Config()->m_SvFastDownload && Config()->m_SvMapWindowAdaptive)
+			{
+				// the chunks are sent by PumpMapTransfers
+				m_aClients[ClientId].m_MapTransfer.OnRequest(Chunk, Config()->m_SvMapWindow, time_get());
+				return;
+			}
 			if(Chunk != m_aClients[ClientId].m_NextMapChunk || !Config()->m_SvFastDownload)
 			{
 				SendMapData(ClientId, Chunk);
@@ -2160,6 +2334,16 @@ void CServer::OnNetMsgRconAuth(int ClientId, const char *pName, const char *pPw,
 	}
 }
 
+static inline int GetCacheIndex(int Type, bool SendClient)
+{
+	if(Type == SERVERINFO_INGAME)
+		Type = SERVERINFO_VANILLA;
+	else if(Type == SERVERINFO_EXTENDED_MORE)
+		Type = SERVERINFO_EXTENDED;
+
+	return Type * 2 + SendClient;
+}
+
 bool CServer::RateLimitServerInfoConnless()
 {
 	bool SendClients = true;
@@ -2179,22 +2363,17 @@ bool CServer::RateLimitServerInfoConnless()
 		}
 	}
 
+	m_ServerInfoRequests++;
+	if(!SendClients)
+		m_ServerInfoLimitedRequests++;
 	return SendClients;
 }
 
 void CServer::SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type)
 {
-	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
-}
-
-static inline int GetCacheIndex(int Type, bool SendClient)
-{
-	if(Type == SERVERINFO_INGAME)
-		Type = SERVERINFO_VANILLA;
-	else if(Type == SERVERINFO_EXTENDED_MORE)
-		Type = SERVERINFO_EXTENDED;
-
-	return Type * 2 + SendClient;
+	const bool SendClients = RateLimitServerInfoConnless();
+	m_ServerInfoSentPackets += m_aServerInfoCache[GetCacheIndex(Type, SendClients)].m_vCache.size();
+	m_ServerInfoSentBytes += SendServerInfo(pAddr, Token, Type, SendClients);
 }
 
 CServer::CCache::CCache()
@@ -2222,6 +2401,95 @@ void CServer::CCache::Clear()
 	m_vCache.clear();
 }
 
+void CServer::UpdateClientServerInfo(int ClientId)
+{
+	CClient &Client = m_aClients[ClientId];
+	CServerInfoEntry &Entry = Client.m_ServerInfo;
+	char aBuf[16];
+
+	CPacker Packer;
+	Packer.Reset();
+
+#define ADD_INT(p, x) \
+	do \
+	{ \
+		str_format(aBuf, sizeof(aBuf), "%d", x); \
+		(p).AddString(aBuf, 0); \
+	} while(0)
+
+	Packer.AddString(ClientName(ClientId), MAX_NAME_LENGTH); // client name
+	Packer.AddString(ClientClan(ClientId), MAX_CLAN_LENGTH); // client clan
+
+	ADD_INT(Packer, Client.m_Country); // client country (ISO 3166-1 numeric)
+
+	int Score;
+	if(Client.m_Score.has_value())
+	{
+		Score = Client.m_Score.value();
+		if(Score == -FinishTime::NOT_FINISHED_TIMESCORE)
+			Score = FinishTime::NOT_FINISHED_TIMESCORE - 1;
+		else if(Score == 0) // 0 time isn't displayed otherwise.
+			Score = -1;
+		else
+			Score = -Score;
+	}
+	else
+	{
+		Score = FinishTime::NOT_FINISHED_TIMESCORE;
+	}
+
+	ADD_INT(Packer, Score); // client score
+	ADD_INT(Packer, GameServer()->IsClientPlayer(ClientId) ? 1 : 0); // is player?
+	Packer.AddString("", 0); // extra info, reserved
+#undef ADD_INT
+
+	dbg_assert(Packer.Size() <= (int)sizeof(Entry.m_aData), "Server info entry too large: %d", Packer.Size());
+	mem_copy(Entry.m_aData, Packer.Data(), Packer.Size());
+	Entry.m_DataSize = Packer.Size();
+
+	Packer.Reset();
+	Packer.AddString(ClientName(ClientId), MAX_NAME_LENGTH); // client name
+	Packer.AddString(ClientClan(ClientId), MAX_CLAN_LENGTH); // client clan
+	Packer.AddInt(Client.m_Country); // client country (ISO 3166-1 numeric)
+	Packer.AddInt(Client.m_Score.value_or(-1)); // client score
+	Packer.AddInt(GameServer()->IsClientPlayer(ClientId) ? 0 : 1); // flag spectator=1, bot=2 (player=0)
+
+	dbg_assert(Packer.Size() <= (int)sizeof(Entry.m_aSixupData), "Sixup server info entry too large: %d", Packer.Size());
+	mem_copy(Entry.m_aSixupData, Packer.Data(), Packer.Size());
+	Entry.m_SixupDataSize = Packer.Size();
+
+	// indented to be spliced into the clients array of the register info
+	CJsonStringWriter JsonWriter(2);
+
+	JsonWriter.BeginObject();
+
+	JsonWriter.WriteAttribute("name");
+	JsonWriter.WriteStrValue(ClientName(ClientId));
+
+	JsonWriter.WriteAttribute("clan");
+	JsonWriter.WriteStrValue(ClientClan(ClientId));
+
+	JsonWriter.WriteAttribute("country");
+	JsonWriter.WriteIntValue(Client.m_Country); // ISO 3166-1 numeric
+
+	JsonWriter.WriteAttribute("score");
+	JsonWriter.WriteIntValue(Client.m_Score.value_or(FinishTime::NOT_FINISHED_TIMESCORE));
+
+	JsonWriter.WriteAttribute("is_player");
+	JsonWriter.WriteBoolValue(GameServer()->IsClientPlayer(ClientId));
+
+	GameServer()->OnUpdatePlayerServerInfo(&JsonWriter, ClientId);
+
+	JsonWriter.EndObject();
+
+	Entry.m_Json = JsonWriter.GetOutputString();
+	Entry.m_Json.pop_back(); // trailing newline
+
+	Entry.m_State = Client.m_State;
+	Entry.m_Dirty = false;
+	m_ServerInfoEntryUpdates++;
+}
+
 void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 {
 	pCache->Clear();
@@ -2386,31 +2654,9 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 			int PreviousSize = q.Size();
 
-			q.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-			q.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-
-			ADD_INT(q, m_aClients[i].m_Country); // client country (ISO 3166-1 numeric)
-
-			int Score;
-			if(m_aClients[i].m_Score.has_value())
-			{
-				Score = m_aClients[i].m_Score.value();
-				if(Score == -FinishTime::NOT_FINISHED_TIMESCORE)
-					Score = FinishTime::NOT_FINISHED_TIMESCORE - 1;
-				else if(Score == 0) // 0 time isn't displayed otherwise.
-					Score = -1;
-				else
-					Score = -Score;
-			}
-			else
-			{
-				Score = FinishTime::NOT_FINISHED_TIMESCORE;
-			}
-
-			ADD_INT(q, Score); // client score
-			ADD_INT(q, GameServer()->IsClientPlayer(i) ? 1 : 0); // is player?
-			if(Type == SERVERINFO_EXTENDED)
-				q.AddString("", 0); // extra info, reserved
+			// only the extended server info has the reserved extra info
+			const CServerInfoEntry &Entry = m_aClients[i].m_ServerInfo;
+			q.AddRaw(Entry.m_aData, Type == SERVERINFO_EXTENDED ? Entry.m_DataSize : Entry.m_DataSize - 1);
 
 			if(Type == SERVERINFO_EXTENDED)
 			{
@@ -2499,11 +2745,8 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxCons
 		{
 			if(m_aClients[i].IncludedInServerInfo())
 			{
-				Packer.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-				Packer.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-				Packer.AddInt(m_aClients[i].m_Country); // client country (ISO 3166-1 numeric)
-				Packer.AddInt(m_aClients[i].m_Score.value_or(-1)); // client score
-				Packer.AddInt(GameServer()->IsClientPlayer(i) ? 0 : 1); // flag spectator=1, bot=2 (player=0)
+				const CServerInfoEntry &Entry = m_aClients[i].m_ServerInfo;
+				Packer.AddRaw(Entry.m_aSixupData, Entry.m_SixupDataSize);
 
 				const int MaxPacketSize = NET_MAX_PAYLOAD - 128;
 				if(MaxConsideredClients == MAX_CLIENTS)
@@ -2528,7 +2771,7 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxCons
 	pCache->AddChunk(Packer.Data(), Packer.Size());
 }
 
-void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
+int CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
 	CPacker p;
 	char aBuf[128];
@@ -2549,6 +2792,7 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
+	int SentBytes = 0;
 	for(const auto &Chunk : pCache->m_vCache)
 	{
 		p.Reset();
@@ -2579,7 +2823,9 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 		Packet.m_pData = p.Data();
 		Packet.m_DataSize = p.Size();
 		m_NetServer.Send(&Packet);
+		SentBytes += p.Size();
 	}
+	return SentBytes;
 }
 
 void CServer::GetServerInfoSixup(CPacker *pPacker, bool SendClients)
@@ -2615,6 +2861,15 @@ void CServer::FillAntibot(CAntibotRoundData *pData)
 
 void CServer::ExpireServerInfo()
 {
+	for(auto &Client : m_aClients)
+		Client.m_ServerInfo.m_Dirty = true;
+	m_ServerInfoNeedsUpdate = true;
+}
+
+void CServer::ExpireClientServerInfo(int ClientId)
+{
+	dbg_assert(0 <= ClientId && ClientId < MAX_CLIENTS, "Invalid ClientId: %d", ClientId);
+	m_aClients[ClientId].m_ServerInfo.m_Dirty = true;
 	m_ServerInfoNeedsUpdate = true;
 }
 
@@ -2728,30 +2983,11 @@ void CServer::UpdateRegisterServerInfo()
 	JsonWriter.WriteAttribute("clients");
 	JsonWriter.BeginArray();
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(const auto &Client : m_aClients)
 	{
-		if(m_aClients[i].IncludedInServerInfo())
+		if(Client.IncludedInServerInfo())
 		{
-			JsonWriter.BeginObject();
-
-			JsonWriter.WriteAttribute("name");
-			JsonWriter.WriteStrValue(ClientName(i));
-
-			JsonWriter.WriteAttribute("clan");
-			JsonWriter.WriteStrValue(ClientClan(i));
-
-			JsonWriter.WriteAttribute("country");
-			JsonWriter.WriteIntValue(m_aClients[i].m_Country); // ISO 3166-1 numeric
-
-			JsonWriter.WriteAttribute("score");
-			JsonWriter.WriteIntValue(m_aClients[i].m_Score.value_or(FinishTime::NOT_FINISHED_TIMESCORE));
-
-			JsonWriter.WriteAttribute("is_player");
-			JsonWriter.WriteBoolValue(GameServer()->IsClientPlayer(i));
-
-			GameServer()->OnUpdatePlayerServerInfo(&JsonWriter, i);
-
-			JsonWriter.EndObject();
+			JsonWriter.WriteRawValue(Client.m_ServerInfo.m_Json.c_str(), Client.m_ServerInfo.m_Json.size());
 		}
 	}
 
@@ -2766,6 +3002,14 @@ void CServer::UpdateServerInfo(bool Resend)
 	if(m_RunServer == UNINITIALIZED)
 		return;
 
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CClient &Client = m_aClients[i];
+		if(Client.IncludedInServerInfo() && (Client.m_ServerInfo.m_Dirty || Client.m_ServerInfo.m_State != Client.m_State))
+			UpdateClientServerInfo(i);
+	}
+	m_ServerInfoUpdates++;
+
 	UpdateRegisterServerInfo();
 
 	for(int i = 0; i < 3; i++)
@@ -2850,6 +3094,8 @@ void CServer::PumpNetwork(bool PacketWaiting)
 						Packer.AddInt(SrvBrwsToken);
 						GetServerInfoSixup(&Packer, RateLimitServerInfoConnless());
 						CNetBase::SendPacketConnlessWithToken7(m_NetServer.Socket(), &Packet.m_Address, Packer.Data(), Packer.Size(), ResponseToken, m_NetServer.GetToken(Packet.m_Address));
+						m_ServerInfoSentPackets++;
+						m_ServerInfoSentBytes += Packer.Size();
 					}
 					else if(Type != -1)
 					{
@@ -2894,6 +3140,8 @@ void CServer::PumpNetwork(bool PacketWaiting)
 		}
 	}
 
+	PumpMapTransfers();
+
 	m_ServerBan.Update();
 	m_Econ.Update();
 }
@@ -3001,6 +3249,32 @@ int CServer::LoadMap(const char *pMapName)
 	return 1;
 }
 
+void CServer::AddDebugClient(int ClientId, bool Sixup)
+{
+	CClient &Client = m_aClients[ClientId];
+	NewClientCallback(ClientId, this, Sixup);
+	Client.m_DebugDummy = true;
+
+	// See https://en.wikipedia.org/wiki/Unique_local_address
+	Client.m_DebugDummyAddr.type = NETTYPE_IPV6;
+	Client.m_DebugDummyAddr.ip[0] = 0xfd;
+	// Global ID (40 bits): random
+	secure_random_fill(&Client.m_DebugDummyAddr.ip[1], 5);
+	// Subnet ID (16 bits): constant
+	Client.m_DebugDummyAddr.ip[6] = 0xc0;
+	Client.m_DebugDummyAddr.ip[7] = 0xde;
+	// Interface ID (64 bits): set to client ID
+	Client.m_DebugDummyAddr.ip[8] = 0x00;
+	Client.m_DebugDummyAddr.ip[9] = 0x00;
+	Client.m_DebugDummyAddr.ip[10] = 0x00;
+	Client.m_DebugDummyAddr.ip[11] = 0x00;
+	uint_to_bytes_be(&Client.m_DebugDummyAddr.ip[12], ClientId);
+	// Port: random like normal clients
+	Client.m_DebugDummyAddr.port = secure_rand_below(65535 - 1024) + 1024;
+	net_addr_str(&Client.m_DebugDummyAddr, Client.m_aDebugDummyAddrString.data(), Client.m_aDebugDummyAddrString.size(), true);
+	net_addr_str(&Client.m_DebugDummyAddr, Client.m_aDebugDummyAddrStringNoPort.data(), Client.m_aDebugDummyAddrStringNoPort.size(), false);
+}
+
 void CServer::UpdateDebugDummies(bool ForceDisconnect)
 {
 	if(m_PreviousDebugDummies == g_Config.m_DbgDummies && !ForceDisconnect)
@@ -3014,27 +3288,7 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 		CClient &Client = m_aClients[ClientId];
 		if(AddDummy && m_aClients[ClientId].m_State == CClient::STATE_EMPTY)
 		{
-			NewClientCallback(ClientId, this, false);
-			Client.m_DebugDummy = true;
-
-			// See https://en.wikipedia.org/wiki/Unique_local_address
-			Client.m_DebugDummyAddr.type = NETTYPE_IPV6;
-			Client.m_DebugDummyAddr.ip[0] = 0xfd;
-			// Global ID (40 bits): random
-			secure_random_fill(&Client.m_DebugDummyAddr.ip[1], 5);
-			// Subnet ID (16 bits): constant
-			Client.m_DebugDummyAddr.ip[6] = 0xc0;
-			Client.m_DebugDummyAddr.ip[7] = 0xde;
-			// Interface ID (64 bits): set to client ID
-			Client.m_DebugDummyAddr.ip[8] = 0x00;
-			Client.m_DebugDummyAddr.ip[9] = 0x00;
-			Client.m_DebugDummyAddr.ip[10] = 0x00;
-			Client.m_DebugDummyAddr.ip[11] = 0x00;
-			uint_to_bytes_be(&Client.m_DebugDummyAddr.ip[12], ClientId);
-			// Port: random like normal clients
-			Client.m_DebugDummyAddr.port = secure_rand_below(65535 - 1024) + 1024;
-			net_addr_str(&Client.m_DebugDummyAddr, Client.m_aDebugDummyAddrString.data(), Client.m_aDebugDummyAddrString.size(), true);
-			net_addr_str(&Client.m_DebugDummyAddr, Client.m_aDebugDummyAddrStringNoPort.data(), Client.m_aDebugDummyAddrStringNoPort.size(), false);
+			AddDebugClient(ClientId, false);
 
 			GameServer()->OnClientConnected(ClientId, nullptr);
 			Client.m_State = CClient::STATE_INGAME;
@@ -3278,50 +3532,8 @@ int CServer::Run()
 
 			while(LastTime > TickStartTime(m_CurrentGameTick + 1))
 			{
-				GameServer()->OnPreTickTeehistorian();
-				UpdateDebugDummies(false);
-
-				for(int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick() + 1)
-						{
-							GameServer()->OnClientPredictedEarlyInput(c, Input.m_aData);
-							ClientHadInput = true;
-							break;
-						}
-					}
-					if(!ClientHadInput)
-						GameServer()->OnClientPredictedEarlyInput(c, nullptr);
-				}
-
-				m_CurrentGameTick++;
+				DoGameTick();
 				NewTicks++;
-
-				// apply new input
-				for(int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick())
-						{
-							GameServer()->OnClientPredictedInput(c, Input.m_aData);
-							ClientHadInput = true;
-							break;
-						}
-					}
-					if(!ClientHadInput)
-						GameServer()->OnClientPredictedInput(c, nullptr);
-				}
-
-				GameServer()->OnTick();
 				if(ErrorShutdown())
 				{
 					break;
@@ -3339,6 +3551,10 @@ int CServer::Run()
 
 				m_Fifo.Update();
 
+				// log lines of other threads, e.g. of the deferred logging thread
+				if(m_pServerLogger)
+					m_pServerLogger->Flush();
+
 #if defined(CONF_PLATFORM_ANDROID)
 				std::vector<std::string> vAndroidCommandQueue = FetchAndroidServerCommandQueue();
 				for(const std::string &Command : vAndroidCommandQueue)
@@ -4120,6 +4336,22 @@ void CServer::ConReloadMaplist(IConsole::IResult *pResult, void *pUserData)
 	pThis->InitMaplist();
 }
 
+void CServer::ConServerInfoStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pThis = static_cast<CServer *>(pUserData);
+	const double Seconds = maximum<double>((time_get() - pThis->m_ServerInfoStatsSince) / (double)time_freq(), 1.0);
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "connless requests=%" PRId64 " (%.1f/s) rate limited=%" PRId64 " in %.0fs",
+		pThis->m_ServerInfoRequests, pThis->m_ServerInfoRequests / Seconds, pThis->m_ServerInfoLimitedRequests, Seconds);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	str_format(aBuf, sizeof(aBuf), "connless responses packets=%" PRId64 " bytes=%" PRId64 " (%.1f KiB/s)",
+		pThis->m_ServerInfoSentPackets, pThis->m_ServerInfoSentBytes, pThis->m_ServerInfoSentBytes / Seconds / 1024.0);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	str_format(aBuf, sizeof(aBuf), "cache updates=%" PRId64 " repacked client entries=%" PRId64,
+		pThis->m_ServerInfoUpdates, pThis->m_ServerInfoEntryUpdates);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
 void CServer::ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -4416,6 +4648,7 @@ void CServer::RegisterCommands()
 
 	Console()->Register("reload_announcement", "", CFGFLAG_SERVER, ConReloadAnnouncement, this, "Reload the announcements");
 	Console()->Register("reload_maplist", "", CFGFLAG_SERVER, ConReloadMaplist, this, "Reload the maplist");
+	Console()->Register("server_info_stats", "", CFGFLAG_SERVER, ConServerInfoStats, this, "Show the traffic caused by server info requests");
 
 	RustVersionRegister(*Console());
 
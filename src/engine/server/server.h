@@ -5,6 +5,7 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "map_transfer.h"
 #include "name_ban.h"
 #include "snap_id_pool.h"
 
@@ -24,6 +25,7 @@
 
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 #if defined(CONF_UPNP)
@@ -35,6 +37,7 @@ class CHostLookup;
 class CLogMessage;
 class CMsgPacker;
 class CPacker;
+class CServerLogger;
 class IEngine;
 class ILogger;
 
@@ -61,6 +64,8 @@ public:
 class CServer : public IServer
 {
 	friend class CServerLogger;
+	// replaces the register to capture the server info
+	friend class CTestServerInfo;
 
 	class IGameServer *m_pGameServer;
 	class CConfig *m_pConfig;
@@ -110,6 +115,29 @@ public:
 
 	static const char *DnsblStateStr(EDnsblState State);
 
+	// Server info entries of one client, only repacked after the client's
+	// info changed and spliced into the server info caches.
+	class CServerInfoEntry
+	{
+	public:
+		enum
+		{
+			MAX_SIZE = 128,
+		};
+
+		bool m_Dirty = true;
+		// client state the entry was packed in, the name depends on it
+		int m_State;
+		// 0.6 entry with the reserved extra info of the extended server info
+		// at the end, the other variants leave out its last byte
+		unsigned char m_aData[MAX_SIZE];
+		int m_DataSize;
+		unsigned char m_aSixupData[MAX_SIZE];
+		int m_SixupDataSize;
+		// JSON object for the master server info
+		std::string m_Json;
+	};
+
 	class CClient
 	{
 	public:
@@ -163,6 +191,7 @@ public:
 		int m_AuthTries;
 		bool m_AuthHidden;
 		int m_NextMapChunk;
+		CMapTransferWindow m_MapTransfer;
 		int m_Flags;
 		bool m_ShowIps;
 		bool m_DebugDummy;
@@ -200,6 +229,8 @@ public:
 
 		bool m_Sixup;
 
+		CServerInfoEntry m_ServerInfo;
+
 		bool IncludedInServerInfo() const
 		{
 			return m_State != STATE_EMPTY && !m_DebugDummy;
@@ -219,6 +250,8 @@ public:
 	CFifo m_Fifo;
 	CServerBan m_ServerBan;
 	CHttp m_Http;
+	CMapTransferLimiter m_MapTransferLimiter;
+	int m_MapTransferFirstClient = 0;
 
 	int64_t m_GameStartTime;
 
@@ -266,6 +299,15 @@ public:
 	int64_t m_ServerInfoFirstRequest;
 	int m_ServerInfoNumRequests;
 
+	// traffic caused by connless server info requests
+	int64_t m_ServerInfoStatsSince;
+	int64_t m_ServerInfoRequests;
+	int64_t m_ServerInfoLimitedRequests;
+	int64_t m_ServerInfoSentPackets;
+	int64_t m_ServerInfoSentBytes;
+	int64_t m_ServerInfoUpdates;
+	int64_t m_ServerInfoEntryUpdates;
+
 	char m_aErrorShutdownReason[128];
 
 	CNameBans m_NameBans;
@@ -275,6 +317,7 @@ public:
 
 	std::shared_ptr<ILogger> m_pFileLogger = nullptr;
 	std::shared_ptr<ILogger> m_pStdoutLogger = nullptr;
+	CServerLogger *m_pServerLogger = nullptr;
 
 	CServer();
 	~CServer() override;
@@ -326,8 +369,17 @@ public:
 
 	int GetClientVersion(int ClientId) const override;
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
+	int SendMsgBroadcast(CMsgPacker *pMsg, int Flags, const CClientMask &Recipients) override;
 
+	// advances the game by one tick, applying the inputs queued for it
+	void DoGameTick();
 	void DoSnapshot();
+	// creates a client without a network connection, like the debug dummies
+	void AddDebugClient(int ClientId, bool Sixup);
+
+	// time spent in the last IGameServer::OnTick and in all IGameServer::OnSnap calls of the last snapshot
+	int64_t m_OnTickDuration = 0;
+	int64_t m_OnSnapDuration = 0;
 
 	static int NewClientCallback(int ClientId, void *pUser, bool Sixup);
 	static int NewClientNoAuthCallback(int ClientId, void *pUser);
@@ -339,6 +391,10 @@ public:
 	void SendCapabilities(int ClientId);
 	void SendMap(int ClientId);
 	void SendMapData(int ClientId, int Chunk);
+	// Sends the next map chunk if it fits into the adaptive window of the
+	// client and the bandwidth limit.
+	bool SendNextMapData(int ClientId, int64_t Now);
+	void PumpMapTransfers();
 	void SendMapReload(int ClientId);
 	void SendConnectionReady(int ClientId);
 	void SendRconLine(int ClientId, const char *pLine);
@@ -403,10 +459,12 @@ public:
 	void FillAntibot(CAntibotRoundData *pData) override;
 
 	void ExpireServerInfo() override;
+	void ExpireClientServerInfo(int ClientId) override;
 	void ExpireServerInfoAndQueueResend();
+	void UpdateClientServerInfo(int ClientId);
 	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxConsideredClients);
-	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
+	int SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
 	void GetServerInfoSixup(CPacker *pPacker, bool SendClients);
 	bool RateLimitServerInfoConnless();
 	void SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type);
@@ -451,6 +509,7 @@ public:
 
 	static void ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData);
 	static void ConReloadMaplist(IConsole::IResult *pResult, void *pUserData);
+	static void ConServerInfoStats(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -525,6 +584,7 @@ public:
 	bool IsSixup(int ClientId) const override { return ClientId != SERVER_DEMO_CLIENT && m_aClients[ClientId].m_Sixup; }
 
 	void SetLoggers(std::shared_ptr<ILogger> &&pFileLogger, std::shared_ptr<ILogger> &&pStdoutLogger);
+	void SetServerLogger(CServerLogger *pServerLogger) { m_pServerLogger = pServerLogger; }
 
 #ifdef CONF_FAMILY_UNIX
 	enum CONN_LOGGING_CMD
@@ -15,28 +15,34 @@ void CServerLogger::Log(const CLogMessage *pMessage)
 	{
 		return;
 	}
-	m_PendingLock.lock();
 	if(m_MainThread == std::this_thread::get_id())
 	{
-		if(!m_vPending.empty())
-		{
-			if(m_pServer)
-			{
-				for(const auto &Message : m_vPending)
-				{
-					m_pServer->SendLogLine(&Message);
-				}
-			}
-			m_vPending.clear();
-		}
-		m_PendingLock.unlock();
+		Flush();
 		if(m_pServer)
 			m_pServer->SendLogLine(pMessage);
 	}
 	else
 	{
+		const CLockScope LockScope(m_PendingLock);
 		m_vPending.push_back(*pMessage);
-		m_PendingLock.unlock();
+	}
+}
+
+void CServerLogger::Flush()
+{
+	std::vector<CLogMessage> vPending;
+	{
+		const CLockScope LockScope(m_PendingLock);
+		if(m_vPending.empty())
+			return;
+		std::swap(vPending, m_vPending);
+	}
+	if(m_pServer)
+	{
+		for(const auto &Message : vPending)
+		{
+			m_pServer->SendLogLine(&Message);
+		}
 	}
 }
 
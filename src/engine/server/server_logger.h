@@ -16,6 +16,8 @@ class CServerLogger : public ILogger
 public:
 	CServerLogger(CServer *pServer);
 	void Log(const CLogMessage *pMessage) override REQUIRES(!m_PendingLock);
+	// Sends the messages logged from other threads. Must be called from the main thread!
+	void Flush() REQUIRES(!m_PendingLock);
 	// Must be called from the main thread!
 	void OnServerDeletion();
 };
@@ -650,18 +650,113 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+static unsigned CommandNameHash(const char *pName)
+{
+	// FNV-1a over the name in lowercase, consistent with str_comp_nocase
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = (Hash ^ c) * 16777619u;
+	}
+	return Hash;
+}
+
+template<typename TMatch>
+CConsole::CCommand *CConsole::FindIndexedCommand(const char *pName, TMatch &&Match)
+{
+	if(m_vpCommandIndex.empty())
+		return nullptr;
+
+	const unsigned Mask = m_vpCommandIndex.size() - 1;
+	CCommand *pFound = nullptr;
+	for(unsigned Slot = CommandNameHash(pName) & Mask; m_vpCommandIndex[Slot]; Slot = (Slot + 1) & Mask)
+	{
+		CCommand *pCommand = m_vpCommandIndex[Slot];
+		if(!Match(pCommand) || str_comp_nocase(pCommand->m_pName, pName) != 0)
+			continue;
+		if(pFound)
+		{
+			// multiple commands match, the first one in the sorted command list wins
+			for(pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+			{
+				if(Match(pCommand) && str_comp_nocase(pCommand->m_pName, pName) == 0)
+					return pCommand;
+			}
+		}
+		pFound = pCommand;
+	}
+	return pFound;
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	return FindIndexedCommand(pName, [FlagMask](const CCommand *pCommand) {
+		return (pCommand->m_Flags & FlagMask) != 0;
+	});
+}
+
+void CConsole::IndexCommand(CCommand *pCommand)
+{
+	if((m_NumIndexedCommands + 1) * 2 > (int)m_vpCommandIndex.size())
 	{
-		if(pCommand->m_Flags & FlagMask)
+		std::vector<CCommand *> vpOldIndex(maximum<size_t>(m_vpCommandIndex.size() * 2, 256), nullptr);
+		std::swap(vpOldIndex, m_vpCommandIndex);
+		m_NumIndexedCommands = 0;
+		for(CCommand *pOldCommand : vpOldIndex)
 		{
-			if(str_comp_nocase(pCommand->m_pName, pName) == 0)
-				return pCommand;
+			if(pOldCommand)
+				IndexCommand(pOldCommand);
 		}
 	}
 
-	return nullptr;
+	const unsigned Mask = m_vpCommandIndex.size() - 1;
+	unsigned Slot = CommandNameHash(pCommand->m_pName) & Mask;
+	while(m_vpCommandIndex[Slot])
+		Slot = (Slot + 1) & Mask;
+	m_vpCommandIndex[Slot] = pCommand;
+	m_NumIndexedCommands++;
+}
+
+void CConsole::UnindexCommand(CCommand *pCommand)
+{
+	if(m_vpCommandIndex.empty())
+		return;
+
+	const unsigned Mask = m_vpCommandIndex.size() - 1;
+	unsigned Slot = CommandNameHash(pCommand->m_pName) & Mask;
+	while(m_vpCommandIndex[Slot] != pCommand)
+	{
+		if(!m_vpCommandIndex[Slot])
+			return;
+		Slot = (Slot + 1) & Mask;
+	}
+	m_vpCommandIndex[Slot] = nullptr;
+	m_NumIndexedCommands--;
+
+	// move following entries of the probe sequence into the gap, if that doesn't skip their home slot
+	for(unsigned Next = (Slot + 1) & Mask; m_vpCommandIndex[Next]; Next = (Next + 1) & Mask)
+	{
+		const unsigned Home = CommandNameHash(m_vpCommandIndex[Next]->m_pName) & Mask;
+		if(((Next - Home) & Mask) >= ((Next - Slot) & Mask))
+		{
+			m_vpCommandIndex[Slot] = m_vpCommandIndex[Next];
+			m_vpCommandIndex[Next] = nullptr;
+			Slot = Next;
+		}
+	}
+}
+
+void CConsole::RebuildCommandIndex()
+{
+	std::fill(m_vpCommandIndex.begin(), m_vpCommandIndex.end(), nullptr);
+	m_NumIndexedCommands = 0;
+	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	{
+		IndexCommand(pCommand);
+	}
 }
 
 void CConsole::ExecuteLine(const char *pStr, int ClientId, bool InterpretSemicolons)
@@ -938,6 +1033,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+	IndexCommand(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -1028,6 +1124,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		UnindexCommand(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1051,6 +1148,8 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	RebuildCommandIndex();
+
 	m_TempCommands.Reset();
 	m_pRecycleList = nullptr;
 }
@@ -1101,16 +1200,9 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
-	{
-		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
-		{
-			if(str_comp_nocase(pCommand->Name(), pName) == 0)
-				return pCommand;
-		}
-	}
-
-	return nullptr;
+	return FindIndexedCommand(pName, [FlagMask, Temp](const CCommand *pCommand) {
+		return (pCommand->m_Flags & FlagMask) && pCommand->m_Temp == Temp;
+	});
 }
 
 std::unique_ptr<IConsole> CreateConsole(int FlagMask) { return std::make_unique<CConsole>(FlagMask); }
@@ -166,6 +166,15 @@ class CConsole : public IConsole
 	void AddCommandSorted(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
+	// open addressing hash table of all commands, keyed by their case-insensitive name
+	std::vector<CCommand *> m_vpCommandIndex;
+	int m_NumIndexedCommands = 0;
+	void IndexCommand(CCommand *pCommand);
+	void UnindexCommand(CCommand *pCommand);
+	void RebuildCommandIndex();
+	template<typename TMatch>
+	CCommand *FindIndexedCommand(const char *pName, TMatch &&Match);
+
 	bool m_Cheated;
 
 public:
@@ -3,6 +3,7 @@
 
 #include "datafile.h"
 
+#include "jobs.h"
 #include "uuid_manager.h"
 
 #include <base/bytes.h>
@@ -19,8 +20,10 @@
 
 #include <zlib.h>
 
+#include <condition_variable>
 #include <cstdlib>
 #include <limits>
+#include <mutex>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
@@ -1144,21 +1147,111 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+void CDataFileWriter::CompressData(CDataInfo &DataInfo)
+{
+	unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
+	DataInfo.m_pCompressedData = malloc(CompressedSize);
+	const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+	DataInfo.m_CompressedSize = CompressedSize;
+	free(DataInfo.m_pUncompressedData);
+	DataInfo.m_pUncompressedData = nullptr;
+	dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+}
+
+// Hands out the data to compress in order. Shared by the thread running
+// Finish and the helper jobs, which may only start after Finish returned.
+class CDataFileWriter::CCompressQueue
+{
+	std::mutex m_Mutex;
+	std::condition_variable m_Cond;
+	CDataInfo *m_pDatas;
+	size_t m_NumDatas;
+	size_t m_Next = 0;
+	size_t m_NumInFlight = 0;
+	size_t m_InFlightMemory = 0;
+
+public:
+	CCompressQueue(CDataInfo *pDatas, size_t NumDatas) :
+		m_pDatas(pDatas),
+		m_NumDatas(NumDatas)
+	{
+	}
+
+	// compresses data until none is left
+	void Work()
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		while(m_Next < m_NumDatas)
+		{
+			CDataInfo &DataInfo = m_pDatas[m_Next];
+			const size_t Memory = compressBound(DataInfo.m_UncompressedSize);
+			if(m_NumInFlight > 0 && m_InFlightMemory + Memory > MAX_COMPRESS_MEMORY)
+			{
+				m_Cond.wait(Lock);
+				continue;
+			}
+			m_Next++;
+			m_NumInFlight++;
+			m_InFlightMemory += Memory;
+
+			Lock.unlock();
+			CompressData(DataInfo);
+			Lock.lock();
+
+			m_NumInFlight--;
+			m_InFlightMemory -= Memory;
+			m_Cond.notify_all();
+		}
+	}
+
+	// waits until the data taken by other threads is compressed
+	void Wait()
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_Cond.wait(Lock, [this]() { return m_NumInFlight == 0; });
+	}
+};
+
+class CDataFileWriter::CCompressJob : public IJob
+{
+	std::shared_ptr<CCompressQueue> m_pQueue;
+
+	void Run() override
+	{
+		m_pQueue->Work();
+	}
+
+public:
+	CCompressJob(std::shared_ptr<CCompressQueue> pQueue) :
+		m_pQueue(std::move(pQueue))
+	{
+	}
+};
+
+void CDataFileWriter::Finish(CJobPool *pJobPool)
 {
 	dbg_assert((bool)m_File, "File not open");
 
 	// Compress data. This takes the majority of the time when saving a datafile,
-	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+	// so it's delayed until the end so it can be off-loaded to other threads.
+	// Every data is compressed on its own, so the result is the same in any order.
+	if(pJobPool && m_vDatas.size() > 1)
 	{
-		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
-		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
-		DataInfo.m_CompressedSize = CompressedSize;
-		free(DataInfo.m_pUncompressedData);
-		DataInfo.m_pUncompressedData = nullptr;
-		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+		std::shared_ptr<CCompressQueue> pQueue = std::make_shared<CCompressQueue>(m_vDatas.data(), m_vDatas.size());
+		const size_t NumHelpers = minimum<size_t>(m_vDatas.size() - 1, pJobPool->NumThreads());
+		for(size_t i = 0; i < NumHelpers; i++)
+		{
+			pJobPool->Add(std::make_shared<CCompressJob>(pQueue));
+		}
+		pQueue->Work();
+		pQueue->Wait();
+	}
+	else
+	{
+		for(CDataInfo &DataInfo : m_vDatas)
+		{
+			CompressData(DataInfo);
+		}
 	}
 
 	// Calculate total size of items
@@ -14,6 +14,8 @@
 #include <map>
 #include <vector>
 
+class CJobPool;
+
 enum
 {
 	ITEMTYPE_EX = 0xFFFF,
@@ -107,6 +109,12 @@ private:
 		CUuid m_Uuid;
 	};
 
+	class CCompressQueue;
+	class CCompressJob;
+
+	// upper bound for the compression buffers of data compressed at the same time
+	static constexpr size_t MAX_COMPRESS_MEMORY = 64 * 1024 * 1024;
+
 	IOHANDLE m_File;
 	std::map<uint16_t, CItemTypeInfo, std::less<>> m_ItemTypes; // item types must be sorted in ascending order
 	std::vector<CItemInfo> m_vItems;
@@ -115,6 +123,7 @@ private:
 
 	int GetTypeFromIndex(int Index) const;
 	int GetExtendedItemTypeIndex(int Type, const CUuid *pUuid);
+	static void CompressData(CDataInfo &DataInfo);
 
 public:
 	CDataFileWriter();
@@ -134,7 +143,16 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
-	void Finish();
+
+	/**
+	 * Compresses the data and writes the file.
+	 *
+	 * @param pJobPool Optional job pool that helps compressing independent
+	 * data concurrently. The calling thread takes part in the compression,
+	 * so this may be called from a job of the same pool. The output does
+	 * not depend on whether a job pool is used.
+	 */
+	void Finish(CJobPool *pJobPool = nullptr);
 };
 
 #endif
@@ -11,6 +11,7 @@
 
 #include <game/version.h>
 
+#include <cinttypes>
 #include <limits>
 
 #if !defined(CONF_FAMILY_WINDOWS)
@@ -197,7 +198,17 @@ bool CHttpRequest::ConfigureHandle(void *pHandle)
 	curl_easy_setopt(pH, CURLOPT_URL, m_aUrl);
 	curl_easy_setopt(pH, CURLOPT_NOSIGNAL, 1L);
 	curl_easy_setopt(pH, CURLOPT_USERAGENT, GAME_NAME " " GAME_RELEASE_VERSION " (" CONF_PLATFORM_STRING "; " CONF_ARCH_STRING ")");
-	curl_easy_setopt(pH, CURLOPT_ACCEPT_ENCODING, ""); // Use any compression algorithm supported by libcurl.
+	if(m_RangeStart >= 0)
+	{
+		// ranges of compressed responses can't be decompressed separately
+		char aRange[64];
+		str_format(aRange, sizeof(aRange), "%" PRId64 "-%" PRId64, m_RangeStart, m_RangeStart + m_RangeLength - 1);
+		curl_easy_setopt(pH, CURLOPT_RANGE, aRange);
+	}
+	else
+	{
+		curl_easy_setopt(pH, CURLOPT_ACCEPT_ENCODING, ""); // Use any compression algorithm supported by libcurl.
+	}
 
 	curl_easy_setopt(pH, CURLOPT_HEADERDATA, this);
 	curl_easy_setopt(pH, CURLOPT_HEADERFUNCTION, HeaderCallback);
@@ -275,10 +286,12 @@ size_t CHttpRequest::OnHeader(char *pHeader, size_t HeaderSize)
 		m_HeadersEnded = false;
 		m_ResultDate = {};
 		m_ResultLastModified = {};
+		m_HasContentRange = false;
 	}
 
 	static const char DATE[] = "Date: ";
 	static const char LAST_MODIFIED[] = "Last-Modified: ";
+	static const char CONTENT_RANGE[] = "Content-Range: ";
 
 	// Trailing newline and null termination evens out.
 	if(HeaderSize - 1 >= sizeof(DATE) - 1 && str_startswith_nocase(pHeader, DATE))
@@ -301,6 +314,10 @@ size_t CHttpRequest::OnHeader(char *pHeader, size_t HeaderSize)
 			m_ResultLastModified = Value;
 		}
 	}
+	if(HeaderSize - 1 >= sizeof(CONTENT_RANGE) - 1 && str_startswith_nocase(pHeader, CONTENT_RANGE))
+	{
+		m_HasContentRange = true;
+	}
 
 	return HeaderSize;
 }
@@ -319,7 +336,15 @@ size_t CHttpRequest::OnData(char *pData, size_t DataSize)
 		return DataSize;
 	}
 
-	sha256_update(&m_ActualSha256Ctx, pData, DataSize);
+	if(m_RangeStart < 0)
+	{
+		sha256_update(&m_ActualSha256Ctx, pData, DataSize);
+	}
+
+	if(!OnResponseData(pData, DataSize))
+	{
+		return 0;
+	}
 
 	size_t Result = DataSize;
 
@@ -395,6 +420,15 @@ void CHttpRequest::OnCompletionInternal(void *pHandle, unsigned int Result)
 		State = EHttpState::DONE;
 	}
 
+	if(State == EHttpState::DONE && m_RangeStart >= 0 && (RangeRejected() || m_ResponseLength != (uint64_t)m_RangeLength))
+	{
+		if(g_Config.m_DbgCurl || m_LogProgress >= HTTPLOG::FAILURE)
+		{
+			log_error("http", "%s failed. range %" PRId64 "+%" PRId64 " not served, status=%d length=%" PRIu64, m_aUrl, m_RangeStart, m_RangeLength, m_StatusCode, m_ResponseLength);
+		}
+		State = EHttpState::ERROR;
+	}
+
 	if(State == EHttpState::DONE)
 	{
 		m_ActualSha256 = sha256_finish(&m_ActualSha256Ctx);
@@ -582,6 +616,385 @@ std::optional<int64_t> CHttpRequest::ResultLastModified() const
 	return m_ResultLastModified;
 }
 
+class CHttpRangedDownloadPiece : public CHttpRequest
+{
+public:
+	std::shared_ptr<CHttpRangedDownload> m_pDownload;
+	int64_t m_Offset;
+	int64_t m_Length;
+	int m_Attempt;
+	bool m_RangeRejected = false;
+	std::vector<unsigned char> m_vData;
+
+	CHttpRangedDownloadPiece(const char *pUrl, std::shared_ptr<CHttpRangedDownload> pDownload, int64_t Offset, int64_t Length, int Attempt) :
+		CHttpRequest(pUrl),
+		m_pDownload(std::move(pDownload)),
+		m_Offset(Offset),
+		m_Length(Length),
+		m_Attempt(Attempt)
+	{
+		Range(Offset, Length);
+		WriteToNothing();
+		LogProgress(HTTPLOG::FAILURE);
+		m_vData.reserve(Length);
+	}
+
+protected:
+	bool OnResponseData(const char *pData, size_t DataSize) override
+	{
+		m_vData.insert(m_vData.end(), pData, pData + DataSize);
+		return true;
+	}
+
+	void OnCompletion(EHttpState State) override
+	{
+		// drop the reference to the download, it holds a reference to this piece while running
+		std::shared_ptr<CHttpRangedDownload> pDownload = std::move(m_pDownload);
+		m_RangeRejected = RangeRejected();
+		pDownload->OnPieceCompletion(this, State);
+	}
+};
+
+CHttpRangedDownload::CHttpRangedDownload(const char *pUrl, IStorage *pStorage, const char *pPartFile, const char *pDest, int StorageType, int64_t Size, const SHA256_DIGEST &Sha256) :
+	m_Size(Size),
+	m_ExpectedSha256(Sha256)
+{
+	str_copy(m_aUrl, pUrl);
+	pStorage->GetCompletePath(StorageType, pPartFile, m_aPartAbsolute, sizeof(m_aPartAbsolute));
+	pStorage->GetCompletePath(StorageType, pDest, m_aDestAbsolute, sizeof(m_aDestAbsolute));
+	sha256_init(&m_Sha256Ctx);
+}
+
+CHttpRangedDownload::~CHttpRangedDownload()
+{
+	if(m_File)
+	{
+		io_close(m_File);
+	}
+}
+
+class CHttpRangedDownloadWriter : public IJob
+{
+	std::shared_ptr<CHttpRangedDownload> m_pDownload;
+
+	void Run() override
+	{
+		m_pDownload->WritePieces();
+	}
+
+public:
+	CHttpRangedDownloadWriter(std::shared_ptr<CHttpRangedDownload> pDownload) :
+		m_pDownload(std::move(pDownload))
+	{
+	}
+};
+
+void CHttpRangedDownload::Start(IHttp *pHttp)
+{
+	dbg_assert(m_State == EHttpState::QUEUED, "ranged download started twice");
+	m_pHttp = pHttp;
+	std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> vpNewPieces;
+	bool Write;
+	{
+		std::unique_lock Lock(m_Lock);
+		m_State = EHttpState::RUNNING;
+		if(fs_makedir_rec_for(m_aPartAbsolute) < 0)
+		{
+			Fail("cannot create folder for part file");
+			return;
+		}
+
+		// continue after the data received earlier
+		IOHANDLE PartFile = io_open(m_aPartAbsolute, IOFLAG_READ);
+		if(PartFile)
+		{
+			unsigned char aBuffer[64 * 1024];
+			while(true)
+			{
+				unsigned Bytes = io_read(PartFile, aBuffer, sizeof(aBuffer));
+				if(Bytes == 0)
+					break;
+				sha256_update(&m_Sha256Ctx, aBuffer, Bytes);
+				m_WrittenSize += Bytes;
+			}
+			io_close(PartFile);
+			if(m_WrittenSize > m_Size)
+			{
+				fs_remove(m_aPartAbsolute);
+				sha256_init(&m_Sha256Ctx);
+				m_WrittenSize = 0;
+			}
+		}
+		m_ResumedSize = m_WrittenSize;
+		m_NextOffset = m_WrittenSize;
+		if(m_ResumedSize > 0)
+		{
+			log_info("http", "resuming download of %s at %" PRId64 "/%" PRId64 " bytes", m_aUrl, m_ResumedSize, m_Size);
+		}
+
+		m_File = io_open(m_aPartAbsolute, IOFLAG_APPEND);
+		if(!m_File)
+		{
+			Fail("cannot open part file");
+			return;
+		}
+		// the writer finishes a complete part file
+		Write = ClaimWriter();
+		FillPieces(vpNewPieces);
+	}
+	RunPieces(vpNewPieces);
+	if(Write)
+	{
+		StartWriter();
+	}
+}
+
+void CHttpRangedDownload::Abort()
+{
+	std::unique_lock Lock(m_Lock);
+	if(Done())
+	{
+		return;
+	}
+	if(!m_Stopped)
+	{
+		Stop(EHttpState::ABORTED);
+	}
+	// the part file must be complete and closed when a new download resumes it
+	m_WriterCv.wait(Lock, [this]() { return !m_Writing; });
+}
+
+double CHttpRangedDownload::Current() const
+{
+	std::unique_lock Lock(m_Lock);
+	double Current = m_WrittenSize + m_CompletedPiecesSize;
+	for(const auto &pPiece : m_vpRunningPieces)
+	{
+		Current += pPiece->Current();
+	}
+	return Current;
+}
+
+void CHttpRangedDownload::Stop(EHttpState State)
+{
+	for(auto &pPiece : m_vpRunningPieces)
+	{
+		pPiece->Abort();
+	}
+	m_vpRunningPieces.clear();
+	m_Stopped = true;
+	if(m_Writing)
+	{
+		// the writer closes the file and sets the state
+		m_StopState = State;
+		return;
+	}
+	if(m_File)
+	{
+		io_close(m_File);
+		m_File = nullptr;
+	}
+	m_State = State;
+}
+
+void CHttpRangedDownload::Fail(const char *pReason)
+{
+	log_error("http", "%s failed. %s", m_aUrl, pReason);
+	Stop(EHttpState::ERROR);
+}
+
+bool CHttpRangedDownload::ClaimWriter()
+{
+	if(m_Writing || m_Stopped)
+	{
+		return false;
+	}
+	const bool NextPiece = !m_CompletedPieces.empty() && m_CompletedPieces.begin()->first == m_WrittenSize;
+	if(!NextPiece && m_WrittenSize != m_Size)
+	{
+		return false;
+	}
+	m_Writing = true;
+	return true;
+}
+
+void CHttpRangedDownload::StartWriter()
+{
+	if(m_pJobPool)
+	{
+		m_pJobPool->Add(std::make_shared<CHttpRangedDownloadWriter>(shared_from_this()));
+	}
+	else
+	{
+		WritePieces();
+	}
+}
+
+void CHttpRangedDownload::WritePieces()
+{
+	// appends the pieces following the part file without holding the lock
+	while(true)
+	{
+		std::vector<unsigned char> vData;
+		{
+			std::unique_lock Lock(m_Lock);
+			if(m_Stopped)
+			{
+				if(m_File)
+				{
+					io_close(m_File);
+					m_File = nullptr;
+				}
+				m_Writing = false;
+				m_State = m_StopState;
+				m_WriterCv.notify_all();
+				return;
+			}
+			const auto It = m_CompletedPieces.begin();
+			if(It == m_CompletedPieces.end() || It->first != m_WrittenSize)
+			{
+				if(m_WrittenSize == m_Size)
+				{
+					break;
+				}
+				m_Writing = false;
+				return;
+			}
+			vData = std::move(It->second);
+			m_CompletedPieces.erase(It);
+		}
+
+		const bool WriteError = io_write(m_File, vData.data(), vData.size()) != vData.size();
+		if(!WriteError)
+		{
+			sha256_update(&m_Sha256Ctx, vData.data(), vData.size());
+		}
+
+		std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> vpNewPieces;
+		{
+			std::unique_lock Lock(m_Lock);
+			m_CompletedPiecesSize -= vData.size();
+			if(WriteError && !m_Stopped)
+			{
+				Fail("i/o error, cannot write part file");
+				continue;
+			}
+			m_WrittenSize += vData.size();
+			if(!m_Stopped)
+			{
+				FillPieces(vpNewPieces);
+			}
+		}
+		RunPieces(vpNewPieces);
+	}
+	Finish();
+}
+
+void CHttpRangedDownload::Finish()
+{
+	EHttpState State = EHttpState::DONE;
+	const bool CloseError = io_close(m_File) != 0;
+	m_File = nullptr;
+	const SHA256_DIGEST Sha256 = sha256_finish(&m_Sha256Ctx);
+	if(CloseError)
+	{
+		log_error("http", "%s failed. i/o error, cannot close part file", m_aUrl);
+		State = EHttpState::ERROR;
+	}
+	else if(Sha256 != m_ExpectedSha256)
+	{
+		char aActualSha256[SHA256_MAXSTRSIZE];
+		sha256_str(Sha256, aActualSha256, sizeof(aActualSha256));
+		char aExpectedSha256[SHA256_MAXSTRSIZE];
+		sha256_str(m_ExpectedSha256, aExpectedSha256, sizeof(aExpectedSha256));
+		log_error("http", "SHA256 mismatch: got=%s, expected=%s, url=%s", aActualSha256, aExpectedSha256, m_aUrl);
+		fs_remove(m_aPartAbsolute);
+		State = EHttpState::ERROR;
+	}
+	else if(fs_rename(m_aPartAbsolute, m_aDestAbsolute))
+	{
+		log_error("http", "%s failed. i/o error, cannot move part file", m_aUrl);
+		State = EHttpState::ERROR;
+	}
+	else
+	{
+		log_info("http", "task done: %s", m_aUrl);
+	}
+
+	std::unique_lock Lock(m_Lock);
+	m_Writing = false;
+	m_State = m_Stopped ? m_StopState : State;
+	m_Stopped = true;
+	m_WriterCv.notify_all();
+}
+
+void CHttpRangedDownload::FillPieces(std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> &vpNewPieces)
+{
+	// limit the data held in memory until the pieces before it arrived
+	const int64_t MaxAhead = 2 * m_Connections * m_PieceSize;
+	while((int)m_vpRunningPieces.size() < m_Connections && m_NextOffset < m_Size && m_NextOffset - m_WrittenSize < MaxAhead)
+	{
+		const int64_t Length = std::min(m_PieceSize, m_Size - m_NextOffset);
+		vpNewPieces.push_back(std::make_shared<CHttpRangedDownloadPiece>(m_aUrl, shared_from_this(), m_NextOffset, Length, 0));
+		m_vpRunningPieces.push_back(vpNewPieces.back());
+		m_NextOffset += Length;
+	}
+}
+
+void CHttpRangedDownload::RunPieces(std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> &vpNewPieces)
+{
+	// can complete the pieces immediately, must not hold the lock
+	for(auto &pPiece : vpNewPieces)
+	{
+		pPiece->Timeout(m_Timeout);
+		m_pHttp->Run(pPiece);
+	}
+}
+
+void CHttpRangedDownload::OnPieceCompletion(CHttpRangedDownloadPiece *pPiece, EHttpState State)
+{
+	std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> vpNewPieces;
+	bool Write = false;
+	{
+		std::unique_lock Lock(m_Lock);
+		const auto RunningIt = std::find_if(m_vpRunningPieces.begin(), m_vpRunningPieces.end(), [pPiece](const auto &pRunning) { return pRunning.get() == pPiece; });
+		if(RunningIt == m_vpRunningPieces.end() || m_Stopped)
+		{
+			return;
+		}
+		m_vpRunningPieces.erase(RunningIt);
+
+		if(State != EHttpState::DONE)
+		{
+			// retrying won't help if the server answered with anything else than the range
+			if(pPiece->m_RangeRejected)
+			{
+				Fail("server did not serve the requested range");
+				return;
+			}
+			if(State == EHttpState::ABORTED || pPiece->m_Attempt + 1 >= MAX_ATTEMPTS)
+			{
+				Fail("cannot download range");
+				return;
+			}
+			vpNewPieces.push_back(std::make_shared<CHttpRangedDownloadPiece>(m_aUrl, shared_from_this(), pPiece->m_Offset, pPiece->m_Length, pPiece->m_Attempt + 1));
+			m_vpRunningPieces.push_back(vpNewPieces.back());
+		}
+		else
+		{
+			m_CompletedPiecesSize += pPiece->m_Length;
+			m_CompletedPieces.emplace(pPiece->m_Offset, std::move(pPiece->m_vData));
+			Write = ClaimWriter();
+			FillPieces(vpNewPieces);
+		}
+	}
+	RunPieces(vpNewPieces);
+	if(Write)
+	{
+		StartWriter();
+	}
+}
+
 bool CHttp::Init(std::chrono::milliseconds ShutdownDelay)
 {
 	m_ShutdownDelay = ShutdownDelay;
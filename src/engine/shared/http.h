@@ -15,9 +15,12 @@
 #include <condition_variable>
 #include <cstdlib>
 #include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 typedef struct _json_value json_value;
 class IStorage;
@@ -94,6 +97,8 @@ class CHttpRequest : public IHttpRequest
 	CTimeout m_Timeout = CTimeout{0, 0, 0, 0};
 	int64_t m_MaxResponseSize = -1;
 	int64_t m_IfModifiedSince = -1;
+	int64_t m_RangeStart = -1;
+	int64_t m_RangeLength = 0;
 	REQUEST m_Type = REQUEST::GET;
 
 	std::optional<SHA256_DIGEST> m_ActualSha256;
@@ -132,6 +137,7 @@ class CHttpRequest : public IHttpRequest
 
 	int m_StatusCode = 0;
 	bool m_HeadersEnded = false;
+	bool m_HasContentRange = false;
 	std::optional<int64_t> m_ResultDate = std::nullopt;
 	std::optional<int64_t> m_ResultLastModified = std::nullopt;
 
@@ -157,6 +163,13 @@ protected:
 	// These run on the curl thread now, DO NOT STALL THE THREAD
 	virtual void OnProgress() {}
 	virtual void OnCompletion(EHttpState State) {}
+	// Called for every received part of the response body. Abort the
+	// request if `OnResponseData()` returns false.
+	virtual bool OnResponseData(const char *pData, size_t DataSize) { return true; }
+	// Whether the server responded to a range request with something else
+	// than 206 Partial Content and a Content-Range, e.g. because it doesn't
+	// support ranges.
+	bool RangeRejected() const { return m_RangeStart >= 0 && m_StatusCode != 0 && (m_StatusCode != 206 || !m_HasContentRange); }
 
 public:
 	CHttpRequest(const char *pUrl);
@@ -175,6 +188,12 @@ public:
 		m_WriteToMemory = true;
 		m_WriteToFile = false;
 	}
+	// Don't store the response, only pass it to `OnResponseData()`.
+	void WriteToNothing()
+	{
+		m_WriteToMemory = false;
+		m_WriteToFile = false;
+	}
 	// Download to filesystem and memory.
 	void WriteToFileAndMemory(IStorage *pStorage, const char *pDest, int StorageType);
 	// Download to the filesystem only.
@@ -184,6 +203,14 @@ public:
 	void ValidateBeforeOverwrite(bool ValidateBeforeOverwrite) { m_ValidateBeforeOverwrite = ValidateBeforeOverwrite; }
 	void ExpectSha256(const SHA256_DIGEST &Sha256) { m_ExpectedSha256 = Sha256; }
 	void Head() { m_Type = REQUEST::HEAD; }
+	// Only request `Length` bytes starting at `Start`. The request fails if
+	// the server sends anything else than this part of the file.
+	void Range(int64_t Start, int64_t Length)
+	{
+		m_RangeStart = Start;
+		m_RangeLength = Length;
+		m_MaxResponseSize = Length;
+	}
 	void Post(const unsigned char *pData, size_t DataLength)
 	{
 		m_Type = REQUEST::POST;
@@ -297,6 +324,95 @@ inline std::unique_ptr<CHttpRequest> HttpPostJson(const char *pUrl, const char *
 	return pResult;
 }
 
+class CHttpRangedDownloadPiece;
+class CHttpRangedDownloadWriter;
+
+// Downloads a file of known size and SHA256 with several concurrent range
+// requests. Received parts are appended to the part file in order while
+// hashing them, so an interrupted download continues from the part file.
+// The file is moved to its destination once the SHA256 matches. The disk
+// I/O runs on the job pool if one is set, never on the curl thread.
+class CHttpRangedDownload : public std::enable_shared_from_this<CHttpRangedDownload>
+{
+	friend class CHttpRangedDownloadPiece;
+	friend class CHttpRangedDownloadWriter;
+
+	enum
+	{
+		MAX_ATTEMPTS = 3,
+	};
+
+	char m_aUrl[256];
+	char m_aPartAbsolute[IO_MAX_PATH_LENGTH];
+	char m_aDestAbsolute[IO_MAX_PATH_LENGTH];
+	int64_t m_Size;
+	SHA256_DIGEST m_ExpectedSha256;
+
+	CTimeout m_Timeout = CTimeout{0, 0, 0, 0};
+	int m_Connections = 4;
+	int64_t m_PieceSize = 1024 * 1024;
+	IHttp *m_pHttp = nullptr;
+	CJobPool *m_pJobPool = nullptr;
+
+	mutable std::mutex m_Lock;
+	std::condition_variable m_WriterCv;
+	std::atomic<EHttpState> m_State{EHttpState::QUEUED};
+	// no more pieces are run, m_State is set to m_StopState once the writer is done
+	bool m_Stopped = false;
+	EHttpState m_StopState = EHttpState::ERROR;
+	// the writer owns the part file and the SHA256 context while it runs
+	bool m_Writing = false;
+	IOHANDLE m_File = nullptr;
+	SHA256_CTX m_Sha256Ctx;
+	int64_t m_ResumedSize = 0;
+	// appended to the part file
+	int64_t m_WrittenSize = 0;
+	int64_t m_NextOffset = 0;
+	// received out of order, by offset
+	std::map<int64_t, std::vector<unsigned char>> m_CompletedPieces;
+	int64_t m_CompletedPiecesSize = 0;
+	std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> m_vpRunningPieces;
+
+	void Stop(EHttpState State);
+	void Fail(const char *pReason);
+	// Returns whether the writer must be started after unlocking.
+	bool ClaimWriter();
+	void StartWriter();
+	void WritePieces();
+	void Finish();
+	// Returns the pieces to run after unlocking.
+	void FillPieces(std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> &vpNewPieces);
+	void OnPieceCompletion(CHttpRangedDownloadPiece *pPiece, EHttpState State);
+	void RunPieces(std::vector<std::shared_ptr<CHttpRangedDownloadPiece>> &vpNewPieces);
+
+public:
+	CHttpRangedDownload(const char *pUrl, IStorage *pStorage, const char *pPartFile, const char *pDest, int StorageType, int64_t Size, const SHA256_DIGEST &Sha256);
+	~CHttpRangedDownload();
+
+	void Timeout(CTimeout Timeout) { m_Timeout = Timeout; }
+	void Connections(int Connections) { m_Connections = Connections; }
+	void PieceSize(int64_t PieceSize) { m_PieceSize = PieceSize; }
+	// Writes and hashes the received data on the job pool instead of the
+	// thread that completed the piece.
+	void JobPool(CJobPool *pJobPool) { m_pJobPool = pJobPool; }
+
+	void Start(IHttp *pHttp);
+	// Stops the download, the part file is kept to resume it later. Waits
+	// for a running write to the part file.
+	void Abort();
+
+	double Current() const;
+	double Size() const { return m_Size; }
+	// Size of the part file the download was resumed from.
+	int64_t ResumedSize() const { return m_ResumedSize; }
+	EHttpState State() const { return m_State; }
+	bool Done() const
+	{
+		EHttpState State = m_State;
+		return State != EHttpState::QUEUED && State != EHttpState::RUNNING;
+	}
+};
+
 void EscapeUrl(char *pBuf, int Size, const char *pStr);
 
 template<int N>
@@ -170,5 +170,10 @@ public:
 	 * will be enqueue anymore. Abortable jobs will immediately be aborted.
 	 */
 	void Add(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+
+	/**
+	 * @return The number of worker threads.
+	 */
+	int NumThreads() const { return m_vpThreads.size(); }
 };
 #endif
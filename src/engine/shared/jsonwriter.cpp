@@ -20,9 +20,9 @@ static char EscapeJsonChar(char c)
 	}
 }
 
-CJsonWriter::CJsonWriter()
+CJsonWriter::CJsonWriter(int Indentation)
 {
-	m_Indentation = 0;
+	m_Indentation = Indentation;
 }
 
 void CJsonWriter::BeginObject()
@@ -102,6 +102,14 @@ void CJsonWriter::WriteNullValue()
 	CompleteDataType();
 }
 
+void CJsonWriter::WriteRawValue(const char *pValue, int Length)
+{
+	dbg_assert(CanWriteDatatype(), "Cannot write value here");
+	WriteIndent(false);
+	WriteInternal(pValue, Length);
+	CompleteDataType();
+}
+
 bool CJsonWriter::CanWriteDatatype()
 {
 	return m_States.empty() || TopState()->m_Kind == STATE_ARRAY || TopState()->m_Kind == STATE_ATTRIBUTE;
@@ -155,12 +163,14 @@ void CJsonWriter::WriteIndent(bool EndElement)
 	if(NotRootOrAttribute && !TopState()->m_Empty && !EndElement)
 		WriteInternal(",");
 
+	// the end of the root is indented as well when the writer started
+	// with an indentation
 	if(NotRootOrAttribute || EndElement)
+	{
 		WriteInternal("\n");
-
-	if(NotRootOrAttribute)
 		for(int i = 0; i < m_Indentation; i++)
 			WriteInternal("\t");
+	}
 }
 
 void CJsonWriter::PushState(EJsonStateKind NewState)
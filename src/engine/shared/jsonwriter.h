@@ -47,7 +47,9 @@ protected:
 	virtual void WriteInternal(const char *pStr, int Length = -1) = 0;
 
 public:
-	CJsonWriter();
+	// The indentation is used when the output is written into another
+	// document with `WriteRawValue`.
+	CJsonWriter(int Indentation = 0);
 	virtual ~CJsonWriter() = default;
 
 	// The root is created by beginning the first datatype (object, array, value).
@@ -77,6 +79,8 @@ public:
 	void WriteIntValue(int Value);
 	void WriteBoolValue(bool Value);
 	void WriteNullValue();
+	// Write an already serialized value, e.g. the output of another writer.
+	void WriteRawValue(const char *pValue, int Length = -1);
 };
 
 /**
@@ -111,6 +115,10 @@ protected:
 
 public:
 	CJsonStringWriter() = default;
+	CJsonStringWriter(int Indentation) :
+		CJsonWriter(Indentation)
+	{
+	}
 	~CJsonStringWriter() override = default;
 	std::string &&GetOutputString();
 };
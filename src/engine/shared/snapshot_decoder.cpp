@@ -0,0 +1,173 @@
+#include "snapshot_decoder.h"
+
+#include "compression.h"
+
+#include <base/dbg.h>
+#include <base/thread.h>
+
+CSnapshotDecoder::CSnapshotDecoder() :
+	m_pJobs(std::make_unique<CJob[]>(MAX_JOBS))
+{
+}
+
+CSnapshotDecoder::~CSnapshotDecoder()
+{
+	Shutdown();
+}
+
+void CSnapshotDecoder::Init()
+{
+	dbg_assert(m_pThread == nullptr, "snapshot decoder already initialized");
+	m_Shutdown.store(false);
+	m_pThread = thread_init(ThreadFunc, this, "snapshot decoder");
+}
+
+void CSnapshotDecoder::Shutdown()
+{
+	if(!m_pThread)
+		return;
+	m_Shutdown.store(true);
+	m_Semaphore.Signal();
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+}
+
+void CSnapshotDecoder::ThreadFunc(void *pUser)
+{
+	CSnapshotDecoder *pSelf = static_cast<CSnapshotDecoder *>(pUser);
+	while(true)
+	{
+		pSelf->m_Semaphore.Wait();
+		if(pSelf->m_Shutdown.load())
+			break;
+
+		unsigned Decoded = pSelf->m_Decoded.load(std::memory_order_relaxed);
+		while(Decoded != pSelf->m_Submitted.load(std::memory_order_acquire))
+		{
+			pSelf->Decode(&pSelf->m_pJobs[Decoded % MAX_JOBS]);
+			Decoded++;
+			pSelf->m_Decoded.store(Decoded, std::memory_order_release);
+		}
+	}
+}
+
+void CSnapshotDecoder::Decode(CJob *pJob)
+{
+	const int Conn = pJob->m_Conn;
+	if(pJob->m_Generation != m_aDecoderGeneration[Conn])
+	{
+		m_aStorage[Conn].PurgeAll();
+		m_aDecoderGeneration[Conn] = pJob->m_Generation;
+	}
+	pJob->m_SnapSize = 0;
+	pJob->m_UnpackError = 0;
+
+	// find snapshot that we should use as delta
+	const CSnapshot *pDeltaShot = CSnapshot::EmptySnapshot();
+	if(pJob->m_DeltaTick >= 0 && m_aStorage[Conn].Get(pJob->m_DeltaTick, nullptr, &pDeltaShot, nullptr) < 0)
+	{
+		pJob->m_Result = RESULT_MISSING_DELTA;
+		return;
+	}
+
+	// decompress snapshot
+	const void *pDeltaData = nullptr;
+	pJob->m_DeltaSize = sizeof(int) * 3;
+	if(pJob->m_DataSize)
+	{
+		const int IntSize = CVariableInt::Decompress(pJob->m_aData, pJob->m_DataSize, m_aDeltaData, sizeof(m_aDeltaData));
+		if(IntSize < 0)
+		{
+			pJob->m_Result = RESULT_DECOMPRESS_FAILED;
+			return;
+		}
+		pDeltaData = m_aDeltaData;
+		pJob->m_DeltaSize = IntSize;
+	}
+
+	// unpack delta
+	CSnapshot *pSnapshot = pJob->Snapshot();
+	int SnapSize;
+	{
+		const CLockScope LockScope(m_DeltaLock);
+		SnapSize = m_Delta.UnpackDelta(pDeltaShot, pSnapshot, pDeltaData ? pDeltaData : m_Delta.EmptyDelta(), pJob->m_DeltaSize, pJob->m_Sixup);
+	}
+	if(SnapSize < 0)
+	{
+		pJob->m_Result = RESULT_UNPACK_FAILED;
+		pJob->m_UnpackError = SnapSize;
+		return;
+	}
+	pJob->m_SnapSize = SnapSize;
+	if(!pSnapshot->IsValid(SnapSize))
+	{
+		pJob->m_Result = RESULT_INVALID;
+		return;
+	}
+	if(pJob->m_CheckCrc && pSnapshot->Crc() != pJob->m_Crc)
+	{
+		pJob->m_Result = RESULT_CRC_MISMATCH;
+		return;
+	}
+
+	m_aStorage[Conn].PurgeUntil(pJob->m_PurgeTick);
+	m_aStorage[Conn].Add(pJob->m_GameTick, pJob->m_ReceiveTime, SnapSize, pSnapshot, 0, nullptr);
+	pJob->m_Result = RESULT_SUCCESS;
+}
+
+void CSnapshotDecoder::SetStaticsize(int ItemType, size_t Size)
+{
+	const CLockScope LockScope(m_DeltaLock);
+	m_Delta.SetStaticsize(ItemType, Size);
+}
+
+void CSnapshotDecoder::SetStaticsize7(int ItemType, size_t Size)
+{
+	const CLockScope LockScope(m_DeltaLock);
+	m_Delta.SetStaticsize7(ItemType, Size);
+}
+
+void CSnapshotDecoder::DataRate(int Index, uint64_t *pRate, uint64_t *pUpdates)
+{
+	const CLockScope LockScope(m_DeltaLock);
+	*pRate = m_Delta.GetDataRate(Index);
+	*pUpdates = m_Delta.GetDataUpdates(Index);
+}
+
+void CSnapshotDecoder::Reset(int Conn)
+{
+	dbg_assert(Conn >= 0 && Conn < NUM_CONNS, "invalid Conn");
+	m_aGeneration[Conn]++;
+}
+
+CSnapshotDecoder::CJob *CSnapshotDecoder::NewJob()
+{
+	const unsigned Submitted = m_Submitted.load(std::memory_order_relaxed);
+	if(Submitted - m_Consumed >= (unsigned)MAX_JOBS)
+		return nullptr;
+	return &m_pJobs[Submitted % MAX_JOBS];
+}
+
+void CSnapshotDecoder::Submit()
+{
+	dbg_assert(m_pThread != nullptr, "snapshot decoder not initialized");
+	const unsigned Submitted = m_Submitted.load(std::memory_order_relaxed);
+	CJob *pJob = &m_pJobs[Submitted % MAX_JOBS];
+	dbg_assert(pJob->m_Conn >= 0 && pJob->m_Conn < NUM_CONNS, "invalid Conn");
+	pJob->m_Generation = m_aGeneration[pJob->m_Conn];
+	m_Submitted.store(Submitted + 1, std::memory_order_release);
+	m_Semaphore.Signal();
+}
+
+CSnapshotDecoder::CJob *CSnapshotDecoder::DecodedJob()
+{
+	if(m_Consumed == m_Decoded.load(std::memory_order_acquire))
+		return nullptr;
+	return &m_pJobs[m_Consumed % MAX_JOBS];
+}
+
+void CSnapshotDecoder::PopDecodedJob()
+{
+	dbg_assert(m_Consumed != m_Decoded.load(std::memory_order_acquire), "no decoded snapshot job");
+	m_Consumed++;
+}
@@ -0,0 +1,138 @@
+#ifndef ENGINE_SHARED_SNAPSHOT_DECODER_H
+#define ENGINE_SHARED_SNAPSHOT_DECODER_H
+
+#include "snapshot.h"
+
+#include <base/lock.h>
+#include <base/sphore.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Decompresses and unpacks received snapshot deltas on a background thread.
+ *
+ * The owning thread fills a job with the reassembled snapshot data and
+ * submits it, the decoder thread unpacks it against the previous snapshot
+ * the server used as delta and checks its CRC. Decoded jobs are returned in
+ * submission order. Jobs are passed through a single-producer
+ * single-consumer ring, all functions except `DataRate` must be called from
+ * the owning thread.
+ *
+ * The decoder keeps its own copy of the unpacked snapshots of every
+ * connection to find the delta snapshots.
+ */
+class CSnapshotDecoder
+{
+public:
+	enum
+	{
+		NUM_CONNS = 2,
+		MAX_JOBS = 16,
+	};
+
+	enum EResult
+	{
+		RESULT_SUCCESS,
+		RESULT_MISSING_DELTA,
+		RESULT_DECOMPRESS_FAILED,
+		RESULT_UNPACK_FAILED,
+		RESULT_INVALID,
+		RESULT_CRC_MISMATCH,
+	};
+
+	class CJob
+	{
+	public:
+		int m_Conn;
+		int m_GameTick;
+		int m_DeltaTick;
+		// snapshots before this tick are no longer needed as delta
+		int m_PurgeTick;
+		bool m_CheckCrc;
+		unsigned m_Crc;
+		bool m_Sixup;
+		int64_t m_ReceiveTime;
+		int m_DataSize;
+		unsigned char m_aData[CSnapshot::MAX_SIZE];
+
+		// set by the decoder
+		int m_Generation;
+		EResult m_Result;
+		int m_UnpackError;
+		int m_DeltaSize;
+		int m_SnapSize;
+		unsigned char m_aSnapshot[CSnapshot::MAX_SIZE];
+
+		CSnapshot *Snapshot() { return (CSnapshot *)m_aSnapshot; }
+	};
+
+private:
+	std::unique_ptr<CJob[]> m_pJobs;
+	// written by the owning thread
+	std::atomic<unsigned> m_Submitted{0};
+	// written by the decoder thread
+	std::atomic<unsigned> m_Decoded{0};
+	unsigned m_Consumed = 0;
+
+	int m_aGeneration[NUM_CONNS] = {0, 0};
+	int m_aDecoderGeneration[NUM_CONNS] = {0, 0};
+	CSnapshotStorage m_aStorage[NUM_CONNS];
+	unsigned char m_aDeltaData[CSnapshot::MAX_SIZE];
+
+	CLock m_DeltaLock;
+	CSnapshotDelta m_Delta GUARDED_BY(m_DeltaLock);
+
+	CSemaphore m_Semaphore;
+	std::atomic<bool> m_Shutdown{false};
+	void *m_pThread = nullptr;
+
+	static void ThreadFunc(void *pUser);
+	void Decode(CJob *pJob) REQUIRES(!m_DeltaLock);
+
+public:
+	CSnapshotDecoder();
+	~CSnapshotDecoder();
+
+	void Init();
+	void Shutdown();
+
+	/**
+	 * Must be called before the first job is submitted.
+	 */
+	void SetStaticsize(int ItemType, size_t Size) REQUIRES(!m_DeltaLock);
+	void SetStaticsize7(int ItemType, size_t Size) REQUIRES(!m_DeltaLock);
+	/**
+	 * Statistics of the unpacked deltas like `CSnapshotDelta::GetDataRate`
+	 * and `CSnapshotDelta::GetDataUpdates`.
+	 */
+	void DataRate(int Index, uint64_t *pRate, uint64_t *pUpdates) REQUIRES(!m_DeltaLock);
+
+	/**
+	 * Drops the stored snapshots of the connection. Decoded jobs submitted
+	 * before are no longer current.
+	 *
+	 * @see IsCurrent
+	 */
+	void Reset(int Conn);
+
+	/**
+	 * @return A job to fill and submit, `nullptr` if all jobs are in use.
+	 */
+	CJob *NewJob();
+	/**
+	 * Submits the job returned by the last `NewJob` call.
+	 */
+	void Submit();
+
+	/**
+	 * @return The oldest decoded job or `nullptr` if none was decoded yet.
+	 * It stays valid until `PopDecodedJob` is called.
+	 */
+	CJob *DecodedJob();
+	void PopDecodedJob();
+	bool IsCurrent(const CJob *pJob) const { return pJob->m_Generation == m_aGeneration[pJob->m_Conn]; }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "substring_matcher.h"
+
+#include <algorithm>
+#include <deque>
+
+CSubstringMatcher::CSubstringMatcher()
+{
+	Clear();
+}
+
+void CSubstringMatcher::Clear()
+{
+	m_vNodes.clear();
+	m_vNodes.emplace_back();
+	m_vPatternLengths.clear();
+	m_Built = false;
+}
+
+int CSubstringMatcher::Child(int Node, int Codepoint) const
+{
+	const std::vector<std::pair<int, int>> &vChildren = m_vNodes[Node].m_vChildren;
+	const auto It = std::lower_bound(vChildren.begin(), vChildren.end(), std::pair<int, int>(Codepoint, 0));
+	if(It == vChildren.end() || It->first != Codepoint)
+		return -1;
+	return It->second;
+}
+
+int CSubstringMatcher::Transition(int Node, int Codepoint) const
+{
+	while(true)
+	{
+		const int Next = Child(Node, Codepoint);
+		if(Next != -1)
+			return Next;
+		if(Node == 0)
+			return 0;
+		Node = m_vNodes[Node].m_Fail;
+	}
+}
+
+int CSubstringMatcher::Add(const char *pPattern)
+{
+	m_Built = false;
+	const int Pattern = m_vPatternLengths.size();
+	int Node = 0;
+	int Length = 0;
+	while(*pPattern)
+	{
+		const int Codepoint = str_utf8_tolower_codepoint(str_utf8_decode(&pPattern));
+		int Next = Child(Node, Codepoint);
+		if(Next == -1)
+		{
+			Next = m_vNodes.size();
+			std::vector<std::pair<int, int>> &vChildren = m_vNodes[Node].m_vChildren;
+			vChildren.insert(std::lower_bound(vChildren.begin(), vChildren.end(), std::pair<int, int>(Codepoint, 0)), {Codepoint, Next});
+			m_vNodes.emplace_back();
+		}
+		Node = Next;
+		Length++;
+	}
+	m_vPatternLengths.push_back(Length);
+	if(Length > 0)
+		m_vNodes[Node].m_vPatterns.push_back(Pattern);
+	return Pattern;
+}
+
+void CSubstringMatcher::Build()
+{
+	// breadth first, so the fail node of every node is done before it
+	std::deque<int> Queue;
+	for(const auto &[Codepoint, Child] : m_vNodes[0].m_vChildren)
+	{
+		m_vNodes[Child].m_Fail = 0;
+		m_vNodes[Child].m_OutputLink = -1;
+		Queue.push_back(Child);
+	}
+	while(!Queue.empty())
+	{
+		const int Node = Queue.front();
+		Queue.pop_front();
+		for(const auto &[Codepoint, Child] : m_vNodes[Node].m_vChildren)
+		{
+			const int Fail = Transition(m_vNodes[Node].m_Fail, Codepoint);
+			m_vNodes[Child].m_Fail = Fail;
+			m_vNodes[Child].m_OutputLink = m_vNodes[Fail].m_vPatterns.empty() ? m_vNodes[Fail].m_OutputLink : Fail;
+			Queue.push_back(Child);
+		}
+	}
+	m_Built = true;
+}
@@ -0,0 +1,96 @@
+#ifndef ENGINE_SHARED_SUBSTRING_MATCHER_H
+#define ENGINE_SHARED_SUBSTRING_MATCHER_H
+
+#include <base/dbg.h>
+#include <base/str.h>
+
+#include <utility>
+#include <vector>
+
+/**
+ * Finds all occurrences of a set of UTF-8 patterns in a text in a single
+ * pass (Aho-Corasick automaton). Codepoints are compared case-insensitively
+ * like @link str_utf8_find_nocase @endlink does.
+ */
+class CSubstringMatcher
+{
+	class CNode
+	{
+	public:
+		// sorted by codepoint
+		std::vector<std::pair<int, int>> m_vChildren;
+		int m_Fail = 0;
+		// next node on the fail chain that ends a pattern, -1 if none
+		int m_OutputLink = -1;
+		std::vector<int> m_vPatterns;
+	};
+
+	std::vector<CNode> m_vNodes;
+	std::vector<int> m_vPatternLengths;
+	bool m_Built = false;
+
+	int Child(int Node, int Codepoint) const;
+	int Transition(int Node, int Codepoint) const;
+
+public:
+	CSubstringMatcher();
+
+	/**
+	 * Removes all patterns.
+	 */
+	void Clear();
+
+	/**
+	 * Adds a pattern, empty patterns never match.
+	 *
+	 * @param pPattern The pattern.
+	 *
+	 * @return Index of the pattern, patterns are numbered in the order they
+	 * were added.
+	 */
+	int Add(const char *pPattern);
+
+	/**
+	 * Prepares the automaton, must be called after the last pattern was
+	 * added and before searching.
+	 */
+	void Build();
+
+	int NumPatterns() const { return m_vPatternLengths.size(); }
+
+	/**
+	 * Calls `Fn(int Pattern, const char *pStart, const char *pEnd)` for
+	 * every occurrence of every pattern in the text, ordered by the end of
+	 * the occurrence.
+	 *
+	 * @param pText The text to search.
+	 * @param Fn Called with the pattern index and the occurrence in the text.
+	 */
+	template<typename F>
+	void FindAll(const char *pText, F &&Fn) const;
+};
+
+template<typename F>
+void CSubstringMatcher::FindAll(const char *pText, F &&Fn) const
+{
+	if(m_vPatternLengths.empty())
+		return;
+	dbg_assert(m_Built, "substring matcher used before it was built");
+
+	// start of the recent codepoints to find the start of an occurrence
+	std::vector<const char *> vCodepointStarts;
+	int Node = 0;
+	const char *pCur = pText;
+	while(*pCur)
+	{
+		vCodepointStarts.push_back(pCur);
+		Node = Transition(Node, str_utf8_tolower_codepoint(str_utf8_decode(&pCur)));
+		for(int Output = m_vNodes[Node].m_vPatterns.empty() ? m_vNodes[Node].m_OutputLink : Node; Output != -1; Output = m_vNodes[Output].m_OutputLink)
+		{
+			for(const int Pattern : m_vNodes[Output].m_vPatterns)
+				Fn(Pattern, vCodepointStarts[vCodepointStarts.size() - m_vPatternLengths[Pattern]], pCur);
+		}
+	}
+}
+
+#endif
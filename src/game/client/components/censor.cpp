@@ -7,35 +7,21 @@
 #include <engine/external/json-parser/json.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <optional>
 #include <utility>
 
-static void ReplaceWords(char *pBuffer, const std::vector<std::string> &vWords, char Replacement)
+static void ReplaceWords(char *pBuffer, const CSubstringMatcher &Words, char Replacement)
 {
 	if(!pBuffer)
 		return;
 
-	for(const auto &Word : vWords)
-	{
-		const char *pEnd = nullptr;
-		const char *pStart = pBuffer;
-
-		while(pStart)
-		{
-			pStart = str_utf8_find_nocase(pStart, Word.c_str(), &pEnd);
-			if(!pStart)
-				continue;
-			if((pStart == pBuffer || str_utf8_isspace(*(pStart - 1))) && (str_utf8_isspace(*(pEnd))))
-			{
-				while(pStart != pEnd)
-				{
-					pBuffer[pStart - pBuffer] = Replacement;
-					pStart++;
-				}
-			}
-			pStart = pEnd;
-		}
-	}
+	// occurrences are reported once their end has been read, so replacing
+	// them does not affect the rest of the search
+	Words.FindAll(pBuffer, [&](int Word, const char *pStart, const char *pEnd) {
+		if((pStart == pBuffer || str_utf8_isspace(*(pStart - 1))) && str_utf8_isspace(*pEnd))
+			std::fill(pBuffer + (pStart - pBuffer), pBuffer + (pEnd - pBuffer), Replacement);
+	});
 }
 
 void CCensor::ConchainRefreshCensorList(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
@@ -47,11 +33,6 @@ void CCensor::ConchainRefreshCensorList(IConsole::IResult *pResult, void *pUserD
 		((CCensor *)pUserData)->Reset();
 }
 
-CCensor::CCensor()
-{
-	m_vCensoredWords = {};
-}
-
 void CCensor::OnInit()
 {
 	Reset();
@@ -64,7 +45,7 @@ void CCensor::OnConsoleInit()
 
 void CCensor::Reset()
 {
-	m_vCensoredWords.clear();
+	m_CensoredWords.Clear();
 
 	if(m_pCensorListDownloadJob)
 	{
@@ -80,7 +61,12 @@ void CCensor::OnRender()
 	if(m_pCensorListDownloadJob && m_pCensorListDownloadJob->Done())
 	{
 		if(m_pCensorListDownloadJob->m_vLoadedWords)
-			m_vCensoredWords = std::move(*m_pCensorListDownloadJob->m_vLoadedWords);
+		{
+			m_CensoredWords.Clear();
+			for(const std::string &Word : *m_pCensorListDownloadJob->m_vLoadedWords)
+				m_CensoredWords.Add(Word.c_str());
+			m_CensoredWords.Build();
+		}
 		m_pCensorListDownloadJob = nullptr;
 	}
 }
@@ -100,7 +86,7 @@ void CCensor::CensorMessage(char *pMessage) const
 
 	if(!*pMessage)
 		return;
-	ReplaceWords(pMessage, m_vCensoredWords, '*');
+	ReplaceWords(pMessage, m_CensoredWords, '*');
 }
 
 std::optional<std::vector<std::string>> CCensor::LoadCensorListFromFile(const char *pFilePath) const
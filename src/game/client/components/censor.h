@@ -7,6 +7,7 @@
 #include <engine/shared/config.h>
 #include <engine/shared/http.h>
 #include <engine/shared/jobs.h>
+#include <engine/shared/substring_matcher.h>
 
 #include <game/client/component.h>
 
@@ -18,7 +19,7 @@
 class CCensor : public CComponent
 {
 private:
-	std::vector<std::string> m_vCensoredWords;
+	CSubstringMatcher m_CensoredWords;
 
 	class CCensorListDownloadJob : public IJob
 	{
@@ -45,7 +46,6 @@ private:
 	static void ConchainRefreshCensorList(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
 public:
-	CCensor();
 	int Sizeof() const override { return sizeof(*this); }
 
 	void Reset();
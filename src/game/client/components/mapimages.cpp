@@ -2,8 +2,12 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "mapimages.h"
 
+#include <base/hash_ctxt.h>
 #include <base/log.h>
+#include <base/time.h>
 
+#include <engine/engine.h>
+#include <engine/gfx/image_manipulation.h>
 #include <engine/graphics.h>
 #include <engine/map.h>
 #include <engine/storage.h>
@@ -27,6 +31,137 @@ CMapImages::CMapImages()
 	static_assert(std::size(gs_apModEntitiesNames) == MAP_IMAGE_MOD_TYPE_COUNT, "Mod name string count is not equal to mod type count");
 }
 
+bool CMapImageCache::Contains(const SHA256_DIGEST &Sha256, int LoadFlags)
+{
+	const CLockScope LockScope(m_Lock);
+	return std::any_of(m_vEntries.begin(), m_vEntries.end(), [&](const CEntry &Entry) {
+		return Entry.m_Sha256 == Sha256 && Entry.m_LoadFlags == LoadFlags;
+	});
+}
+
+IGraphics::CTextureHandle CMapImageCache::Acquire(const SHA256_DIGEST &Sha256, int LoadFlags)
+{
+	const CLockScope LockScope(m_Lock);
+	for(CEntry &Entry : m_vEntries)
+	{
+		if(Entry.m_Sha256 == Sha256 && Entry.m_LoadFlags == LoadFlags)
+		{
+			Entry.m_Users++;
+			Entry.m_LastUsed = ++m_UseCounter;
+			return Entry.m_Texture;
+		}
+	}
+	return IGraphics::CTextureHandle();
+}
+
+void CMapImageCache::Add(const SHA256_DIGEST &Sha256, int LoadFlags, IGraphics::CTextureHandle Texture, size_t Size)
+{
+	const CLockScope LockScope(m_Lock);
+	CEntry Entry;
+	Entry.m_Sha256 = Sha256;
+	Entry.m_LoadFlags = LoadFlags;
+	Entry.m_Texture = Texture;
+	Entry.m_Size = Size;
+	Entry.m_Users = 1;
+	Entry.m_LastUsed = ++m_UseCounter;
+	m_vEntries.push_back(Entry);
+}
+
+bool CMapImageCache::Release(IGraphics::CTextureHandle Texture)
+{
+	const CLockScope LockScope(m_Lock);
+	for(CEntry &Entry : m_vEntries)
+	{
+		if(Entry.m_Users > 0 && Entry.m_Texture.Id() == Texture.Id())
+		{
+			Entry.m_Users--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CMapImageCache::Trim(IGraphics *pGraphics, size_t Budget)
+{
+	const CLockScope LockScope(m_Lock);
+	size_t UnusedSize = 0;
+	for(const CEntry &Entry : m_vEntries)
+	{
+		if(Entry.m_Users == 0)
+			UnusedSize += Entry.m_Size;
+	}
+	while(UnusedSize > Budget)
+	{
+		auto Oldest = m_vEntries.end();
+		for(auto It = m_vEntries.begin(); It != m_vEntries.end(); ++It)
+		{
+			if(It->m_Users == 0 && (Oldest == m_vEntries.end() || It->m_LastUsed < Oldest->m_LastUsed))
+				Oldest = It;
+		}
+		UnusedSize -= Oldest->m_Size;
+		pGraphics->UnloadTexture(&Oldest->m_Texture);
+		m_vEntries.erase(Oldest);
+	}
+}
+
+CMapImages::CMapImageLoadQueue::~CMapImageLoadQueue()
+{
+	for(CMapImageLoad &Load : m_vLoads)
+		Load.m_Image.Free();
+}
+
+void CMapImages::CMapImageLoadQueue::Work()
+{
+	while(true)
+	{
+		const int Index = m_NextLoad.fetch_add(1);
+		if(Index >= (int)m_vLoads.size())
+			return;
+		m_vLoads[Index].Load(m_pStorage, m_pGraphics, m_pCache);
+		if(m_LoadsDone.fetch_add(1) + 1 == (int)m_vLoads.size())
+			m_Finished.Signal();
+	}
+}
+
+CMapImages::CMapImageLoadJob::CMapImageLoadJob(std::shared_ptr<CMapImageLoadQueue> pQueue) :
+	m_pQueue(std::move(pQueue))
+{
+}
+
+void CMapImages::CMapImageLoadJob::Run()
+{
+	m_pQueue->Work();
+}
+
+void CMapImages::CMapImageLoad::Load(IStorage *pStorage, IGraphics *pGraphics, CMapImageCache *pCache)
+{
+	const std::chrono::nanoseconds LoadStart = time_get_nanoseconds();
+	void *pData;
+	unsigned DataSize;
+	if(!pStorage->ReadFile(m_aPath, IStorage::TYPE_ALL, &pData, &DataSize))
+	{
+		return;
+	}
+	const std::chrono::nanoseconds DecodeStart = time_get_nanoseconds();
+	m_Timings.m_Load = DecodeStart - LoadStart;
+	if(pCache)
+		m_Sha256 = sha256(pData, DataSize);
+	if(pCache && pCache->Contains(m_Sha256, m_LoadFlags))
+	{
+		free(pData);
+		m_Cached = true;
+		m_Success = true;
+		return;
+	}
+	m_Success = pGraphics->LoadPng(m_Image, static_cast<const uint8_t *>(pData), DataSize, m_aPath);
+	free(pData);
+	if(m_Success && !ConvertToRgba(m_Image))
+	{
+		log_warn("mapimages", "Converted image '%s' to RGBA, consider making its file format RGBA.", m_aPath);
+	}
+	m_Timings.m_Decode = time_get_nanoseconds() - DecodeStart;
+}
+
 void CMapImages::OnInit()
 {
 	m_TextureScale = g_Config.m_ClTextEntitiesSize;
@@ -44,11 +179,15 @@ void CMapImages::OnInit()
 
 void CMapImages::Unload()
 {
-	// unload all textures
+	// unload all textures, cached ones are only unloaded when the cache is full
 	for(int i = 0; i < m_Count; i++)
 	{
-		Graphics()->UnloadTexture(&m_aTextures[i]);
+		if(m_ImageCache.Release(m_aTextures[i]))
+			m_aTextures[i] = IGraphics::CTextureHandle();
+		else
+			Graphics()->UnloadTexture(&m_aTextures[i]);
 	}
+	m_ImageCache.Trim(Graphics(), (size_t)g_Config.m_ClMapImageCacheSize * 1024 * 1024);
 }
 
 void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
@@ -97,10 +236,20 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 
 	const int TextureLoadFlag = Graphics()->Uses2DTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE;
 
-	// load new textures
+	// load new textures, external images are read and decoded by jobs while
+	// the embedded images are loaded, their textures are created afterwards
 	bool ShowWarning = false;
+	int aLoadFlags[MAX_MAPIMAGES];
+	const char *apEmbeddedNames[MAX_MAPIMAGES] = {nullptr};
+	std::shared_ptr<CMapImageLoadQueue> pLoadQueue = std::make_shared<CMapImageLoadQueue>();
+	pLoadQueue->m_pStorage = Storage();
+	pLoadQueue->m_pGraphics = Graphics();
+	// the images are only hashed to look up and add their textures in the cache
+	const bool UseCache = g_Config.m_ClMapImageCacheSize > 0;
+	pLoadQueue->m_pCache = UseCache ? &m_ImageCache : nullptr;
 	for(int i = 0; i < m_Count; i++)
 	{
+		m_aLoadTimings[i] = CLoadTimings();
 		if(aTextureUsedByTileOrQuadLayerFlag[i] == 0)
 		{
 			// skip loading unused images
@@ -108,6 +257,7 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 		}
 
 		const int LoadFlag = (((aTextureUsedByTileOrQuadLayerFlag[i] & 1) != 0) ? TextureLoadFlag : 0) | (((aTextureUsedByTileOrQuadLayerFlag[i] & 2) != 0) ? 0 : (Graphics()->HasTextureArraysSupport() ? IGraphics::TEXLOAD_NO_2D_TEXTURE : 0));
+		aLoadFlags[i] = LoadFlag;
 		const CMapItemImage_v2 *pImg = static_cast<const CMapItemImage_v2 *>(pMap->GetItem(Start + i));
 
 		const char *pName = pMap->GetDataString(pImg->m_ImageName);
@@ -129,48 +279,132 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 			continue;
 		}
 
-		if(pImg->m_External)
+		if(!pImg->m_External)
 		{
-			char aPath[IO_MAX_PATH_LENGTH];
-			bool Translated = false;
-			if(Client()->IsSixup())
-			{
-				Translated =
-					!str_comp(pName, "grass_doodads") ||
-					!str_comp(pName, "grass_main") ||
-					!str_comp(pName, "winter_main") ||
-					!str_comp(pName, "generic_shadows") ||
-					!str_comp(pName, "generic_unhookable") ||
-					!str_comp(pName, "easter");
-			}
-			str_format(aPath, sizeof(aPath), "mapres/%s%s.png", pName, Translated ? "_0.7" : "");
-			m_aTextures[i] = Graphics()->LoadTexture(aPath, IStorage::TYPE_ALL, LoadFlag);
+			// the name stays loaded until the texture was created
+			apEmbeddedNames[i] = pName;
+			continue;
 		}
-		else
+
+		bool Translated = false;
+		if(Client()->IsSixup())
 		{
-			CImageInfo ImageInfo;
-			ImageInfo.m_Width = pImg->m_Width;
-			ImageInfo.m_Height = pImg->m_Height;
-			ImageInfo.m_Format = CImageInfo::FORMAT_RGBA;
-			ImageInfo.m_pData = static_cast<uint8_t *>(pMap->GetData(pImg->m_ImageData));
-			if(ImageInfo.m_pData && (size_t)pMap->GetDataSize(pImg->m_ImageData) >= ImageInfo.DataSize())
+			Translated =
+				!str_comp(pName, "grass_doodads") ||
+				!str_comp(pName, "grass_main") ||
+				!str_comp(pName, "winter_main") ||
+				!str_comp(pName, "generic_shadows") ||
+				!str_comp(pName, "generic_unhookable") ||
+				!str_comp(pName, "easter");
+		}
+		CMapImageLoad &Load = pLoadQueue->m_vLoads.emplace_back();
+		Load.m_Index = i;
+		str_format(Load.m_aPath, sizeof(Load.m_aPath), "mapres/%s%s.png", pName, Translated ? "_0.7" : "");
+		Load.m_LoadFlags = LoadFlag;
+		pMap->UnloadData(pImg->m_ImageName);
+	}
+
+	const int NumLoads = pLoadQueue->m_vLoads.size();
+	const int NumHelpers = std::min(Engine()->JobPool()->NumThreads(), NumLoads);
+	for(int i = 0; i < NumHelpers; i++)
+		Engine()->AddJob(std::make_shared<CMapImageLoadJob>(pLoadQueue));
+
+	for(int i = 0; i < m_Count; i++)
+	{
+		if(apEmbeddedNames[i] == nullptr)
+		{
+			continue;
+		}
+
+		const int LoadFlag = aLoadFlags[i];
+		const CMapItemImage_v2 *pImg = static_cast<const CMapItemImage_v2 *>(pMap->GetItem(Start + i));
+		const std::chrono::nanoseconds LoadStart = time_get_nanoseconds();
+		CImageInfo ImageInfo;
+		ImageInfo.m_Width = pImg->m_Width;
+		ImageInfo.m_Height = pImg->m_Height;
+		ImageInfo.m_Format = CImageInfo::FORMAT_RGBA;
+		ImageInfo.m_pData = static_cast<uint8_t *>(pMap->GetData(pImg->m_ImageData));
+		if(ImageInfo.m_pData && (size_t)pMap->GetDataSize(pImg->m_ImageData) >= ImageInfo.DataSize())
+		{
+			SHA256_DIGEST Sha256 = {};
+			if(UseCache)
 			{
-				char aTexName[IO_MAX_PATH_LENGTH];
-				str_format(aTexName, sizeof(aTexName), "embedded: %s", pName);
-				m_aTextures[i] = Graphics()->LoadTextureRaw(ImageInfo, LoadFlag, aTexName);
-				pMap->UnloadData(pImg->m_ImageData);
+				SHA256_CTX Sha256Ctx;
+				sha256_init(&Sha256Ctx);
+				sha256_update(&Sha256Ctx, &pImg->m_Width, sizeof(pImg->m_Width));
+				sha256_update(&Sha256Ctx, &pImg->m_Height, sizeof(pImg->m_Height));
+				sha256_update(&Sha256Ctx, ImageInfo.m_pData, ImageInfo.DataSize());
+				Sha256 = sha256_finish(&Sha256Ctx);
 			}
-			else
+
+			const std::chrono::nanoseconds UploadStart = time_get_nanoseconds();
+			m_aTextures[i] = UseCache ? m_ImageCache.Acquire(Sha256, LoadFlag) : IGraphics::CTextureHandle();
+			if(!m_aTextures[i].IsValid())
 			{
-				pMap->UnloadData(pImg->m_ImageData);
-				log_error("mapimages", "Failed to load map image %d: failed to load data.", i);
-				ShowWarning = true;
-				continue;
+				char aTexName[IO_MAX_PATH_LENGTH];
+				str_format(aTexName, sizeof(aTexName), "embedded: %s", apEmbeddedNames[i]);
+				m_aTextures[i] = Graphics()->LoadTextureRaw(ImageInfo, LoadFlag, aTexName);
+				if(UseCache && m_aTextures[i].IsValid() && !m_aTextures[i].IsNullTexture())
+					m_ImageCache.Add(Sha256, LoadFlag, m_aTextures[i], ImageInfo.DataSize());
 			}
+			m_aLoadTimings[i].m_Load = UploadStart - LoadStart;
+			m_aLoadTimings[i].m_Upload = time_get_nanoseconds() - UploadStart;
+			ShowWarning = ShowWarning || m_aTextures[i].IsNullTexture();
 		}
+		else
+		{
+			log_error("mapimages", "Failed to load map image %d: failed to load data.", i);
+			ShowWarning = true;
+		}
+		pMap->UnloadData(pImg->m_ImageData);
 		pMap->UnloadData(pImg->m_ImageName);
+	}
+
+	// load the remaining external images on this thread as well, then
+	// create their textures in order
+	if(NumLoads > 0)
+	{
+		pLoadQueue->Work();
+		pLoadQueue->m_Finished.Wait();
+	}
+	for(CMapImageLoad &Load : pLoadQueue->m_vLoads)
+	{
+		const int i = Load.m_Index;
+		m_aLoadTimings[i] = Load.m_Timings;
+		if(Load.m_Cached)
+		{
+			m_aTextures[i] = m_ImageCache.Acquire(Load.m_Sha256, Load.m_LoadFlags);
+		}
+		else if(Load.m_Success)
+		{
+			const std::chrono::nanoseconds UploadStart = time_get_nanoseconds();
+			const size_t Size = Load.m_Image.DataSize();
+			m_aTextures[i] = Graphics()->LoadTextureRawMove(Load.m_Image, Load.m_LoadFlags, Load.m_aPath);
+			m_aLoadTimings[i].m_Upload = time_get_nanoseconds() - UploadStart;
+			if(UseCache && m_aTextures[i].IsValid() && !m_aTextures[i].IsNullTexture())
+				m_ImageCache.Add(Load.m_Sha256, Load.m_LoadFlags, m_aTextures[i], Size);
+		}
+		if(!m_aTextures[i].IsValid())
+		{
+			// load again on this thread to get the null texture and the error
+			m_aTextures[i] = Graphics()->LoadTexture(Load.m_aPath, IStorage::TYPE_ALL, Load.m_LoadFlags);
+		}
 		ShowWarning = ShowWarning || m_aTextures[i].IsNullTexture();
 	}
+
+	if(g_Config.m_Debug)
+	{
+		CLoadTimings Total;
+		for(int i = 0; i < m_Count; i++)
+		{
+			Total.m_Load += m_aLoadTimings[i].m_Load;
+			Total.m_Decode += m_aLoadTimings[i].m_Decode;
+			Total.m_Upload += m_aLoadTimings[i].m_Upload;
+		}
+		log_trace("mapimages", "Loaded %d map images: load %.2fms, decode %.2fms, upload %.2fms",
+			m_Count, Total.m_Load.count() / 1e6, Total.m_Decode.count() / 1e6, Total.m_Upload.count() / 1e6);
+	}
+
 	if(ShowWarning)
 	{
 		Client()->AddWarning(SWarning(Localize("Some map images could not be loaded. Check the local console for details.")));
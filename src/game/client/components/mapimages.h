@@ -3,13 +3,23 @@
 #ifndef GAME_CLIENT_COMPONENTS_MAPIMAGES_H
 #define GAME_CLIENT_COMPONENTS_MAPIMAGES_H
 
+#include <base/hash.h>
+#include <base/lock.h>
+#include <base/sphore.h>
+
 #include <engine/console.h>
 #include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 
 #include <game/client/component.h>
 #include <game/map/render_interfaces.h>
 #include <game/mapitems.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
 enum EMapImageModType
 {
 	MAP_IMAGE_MOD_TYPE_DDNET = 0,
@@ -33,12 +43,104 @@ constexpr const char *const gs_apModEntitiesNames[] = {
 	"f-ddrace",
 };
 
+// Keeps the textures of map images alive after their map was unloaded, so
+// maps using the same images can reuse them without decoding and uploading.
+class CMapImageCache
+{
+	class CEntry
+	{
+	public:
+		SHA256_DIGEST m_Sha256;
+		int m_LoadFlags;
+		IGraphics::CTextureHandle m_Texture;
+		size_t m_Size;
+		int m_Users;
+		int64_t m_LastUsed;
+	};
+
+	CLock m_Lock;
+	std::vector<CEntry> m_vEntries GUARDED_BY(m_Lock);
+	int64_t m_UseCounter GUARDED_BY(m_Lock) = 0;
+
+public:
+	// may be called from jobs
+	bool Contains(const SHA256_DIGEST &Sha256, int LoadFlags) REQUIRES(!m_Lock);
+	// returns an invalid handle if the texture is not cached
+	IGraphics::CTextureHandle Acquire(const SHA256_DIGEST &Sha256, int LoadFlags) REQUIRES(!m_Lock);
+	void Add(const SHA256_DIGEST &Sha256, int LoadFlags, IGraphics::CTextureHandle Texture, size_t Size) REQUIRES(!m_Lock);
+	// returns false if the texture is not cached
+	bool Release(IGraphics::CTextureHandle Texture) REQUIRES(!m_Lock);
+	// unloads the least recently used textures that are not in use until the
+	// remaining ones fit into the budget
+	void Trim(IGraphics *pGraphics, size_t Budget) REQUIRES(!m_Lock);
+};
+
 class CMapImages : public CComponent, public IMapImages
 {
 	friend class CBackground;
 	friend class CMenuBackground;
 
+public:
+	class CLoadTimings
+	{
+	public:
+		std::chrono::nanoseconds m_Load{0}; // reading the file or the map data
+		std::chrono::nanoseconds m_Decode{0}; // decoding the PNG and converting to RGBA
+		std::chrono::nanoseconds m_Upload{0}; // queueing the texture creation
+	};
+
+private:
+	// reads and decodes an external image, the texture is created on the main thread
+	class CMapImageLoad
+	{
+	public:
+		int m_Index;
+		char m_aPath[IO_MAX_PATH_LENGTH];
+		int m_LoadFlags;
+
+		CImageInfo m_Image;
+		SHA256_DIGEST m_Sha256;
+		bool m_Success = false;
+		// the image was not decoded because its texture is cached
+		bool m_Cached = false;
+		CLoadTimings m_Timings;
+
+		// `pCache` is null if the cache is disabled
+		void Load(IStorage *pStorage, IGraphics *pGraphics, CMapImageCache *pCache);
+	};
+
+	// external images of a map, loaded by the job pool and the main thread
+	class CMapImageLoadQueue
+	{
+	public:
+		IStorage *m_pStorage;
+		IGraphics *m_pGraphics;
+		CMapImageCache *m_pCache;
+		std::vector<CMapImageLoad> m_vLoads;
+		std::atomic<int> m_NextLoad = 0;
+		std::atomic<int> m_LoadsDone = 0;
+		// signaled by the thread that finished the last image
+		CSemaphore m_Finished;
+
+		~CMapImageLoadQueue();
+		void Work();
+	};
+
+	class CMapImageLoadJob : public IJob
+	{
+		std::shared_ptr<CMapImageLoadQueue> m_pQueue;
+
+	protected:
+		void Run() override;
+
+	public:
+		CMapImageLoadJob(std::shared_ptr<CMapImageLoadQueue> pQueue);
+	};
+
+	CMapImageCache m_ImageCache;
+
 	IGraphics::CTextureHandle m_aTextures[MAX_MAPIMAGES];
+	CLoadTimings m_aLoadTimings[MAX_MAPIMAGES];
 	int m_Count;
 
 	char m_aEntitiesPath[IO_MAX_PATH_LENGTH];
@@ -49,6 +151,7 @@ public:
 
 	IGraphics::CTextureHandle Get(int Index) const override { return m_aTextures[Index]; }
 	int Num() const override { return m_Count; }
+	const CLoadTimings &LoadTimings(int Index) const { return m_aLoadTimings[Index]; }
 
 	void OnMapLoadImpl(class CLayers *pLayers, class IMap *pMap);
 	void OnMapLoad() override;
@@ -22,21 +22,99 @@ CParticles::CParticles()
 	m_RenderGeneral.m_pParts = this;
 }
 
+void CParticles::CParticleBuffer::Add(const CParticle &Particle, float Life, int64_t Sequence)
+{
+	m_vSequence.push_back(Sequence);
+	m_vPosX.push_back(Particle.m_Pos.x);
+	m_vPosY.push_back(Particle.m_Pos.y);
+	m_vVelX.push_back(Particle.m_Vel.x);
+	m_vVelY.push_back(Particle.m_Vel.y);
+	m_vLife.push_back(Life);
+	m_vLifeSpan.push_back(Particle.m_LifeSpan);
+	m_vStartSize.push_back(Particle.m_StartSize);
+	m_vEndSize.push_back(Particle.m_EndSize);
+	m_vStartAlpha.push_back(Particle.m_UseAlphaFading ? Particle.m_StartAlpha : Particle.m_Color.a);
+	m_vEndAlpha.push_back(Particle.m_UseAlphaFading ? Particle.m_EndAlpha : Particle.m_Color.a);
+	m_vRot.push_back(Particle.m_Rot);
+	m_vRotspeed.push_back(Particle.m_Rotspeed);
+	m_vGravity.push_back(Particle.m_Gravity);
+	m_vFriction.push_back(Particle.m_Friction);
+	m_vColor.push_back(Particle.m_Color);
+	m_vSpr.push_back(Particle.m_Spr);
+}
+
+void CParticles::CParticleBuffer::Move(size_t From, size_t To)
+{
+	m_vSequence[To] = m_vSequence[From];
+	m_vPosX[To] = m_vPosX[From];
+	m_vPosY[To] = m_vPosY[From];
+	m_vVelX[To] = m_vVelX[From];
+	m_vVelY[To] = m_vVelY[From];
+	m_vLife[To] = m_vLife[From];
+	m_vLifeSpan[To] = m_vLifeSpan[From];
+	m_vStartSize[To] = m_vStartSize[From];
+	m_vEndSize[To] = m_vEndSize[From];
+	m_vStartAlpha[To] = m_vStartAlpha[From];
+	m_vEndAlpha[To] = m_vEndAlpha[From];
+	m_vRot[To] = m_vRot[From];
+	m_vRotspeed[To] = m_vRotspeed[From];
+	m_vGravity[To] = m_vGravity[From];
+	m_vFriction[To] = m_vFriction[From];
+	m_vColor[To] = m_vColor[From];
+	m_vSpr[To] = m_vSpr[From];
+}
+
+void CParticles::CParticleBuffer::Resize(size_t Size)
+{
+	m_vSequence.resize(Size);
+	m_vPosX.resize(Size);
+	m_vPosY.resize(Size);
+	m_vVelX.resize(Size);
+	m_vVelY.resize(Size);
+	m_vLife.resize(Size);
+	m_vLifeSpan.resize(Size);
+	m_vStartSize.resize(Size);
+	m_vEndSize.resize(Size);
+	m_vStartAlpha.resize(Size);
+	m_vEndAlpha.resize(Size);
+	m_vRot.resize(Size);
+	m_vRotspeed.resize(Size);
+	m_vGravity.resize(Size);
+	m_vFriction.resize(Size);
+	m_vColor.resize(Size);
+	m_vSpr.resize(Size);
+}
+
+void CParticles::CParticleBuffer::Clear()
+{
+	m_vSequence.clear();
+	m_vPosX.clear();
+	m_vPosY.clear();
+	m_vVelX.clear();
+	m_vVelY.clear();
+	m_vLife.clear();
+	m_vLifeSpan.clear();
+	m_vStartSize.clear();
+	m_vEndSize.clear();
+	m_vStartAlpha.clear();
+	m_vEndAlpha.clear();
+	m_vRot.clear();
+	m_vRotspeed.clear();
+	m_vGravity.clear();
+	m_vFriction.clear();
+	m_vColor.clear();
+	m_vSpr.clear();
+}
+
 void CParticles::OnReset()
 {
 	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
+	for(CParticleGroup &Group : m_aGroups)
 	{
-		m_aParticles[i].m_PrevPart = i - 1;
-		m_aParticles[i].m_NextPart = i + 1;
+		Group.m_Colliding.Clear();
+		Group.m_NonColliding.Clear();
 	}
-
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES - 1].m_NextPart = -1;
-	m_FirstFree = 0;
-
-	for(int &FirstPart : m_aFirstPart)
-		FirstPart = -1;
+	m_NumParticles = 0;
 }
 
 void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
@@ -53,27 +131,12 @@ void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
 			return;
 	}
 
-	if(m_FirstFree == -1)
+	if(m_NumParticles >= MAX_PARTICLES)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
-
-	// copy data
-	m_aParticles[Id] = *pPart;
-
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
-
-	// set some parameters
-	m_aParticles[Id].m_Life = TimePassed;
+	CParticleBuffer &Buffer = pPart->m_Collides ? m_aGroups[Group].m_Colliding : m_aGroups[Group].m_NonColliding;
+	Buffer.Add(*pPart, TimePassed, m_NextSequence++);
+	m_NumParticles++;
 }
 
 void CParticles::Update(float TimePassed)
@@ -93,55 +156,90 @@ void CParticles::Update(float TimePassed)
 		m_FrictionFraction -= 0.05f;
 	}
 
-	for(int &FirstPart : m_aFirstPart)
+	for(CParticleGroup &Group : m_aGroups)
 	{
-		int i = FirstPart;
-		while(i != -1)
-		{
-			int Next = m_aParticles[i].m_NextPart;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity * TimePassed;
-
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
+		UpdateBuffer(Group.m_Colliding, TimePassed, FrictionCount, true);
+		UpdateBuffer(Group.m_NonColliding, TimePassed, FrictionCount, false);
+	}
+}
 
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel * TimePassed;
-			if(m_aParticles[i].m_Collides)
-			{
-				Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, random_float(0.1f, 1.0f), nullptr);
-			}
-			else
-			{
-				m_aParticles[i].m_Pos += Vel;
-			}
-			m_aParticles[i].m_Vel = Vel * (1.0f / TimePassed);
+void CParticles::UpdateBuffer(CParticleBuffer &Buffer, float TimePassed, int FrictionCount, bool Collides)
+{
+	const size_t Size = Buffer.Size();
+	float *pPosX = Buffer.m_vPosX.data();
+	float *pPosY = Buffer.m_vPosY.data();
+	float *pVelX = Buffer.m_vVelX.data();
+	float *pVelY = Buffer.m_vVelY.data();
+	float *pLife = Buffer.m_vLife.data();
+	float *pRot = Buffer.m_vRot.data();
+	const float *pRotspeed = Buffer.m_vRotspeed.data();
+	const float *pGravity = Buffer.m_vGravity.data();
+	const float *pFriction = Buffer.m_vFriction.data();
+
+	for(size_t i = 0; i < Size; i++)
+		pVelY[i] += pGravity[i] * TimePassed;
+
+	// applying the friction for every passed friction step is the same as applying its power once
+	if(FrictionCount == 1)
+	{
+		for(size_t i = 0; i < Size; i++)
+		{
+			pVelX[i] *= pFriction[i];
+			pVelY[i] *= pFriction[i];
+		}
+	}
+	else if(FrictionCount > 1)
+	{
+		for(size_t i = 0; i < Size; i++)
+		{
+			const float Friction = std::pow(pFriction[i], (float)FrictionCount);
+			pVelX[i] *= Friction;
+			pVelY[i] *= Friction;
+		}
+	}
 
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
+	// move the points
+	if(Collides)
+	{
+		for(size_t i = 0; i < Size; i++)
+		{
+			vec2 Pos = vec2(pPosX[i], pPosY[i]);
+			vec2 Vel = vec2(pVelX[i], pVelY[i]) * TimePassed;
+			Collision()->MovePoint(&Pos, &Vel, random_float(0.1f, 1.0f), nullptr);
+			Vel *= 1.0f / TimePassed;
+			pPosX[i] = Pos.x;
+			pPosY[i] = Pos.y;
+			pVelX[i] = Vel.x;
+			pVelY[i] = Vel.y;
+		}
+	}
+	else
+	{
+		for(size_t i = 0; i < Size; i++)
+		{
+			pPosX[i] += pVelX[i] * TimePassed;
+			pPosY[i] += pVelY[i] * TimePassed;
+		}
+	}
 
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					FirstPart = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
+	for(size_t i = 0; i < Size; i++)
+	{
+		pLife[i] += TimePassed;
+		pRot[i] += TimePassed * pRotspeed[i];
+	}
 
-			i = Next;
-		}
+	// remove dead particles, keeping the order of the others
+	size_t Alive = 0;
+	for(size_t i = 0; i < Size; i++)
+	{
+		if(pLife[i] > Buffer.m_vLifeSpan[i])
+			continue;
+		if(Alive != i)
+			Buffer.Move(i, Alive);
+		Alive++;
 	}
+	m_NumParticles -= Size - Alive;
+	Buffer.Resize(Alive);
 }
 
 void CParticles::OnRender()
@@ -222,8 +320,6 @@ void CParticles::RenderGroup(int Group)
 	// don't use the buffer methods here, else the old renderer gets many draw calls
 	if(Graphics()->IsQuadContainerBufferingEnabled())
 	{
-		int i = m_aFirstPart[Group];
-
 		static IGraphics::SRenderSpriteInfo s_aParticleRenderInfo[MAX_PARTICLES];
 
 		int CurParticleRenderCount = 0;
@@ -232,73 +328,39 @@ void CParticles::RenderGroup(int Group)
 		ColorRGBA LastColor;
 		int LastQuadOffset = 0;
 
-		if(i != -1)
-		{
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
-			LastColor.r = m_aParticles[i].m_Color.r;
-			LastColor.g = m_aParticles[i].m_Color.g;
-			LastColor.b = m_aParticles[i].m_Color.b;
-			LastColor.a = Alpha;
-
-			Graphics()->SetColor(
-				m_aParticles[i].m_Color.r,
-				m_aParticles[i].m_Color.g,
-				m_aParticles[i].m_Color.b,
-				Alpha);
-
-			LastQuadOffset = m_aParticles[i].m_Spr;
-		}
-
-		while(i != -1)
-		{
-			int QuadOffset = m_aParticles[i].m_Spr;
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
+		m_aGroups[Group].ForEachNewestFirst([&](const CParticleBuffer &Buffer, size_t i) {
+			const int QuadOffset = Buffer.m_vSpr[i];
+			const float a = Buffer.m_vLife[i] / Buffer.m_vLifeSpan[i];
+			const vec2 p = vec2(Buffer.m_vPosX[i], Buffer.m_vPosY[i]);
+			const float Size = mix(Buffer.m_vStartSize[i], Buffer.m_vEndSize[i], a);
+			ColorRGBA Color = Buffer.m_vColor[i];
+			Color.a = mix(Buffer.m_vStartAlpha[i], Buffer.m_vEndAlpha[i], a);
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
-			if(ParticleIsVisibleOnScreen(p, Size))
+			if(!ParticleIsVisibleOnScreen(p, Size))
+				return;
+
+			if(CurParticleRenderCount == 0 || (size_t)CurParticleRenderCount == GRAPHICS_MAX_PARTICLES_RENDER_COUNT || LastColor != Color || LastQuadOffset != QuadOffset)
 			{
-				if((size_t)CurParticleRenderCount == GRAPHICS_MAX_PARTICLES_RENDER_COUNT || LastColor.r != m_aParticles[i].m_Color.r || LastColor.g != m_aParticles[i].m_Color.g || LastColor.b != m_aParticles[i].m_Color.b || LastColor.a != Alpha || LastQuadOffset != QuadOffset)
+				if(CurParticleRenderCount > 0)
 				{
 					dbg_assert(LastQuadOffset >= FirstParticleOffset, "Invalid particle offsets: %d < %d", LastQuadOffset, FirstParticleOffset);
 					Graphics()->TextureSet(aParticles[LastQuadOffset - FirstParticleOffset]);
 					Graphics()->RenderQuadContainerAsSpriteMultiple(ParticleQuadContainerIndex, LastQuadOffset - FirstParticleOffset, CurParticleRenderCount, s_aParticleRenderInfo);
 					CurParticleRenderCount = 0;
-					LastQuadOffset = QuadOffset;
-
-					Graphics()->SetColor(
-						m_aParticles[i].m_Color.r,
-						m_aParticles[i].m_Color.g,
-						m_aParticles[i].m_Color.b,
-						Alpha);
-
-					LastColor.r = m_aParticles[i].m_Color.r;
-					LastColor.g = m_aParticles[i].m_Color.g;
-					LastColor.b = m_aParticles[i].m_Color.b;
-					LastColor.a = Alpha;
 				}
-
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[0] = p.x;
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[1] = p.y;
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Scale = Size;
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = m_aParticles[i].m_Rot;
-
-				++CurParticleRenderCount;
+				LastQuadOffset = QuadOffset;
+				Graphics()->SetColor(Color);
+				LastColor = Color;
 			}
 
-			i = m_aParticles[i].m_NextPart;
-		}
+			s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[0] = p.x;
+			s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[1] = p.y;
+			s_aParticleRenderInfo[CurParticleRenderCount].m_Scale = Size;
+			s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = Buffer.m_vRot[i];
+
+			++CurParticleRenderCount;
+		});
 
 		if(CurParticleRenderCount > 0)
 		{
@@ -309,42 +371,30 @@ void CParticles::RenderGroup(int Group)
 	}
 	else
 	{
-		int i = m_aFirstPart[Group];
-
 		Graphics()->WrapClamp();
 
-		while(i != -1)
-		{
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
+		m_aGroups[Group].ForEachNewestFirst([&](const CParticleBuffer &Buffer, size_t i) {
+			const float a = Buffer.m_vLife[i] / Buffer.m_vLifeSpan[i];
+			const vec2 p = vec2(Buffer.m_vPosX[i], Buffer.m_vPosY[i]);
+			const float Size = mix(Buffer.m_vStartSize[i], Buffer.m_vEndSize[i], a);
+			ColorRGBA Color = Buffer.m_vColor[i];
+			Color.a = mix(Buffer.m_vStartAlpha[i], Buffer.m_vEndAlpha[i], a);
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
-			if(ParticleIsVisibleOnScreen(p, Size))
-			{
-				Graphics()->TextureSet(aParticles[m_aParticles[i].m_Spr - FirstParticleOffset]);
-				Graphics()->QuadsBegin();
+			if(!ParticleIsVisibleOnScreen(p, Size))
+				return;
 
-				Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
+			Graphics()->TextureSet(aParticles[Buffer.m_vSpr[i] - FirstParticleOffset]);
+			Graphics()->QuadsBegin();
 
-				Graphics()->SetColor(
-					m_aParticles[i].m_Color.r,
-					m_aParticles[i].m_Color.g,
-					m_aParticles[i].m_Color.b,
-					Alpha);
+			Graphics()->QuadsSetRotation(Buffer.m_vRot[i]);
 
-				IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
-				Graphics()->QuadsDraw(&QuadItem, 1);
-				Graphics()->QuadsEnd();
-			}
+			Graphics()->SetColor(Color);
 
-			i = m_aParticles[i].m_NextPart;
-		}
+			IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
+			Graphics()->QuadsDraw(&QuadItem, 1);
+			Graphics()->QuadsEnd();
+		});
 		Graphics()->WrapNormal();
 	}
 }
@@ -7,6 +7,8 @@
 
 #include <game/client/component.h>
 
+#include <vector>
+
 // particles
 struct CParticle
 {
@@ -54,11 +56,6 @@ struct CParticle
 	ColorRGBA m_Color;
 
 	bool m_Collides;
-
-	// set by the particle system
-	float m_Life;
-	int m_PrevPart;
-	int m_NextPart;
 };
 
 class CParticles : public CComponent
@@ -94,15 +91,71 @@ private:
 		MAX_PARTICLES = 1024 * 8,
 	};
 
-	CParticle m_aParticles[MAX_PARTICLES];
-	int m_FirstFree;
-	int m_aFirstPart[NUM_GROUPS];
+	// Particles stored as structure of arrays, so the update loops can be
+	// vectorized. The particles stay in the order they were added.
+	class CParticleBuffer
+	{
+	public:
+		std::vector<int64_t> m_vSequence;
+		std::vector<float> m_vPosX;
+		std::vector<float> m_vPosY;
+		std::vector<float> m_vVelX;
+		std::vector<float> m_vVelY;
+		std::vector<float> m_vLife;
+		std::vector<float> m_vLifeSpan;
+		std::vector<float> m_vStartSize;
+		std::vector<float> m_vEndSize;
+		// both are the color alpha for particles without alpha fading
+		std::vector<float> m_vStartAlpha;
+		std::vector<float> m_vEndAlpha;
+		std::vector<float> m_vRot;
+		std::vector<float> m_vRotspeed;
+		std::vector<float> m_vGravity;
+		std::vector<float> m_vFriction;
+		std::vector<ColorRGBA> m_vColor;
+		std::vector<int> m_vSpr;
+
+		size_t Size() const { return m_vPosX.size(); }
+		void Add(const CParticle &Particle, float Life, int64_t Sequence);
+		void Move(size_t From, size_t To);
+		void Resize(size_t Size);
+		void Clear();
+	};
+
+	class CParticleGroup
+	{
+	public:
+		// only colliding particles need the per particle collision check
+		CParticleBuffer m_Colliding;
+		CParticleBuffer m_NonColliding;
+
+		// Calls `Func(Buffer, Index)` for all particles, the newest first
+		// like they are rendered.
+		template<typename TFunc>
+		void ForEachNewestFirst(TFunc &&Func) const
+		{
+			size_t Colliding = m_Colliding.Size();
+			size_t NonColliding = m_NonColliding.Size();
+			while(Colliding > 0 || NonColliding > 0)
+			{
+				if(NonColliding == 0 || (Colliding > 0 && m_Colliding.m_vSequence[Colliding - 1] > m_NonColliding.m_vSequence[NonColliding - 1]))
+					Func(m_Colliding, --Colliding);
+				else
+					Func(m_NonColliding, --NonColliding);
+			}
+		}
+	};
+
+	CParticleGroup m_aGroups[NUM_GROUPS];
+	int m_NumParticles;
+	int64_t m_NextSequence = 0;
 
 	float m_FrictionFraction = 0.0f;
 	int64_t m_LastRenderTime = 0;
 
 	void RenderGroup(int Group);
 	void Update(float TimePassed);
+	void UpdateBuffer(CParticleBuffer &Buffer, float TimePassed, int FrictionCount, bool Collides);
 
 	template<int TGROUP>
 	class CRenderGroup : public CComponent
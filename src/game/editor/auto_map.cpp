@@ -2,16 +2,21 @@
 
 #include <base/io.h>
 #include <base/log.h>
+#include <base/sphore.h>
 #include <base/str.h>
 
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
+#include <game/editor/editor.h>
 #include <game/editor/editor_actions.h>
 #include <game/editor/mapitems/layer_tiles.h>
 #include <game/editor/mapitems/map.h>
 #include <game/mapitems.h>
 
+#include <atomic>
 #include <cinttypes>
 #include <cstdio> // sscanf
 
@@ -440,17 +445,23 @@ void CAutoMapper::ProceedLocalized(CLayerTiles *pLayer, CLayerTiles *pGameLayer,
 		{
 			const CTile *pInLayer = &pUpdateLayer->m_pTiles[(y - UpdateFromY) * pUpdateLayer->m_Width + x - UpdateFromX];
 			CTile *pOutLayer = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-			CTile PreviousLayer = *pOutLayer;
-			pOutLayer->m_Index = pInLayer->m_Index;
-			pOutLayer->m_Flags = pInLayer->m_Flags;
-			pLayer->RecordStateChange(x, y, PreviousLayer, *pOutLayer);
+			if(pOutLayer->m_Index != pInLayer->m_Index || pOutLayer->m_Flags != pInLayer->m_Flags)
+			{
+				CTile PreviousLayer = *pOutLayer;
+				pOutLayer->m_Index = pInLayer->m_Index;
+				pOutLayer->m_Flags = pInLayer->m_Flags;
+				pLayer->RecordStateChange(x, y, PreviousLayer, *pOutLayer);
+			}
 
 			const CTile *pInGame = &pUpdateGame->m_pTiles[(y - UpdateFromY) * pUpdateGame->m_Width + x - UpdateFromX];
 			CTile *pOutGame = &pGameLayer->m_pTiles[y * pGameLayer->m_Width + x];
-			CTile PreviousGame = *pOutGame;
-			pOutGame->m_Index = pInGame->m_Index;
-			pOutGame->m_Flags = pInGame->m_Flags;
-			pGameLayer->RecordStateChange(x, y, PreviousGame, *pOutGame);
+			if(pOutGame->m_Index != pInGame->m_Index || pOutGame->m_Flags != pInGame->m_Flags)
+			{
+				CTile PreviousGame = *pOutGame;
+				pOutGame->m_Index = pInGame->m_Index;
+				pOutGame->m_Flags = pInGame->m_Flags;
+				pGameLayer->RecordStateChange(x, y, PreviousGame, *pOutGame);
+			}
 		}
 	}
 
@@ -458,6 +469,157 @@ void CAutoMapper::ProceedLocalized(CLayerTiles *pLayer, CLayerTiles *pGameLayer,
 	delete pUpdateGame;
 }
 
+// Rows of a run that reads from a copy of the layer are independent of each
+// other, so they are split between the calling thread and the job pool.
+class CAutoMapper::CRowQueue
+{
+public:
+	static constexpr int ROWS_PER_CLAIM = 16;
+
+	const CAutoMapper *m_pAutoMapper;
+	const CRun *m_pRun;
+	int m_RunIndex;
+	bool m_IsFilterable;
+	const CTile *m_pReadTiles;
+	CTile *m_pTiles;
+	int m_Width;
+	int m_Height;
+	int m_Seed;
+	int m_SeedOffsetX;
+	int m_SeedOffsetY;
+
+	std::atomic<int> m_NextRow = 0;
+	std::atomic<int> m_RowsDone = 0;
+	// signaled by the thread that finished the last rows
+	CSemaphore m_Finished;
+	// tiles changed in each row with their previous state, filled by the thread that proceeded the row
+	std::vector<std::vector<std::pair<int, CTile>>> m_vvChanges;
+
+	void Work()
+	{
+		while(true)
+		{
+			const int FromY = m_NextRow.fetch_add(ROWS_PER_CLAIM);
+			if(FromY >= m_Height)
+				return;
+			const int ToY = std::min(FromY + ROWS_PER_CLAIM, m_Height);
+			for(int y = FromY; y < ToY; y++)
+			{
+				for(int x = 0; x < m_Width; x++)
+				{
+					CTile *pTile = &m_pTiles[y * m_Width + x];
+					const CTile Previous = *pTile;
+					m_pAutoMapper->ProceedTile(*m_pRun, m_RunIndex, m_IsFilterable, m_pReadTiles, pTile, m_Width, m_Height, x, y, m_Seed, m_SeedOffsetX, m_SeedOffsetY);
+					if(pTile->m_Index != Previous.m_Index || pTile->m_Flags != Previous.m_Flags)
+						m_vvChanges[y].emplace_back(x, Previous);
+				}
+			}
+			if(m_RowsDone.fetch_add(ToY - FromY) + (ToY - FromY) == m_Height)
+				m_Finished.Signal();
+		}
+	}
+};
+
+class CAutoMapper::CRowsJob : public IJob
+{
+	std::shared_ptr<CRowQueue> m_pQueue;
+
+	void Run() override
+	{
+		m_pQueue->Work();
+	}
+
+public:
+	CRowsJob(std::shared_ptr<CRowQueue> pQueue) :
+		m_pQueue(std::move(pQueue))
+	{
+	}
+};
+
+void CAutoMapper::ProceedTile(const CRun &Run, int RunIndex, bool IsFilterable, const CTile *pReadTiles, CTile *pTile, int Width, int Height, int x, int y, int Seed, int SeedOffsetX, int SeedOffsetY) const
+{
+	const CTile *pReadTile = &pReadTiles[y * Width + x];
+
+	for(size_t i = 0; i < Run.m_vIndexRules.size(); ++i)
+	{
+		const CIndexRule *pIndexRule = &Run.m_vIndexRules[i];
+		if(pReadTile->m_Index == 0)
+		{
+			if(pTile->m_Index != 0 && IsFilterable) // TODO: This is a lazy workaround
+			{
+				pTile->m_Index = 0;
+				pTile->m_Flags = pIndexRule->m_Flag;
+				continue;
+			}
+
+			if(pIndexRule->m_SkipEmpty) // skip empty tiles
+				continue;
+		}
+		if(pIndexRule->m_SkipFull && pReadTile->m_Index != 0) // skip full tiles
+			continue;
+
+		bool RespectRules = true;
+		for(size_t j = 0; j < pIndexRule->m_vRules.size() && RespectRules; ++j)
+		{
+			const CPosRule *pRule = &pIndexRule->m_vRules[j];
+
+			int CheckIndex, CheckFlags;
+			int CheckX = x + pRule->m_X;
+			int CheckY = y + pRule->m_Y;
+			if(CheckX >= 0 && CheckX < Width && CheckY >= 0 && CheckY < Height)
+			{
+				int CheckTile = CheckY * Width + CheckX;
+				CheckIndex = pReadTiles[CheckTile].m_Index;
+				CheckFlags = pReadTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_XFLIP | TILEFLAG_YFLIP);
+			}
+			else
+			{
+				CheckIndex = -1;
+				CheckFlags = 0;
+			}
+
+			if(pRule->m_Value == CPosRule::INDEX)
+			{
+				RespectRules = false;
+				for(const auto &Index : pRule->m_vIndexList)
+				{
+					if(CheckIndex == Index.m_Id && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
+					{
+						RespectRules = true;
+						break;
+					}
+				}
+			}
+			else if(pRule->m_Value == CPosRule::NOTINDEX)
+			{
+				for(const auto &Index : pRule->m_vIndexList)
+				{
+					if(CheckIndex == Index.m_Id && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
+					{
+						RespectRules = false;
+						break;
+					}
+				}
+			}
+		}
+
+		bool PassesModuloCheck;
+		if(pIndexRule->m_vModuloRules.empty())
+			PassesModuloCheck = true;
+		else
+			PassesModuloCheck = std::any_of(pIndexRule->m_vModuloRules.cbegin(), pIndexRule->m_vModuloRules.cend(), [&](const CModuloRule &ModuloRule) {
+				return (x + SeedOffsetX + ModuloRule.m_OffsetX) % ModuloRule.m_ModX == 0 && (y + SeedOffsetY + ModuloRule.m_OffsetY) % ModuloRule.m_ModY == 0;
+			});
+
+		if(RespectRules && PassesModuloCheck &&
+			(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, RunIndex, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
+		{
+			pTile->m_Index = pIndexRule->m_Id;
+			pTile->m_Flags = pIndexRule->m_Flag;
+		}
+	}
+}
+
 void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int ReferenceId, int ConfigId, int Seed, int SeedOffsetX, int SeedOffsetY)
 {
 	if(!m_FileLoaded || pLayer->m_Readonly || ConfigId < 0 || ConfigId >= (int)m_vConfigs.size())
@@ -468,6 +630,7 @@ void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int Refe
 
 	CConfiguration *pConf = &m_vConfigs[ConfigId];
 	pLayer->ClearHistory();
+	pLayer->Map()->OnModify();
 
 	const int LayerWidth = pLayer->m_Width;
 	const int LayerHeight = pLayer->m_Height;
@@ -476,6 +639,9 @@ void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int Refe
 
 	static_assert(std::size(AUTOMAP_REFERENCE_NAMES) == std::size(s_aTileIndex) + 1, "AUTOMAP_REFERENCE_NAMES and s_aTileIndex must include the same items");
 
+	CJobPool *pJobPool = Editor()->Engine() ? Editor()->Engine()->JobPool() : nullptr;
+	std::vector<CTile> vReadTiles;
+
 	// for every run: copy tiles, automap, overwrite tiles
 	for(size_t h = 0; h < pConf->m_vRuns.size(); ++h)
 	{
@@ -483,11 +649,11 @@ void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int Refe
 		bool IsFilterable = h == 0 && ReferenceId >= 0;
 
 		// don't make copy if it's requested
-		CLayerTiles *pReadLayer;
+		const CTile *pReadTiles;
 		CLayerTiles *pBuffer = IsFilterable ? pGameLayer : pLayer;
 		if(pRun->m_AutomapCopy)
 		{
-			pReadLayer = new CLayerTiles(pLayer->Map(), LayerWidth, LayerHeight);
+			vReadTiles.assign((size_t)LayerWidth * LayerHeight, CTile{});
 
 			int LoopWidth = IsFilterable ? std::min(pGameLayer->m_Width, LayerWidth) : LayerWidth;
 			int LoopHeight = IsFilterable ? std::min(pGameLayer->m_Height, LayerHeight) : LayerHeight;
@@ -497,7 +663,7 @@ void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int Refe
 				for(int x = 0; x < LoopWidth; x++)
 				{
 					const CTile *pIn = &pBuffer->m_pTiles[y * pBuffer->m_Width + x];
-					CTile *pOut = &pReadLayer->m_pTiles[y * LayerWidth + x];
+					CTile *pOut = &vReadTiles[y * LayerWidth + x];
 					if(h == 0 && ReferenceId >= 1 && pIn->m_Index != s_aTileIndex[ReferenceId - 1])
 						pOut->m_Index = 0;
 					else
@@ -505,108 +671,56 @@ void CAutoMapper::Proceed(CLayerTiles *pLayer, CLayerTiles *pGameLayer, int Refe
 					pOut->m_Flags = pIn->m_Flags;
 				}
 			}
+			pReadTiles = vReadTiles.data();
 		}
 		else
 		{
-			pReadLayer = pBuffer;
+			pReadTiles = pBuffer->m_pTiles;
 		}
 
 		// auto map
-		for(int y = 0; y < LayerHeight; y++)
+		if(pRun->m_AutomapCopy && pJobPool && pJobPool->NumThreads() > 0 && LayerHeight > CRowQueue::ROWS_PER_CLAIM)
 		{
-			for(int x = 0; x < LayerWidth; x++)
+			// tiles only depend on the copy, the rows can be proceeded in parallel
+			std::shared_ptr<CRowQueue> pQueue = std::make_shared<CRowQueue>();
+			pQueue->m_pAutoMapper = this;
+			pQueue->m_pRun = pRun;
+			pQueue->m_RunIndex = h;
+			pQueue->m_IsFilterable = IsFilterable;
+			pQueue->m_pReadTiles = pReadTiles;
+			pQueue->m_pTiles = pLayer->m_pTiles;
+			pQueue->m_Width = LayerWidth;
+			pQueue->m_Height = LayerHeight;
+			pQueue->m_Seed = Seed;
+			pQueue->m_SeedOffsetX = SeedOffsetX;
+			pQueue->m_SeedOffsetY = SeedOffsetY;
+			pQueue->m_vvChanges.resize(LayerHeight);
+
+			const int NumHelpers = std::min(pJobPool->NumThreads(), (LayerHeight - 1) / CRowQueue::ROWS_PER_CLAIM);
+			for(int i = 0; i < NumHelpers; i++)
+				pJobPool->Add(std::make_shared<CRowsJob>(pQueue));
+			pQueue->Work();
+			pQueue->m_Finished.Wait();
+
+			for(int y = 0; y < LayerHeight; y++)
 			{
-				CTile *pTile = &(pLayer->m_pTiles[y * LayerWidth + x]);
-				const CTile *pReadTile = &(pReadLayer->m_pTiles[y * LayerWidth + x]);
-				pLayer->Map()->OnModify();
-
-				for(size_t i = 0; i < pRun->m_vIndexRules.size(); ++i)
+				for(const auto &[x, Previous] : pQueue->m_vvChanges[y])
+					pLayer->RecordStateChange(x, y, Previous, pLayer->m_pTiles[y * LayerWidth + x]);
+			}
+		}
+		else
+		{
+			for(int y = 0; y < LayerHeight; y++)
+			{
+				for(int x = 0; x < LayerWidth; x++)
 				{
-					CIndexRule *pIndexRule = &pRun->m_vIndexRules[i];
-					if(pReadTile->m_Index == 0)
-					{
-						if(pTile->m_Index != 0 && IsFilterable) // TODO: This is a lazy workaround
-						{
-							CTile Previous = *pTile;
-							pTile->m_Index = 0;
-							pTile->m_Flags = pIndexRule->m_Flag;
-							pLayer->RecordStateChange(x, y, Previous, *pTile);
-							continue;
-						}
-
-						if(pIndexRule->m_SkipEmpty) // skip empty tiles
-							continue;
-					}
-					if(pIndexRule->m_SkipFull && pReadTile->m_Index != 0) // skip full tiles
-						continue;
-
-					bool RespectRules = true;
-					for(size_t j = 0; j < pIndexRule->m_vRules.size() && RespectRules; ++j)
-					{
-						CPosRule *pRule = &pIndexRule->m_vRules[j];
-
-						int CheckIndex, CheckFlags;
-						int CheckX = x + pRule->m_X;
-						int CheckY = y + pRule->m_Y;
-						if(CheckX >= 0 && CheckX < LayerWidth && CheckY >= 0 && CheckY < LayerHeight)
-						{
-							int CheckTile = CheckY * LayerWidth + CheckX;
-							CheckIndex = pReadLayer->m_pTiles[CheckTile].m_Index;
-							CheckFlags = pReadLayer->m_pTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_XFLIP | TILEFLAG_YFLIP);
-						}
-						else
-						{
-							CheckIndex = -1;
-							CheckFlags = 0;
-						}
-
-						if(pRule->m_Value == CPosRule::INDEX)
-						{
-							RespectRules = false;
-							for(const auto &Index : pRule->m_vIndexList)
-							{
-								if(CheckIndex == Index.m_Id && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
-								{
-									RespectRules = true;
-									break;
-								}
-							}
-						}
-						else if(pRule->m_Value == CPosRule::NOTINDEX)
-						{
-							for(const auto &Index : pRule->m_vIndexList)
-							{
-								if(CheckIndex == Index.m_Id && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
-								{
-									RespectRules = false;
-									break;
-								}
-							}
-						}
-					}
-
-					bool PassesModuloCheck;
-					if(pIndexRule->m_vModuloRules.empty())
-						PassesModuloCheck = true;
-					else
-						PassesModuloCheck = std::any_of(pIndexRule->m_vModuloRules.cbegin(), pIndexRule->m_vModuloRules.cend(), [&](const CModuloRule &ModuloRule) {
-							return (x + SeedOffsetX + ModuloRule.m_OffsetX) % ModuloRule.m_ModX == 0 && (y + SeedOffsetY + ModuloRule.m_OffsetY) % ModuloRule.m_ModY == 0;
-						});
-
-					if(RespectRules && PassesModuloCheck &&
-						(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, h, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
-					{
-						CTile Previous = *pTile;
-						pTile->m_Index = pIndexRule->m_Id;
-						pTile->m_Flags = pIndexRule->m_Flag;
+					CTile *pTile = &pLayer->m_pTiles[y * LayerWidth + x];
+					const CTile Previous = *pTile;
+					ProceedTile(*pRun, h, IsFilterable, pReadTiles, pTile, LayerWidth, LayerHeight, x, y, Seed, SeedOffsetX, SeedOffsetY);
+					if(pTile->m_Index != Previous.m_Index || pTile->m_Flags != Previous.m_Flags)
 						pLayer->RecordStateChange(x, y, Previous, *pTile);
-					}
 				}
 			}
 		}
-
-		// clean-up
-		if(pRun->m_AutomapCopy && pReadLayer != pLayer)
-			delete pReadLayer;
 	}
 }
@@ -2,6 +2,7 @@
 #define GAME_EDITOR_AUTO_MAP_H
 
 #include <game/editor/map_object.h>
+#include <game/mapitems.h>
 
 #include <vector>
 
@@ -87,6 +88,12 @@ public:
 private:
 	std::vector<CConfiguration> m_vConfigs;
 	bool m_FileLoaded = false;
+
+	class CRowQueue;
+	class CRowsJob;
+
+	// applies all index rules of a run to the tile at the given position
+	void ProceedTile(const CRun &Run, int RunIndex, bool IsFilterable, const CTile *pReadTiles, CTile *pTile, int Width, int Height, int x, int y, int Seed, int SeedOffsetX, int SeedOffsetY) const;
 };
 
 #endif
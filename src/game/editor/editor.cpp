@@ -6042,12 +6042,6 @@ void CEditor::RenderEditorHistory(CUIRect View)
 		}
 	}
 
-	SLabelProperties InfoProps;
-	InfoProps.m_MaxWidth = ToolBar.w - 60.f;
-	InfoProps.m_EllipsisAtEnd = true;
-	Label.VSplitLeft(8.0f, nullptr, &Label);
-	Ui()->DoLabel(&Label, "Editor history. Click on an action to undo all actions above.", 10.0f, TEXTALIGN_ML, InfoProps);
-
 	CEditorHistory *pCurrentHistory;
 	if(s_HistoryType == EDITOR_HISTORY)
 		pCurrentHistory = &Map()->m_EditorHistory;
@@ -6058,6 +6052,14 @@ void CEditor::RenderEditorHistory(CUIRect View)
 	else
 		return;
 
+	SLabelProperties InfoProps;
+	InfoProps.m_MaxWidth = ToolBar.w - 60.f;
+	InfoProps.m_EllipsisAtEnd = true;
+	Label.VSplitLeft(8.0f, nullptr, &Label);
+	char aInfo[128];
+	str_format(aInfo, sizeof(aInfo), "Editor history (%.1f MiB). Click on an action to undo all actions above.", pCurrentHistory->MemoryUsage() / (1024.0f * 1024.0f));
+	Ui()->DoLabel(&Label, aInfo, 10.0f, TEXTALIGN_ML, InfoProps);
+
 	// delete button
 	ToolBar.VSplitRight(25.0f, &ToolBar, &Button);
 	ToolBar.VSplitRight(5.0f, &ToolBar, nullptr);
@@ -3,6 +3,8 @@
 
 #include <game/editor/map_object.h>
 
+#include <cstddef>
+
 class IEditorAction : public CMapObject
 {
 public:
@@ -14,6 +16,12 @@ public:
 
 	virtual bool IsEmpty() { return false; }
 
+	/**
+	 * Approximate memory used by the action, which is counted against the
+	 * memory budget of the history.
+	 */
+	virtual size_t MemoryUsage() const { return sizeof(IEditorAction); }
+
 	const char *DisplayText() const { return m_aDisplayText; }
 
 protected:
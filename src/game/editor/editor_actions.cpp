@@ -12,6 +12,8 @@
 #include <game/editor/mapitems/layer_sounds.h>
 #include <game/editor/mapitems/map.h>
 
+#include <set>
+
 CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 	IEditorAction(pMap), m_Group(Group)
 {
@@ -27,7 +29,7 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 			{
 				if(!Map()->m_pTeleLayer->m_History.empty())
 				{
-					m_TeleTileChanges = std::map(Map()->m_pTeleLayer->m_History);
+					m_TeleTileChanges = CPackedTileChanges<STeleTileStateChange>(Map()->m_pTeleLayer->m_History);
 					Map()->m_pTeleLayer->ClearHistory();
 				}
 			}
@@ -35,7 +37,7 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 			{
 				if(!Map()->m_pTuneLayer->m_History.empty())
 				{
-					m_TuneTileChanges = std::map(Map()->m_pTuneLayer->m_History);
+					m_TuneTileChanges = CPackedTileChanges<STuneTileStateChange>(Map()->m_pTuneLayer->m_History);
 					Map()->m_pTuneLayer->ClearHistory();
 				}
 			}
@@ -43,7 +45,7 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 			{
 				if(!Map()->m_pSwitchLayer->m_History.empty())
 				{
-					m_SwitchTileChanges = std::map(Map()->m_pSwitchLayer->m_History);
+					m_SwitchTileChanges = CPackedTileChanges<SSwitchTileStateChange>(Map()->m_pSwitchLayer->m_History);
 					Map()->m_pSwitchLayer->ClearHistory();
 				}
 			}
@@ -51,14 +53,14 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 			{
 				if(!Map()->m_pSpeedupLayer->m_History.empty())
 				{
-					m_SpeedupTileChanges = std::map(Map()->m_pSpeedupLayer->m_History);
+					m_SpeedupTileChanges = CPackedTileChanges<SSpeedupTileStateChange>(Map()->m_pSpeedupLayer->m_History);
 					Map()->m_pSpeedupLayer->ClearHistory();
 				}
 			}
 
 			if(!pLayerTiles->m_TilesHistory.empty())
 			{
-				m_vTileChanges.emplace_back(k, std::map(pLayerTiles->m_TilesHistory));
+				m_vTileChanges.emplace_back(k, CPackedTileChanges<STileStateChange>(pLayerTiles->m_TilesHistory));
 				pLayerTiles->ClearHistory();
 			}
 		}
@@ -81,49 +83,35 @@ void CEditorBrushDrawAction::SetInfos()
 		m_TotalLayers++;
 
 		if(pLayer->m_Type == LAYERTYPE_TILES)
-		{
-			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				m_TotalTilesDrawn += Change.second.size();
-			}
-		}
-	}
-
-	// Process speedup tiles
-	for(auto const &SpeedupChange : m_SpeedupTileChanges)
-	{
-		m_TotalTilesDrawn += SpeedupChange.second.size();
-	}
-
-	// Process tele tiles
-	for(auto const &TeleChange : m_TeleTileChanges)
-	{
-		m_TotalTilesDrawn += TeleChange.second.size();
+			m_TotalTilesDrawn += Pair.second.Size();
 	}
 
-	// Process switch tiles
-	for(auto const &SwitchChange : m_SwitchTileChanges)
-	{
-		m_TotalTilesDrawn += SwitchChange.second.size();
-	}
+	m_TotalTilesDrawn += m_SpeedupTileChanges.Size();
+	m_TotalTilesDrawn += m_TeleTileChanges.Size();
+	m_TotalTilesDrawn += m_SwitchTileChanges.Size();
+	m_TotalTilesDrawn += m_TuneTileChanges.Size();
 
-	// Process tune tiles
-	for(auto const &TuneChange : m_TuneTileChanges)
-	{
-		m_TotalTilesDrawn += TuneChange.second.size();
-	}
-
-	m_TotalLayers += !m_SpeedupTileChanges.empty();
-	m_TotalLayers += !m_SwitchTileChanges.empty();
-	m_TotalLayers += !m_TeleTileChanges.empty();
-	m_TotalLayers += !m_TuneTileChanges.empty();
+	m_TotalLayers += !m_SpeedupTileChanges.Empty();
+	m_TotalLayers += !m_SwitchTileChanges.Empty();
+	m_TotalLayers += !m_TeleTileChanges.Empty();
+	m_TotalLayers += !m_TuneTileChanges.Empty();
 }
 
 bool CEditorBrushDrawAction::IsEmpty()
 {
-	return m_vTileChanges.empty() && m_SpeedupTileChanges.empty() && m_SwitchTileChanges.empty() && m_TeleTileChanges.empty() && m_TuneTileChanges.empty();
+	return m_vTileChanges.empty() && m_SpeedupTileChanges.Empty() && m_SwitchTileChanges.Empty() && m_TeleTileChanges.Empty() && m_TuneTileChanges.Empty();
+}
+
+size_t CEditorBrushDrawAction::MemoryUsage() const
+{
+	size_t Usage = sizeof(*this) + m_vTileChanges.capacity() * sizeof(m_vTileChanges[0]);
+	for(auto const &Pair : m_vTileChanges)
+		Usage += Pair.second.MemoryUsage();
+	Usage += m_TeleTileChanges.MemoryUsage();
+	Usage += m_SpeedupTileChanges.MemoryUsage();
+	Usage += m_SwitchTileChanges.MemoryUsage();
+	Usage += m_TuneTileChanges.MemoryUsage();
+	return Usage;
 }
 
 void CEditorBrushDrawAction::Undo()
@@ -147,96 +135,47 @@ void CEditorBrushDrawAction::Apply(bool Undo)
 		if(pLayer->m_Type == LAYERTYPE_TILES)
 		{
 			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				int y = Change.first;
-				auto Line = Change.second;
-				for(auto &Tile : Line)
-				{
-					int x = Tile.first;
-					STileStateChange State = Tile.second;
-					pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-				}
-			}
+			Pair.second.ForEach(Undo, [&](int x, int y, const CTile &Tile) {
+				pLayerTiles->SetTileIgnoreHistory(x, y, Tile);
+			});
 		}
 	}
 
 	// Process speedup tiles
-	for(auto const &SpeedupChange : m_SpeedupTileChanges)
-	{
-		int y = SpeedupChange.first;
-		auto Line = SpeedupChange.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			int Index = y * Map()->m_pSpeedupLayer->m_Width + x;
-			SSpeedupTileStateChange State = Tile.second;
-			SSpeedupTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Force = Data.m_Force;
-			Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_MaxSpeed = Data.m_MaxSpeed;
-			Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Angle = Data.m_Angle;
-			Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Type = Data.m_Type;
-			Map()->m_pSpeedupLayer->m_pTiles[Index].m_Index = Data.m_Index;
-		}
-	}
+	m_SpeedupTileChanges.ForEach(Undo, [&](int x, int y, const SSpeedupTileStateChange::SData &Data) {
+		int Index = y * Map()->m_pSpeedupLayer->m_Width + x;
+		Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Force = Data.m_Force;
+		Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_MaxSpeed = Data.m_MaxSpeed;
+		Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Angle = Data.m_Angle;
+		Map()->m_pSpeedupLayer->m_pSpeedupTile[Index].m_Type = Data.m_Type;
+		Map()->m_pSpeedupLayer->m_pTiles[Index].m_Index = Data.m_Index;
+	});
 
 	// Process tele tiles
-	for(auto const &TeleChange : m_TeleTileChanges)
-	{
-		int y = TeleChange.first;
-		auto Line = TeleChange.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			int Index = y * Map()->m_pTeleLayer->m_Width + x;
-			STeleTileStateChange State = Tile.second;
-			STeleTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map()->m_pTeleLayer->m_pTeleTile[Index].m_Number = Data.m_Number;
-			Map()->m_pTeleLayer->m_pTeleTile[Index].m_Type = Data.m_Type;
-			Map()->m_pTeleLayer->m_pTiles[Index].m_Index = Data.m_Index;
-		}
-	}
+	m_TeleTileChanges.ForEach(Undo, [&](int x, int y, const STeleTileStateChange::SData &Data) {
+		int Index = y * Map()->m_pTeleLayer->m_Width + x;
+		Map()->m_pTeleLayer->m_pTeleTile[Index].m_Number = Data.m_Number;
+		Map()->m_pTeleLayer->m_pTeleTile[Index].m_Type = Data.m_Type;
+		Map()->m_pTeleLayer->m_pTiles[Index].m_Index = Data.m_Index;
+	});
 
 	// Process switch tiles
-	for(auto const &SwitchChange : m_SwitchTileChanges)
-	{
-		int y = SwitchChange.first;
-		auto Line = SwitchChange.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			int Index = y * Map()->m_pSwitchLayer->m_Width + x;
-			SSwitchTileStateChange State = Tile.second;
-			SSwitchTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Number = Data.m_Number;
-			Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Type = Data.m_Type;
-			Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Flags = Data.m_Flags;
-			Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Delay = Data.m_Delay;
-			Map()->m_pSwitchLayer->m_pTiles[Index].m_Index = Data.m_Index;
-		}
-	}
+	m_SwitchTileChanges.ForEach(Undo, [&](int x, int y, const SSwitchTileStateChange::SData &Data) {
+		int Index = y * Map()->m_pSwitchLayer->m_Width + x;
+		Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Number = Data.m_Number;
+		Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Type = Data.m_Type;
+		Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Flags = Data.m_Flags;
+		Map()->m_pSwitchLayer->m_pSwitchTile[Index].m_Delay = Data.m_Delay;
+		Map()->m_pSwitchLayer->m_pTiles[Index].m_Index = Data.m_Index;
+	});
 
 	// Process tune tiles
-	for(auto const &TuneChange : m_TuneTileChanges)
-	{
-		int y = TuneChange.first;
-		auto Line = TuneChange.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			int Index = y * Map()->m_pTuneLayer->m_Width + x;
-			STuneTileStateChange State = Tile.second;
-			STuneTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map()->m_pTuneLayer->m_pTuneTile[Index].m_Number = Data.m_Number;
-			Map()->m_pTuneLayer->m_pTuneTile[Index].m_Type = Data.m_Type;
-			Map()->m_pTuneLayer->m_pTiles[Index].m_Index = Data.m_Index;
-		}
-	}
+	m_TuneTileChanges.ForEach(Undo, [&](int x, int y, const STuneTileStateChange::SData &Data) {
+		int Index = y * Map()->m_pTuneLayer->m_Width + x;
+		Map()->m_pTuneLayer->m_pTuneTile[Index].m_Number = Data.m_Number;
+		Map()->m_pTuneLayer->m_pTuneTile[Index].m_Type = Data.m_Type;
+		Map()->m_pTuneLayer->m_pTiles[Index].m_Index = Data.m_Index;
+	});
 }
 
 // -------------------------------------------
@@ -264,6 +203,11 @@ void CEditorActionQuadPlace::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionQuadPlace::MemoryUsage() const
+{
+	return sizeof(*this) + m_vBrush.capacity() * sizeof(CQuad);
+}
+
 CEditorActionSoundPlace::CEditorActionSoundPlace(CEditorMap *pMap, int GroupIndex, int LayerIndex, std::vector<CSoundSource> &vBrush) :
 	CEditorActionLayerBase(pMap, GroupIndex, LayerIndex), m_vBrush(vBrush)
 {
@@ -288,6 +232,11 @@ void CEditorActionSoundPlace::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionSoundPlace::MemoryUsage() const
+{
+	return sizeof(*this) + m_vBrush.capacity() * sizeof(CSoundSource);
+}
+
 // ---------------------------------------------------------------------------------------
 
 CEditorActionDeleteQuad::CEditorActionDeleteQuad(CEditorMap *pMap, int GroupIndex, int LayerIndex, std::vector<int> const &vQuadsIndices, std::vector<CQuad> const &vDeletedQuads) :
@@ -323,6 +272,11 @@ void CEditorActionDeleteQuad::Redo()
 	}
 }
 
+size_t CEditorActionDeleteQuad::MemoryUsage() const
+{
+	return sizeof(*this) + m_vQuadsIndices.capacity() * sizeof(int) + m_vDeletedQuads.capacity() * sizeof(CQuad);
+}
+
 // ---------------------------------------------------------------------------------------
 
 CEditorActionEditQuadPoint::CEditorActionEditQuadPoint(CEditorMap *pMap, int GroupIndex, int LayerIndex, int QuadIndex, std::vector<CPoint> const &vPreviousPoints, std::vector<CPoint> const &vCurrentPoints) :
@@ -341,6 +295,11 @@ void CEditorActionEditQuadPoint::Redo()
 	Apply(m_vCurrentPoints);
 }
 
+size_t CEditorActionEditQuadPoint::MemoryUsage() const
+{
+	return sizeof(*this) + (m_vPreviousPoints.capacity() + m_vCurrentPoints.capacity()) * sizeof(CPoint);
+}
+
 void CEditorActionEditQuadPoint::Apply(const std::vector<CPoint> &vValue)
 {
 	std::shared_ptr<CLayerQuads> pLayerQuads = std::static_pointer_cast<CLayerQuads>(m_pLayer);
@@ -365,6 +324,11 @@ void CEditorActionEditQuadColor::Redo()
 	Apply(m_vCurrentColors);
 }
 
+size_t CEditorActionEditQuadColor::MemoryUsage() const
+{
+	return sizeof(*this) + (m_vPreviousColors.capacity() + m_vCurrentColors.capacity()) * sizeof(CColor);
+}
+
 void CEditorActionEditQuadColor::Apply(std::vector<CColor> &vValue)
 {
 	std::shared_ptr<CLayerQuads> pLayerQuads = std::static_pointer_cast<CLayerQuads>(m_pLayer);
@@ -513,6 +477,14 @@ void CEditorActionBulk::Redo()
 	}
 }
 
+size_t CEditorActionBulk::MemoryUsage() const
+{
+	size_t Usage = sizeof(*this) + m_vpActions.capacity() * sizeof(m_vpActions[0]);
+	for(const auto &pAction : m_vpActions)
+		Usage += pAction->MemoryUsage();
+	return Usage;
+}
+
 // ---------
 
 CEditorActionTileChanges::CEditorActionTileChanges(CEditorMap *pMap, int GroupIndex, int LayerIndex, const char *pAction, const EditorTileStateChangeHistory<STileStateChange> &Changes) :
@@ -535,26 +507,21 @@ void CEditorActionTileChanges::Redo()
 void CEditorActionTileChanges::Apply(bool Undo)
 {
 	std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(m_pLayer);
-	for(auto &Change : m_Changes)
-	{
-		int y = Change.first;
-		auto Line = Change.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			STileStateChange State = Tile.second;
-			pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-		}
-	}
+	m_Changes.ForEach(Undo, [&](int x, int y, const CTile &Tile) {
+		pLayerTiles->SetTileIgnoreHistory(x, y, Tile);
+	});
 
 	Map()->OnModify();
 }
 
+size_t CEditorActionTileChanges::MemoryUsage() const
+{
+	return sizeof(*this) + m_Changes.MemoryUsage();
+}
+
 void CEditorActionTileChanges::ComputeInfos()
 {
-	m_TotalChanges = 0;
-	for(auto &Line : m_Changes)
-		m_TotalChanges += Line.second.size();
+	m_TotalChanges = m_Changes.Size();
 }
 
 // ---------
@@ -664,6 +631,12 @@ void CEditorActionDeleteLayer::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionDeleteLayer::MemoryUsage() const
+{
+	// the deleted layer is only kept alive by this action
+	return sizeof(*this) + m_pLayer->MemoryUsage();
+}
+
 void CEditorActionDeleteLayer::Undo()
 {
 	// Undo: add back the removed layer contained in this class
@@ -738,6 +711,12 @@ void CEditorActionGroup::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionGroup::MemoryUsage() const
+{
+	// a deleted group is only kept alive by this action, a new one is part of the map
+	return sizeof(*this) + (m_Delete ? m_pGroup->MemoryUsage() : 0);
+}
+
 CEditorActionEditGroupProp::CEditorActionEditGroupProp(CEditorMap *pMap, int GroupIndex, EGroupProp Prop, int Previous, int Current) :
 	IEditorAction(pMap), m_GroupIndex(GroupIndex), m_Prop(Prop), m_Previous(Previous), m_Current(Current)
 {
@@ -1067,6 +1046,20 @@ void CEditorActionEditLayerTilesProp::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionEditLayerTilesProp::MemoryUsage() const
+{
+	size_t Usage = sizeof(*this);
+	std::set<const CLayer *> CountedLayers;
+	for(const auto &[Type, pLayer] : m_SavedLayers)
+	{
+		Usage += sizeof(Type) + sizeof(pLayer);
+		// the game and tiles entries can share the same copy
+		if(pLayer && CountedLayers.insert(pLayer.get()).second)
+			Usage += pLayer->MemoryUsage();
+	}
+	return Usage;
+}
+
 void CEditorActionEditLayerTilesProp::RestoreLayer(int Layer, const std::shared_ptr<CLayerTiles> &pLayerTiles)
 {
 	if(m_SavedLayers[Layer] != nullptr)
@@ -1187,6 +1180,11 @@ void CEditorActionEditLayersGroupAndOrder::Redo()
 	Map()->m_SelectedGroup = m_NewGroupIndex;
 }
 
+size_t CEditorActionEditLayersGroupAndOrder::MemoryUsage() const
+{
+	return sizeof(*this) + (m_LayerIndices.capacity() + m_NewLayerIndices.capacity()) * sizeof(int);
+}
+
 // -----------------------------------
 
 CEditorActionAppendMap::CEditorActionAppendMap(CEditorMap *pMap, const char *pMapName, const SPrevInfo &PrevInfo, std::vector<int> &vImageIndexMap) :
@@ -1265,6 +1263,11 @@ void CEditorActionAppendMap::Redo()
 	Map()->Append(m_aMapName, IStorage::TYPE_ALL, true, ErrorHandler);
 }
 
+size_t CEditorActionAppendMap::MemoryUsage() const
+{
+	return sizeof(*this) + m_vImageIndexMap.capacity() * sizeof(int);
+}
+
 // ---------------------------
 
 CEditorActionTileArt::CEditorActionTileArt(CEditorMap *pMap, int PreviousImageCount, const char *pFilename, std::vector<int> &vImageIndexMap) :
@@ -1323,6 +1326,11 @@ void CEditorActionTileArt::Redo()
 	Map()->AddTileArt(std::move(Image), m_aFilename, true);
 }
 
+size_t CEditorActionTileArt::MemoryUsage() const
+{
+	return sizeof(*this) + m_vImageIndexMap.capacity() * sizeof(int);
+}
+
 // ---------------------------
 
 CEditorActionQuadArt::CEditorActionQuadArt(CEditorMap *pMap, const std::shared_ptr<CLayerGroup> &pGroup) :
@@ -1454,6 +1462,11 @@ void CEditorCommandAction::Redo()
 	}
 }
 
+size_t CEditorCommandAction::MemoryUsage() const
+{
+	return sizeof(*this) + m_PreviousCommand.capacity() + m_CurrentCommand.capacity();
+}
+
 // ------------------------------------------------
 
 CEditorActionEnvelopeAdd::CEditorActionEnvelopeAdd(CEditorMap *pMap, CEnvelope::EType EnvelopeType) :
@@ -1498,6 +1511,11 @@ void CEditorActionEnvelopeDelete::Redo()
 	Map()->DeleteEnvelope(m_EnvelopeIndex);
 }
 
+size_t CEditorActionEnvelopeDelete::MemoryUsage() const
+{
+	return sizeof(*this) + m_pEnv->MemoryUsage() + m_vpObjectReferences.capacity() * sizeof(m_vpObjectReferences[0]);
+}
+
 CEditorActionEnvelopeEdit::CEditorActionEnvelopeEdit(CEditorMap *pMap, int EnvelopeIndex, EEditType EditType, int Previous, int Current) :
 	IEditorAction(pMap), m_EnvelopeIndex(EnvelopeIndex), m_EditType(EditType), m_Previous(Previous), m_Current(Current)
 {
@@ -1851,6 +1869,11 @@ void CEditorActionEditSoundSourceShape::Redo()
 	Map()->OnModify();
 }
 
+size_t CEditorActionEditSoundSourceShape::MemoryUsage() const
+{
+	return sizeof(*this) + m_vOriginalValues.capacity() * sizeof(int);
+}
+
 void CEditorActionEditSoundSourceShape::Save()
 {
 	std::shared_ptr<CLayerSounds> pLayerSounds = std::static_pointer_cast<CLayerSounds>(m_pLayer);
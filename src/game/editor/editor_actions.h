@@ -20,6 +20,74 @@ class CEditorMap;
 class IEditorEnvelopeReference;
 class CLayerGroup;
 
+/**
+ * Tile state changes packed into runs of horizontally adjacent tiles.
+ *
+ * The 2D map the changes are recorded in needs a tree node per tile, the
+ * packed runs only need the previous and current state of each tile.
+ */
+template<typename TChange>
+class CPackedTileChanges
+{
+public:
+	using TData = decltype(TChange::m_Previous);
+
+	CPackedTileChanges() = default;
+	explicit CPackedTileChanges(const EditorTileStateChangeHistory<TChange> &Changes)
+	{
+		for(const auto &[y, Line] : Changes)
+		{
+			for(const auto &[x, Change] : Line)
+			{
+				if(!Change.m_Changed)
+					continue;
+				if(m_vRuns.empty() || m_vRuns.back().m_Y != y || m_vRuns.back().m_X + m_vRuns.back().m_Length != x)
+					m_vRuns.push_back({y, x, 0});
+				m_vRuns.back().m_Length++;
+				m_vPrevious.push_back(Change.m_Previous);
+				m_vCurrent.push_back(Change.m_Current);
+			}
+		}
+		m_vRuns.shrink_to_fit();
+		m_vPrevious.shrink_to_fit();
+		m_vCurrent.shrink_to_fit();
+	}
+
+	bool Empty() const { return m_vPrevious.empty(); }
+	int Size() const { return m_vPrevious.size(); }
+
+	size_t MemoryUsage() const
+	{
+		return m_vRuns.capacity() * sizeof(CRun) + (m_vPrevious.capacity() + m_vCurrent.capacity()) * sizeof(TData);
+	}
+
+	// calls Fn(x, y, Data) with the previous or current data of every changed tile
+	template<typename F>
+	void ForEach(bool Undo, F &&Fn) const
+	{
+		const std::vector<TData> &vData = Undo ? m_vPrevious : m_vCurrent;
+		size_t Index = 0;
+		for(const CRun &Run : m_vRuns)
+		{
+			for(int x = Run.m_X; x < Run.m_X + Run.m_Length; x++)
+				Fn(x, Run.m_Y, vData[Index++]);
+		}
+	}
+
+private:
+	class CRun
+	{
+	public:
+		int m_Y;
+		int m_X;
+		int m_Length;
+	};
+
+	std::vector<CRun> m_vRuns;
+	std::vector<TData> m_vPrevious;
+	std::vector<TData> m_vCurrent;
+};
+
 class CEditorActionLayerBase : public IEditorAction
 {
 public:
@@ -39,17 +107,17 @@ public:
 	void Undo() override;
 	void Redo() override;
 	bool IsEmpty() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_Group;
 	// m_vTileChanges is a list of changes for each layer that was modified.
-	// The std::pair is used to pair one layer (index) with its history (2D map).
-	// EditorTileStateChangeHistory<T> is a 2D map, storing a change item at a specific y,x position.
-	std::vector<std::pair<int, EditorTileStateChangeHistory<STileStateChange>>> m_vTileChanges;
-	EditorTileStateChangeHistory<STeleTileStateChange> m_TeleTileChanges;
-	EditorTileStateChangeHistory<SSpeedupTileStateChange> m_SpeedupTileChanges;
-	EditorTileStateChangeHistory<SSwitchTileStateChange> m_SwitchTileChanges;
-	EditorTileStateChangeHistory<STuneTileStateChange> m_TuneTileChanges;
+	// The std::pair is used to pair one layer (index) with its packed changes.
+	std::vector<std::pair<int, CPackedTileChanges<STileStateChange>>> m_vTileChanges;
+	CPackedTileChanges<STeleTileStateChange> m_TeleTileChanges;
+	CPackedTileChanges<SSpeedupTileStateChange> m_SpeedupTileChanges;
+	CPackedTileChanges<SSwitchTileStateChange> m_SwitchTileChanges;
+	CPackedTileChanges<STuneTileStateChange> m_TuneTileChanges;
 
 	int m_TotalTilesDrawn;
 	int m_TotalLayers;
@@ -67,6 +135,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	std::vector<CQuad> m_vBrush;
@@ -79,6 +148,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	std::vector<CSoundSource> m_vBrush;
@@ -93,6 +163,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	std::vector<int> m_vQuadsIndices;
@@ -108,6 +179,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_QuadIndex;
@@ -124,6 +196,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_QuadIndex;
@@ -177,6 +250,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	std::vector<std::shared_ptr<IEditorAction>> m_vpActions;
@@ -193,9 +267,10 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
-	EditorTileStateChangeHistory<STileStateChange> m_Changes;
+	CPackedTileChanges<STileStateChange> m_Changes;
 	int m_TotalChanges;
 
 	void ComputeInfos();
@@ -223,6 +298,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 };
 
 class CEditorActionGroup : public IEditorAction
@@ -232,6 +308,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_GroupIndex;
@@ -287,6 +364,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 	void SetSavedLayers(const std::map<int, std::shared_ptr<CLayer>> &SavedLayers);
 
@@ -315,6 +393,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_GroupIndex;
@@ -340,6 +419,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	char m_aMapName[IO_MAX_PATH_LENGTH];
@@ -356,6 +436,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_PreviousImageCount;
@@ -395,6 +476,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	EType m_Type;
@@ -426,6 +508,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_EnvelopeIndex;
@@ -590,6 +673,7 @@ public:
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override;
 
 private:
 	int m_SourceIndex;
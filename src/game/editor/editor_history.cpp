@@ -24,17 +24,17 @@ void CEditorHistory::RecordAction(const std::shared_ptr<IEditorAction> &pAction,
 		return;
 	}
 
-	m_vpRedoActions.clear();
-
 	if((int)m_vpUndoActions.size() >= g_Config.m_ClEditorMaxHistory)
 	{
-		m_vpUndoActions.pop_front();
+		PopOldestUndo();
 	}
 
 	if(pDisplay == nullptr)
-		m_vpUndoActions.emplace_back(pAction);
+		PushAction(pAction);
 	else
-		m_vpUndoActions.emplace_back(std::make_shared<CEditorActionBulk>(Map(), std::vector<std::shared_ptr<IEditorAction>>{pAction}, pDisplay));
+		PushAction(std::make_shared<CEditorActionBulk>(Map(), std::vector<std::shared_ptr<IEditorAction>>{pAction}, pDisplay));
+
+	TrimMemory((size_t)g_Config.m_ClEditorMaxHistoryMemory * 1024 * 1024);
 }
 
 bool CEditorHistory::Undo()
@@ -42,12 +42,7 @@ bool CEditorHistory::Undo()
 	if(m_vpUndoActions.empty())
 		return false;
 
-	auto pLastAction = m_vpUndoActions.back();
-	m_vpUndoActions.pop_back();
-
-	pLastAction->Undo();
-
-	m_vpRedoActions.emplace_back(pLastAction);
+	MoveToRedo()->Undo();
 	return true;
 }
 
@@ -56,19 +51,13 @@ bool CEditorHistory::Redo()
 	if(m_vpRedoActions.empty())
 		return false;
 
-	auto pLastAction = m_vpRedoActions.back();
-	m_vpRedoActions.pop_back();
-
-	pLastAction->Redo();
-
-	m_vpUndoActions.emplace_back(pLastAction);
+	MoveToUndo()->Redo();
 	return true;
 }
 
 void CEditorHistory::Clear()
 {
-	m_vpUndoActions.clear();
-	m_vpRedoActions.clear();
+	ClearActions();
 }
 
 void CEditorHistory::BeginBulk()
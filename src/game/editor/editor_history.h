@@ -9,7 +9,93 @@
 #include <memory>
 #include <vector>
 
-class CEditorHistory : public CMapObject
+/**
+ * Undo and redo stacks that count the memory usage of their actions. The
+ * usage of an action is stored when it is recorded, because the objects it
+ * refers to can be changed after an undo.
+ */
+template<typename TAction>
+class CHistoryStacks
+{
+public:
+	std::deque<std::shared_ptr<TAction>> m_vpUndoActions;
+	std::deque<std::shared_ptr<TAction>> m_vpRedoActions;
+
+	// approximate memory used by the undo and redo actions
+	size_t MemoryUsage() const { return m_MemoryUsage; }
+
+	// adds a new undo action and drops the redo actions
+	void PushAction(const std::shared_ptr<TAction> &pAction)
+	{
+		ClearRedo();
+		m_vpUndoActions.push_back(pAction);
+		m_vUndoMemoryUsages.push_back(pAction->MemoryUsage());
+		m_MemoryUsage += m_vUndoMemoryUsages.back();
+	}
+
+	void PopOldestUndo()
+	{
+		m_MemoryUsage -= m_vUndoMemoryUsages.front();
+		m_vpUndoActions.pop_front();
+		m_vUndoMemoryUsages.pop_front();
+	}
+
+	// moves the newest undo action to the redo actions and returns it
+	std::shared_ptr<TAction> MoveToRedo()
+	{
+		std::shared_ptr<TAction> pAction = m_vpUndoActions.back();
+		m_vpRedoActions.push_back(pAction);
+		m_vRedoMemoryUsages.push_back(m_vUndoMemoryUsages.back());
+		m_vpUndoActions.pop_back();
+		m_vUndoMemoryUsages.pop_back();
+		return pAction;
+	}
+
+	// moves the newest redo action to the undo actions and returns it
+	std::shared_ptr<TAction> MoveToUndo()
+	{
+		std::shared_ptr<TAction> pAction = m_vpRedoActions.back();
+		m_vpUndoActions.push_back(pAction);
+		m_vUndoMemoryUsages.push_back(m_vRedoMemoryUsages.back());
+		m_vpRedoActions.pop_back();
+		m_vRedoMemoryUsages.pop_back();
+		return pAction;
+	}
+
+	/**
+	 * Drops the oldest undo actions until the memory usage fits into the
+	 * budget. The newest action is always kept. A budget of 0 means unlimited.
+	 */
+	void TrimMemory(size_t MaxMemoryUsage)
+	{
+		while(MaxMemoryUsage > 0 && m_MemoryUsage > MaxMemoryUsage && m_vpUndoActions.size() > 1)
+			PopOldestUndo();
+	}
+
+	void ClearRedo()
+	{
+		for(size_t RedoMemoryUsage : m_vRedoMemoryUsages)
+			m_MemoryUsage -= RedoMemoryUsage;
+		m_vpRedoActions.clear();
+		m_vRedoMemoryUsages.clear();
+	}
+
+	void ClearActions()
+	{
+		m_vpUndoActions.clear();
+		m_vpRedoActions.clear();
+		m_vUndoMemoryUsages.clear();
+		m_vRedoMemoryUsages.clear();
+		m_MemoryUsage = 0;
+	}
+
+private:
+	std::deque<size_t> m_vUndoMemoryUsages;
+	std::deque<size_t> m_vRedoMemoryUsages;
+	size_t m_MemoryUsage = 0;
+};
+
+class CEditorHistory : public CMapObject, public CHistoryStacks<IEditorAction>
 {
 public:
 	explicit CEditorHistory(CEditorMap *pMap) :
@@ -37,9 +123,6 @@ public:
 	void EndBulk(const char *pDisplay = nullptr);
 	void EndBulk(int DisplayToUse);
 
-	std::deque<std::shared_ptr<IEditorAction>> m_vpUndoActions;
-	std::deque<std::shared_ptr<IEditorAction>> m_vpRedoActions;
-
 private:
 	std::vector<std::shared_ptr<IEditorAction>> m_vpBulkActions;
 	bool m_IsBulk = false;
@@ -30,6 +30,7 @@ public:
 	int FindPointIndex(CFixedTime Time) const;
 	int GetChannels() const;
 	EType Type() const { return m_Type; }
+	size_t MemoryUsage() const { return sizeof(*this) + m_vPoints.capacity() * sizeof(CEnvPoint_runtime); }
 
 private:
 	void Resort();
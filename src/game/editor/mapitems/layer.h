@@ -38,6 +38,8 @@ public:
 
 	virtual std::shared_ptr<CLayer> Duplicate() const = 0;
 	virtual const char *TypeName() const = 0;
+	// approximate memory used by the layer including its tiles, quads or sources
+	virtual size_t MemoryUsage() const { return sizeof(CLayer); }
 
 	virtual void GetSize(float *pWidth, float *pHeight)
 	{
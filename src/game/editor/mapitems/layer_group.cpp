@@ -168,6 +168,14 @@ void CLayerGroup::GetSize(float *pWidth, float *pHeight) const
 	}
 }
 
+size_t CLayerGroup::MemoryUsage() const
+{
+	size_t Usage = sizeof(*this) + m_vpLayers.capacity() * sizeof(m_vpLayers[0]);
+	for(const auto &pLayer : m_vpLayers)
+		Usage += pLayer->MemoryUsage();
+	return Usage;
+}
+
 int CLayerGroup::MoveLayer(int IndexFrom, int IndexTo)
 {
 	if(IndexFrom < 0 || IndexFrom >= (int)m_vpLayers.size())
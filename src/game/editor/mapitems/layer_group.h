@@ -41,6 +41,7 @@ public:
 	void Mapping(float *pPoints) const;
 
 	void GetSize(float *pWidth, float *pHeight) const;
+	size_t MemoryUsage() const;
 
 	void AddLayer(const std::shared_ptr<CLayer> &pLayer);
 	void DeleteLayer(int Index);
@@ -262,3 +262,8 @@ const char *CLayerQuads::TypeName() const
 {
 	return "quads";
 }
+
+size_t CLayerQuads::MemoryUsage() const
+{
+	return sizeof(*this) + m_vQuads.capacity() * sizeof(CQuad);
+}
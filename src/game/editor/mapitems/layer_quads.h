@@ -29,6 +29,7 @@ public:
 	void GetSize(float *pWidth, float *pHeight) override;
 	std::shared_ptr<CLayer> Duplicate() const override;
 	const char *TypeName() const override;
+	size_t MemoryUsage() const override;
 
 	int m_Image;
 	std::vector<CQuad> m_vQuads;
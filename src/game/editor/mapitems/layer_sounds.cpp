@@ -209,3 +209,8 @@ const char *CLayerSounds::TypeName() const
 {
 	return "sounds";
 }
+
+size_t CLayerSounds::MemoryUsage() const
+{
+	return sizeof(*this) + m_vSources.capacity() * sizeof(CSoundSource);
+}
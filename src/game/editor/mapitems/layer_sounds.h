@@ -24,6 +24,7 @@ public:
 
 	std::shared_ptr<CLayer> Duplicate() const override;
 	const char *TypeName() const override;
+	size_t MemoryUsage() const override;
 
 	int m_Sound;
 	std::vector<CSoundSource> m_vSources;
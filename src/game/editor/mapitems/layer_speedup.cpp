@@ -354,3 +354,8 @@ const char *CLayerSpeedup::TypeName() const
 {
 	return "speedup";
 }
+
+size_t CLayerSpeedup::MemoryUsage() const
+{
+	return CLayerTiles::MemoryUsage() + (size_t)m_Width * m_Height * sizeof(CSpeedupTile);
+}
@@ -420,3 +420,8 @@ const char *CLayerSwitch::TypeName() const
 {
 	return "switch";
 }
+
+size_t CLayerSwitch::MemoryUsage() const
+{
+	return CLayerTiles::MemoryUsage() + (size_t)m_Width * m_Height * sizeof(CSwitchTile);
+}
@@ -51,6 +51,7 @@ public:
 
 	std::shared_ptr<CLayer> Duplicate() const override;
 	const char *TypeName() const override;
+	size_t MemoryUsage() const override;
 
 private:
 	void RecordStateChange(int x, int y, SSwitchTileStateChange::SData Previous, SSwitchTileStateChange::SData Current);
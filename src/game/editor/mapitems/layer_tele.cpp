@@ -417,3 +417,8 @@ const char *CLayerTele::TypeName() const
 {
 	return "tele";
 }
+
+size_t CLayerTele::MemoryUsage() const
+{
+	return CLayerTiles::MemoryUsage() + (size_t)m_Width * m_Height * sizeof(CTeleTile);
+}
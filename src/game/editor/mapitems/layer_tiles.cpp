@@ -676,6 +676,11 @@ const char *CLayerTiles::TypeName() const
 	return "tiles";
 }
 
+size_t CLayerTiles::MemoryUsage() const
+{
+	return sizeof(*this) + (size_t)m_Width * m_Height * sizeof(CTile);
+}
+
 void CLayerTiles::Resize(int NewW, int NewH)
 {
 	CTile *pNewData = new CTile[NewW * NewH];
@@ -143,6 +143,7 @@ public:
 
 	std::shared_ptr<CLayer> Duplicate() const override;
 	const char *TypeName() const override;
+	size_t MemoryUsage() const override;
 
 	virtual void ShowInfo();
 	CUi::EPopupMenuFunctionResult RenderProperties(CUIRect *pToolbox) override;
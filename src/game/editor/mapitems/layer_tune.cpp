@@ -378,3 +378,8 @@ const char *CLayerTune::TypeName() const
 {
 	return "tune";
 }
+
+size_t CLayerTune::MemoryUsage() const
+{
+	return CLayerTiles::MemoryUsage() + (size_t)m_Width * m_Height * sizeof(CTuneTile);
+}
@@ -40,7 +40,7 @@ public:
 
 void CDataFileWriterFinishJob::Run()
 {
-	m_Writer.Finish();
+	m_Writer.Finish(m_pJobPool);
 
 	if(!m_pStorage->RemoveFile(m_aRealFilename, IStorage::TYPE_SAVE))
 	{
@@ -59,8 +59,9 @@ void CDataFileWriterFinishJob::Run()
 	log_trace("editor/save", "Saved map to '%s'.", m_aRealFilename);
 }
 
-CDataFileWriterFinishJob::CDataFileWriterFinishJob(IStorage *pStorage, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer) :
+CDataFileWriterFinishJob::CDataFileWriterFinishJob(IStorage *pStorage, CJobPool *pJobPool, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer) :
 	m_pStorage(pStorage),
+	m_pJobPool(pJobPool),
 	m_Writer(std::move(Writer))
 {
 	str_copy(m_aRealFilename, pRealFilename);
@@ -436,7 +437,7 @@ bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
 	}
 
 	// finish the data file
-	std::shared_ptr<CDataFileWriterFinishJob> pWriterFinishJob = std::make_shared<CDataFileWriterFinishJob>(m_pEditor->Storage(), pFilename, aFilenameTmp, std::move(Writer));
+	std::shared_ptr<CDataFileWriterFinishJob> pWriterFinishJob = std::make_shared<CDataFileWriterFinishJob>(m_pEditor->Storage(), m_pEditor->Engine()->JobPool(), pFilename, aFilenameTmp, std::move(Writer));
 	m_pEditor->Engine()->AddJob(pWriterFinishJob);
 	m_pEditor->m_WriterFinishJobs.push_back(pWriterFinishJob);
 
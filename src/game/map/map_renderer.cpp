@@ -2,9 +2,14 @@
 
 #include <base/dbg.h>
 #include <base/log.h>
+#include <base/sphore.h>
+
+#include <engine/shared/jobs.h>
 
 #include <game/map/envelope_manager.h>
 
+#include <atomic>
+
 const int LAYER_DEFAULT_TILESET = -1;
 
 void CMapRenderer::Clear()
@@ -14,10 +19,104 @@ void CMapRenderer::Clear()
 	m_vpRenderLayers.clear();
 }
 
-void CMapRenderer::Load(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> RenderCallbackOptional)
+class CMapRenderer::CBuildQueue
+{
+public:
+	enum
+	{
+		STATE_QUEUED,
+		STATE_BUILDING,
+		STATE_DONE,
+	};
+
+	std::vector<CRenderLayer *> m_vpLayers;
+	std::vector<std::atomic<int>> m_vState;
+	// signaled after each built layer
+	CSemaphore m_Built;
+
+	explicit CBuildQueue(std::vector<CRenderLayer *> &&vpLayers) :
+		m_vpLayers(std::move(vpLayers)), m_vState(m_vpLayers.size())
+	{
+		for(auto &State : m_vState)
+			State.store(STATE_QUEUED, std::memory_order_relaxed);
+	}
+
+	bool TryBuild(size_t Index)
+	{
+		int Expected = STATE_QUEUED;
+		if(!m_vState[Index].compare_exchange_strong(Expected, STATE_BUILDING))
+			return false;
+		m_vpLayers[Index]->BuildVisuals();
+		m_vState[Index].store(STATE_DONE, std::memory_order_release);
+		m_Built.Signal();
+		return true;
+	}
+
+	bool IsDone(size_t Index) const
+	{
+		return m_vState[Index].load(std::memory_order_acquire) == STATE_DONE;
+	}
+
+	void BuildAll()
+	{
+		for(size_t i = 0; i < m_vpLayers.size(); i++)
+			TryBuild(i);
+	}
+};
+
+class CMapRenderer::CBuildJob : public IJob
+{
+	std::shared_ptr<CBuildQueue> m_pQueue;
+
+	void Run() override
+	{
+		m_pQueue->BuildAll();
+	}
+
+public:
+	CBuildJob(std::shared_ptr<CBuildQueue> pQueue) :
+		m_pQueue(std::move(pQueue))
+	{
+	}
+};
+
+void CMapRenderer::Load(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> RenderCallbackOptional, CJobPool *pJobPool)
 {
 	Clear();
+	CreateLayers(Type, pLayers, pMapImages, pEnvelopeEval, RenderCallbackOptional);
+
+	std::vector<CRenderLayer *> vpPendingLayers;
+	for(auto &pLayer : m_vpRenderLayers)
+	{
+		if(pLayer->HasPendingVisuals())
+			vpPendingLayers.push_back(pLayer.get());
+	}
+	if(vpPendingLayers.empty())
+		return;
 
+	// the tile data of all layers is built on the job pool, the main thread
+	// helps with the building and uploads the finished layers in map order
+	std::shared_ptr<CBuildQueue> pQueue = std::make_shared<CBuildQueue>(std::move(vpPendingLayers));
+	if(pJobPool)
+	{
+		const size_t NumHelpers = std::min<size_t>(pQueue->m_vpLayers.size() - 1, pJobPool->NumThreads());
+		for(size_t i = 0; i < NumHelpers; i++)
+			pJobPool->Add(std::make_shared<CBuildJob>(pQueue));
+	}
+
+	for(size_t i = 0; i < pQueue->m_vpLayers.size(); i++)
+	{
+		if(!pQueue->TryBuild(i))
+		{
+			while(!pQueue->IsDone(i))
+				pQueue->m_Built.Wait();
+		}
+		pQueue->m_vpLayers[i]->UploadVisuals();
+	}
+}
+
+void CMapRenderer::CreateLayers(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> &RenderCallbackOptional)
+{
 	std::shared_ptr<CEnvelopeManager> pEnvelopeManager = std::make_shared<CEnvelopeManager>(pEnvelopeEval, pLayers->Map());
 	bool PassedGameLayer = false;
 
@@ -7,16 +7,29 @@
 #include <game/map/render_component.h>
 #include <game/map/render_layer.h>
 
+class CJobPool;
+
 class CMapRenderer : public CRenderComponent
 {
 public:
 	CMapRenderer() = default;
 
 	void Clear();
-	void Load(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> RenderCallbackOptional);
+	/**
+	 * Creates the render layers of the map.
+	 *
+	 * @param pJobPool Optional job pool, the tile layer visuals are built on
+	 * it in parallel if given. Only the graphics buffers are created on the
+	 * calling thread.
+	 */
+	void Load(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> RenderCallbackOptional, CJobPool *pJobPool = nullptr);
 	void Render(const CRenderLayerParams &Params);
 
 private:
+	class CBuildQueue;
+	class CBuildJob;
+
+	void CreateLayers(ERenderType Type, CLayers *pLayers, IMapImages *pMapImages, IEnvelopeEval *pEnvelopeEval, std::optional<FRenderUploadCallback> &RenderCallbackOptional);
 	int GetLayerType(const CMapItemLayer *pLayer, const CLayers *pLayers) const;
 
 	std::vector<std::unique_ptr<CRenderLayer>> m_vpRenderLayers;
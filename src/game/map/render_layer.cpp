@@ -579,14 +579,52 @@ void CRenderLayerTile::Init()
 		m_TextureHandle = m_pMapImages->Get(m_pLayerTilemap->m_Image);
 	else
 		m_TextureHandle.Invalidate();
-	UploadTileData(m_VisualTiles, 0, false);
+	QueueTileData(m_VisualTiles, 0, false);
 }
 
-void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer)
+void CRenderLayerTile::QueueTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer)
 {
 	if(!Graphics()->IsTileBufferingEnabled())
 		return;
 
+	// create the visual and set it in the optional, it is filled by BuildVisuals
+	CTileLayerVisuals v;
+	v.OnInit(this);
+	VisualsOptional = v;
+
+	CPendingVisuals Pending;
+	Pending.m_pVisualsOptional = &VisualsOptional;
+	Pending.m_CurOverlay = CurOverlay;
+	Pending.m_AddAsSpeedup = AddAsSpeedup;
+	Pending.m_IsGameLayer = IsGameLayer;
+	Pending.m_DoTextureCoords = GetTexture().IsValid();
+	m_vPendingVisuals.push_back(Pending);
+}
+
+void CRenderLayerTile::BuildVisuals()
+{
+	for(CPendingVisuals &Pending : m_vPendingVisuals)
+	{
+		BuildTileData(Pending);
+	}
+}
+
+void CRenderLayerTile::UploadVisuals()
+{
+	for(CPendingVisuals &Pending : m_vPendingVisuals)
+	{
+		UploadTileData(Pending);
+	}
+	m_vPendingVisuals.clear();
+}
+
+void CRenderLayerTile::BuildTileData(CPendingVisuals &Pending)
+{
+	const int CurOverlay = Pending.m_CurOverlay;
+	const bool AddAsSpeedup = Pending.m_AddAsSpeedup;
+	const bool IsGameLayer = Pending.m_IsGameLayer;
+	const bool DoTextureCoords = Pending.m_DoTextureCoords;
+
 	// prepare all visuals for all tile layers
 	std::vector<CGraphicTile> vTmpTiles;
 	std::vector<CGraphicTileTextureCoords> vTmpTileTexCoords;
@@ -601,16 +639,11 @@ void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsO
 	std::vector<CGraphicTile> vTmpBorderCorners;
 	std::vector<CGraphicTileTextureCoords> vTmpBorderCornersTexCoords;
 
-	const bool DoTextureCoords = GetTexture().IsValid();
-
-	// create the visual and set it in the optional, afterwards get it
-	CTileLayerVisuals v;
-	v.OnInit(this);
-	VisualsOptional = v;
-	CTileLayerVisuals &Visuals = VisualsOptional.value();
-
+	CTileLayerVisuals &Visuals = Pending.m_pVisualsOptional->value();
+	Pending.m_Built = true;
 	if(!Visuals.Init(m_pLayerTilemap->m_Width, m_pLayerTilemap->m_Height))
 		return;
+	Pending.m_Valid = true;
 
 	Visuals.m_IsTextured = DoTextureCoords;
 
@@ -790,15 +823,10 @@ void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsO
 	InsertTiles(vTmpBorderLeftTiles, vTmpBorderLeftTilesTexCoords);
 	InsertTiles(vTmpBorderRightTiles, vTmpBorderRightTilesTexCoords);
 
-	Visuals.m_BufferContainerIndex = -1;
-
-	// upload data to gpu
+	// interleave the data for the upload
 	size_t UploadDataSize = vTmpTileTexCoords.size() * sizeof(CGraphicTileTextureCoords) + vTmpTiles.size() * sizeof(CGraphicTile);
 	if(UploadDataSize == 0)
-	{
-		RenderLoading();
 		return;
-	}
 
 	void *pUploadData = malloc(UploadDataSize);
 
@@ -834,8 +862,30 @@ void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsO
 		mem_copy(pUploadData, vTmpTiles.data(), vTmpTiles.size() * sizeof(CGraphicTile));
 	}
 
+	Pending.m_pUploadData = pUploadData;
+	Pending.m_UploadDataSize = UploadDataSize;
+	Pending.m_NumTiles = vTmpTiles.size();
+}
+
+void CRenderLayerTile::UploadTileData(CPendingVisuals &Pending)
+{
+	dbg_assert(Pending.m_Built, "tile visuals uploaded before they were built");
+	CTileLayerVisuals &Visuals = Pending.m_pVisualsOptional->value();
+	if(!Pending.m_Valid)
+		return;
+
+	Visuals.m_BufferContainerIndex = -1;
+	if(Pending.m_UploadDataSize == 0)
+	{
+		RenderLoading();
+		return;
+	}
+
+	const bool DoTextureCoords = Pending.m_DoTextureCoords;
+
 	// first create the buffer object
-	int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0, true);
+	int BufferObjectIndex = Graphics()->CreateBufferObject(Pending.m_UploadDataSize, Pending.m_pUploadData, 0, true);
+	Pending.m_pUploadData = nullptr;
 
 	// then create the buffer container
 	SBufferContainerInfo ContainerInfo;
@@ -861,13 +911,16 @@ void CRenderLayerTile::UploadTileData(std::optional<CTileLayerVisuals> &VisualsO
 
 	Visuals.m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
 	// and finally inform the backend how many indices are required
-	Graphics()->IndicesNumRequiredNotify(vTmpTiles.size() * 6);
+	Graphics()->IndicesNumRequiredNotify(Pending.m_NumTiles * 6);
 
 	RenderLoading();
 }
 
 void CRenderLayerTile::Unload()
 {
+	for(CPendingVisuals &Pending : m_vPendingVisuals)
+		free(Pending.m_pUploadData);
+	m_vPendingVisuals.clear();
 	if(m_VisualTiles.has_value())
 	{
 		m_VisualTiles->Unload();
@@ -1433,7 +1486,7 @@ CRenderLayerEntityGame::CRenderLayerEntityGame(int GroupId, int LayerId, int Fla
 
 void CRenderLayerEntityGame::Init()
 {
-	UploadTileData(m_VisualTiles, 0, false, true);
+	QueueTileData(m_VisualTiles, 0, false, true);
 }
 
 void CRenderLayerEntityGame::RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params)
@@ -1490,8 +1543,8 @@ int CRenderLayerEntityTele::GetDataIndex(unsigned int &TileSize) const
 
 void CRenderLayerEntityTele::Init()
 {
-	UploadTileData(m_VisualTiles, 0, false);
-	UploadTileData(m_VisualTeleNumbers, 1, false);
+	QueueTileData(m_VisualTiles, 0, false);
+	QueueTileData(m_VisualTeleNumbers, 1, false);
 }
 
 void CRenderLayerEntityTele::InitTileData()
@@ -1559,9 +1612,9 @@ int CRenderLayerEntitySpeedup::GetDataIndex(unsigned int &TileSize) const
 
 void CRenderLayerEntitySpeedup::Init()
 {
-	UploadTileData(m_VisualTiles, 0, true);
-	UploadTileData(m_VisualForce, 1, false);
-	UploadTileData(m_VisualMaxSpeed, 2, false);
+	QueueTileData(m_VisualTiles, 0, true);
+	QueueTileData(m_VisualForce, 1, false);
+	QueueTileData(m_VisualMaxSpeed, 2, false);
 }
 
 void CRenderLayerEntitySpeedup::InitTileData()
@@ -1639,9 +1692,9 @@ int CRenderLayerEntitySwitch::GetDataIndex(unsigned int &TileSize) const
 
 void CRenderLayerEntitySwitch::Init()
 {
-	UploadTileData(m_VisualTiles, 0, false);
-	UploadTileData(m_VisualSwitchNumberTop, 1, false);
-	UploadTileData(m_VisualSwitchNumberBottom, 2, false);
+	QueueTileData(m_VisualTiles, 0, false);
+	QueueTileData(m_VisualSwitchNumberTop, 1, false);
+	QueueTileData(m_VisualSwitchNumberBottom, 2, false);
 }
 
 void CRenderLayerEntitySwitch::InitTileData()
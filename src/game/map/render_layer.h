@@ -68,6 +68,11 @@ public:
 	virtual void OnInit(IGraphics *pGraphics, ITextRender *pTextRender, CRenderMap *pRenderMap, std::shared_ptr<CEnvelopeManager> &pEnvelopeManager, IMap *pMap, IMapImages *pMapImages, std::optional<FRenderUploadCallback> &FRenderUploadCallbackOptional);
 
 	virtual void Init() = 0;
+	// builds the visuals queued by Init, can run on any thread
+	virtual void BuildVisuals() {}
+	// creates the graphics buffers of the built visuals
+	virtual void UploadVisuals() {}
+	virtual bool HasPendingVisuals() const { return false; }
 	virtual void Render(const CRenderLayerParams &Params) = 0;
 	virtual bool DoRender(const CRenderLayerParams &Params) = 0;
 	virtual bool IsValid() const { return true; }
@@ -119,6 +124,9 @@ public:
 	void Render(const CRenderLayerParams &Params) override;
 	bool DoRender(const CRenderLayerParams &Params) override;
 	void Init() override;
+	void BuildVisuals() override;
+	void UploadVisuals() override;
+	bool HasPendingVisuals() const override { return !m_vPendingVisuals.empty(); }
 	void OnInit(IGraphics *pGraphics, ITextRender *pTextRender, CRenderMap *pRenderMap, std::shared_ptr<CEnvelopeManager> &pEnvelopeManager, IMap *pMap, IMapImages *pMapImages, std::optional<FRenderUploadCallback> &FRenderUploadCallbackOptional) override;
 
 	virtual int GetDataIndex(unsigned int &TileSize) const;
@@ -210,7 +218,27 @@ protected:
 		bool m_IsTextured;
 	};
 
-	void UploadTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer = false);
+	// visuals queued by Init, built by BuildVisuals and uploaded by UploadVisuals
+	class CPendingVisuals
+	{
+	public:
+		std::optional<CTileLayerVisuals> *m_pVisualsOptional;
+		int m_CurOverlay;
+		bool m_AddAsSpeedup;
+		bool m_IsGameLayer;
+		bool m_DoTextureCoords;
+
+		bool m_Built = false;
+		bool m_Valid = false;
+		void *m_pUploadData = nullptr;
+		size_t m_UploadDataSize = 0;
+		size_t m_NumTiles = 0;
+	};
+	std::vector<CPendingVisuals> m_vPendingVisuals;
+
+	void QueueTileData(std::optional<CTileLayerVisuals> &VisualsOptional, int CurOverlay, bool AddAsSpeedup, bool IsGameLayer = false);
+	void BuildTileData(CPendingVisuals &Pending);
+	void UploadTileData(CPendingVisuals &Pending);
 
 	virtual void RenderTileLayerWithTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params);
 	virtual void RenderTileLayerNoTileBuffer(const ColorRGBA &Color, const CRenderLayerParams &Params);
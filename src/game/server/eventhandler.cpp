@@ -2,21 +2,47 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "eventhandler.h"
 
-#include "entity.h"
 #include "gamecontext.h"
+#include "player.h"
 
+#include <base/log.h>
 #include <base/system.h>
 #include <base/vmath.h>
 
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
 //////////////////////////////////////////////////
 // Event handler
 //////////////////////////////////////////////////
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = nullptr;
+	m_NumDroppedCreate = 0;
+	m_NumDroppedSnap = 0;
+	m_LoggedDroppedCreate = 0;
+	m_LoggedDroppedSnap = 0;
+	m_LastDroppedLog = 0;
+	m_vEvents.reserve(INITIAL_EVENTS);
+	m_vData.reserve(INITIAL_DATASIZE);
 	Clear();
 }
 
+bool CEventHandler::CCellEntry::operator<(const CCellEntry &Other) const
+{
+	if(m_CellX != Other.m_CellX)
+		return m_CellX < Other.m_CellX;
+	if(m_CellY != Other.m_CellY)
+		return m_CellY < Other.m_CellY;
+	return m_Event < Other.m_Event;
+}
+
+int CEventHandler::CellCoord(float Pos)
+{
+	return (int)std::floor(Pos / (float)CELL_SIZE);
+}
+
 void CEventHandler::SetGameServer(CGameContext *pGameServer)
 {
 	m_pGameServer = pGameServer;
@@ -24,47 +50,163 @@ void CEventHandler::SetGameServer(CGameContext *pGameServer)
 
 void *CEventHandler::Create(int Type, int Size, CClientMask Mask)
 {
-	if(m_NumEvents == MAX_EVENTS)
-		return nullptr;
-	if(m_CurrentOffset + Size >= MAX_DATASIZE)
+	if((int)m_vEvents.size() == MAX_EVENTS)
+	{
+		m_NumDroppedCreate++;
 		return nullptr;
+	}
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
-	m_CurrentOffset += Size;
-	m_NumEvents++;
-	return p;
+	CEvent Event;
+	Event.m_Type = Type;
+	Event.m_Offset = m_vData.size();
+	Event.m_Size = Size;
+	Event.m_SixupType = Type;
+	Event.m_SixupOffset = -1;
+	Event.m_SixupSize = Size;
+	Event.m_ClientMask = Mask;
+	m_vEvents.push_back(Event);
+	// only the pointer to the newest event has to stay valid, the caller
+	// fills it in before creating the next one
+	m_vData.resize(m_vData.size() + Size);
+	m_Prepared = false;
+	return &m_vData[Event.m_Offset];
 }
 
 void CEventHandler::Clear()
 {
-	m_NumEvents = 0;
-	m_CurrentOffset = 0;
+	LogDropped();
+	m_vEvents.clear();
+	m_vData.clear();
+	m_vSixupData.clear();
+	m_vCells.clear();
+	m_Prepared = true;
+}
+
+void CEventHandler::LogDropped()
+{
+	if(m_NumDroppedCreate == m_LoggedDroppedCreate && m_NumDroppedSnap == m_LoggedDroppedSnap)
+		return;
+	const int64_t Now = time_get();
+	if(m_LastDroppedLog != 0 && Now < m_LastDroppedLog + DROPPED_LOG_INTERVAL * time_freq())
+		return;
+	log_warn("events", "dropped %" PRId64 " events that did not fit into the store and %" PRId64 " that did not fit into snapshots (%" PRId64 " and %" PRId64 " in total)",
+		m_NumDroppedCreate - m_LoggedDroppedCreate, m_NumDroppedSnap - m_LoggedDroppedSnap, m_NumDroppedCreate, m_NumDroppedSnap);
+	m_LoggedDroppedCreate = m_NumDroppedCreate;
+	m_LoggedDroppedSnap = m_NumDroppedSnap;
+	m_LastDroppedLog = Now;
+}
+
+void CEventHandler::Prepare()
+{
+	m_vSixupData.clear();
+	m_vCells.clear();
+	for(int i = 0; i < (int)m_vEvents.size(); i++)
+	{
+		CEvent &Event = m_vEvents[i];
+		const char *pData = &m_vData[Event.m_Offset];
+
+		int Type = Event.m_Type;
+		int Size = Event.m_Size;
+		const char *pSixupData = pData;
+		EventToSixup(&Type, &Size, &pSixupData);
+		Event.m_SixupType = Type;
+		Event.m_SixupSize = Size;
+		if(pSixupData == pData)
+		{
+			Event.m_SixupOffset = -1;
+		}
+		else
+		{
+			Event.m_SixupOffset = m_vSixupData.size();
+			m_vSixupData.insert(m_vSixupData.end(), pSixupData, pSixupData + Size);
+		}
+
+		const CNetEvent_Common *pEvent = (const CNetEvent_Common *)pData;
+		m_vCells.push_back({CellCoord(pEvent->m_X), CellCoord(pEvent->m_Y), i});
+	}
+	std::sort(m_vCells.begin(), m_vCells.end());
+	m_Prepared = true;
+}
+
+void CEventHandler::CollectEvents(vec2 ViewPos, vec2 ShowDistance, std::vector<int> *pvEvents)
+{
+	if(!m_Prepared)
+		Prepare();
+
+	pvEvents->clear();
+	const auto &&IsVisible = [&](int Event) {
+		const CNetEvent_Common *pEvent = (const CNetEvent_Common *)&m_vData[m_vEvents[Event].m_Offset];
+		return absolute(ViewPos.x - pEvent->m_X) <= ShowDistance.x && absolute(ViewPos.y - pEvent->m_Y) <= ShowDistance.y;
+	};
+
+	const int MinX = CellCoord(ViewPos.x - ShowDistance.x);
+	const int MaxX = CellCoord(ViewPos.x + ShowDistance.x);
+	const int MinY = CellCoord(ViewPos.y - ShowDistance.y);
+	const int MaxY = CellCoord(ViewPos.y + ShowDistance.y);
+	if((int64_t)MaxX - MinX >= (int64_t)m_vCells.size())
+	{
+		// huge view, walking the columns would be slower than checking every event
+		for(int i = 0; i < (int)m_vEvents.size(); i++)
+		{
+			if(IsVisible(i))
+				pvEvents->push_back(i);
+		}
+		return;
+	}
+
+	for(int CellX = MinX; CellX <= MaxX; CellX++)
+	{
+		auto It = std::lower_bound(m_vCells.begin(), m_vCells.end(), CCellEntry{CellX, MinY, 0});
+		for(; It != m_vCells.end() && It->m_CellX == CellX && It->m_CellY <= MaxY; ++It)
+		{
+			if(IsVisible(It->m_Event))
+				pvEvents->push_back(It->m_Event);
+		}
+	}
+	// keep the snapshot items in creation order
+	std::sort(pvEvents->begin(), pvEvents->end());
 }
 
 void CEventHandler::Snap(int SnappingClient)
 {
-	for(int i = 0; i < m_NumEvents; i++)
+	if(!m_Prepared)
+		Prepare();
+
+	const CPlayer *pPlayer = SnappingClient == SERVER_DEMO_CLIENT ? nullptr : GameServer()->m_apPlayers[SnappingClient];
+	if(pPlayer && !pPlayer->m_ShowAll)
+	{
+		CollectEvents(pPlayer->m_ViewPos, pPlayer->m_ShowDistance, &m_vVisibleEvents);
+	}
+	else
 	{
-		if(SnappingClient == SERVER_DEMO_CLIENT || m_aClientMasks[i].test(SnappingClient))
+		m_vVisibleEvents.resize(m_vEvents.size());
+		for(int i = 0; i < (int)m_vEvents.size(); i++)
+			m_vVisibleEvents[i] = i;
+	}
+
+	const bool Sixup = SnappingClient != SERVER_DEMO_CLIENT && GameServer()->Server()->IsSixup(SnappingClient);
+	for(int i : m_vVisibleEvents)
+	{
+		const CEvent &Event = m_vEvents[i];
+		if(SnappingClient != SERVER_DEMO_CLIENT && !Event.m_ClientMask.test(SnappingClient))
+			continue;
+
+		int Type = Event.m_Type;
+		int Size = Event.m_Size;
+		const char *pData = &m_vData[Event.m_Offset];
+		if(Sixup)
 		{
-			CNetEvent_Common *pEvent = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(!NetworkClipped(GameServer(), SnappingClient, vec2(pEvent->m_X, pEvent->m_Y)))
-			{
-				int Type = m_aTypes[i];
-				int Size = m_aSizes[i];
-				const char *pData = &m_aData[m_aOffsets[i]];
-				if(GameServer()->Server()->IsSixup(SnappingClient))
-					EventToSixup(&Type, &Size, &pData);
-
-				void *pItem = GameServer()->Server()->SnapNewItem(Type, i, Size);
-				if(pItem)
-					mem_copy(pItem, pData, Size);
-			}
+			Type = Event.m_SixupType;
+			Size = Event.m_SixupSize;
+			if(Event.m_SixupOffset >= 0)
+				pData = &m_vSixupData[Event.m_SixupOffset];
 		}
+
+		void *pItem = GameServer()->Server()->SnapNewItem(Type, i, Size);
+		if(pItem)
+			mem_copy(pItem, pData, Size);
+		else
+			m_NumDroppedSnap++;
 	}
 }
 
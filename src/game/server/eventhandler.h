@@ -3,28 +3,69 @@
 #ifndef GAME_SERVER_EVENTHANDLER_H
 #define GAME_SERVER_EVENTHANDLER_H
 
+#include <base/vmath.h>
+
 #include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
 
 #include <cstdint>
+#include <vector>
 
 class CEventHandler
 {
 	enum
 	{
-		MAX_EVENTS = 128,
-		MAX_DATASIZE = 128 * 64,
+		// the index of an event is its snap item id
+		MAX_EVENTS = CSnapshot::MAX_ID + 1,
+		// events are bucketed into square cells of this size (in world units) once per tick
+		CELL_SIZE = 512,
+		INITIAL_EVENTS = 128,
+		INITIAL_DATASIZE = 128 * 64,
+		DROPPED_LOG_INTERVAL = 10,
+	};
+
+	class CEvent
+	{
+	public:
+		int m_Type;
+		int m_Offset;
+		int m_Size;
+		int m_SixupType;
+		int m_SixupOffset;
+		int m_SixupSize;
+		CClientMask m_ClientMask;
 	};
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	CClientMask m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+	class CCellEntry
+	{
+	public:
+		int m_CellX;
+		int m_CellY;
+		int m_Event;
+
+		bool operator<(const CCellEntry &Other) const;
+	};
+
+	std::vector<CEvent> m_vEvents;
+	std::vector<char> m_vData;
+	std::vector<char> m_vSixupData;
+	// events sorted by cell, rebuilt lazily on the first snap of a tick
+	std::vector<CCellEntry> m_vCells;
+	std::vector<int> m_vVisibleEvents;
+	bool m_Prepared;
+
+	int64_t m_NumDroppedCreate;
+	int64_t m_NumDroppedSnap;
+	// dropped events reported by the last log, logged at most every DROPPED_LOG_INTERVAL seconds
+	int64_t m_LoggedDroppedCreate;
+	int64_t m_LoggedDroppedSnap;
+	int64_t m_LastDroppedLog;
 
 	class CGameContext *m_pGameServer;
 
-	int m_CurrentOffset;
-	int m_NumEvents;
+	static int CellCoord(float Pos);
+	void Prepare();
+	void LogDropped();
 
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
@@ -42,6 +83,22 @@ public:
 	void Clear();
 	void Snap(int SnappingClient);
 
+	/**
+	 * Collects the indices of all events that are not network clipped for a
+	 * view at ViewPos with the given show distance, in creation order.
+	 *
+	 * @param ViewPos Center of the view.
+	 * @param ShowDistance Half extents of the view.
+	 * @param pvEvents Receives the event indices, previous contents are discarded.
+	 */
+	void CollectEvents(vec2 ViewPos, vec2 ShowDistance, std::vector<int> *pvEvents);
+
+	int NumEvents() const { return m_vEvents.size(); }
+	// events that could not be created because the store was full
+	int64_t NumDroppedCreate() const { return m_NumDroppedCreate; }
+	// events that were visible to a client but did not fit into its snapshot
+	int64_t NumDroppedSnap() const { return m_NumDroppedSnap; }
+
 	void EventToSixup(int *pType, int *pSize, const char **ppData);
 };
 
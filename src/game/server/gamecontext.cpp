@@ -39,6 +39,7 @@
 #include <game/mapitems.h>
 #include <game/version.h>
 
+#include <algorithm>
 #include <vector>
 
 // Not thread-safe!
@@ -609,14 +610,14 @@ void CGameContext::SendChatTarget(int To, const char *pText, int VersionFlags) c
 
 	if(To == -1)
 	{
+		CClientMask Recipients = Server()->IngameClients();
 		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
 			if(!((Server()->IsSixup(i) && (VersionFlags & FLAG_SIXUP)) ||
 				   (!Server()->IsSixup(i) && (VersionFlags & FLAG_SIX))))
-				continue;
-
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+				Recipients.reset(i);
 		}
+		Server()->SendPackMsgBroadcast(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, Recipients);
 	}
 	else
 	{
@@ -667,6 +668,7 @@ void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, in
 			Server()->SendPackMsg(&Msg, MSGFLAG_NOSEND, SERVER_DEMO_CLIENT);
 
 		// send to the clients
+		CClientMask Recipients;
 		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
 			if(!m_apPlayers[i])
@@ -675,8 +677,9 @@ void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, in
 				    (!Server()->IsSixup(i) && (VersionFlags & FLAG_SIX));
 
 			if(!m_apPlayers[i]->m_DND && Send)
-				Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+				Recipients.set(i);
 		}
+		Server()->SendPackMsgBroadcast(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, Recipients);
 
 		char aBuf[sizeof(aText) + 8];
 		str_format(aBuf, sizeof(aBuf), "Chat: %s", aText);
@@ -695,6 +698,7 @@ void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, in
 			Server()->SendPackMsg(&Msg, MSGFLAG_NOSEND, SERVER_DEMO_CLIENT);
 
 		// send to the clients
+		CClientMask Recipients;
 		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
 			if(m_apPlayers[i] != nullptr)
@@ -703,18 +707,19 @@ void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, in
 				{
 					if(m_apPlayers[i]->GetTeam() == TEAM_SPECTATORS)
 					{
-						Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+						Recipients.set(i);
 					}
 				}
 				else
 				{
 					if(pTeams->Team(i) == Team && m_apPlayers[i]->GetTeam() != TEAM_SPECTATORS)
 					{
-						Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+						Recipients.set(i);
 					}
 				}
 			}
 		}
+		Server()->SendPackMsgBroadcast(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, Recipients);
 	}
 }
 
@@ -1721,7 +1726,7 @@ void CGameContext::OnClientEnter(int ClientId)
 	if(m_VoteCloseTime)
 		SendVoteSet(ClientId);
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(ClientId);
 
 	// send map info if loaded from database
 	if(m_aMapInfoMessage[0] != '\0')
@@ -1864,7 +1869,7 @@ void CGameContext::OnClientConnected(int ClientId, void *pData)
 	SendMotd(ClientId);
 	SendSettings(ClientId);
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(ClientId);
 }
 
 void CGameContext::OnClientDrop(int ClientId, const char *pReason)
@@ -1913,7 +1918,7 @@ void CGameContext::OnClientDrop(int ClientId, const char *pReason)
 	Msg.m_Silent = false;
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, -1);
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(ClientId);
 }
 
 void CGameContext::TeehistorianRecordAntibot(const void *pData, int DataSize)
@@ -2095,6 +2100,7 @@ void *CGameContext::PreProcessMsg(int *pMsgId, CUnpacker *pUnpacker, int ClientI
 			Info.FromSixup();
 			pPlayer->m_TeeInfos = Info;
 			SendSkinChange7(ClientId);
+			Server()->ExpireClientServerInfo(ClientId);
 
 			return nullptr;
 		}
@@ -2177,22 +2183,11 @@ void CGameContext::CensorMessage(char *pCensoredMessage, const char *pMessage, i
 {
 	str_copy(pCensoredMessage, pMessage, Size);
 
-	for(auto &Item : m_vCensorlist)
-	{
-		char *pCurLoc = pCensoredMessage;
-		do
-		{
-			pCurLoc = (char *)str_utf8_find_nocase(pCurLoc, Item.c_str());
-			if(pCurLoc)
-			{
-				for(int i = 0; i < (int)Item.length(); i++)
-				{
-					pCurLoc[i] = '*';
-				}
-				pCurLoc++;
-			}
-		} while(pCurLoc);
-	}
+	// occurrences are reported once their end has been read, so replacing
+	// them does not affect the rest of the search
+	m_CensorMatcher.FindAll(pCensoredMessage, [&](int Word, const char *pStart, const char *pEnd) {
+		std::fill(pCensoredMessage + (pStart - pCensoredMessage), pCensoredMessage + (pEnd - pCensoredMessage), '*');
+	});
 }
 
 void CGameContext::OnMessage(int MsgId, CUnpacker *pUnpacker, int ClientId)
@@ -2891,7 +2886,7 @@ void CGameContext::OnChangeInfoNetMessage(const CNetMsg_Cl_ChangeInfo *pMsg, int
 		SendSkinChange7(ClientId);
 	}
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(ClientId);
 }
 
 void CGameContext::OnEmoticonNetMessage(const CNetMsg_Cl_Emoticon *pMsg, int ClientId)
@@ -3060,7 +3055,7 @@ void CGameContext::OnStartInfoNetMessage(const CNetMsg_Cl_StartInfo *pMsg, int C
 	CNetMsg_Sv_ReadyToEnter ReadyMsg;
 	Server()->SendPackMsg(&ReadyMsg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientId);
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(ClientId);
 }
 
 void CGameContext::ConTuneParam(IConsole::IResult *pResult, void *pUserData)
@@ -5448,18 +5443,19 @@ void CGameContext::ReadCensorList()
 {
 	const char *pCensorFilename = "censorlist.txt";
 	CLineReader LineReader;
-	m_vCensorlist.clear();
+	m_CensorMatcher.Clear();
 	if(LineReader.OpenFile(Storage()->OpenFile(pCensorFilename, IOFLAG_READ, IStorage::TYPE_ALL)))
 	{
 		while(const char *pLine = LineReader.Get())
 		{
-			m_vCensorlist.emplace_back(pLine);
+			m_CensorMatcher.Add(pLine);
 		}
 	}
 	else
 	{
 		dbg_msg("censorlist", "failed to open '%s'", pCensorFilename);
 	}
+	m_CensorMatcher.Build();
 }
 
 bool CGameContext::PracticeByDefault() const
@@ -11,6 +11,7 @@
 
 #include <engine/console.h>
 #include <engine/server.h>
+#include <engine/shared/substring_matcher.h>
 
 #include <generated/protocol.h>
 
@@ -123,7 +124,8 @@ class CGameContext : public IGameServer
 	protocol7::CNetObjHandler m_NetObjHandler7;
 	CNetObjHandler m_NetObjHandler;
 	CTuningParams m_aTuningList[TuneZone::NUM];
-	std::vector<std::string> m_vCensorlist;
+	// words from censorlist.txt
+	CSubstringMatcher m_CensorMatcher;
 
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
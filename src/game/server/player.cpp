@@ -681,7 +681,7 @@ void CPlayer::SetTeam(int Team, bool DoChatMsg)
 		}
 	}
 
-	Server()->ExpireServerInfo();
+	Server()->ExpireClientServerInfo(m_ClientId);
 }
 
 bool CPlayer::SetTimerType(int TimerType)
@@ -762,7 +762,7 @@ void CPlayer::SetAfk(bool Afk)
 {
 	if(m_Afk != Afk)
 	{
-		Server()->ExpireServerInfo();
+		Server()->ExpireClientServerInfo(m_ClientId);
 		m_Afk = Afk;
 	}
 }
@@ -985,7 +985,7 @@ void CPlayer::ProcessScoreResult(CScorePlayerResult &Result)
 					GameServer()->Score()->LoadBestTime();
 				}
 			}
-			Server()->ExpireServerInfo();
+			Server()->ExpireClientServerInfo(m_ClientId);
 			int Birthday = Result.m_Data.m_Info.m_Birthday;
 			if(Birthday != 0 && !m_BirthdayAnnounced && GetCharacter())
 			{
@@ -487,6 +487,8 @@ void CGameTeams::SetForceCharacterTeam(int ClientId, int Team)
 			GetPlayer(ClientId)->m_SwapTargetsClientId = -1;
 		}
 		m_pGameContext->m_World.RemoveEntitiesFromPlayer(ClientId);
+		// the team is part of the server info
+		Server()->ExpireClientServerInfo(ClientId);
 	}
 
 	if(Team != TEAM_SUPER && (m_aTeamState[Team] == ETeamState::EMPTY || (m_aTeamLocked[Team] && !m_aTeamFlock[Team])))
@@ -0,0 +1,285 @@
+#include "teehistorian_reader.h"
+
+#include "teehistorian.h"
+
+#include <base/log.h>
+#include <base/mem.h>
+#include <base/str.h>
+
+#include <engine/external/json-parser/json.h>
+#include <engine/shared/json.h>
+
+#include <cstring>
+
+static const CUuid TEEHISTORIAN_UUID = CalculateUuid("teehistorian@ddnet.tw");
+
+CTeeHistorianReader::CTeeHistorianReader()
+{
+	m_pHeader = nullptr;
+	m_Error = false;
+	m_Finished = true;
+	m_Tick = 0;
+	m_LastPlayerClientId = MAX_CLIENTS;
+}
+
+CTeeHistorianReader::~CTeeHistorianReader()
+{
+	json_value_free(m_pHeader);
+}
+
+bool CTeeHistorianReader::Init(const void *pData, int DataSize)
+{
+	json_value_free(m_pHeader);
+	m_pHeader = nullptr;
+	m_Error = true;
+	m_Finished = true;
+
+	const char *pFile = (const char *)pData;
+	if(DataSize < (int)sizeof(CUuid) || mem_comp(pFile, &TEEHISTORIAN_UUID, sizeof(CUuid)) != 0)
+	{
+		log_error("teehistorian", "not a teehistorian file");
+		return false;
+	}
+
+	const char *pJson = pFile + sizeof(CUuid);
+	const char *pJsonEnd = (const char *)std::memchr(pJson, 0, pFile + DataSize - pJson);
+	if(!pJsonEnd)
+	{
+		log_error("teehistorian", "unterminated header");
+		return false;
+	}
+	m_pHeader = json_parse(pJson, pJsonEnd - pJson);
+	if(!m_pHeader || m_pHeader->type != json_object)
+	{
+		log_error("teehistorian", "invalid header");
+		return false;
+	}
+	if(str_comp(HeaderString("version"), "2") != 0)
+	{
+		log_error("teehistorian", "unsupported version '%s'", HeaderString("version"));
+		return false;
+	}
+
+	const char *pChunks = pJsonEnd + 1;
+	m_Unpacker.Reset(pChunks, pFile + DataSize - pChunks);
+	m_Error = false;
+	m_Finished = false;
+	m_Tick = 0;
+	m_LastPlayerClientId = MAX_CLIENTS;
+	for(auto &Player : m_aPlayers)
+	{
+		Player.m_Alive = false;
+		Player.m_HaveInput = false;
+	}
+	return true;
+}
+
+const char *CTeeHistorianReader::HeaderString(const char *pName) const
+{
+	if(!m_pHeader)
+		return "";
+	const json_value *pValue = json_object_get(m_pHeader, pName);
+	return pValue->type == json_string ? pValue->u.string.ptr : "";
+}
+
+bool CTeeHistorianReader::ReadClientId(int *pClientId)
+{
+	*pClientId = m_Unpacker.GetInt();
+	return !m_Unpacker.Error() && *pClientId >= 0 && *pClientId < MAX_CLIENTS;
+}
+
+void CTeeHistorianReader::ReadPlayerTick(int ClientId)
+{
+	// player data is written in ascending client id order, a lower or equal
+	// client id starts the next tick without an explicit tick chunk
+	if(ClientId <= m_LastPlayerClientId)
+		m_Tick++;
+	m_LastPlayerClientId = ClientId;
+}
+
+bool CTeeHistorianReader::Next(CChunk *pChunk)
+{
+	while(!m_Finished && !m_Error)
+	{
+		const int Type = m_Unpacker.GetInt();
+		if(m_Unpacker.Error())
+		{
+			// recordings of servers that did not shut down cleanly end without a finish chunk
+			m_Finished = true;
+			return false;
+		}
+
+		pChunk->m_Tick = m_Tick;
+		pChunk->m_ClientId = -1;
+		pChunk->m_pData = nullptr;
+		pChunk->m_DataSize = 0;
+		pChunk->m_pString = nullptr;
+
+		if(Type >= 0)
+		{
+			// position diff of a living player
+			const int ClientId = Type;
+			const int Dx = m_Unpacker.GetInt();
+			const int Dy = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || ClientId >= MAX_CLIENTS || !m_aPlayers[ClientId].m_Alive)
+				break;
+			ReadPlayerTick(ClientId);
+			CPlayerState &Player = m_aPlayers[ClientId];
+			Player.m_X += Dx;
+			Player.m_Y += Dy;
+			pChunk->m_Type = CHUNK_PLAYER;
+			pChunk->m_Tick = m_Tick;
+			pChunk->m_ClientId = ClientId;
+			pChunk->m_X = Player.m_X;
+			pChunk->m_Y = Player.m_Y;
+			return true;
+		}
+
+		int ClientId;
+		switch(-Type)
+		{
+		case TEEHISTORIAN_FINISH:
+			m_Finished = true;
+			pChunk->m_Type = CHUNK_FINISH;
+			return true;
+		case TEEHISTORIAN_TICK_SKIP:
+		{
+			const int TickDelta = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || TickDelta < 0)
+				break;
+			m_Tick += TickDelta + 1;
+			m_LastPlayerClientId = -1;
+			continue;
+		}
+		case TEEHISTORIAN_PLAYER_NEW:
+		{
+			if(!ReadClientId(&ClientId))
+				break;
+			const int X = m_Unpacker.GetInt();
+			const int Y = m_Unpacker.GetInt();
+			if(m_Unpacker.Error())
+				break;
+			ReadPlayerTick(ClientId);
+			CPlayerState &Player = m_aPlayers[ClientId];
+			Player.m_Alive = true;
+			Player.m_X = X;
+			Player.m_Y = Y;
+			pChunk->m_Type = CHUNK_PLAYER;
+			pChunk->m_Tick = m_Tick;
+			pChunk->m_ClientId = ClientId;
+			pChunk->m_X = X;
+			pChunk->m_Y = Y;
+			return true;
+		}
+		case TEEHISTORIAN_PLAYER_OLD:
+			if(!ReadClientId(&ClientId))
+				break;
+			ReadPlayerTick(ClientId);
+			m_aPlayers[ClientId].m_Alive = false;
+			pChunk->m_Type = CHUNK_PLAYER_OLD;
+			pChunk->m_Tick = m_Tick;
+			pChunk->m_ClientId = ClientId;
+			return true;
+		case TEEHISTORIAN_INPUT_DIFF:
+		case TEEHISTORIAN_INPUT_NEW:
+		{
+			if(!ReadClientId(&ClientId))
+				break;
+			CPlayerState &Player = m_aPlayers[ClientId];
+			const bool Diff = -Type == TEEHISTORIAN_INPUT_DIFF;
+			if(Diff && !Player.m_HaveInput)
+				break;
+			int *pInput = (int *)&Player.m_Input;
+			for(size_t i = 0; i < sizeof(Player.m_Input) / sizeof(int32_t); i++)
+			{
+				const int Value = m_Unpacker.GetInt();
+				pInput[i] = Diff ? pInput[i] + Value : Value;
+			}
+			if(m_Unpacker.Error())
+				break;
+			Player.m_HaveInput = true;
+			pChunk->m_Type = CHUNK_INPUT;
+			pChunk->m_ClientId = ClientId;
+			pChunk->m_Input = Player.m_Input;
+			return true;
+		}
+		case TEEHISTORIAN_MESSAGE:
+		{
+			if(!ReadClientId(&ClientId))
+				break;
+			const int Size = m_Unpacker.GetInt();
+			const unsigned char *pData = m_Unpacker.GetRaw(Size);
+			if(m_Unpacker.Error() || !pData)
+				break;
+			pChunk->m_Type = CHUNK_MESSAGE;
+			pChunk->m_ClientId = ClientId;
+			pChunk->m_pData = pData;
+			pChunk->m_DataSize = Size;
+			return true;
+		}
+		case TEEHISTORIAN_JOIN:
+			if(!ReadClientId(&ClientId))
+				break;
+			pChunk->m_Type = CHUNK_JOIN;
+			pChunk->m_ClientId = ClientId;
+			return true;
+		case TEEHISTORIAN_DROP:
+		{
+			if(!ReadClientId(&ClientId))
+				break;
+			const char *pReason = m_Unpacker.GetString();
+			if(m_Unpacker.Error())
+				break;
+			// the next player using this slot starts with fresh diffs
+			m_aPlayers[ClientId].m_HaveInput = false;
+			pChunk->m_Type = CHUNK_DROP;
+			pChunk->m_ClientId = ClientId;
+			pChunk->m_pString = pReason;
+			return true;
+		}
+		case TEEHISTORIAN_CONSOLE_COMMAND:
+		{
+			// console commands can come from the server itself
+			ClientId = m_Unpacker.GetInt();
+			pChunk->m_FlagMask = m_Unpacker.GetInt();
+			pChunk->m_pString = m_Unpacker.GetString();
+			const int NumArgs = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || NumArgs < 0)
+				break;
+			pChunk->m_NumArgs = 0;
+			for(int i = 0; i < NumArgs; i++)
+			{
+				const char *pArg = m_Unpacker.GetString();
+				if(pChunk->m_NumArgs < MAX_ARGS)
+					pChunk->m_apArgs[pChunk->m_NumArgs++] = pArg;
+			}
+			if(m_Unpacker.Error())
+				break;
+			pChunk->m_Type = CHUNK_CONSOLE_COMMAND;
+			pChunk->m_ClientId = ClientId;
+			return true;
+		}
+		case TEEHISTORIAN_EX:
+		{
+			const unsigned char *pUuid = m_Unpacker.GetRaw(sizeof(CUuid));
+			const int Size = m_Unpacker.GetInt();
+			const unsigned char *pData = m_Unpacker.GetRaw(Size);
+			if(m_Unpacker.Error() || !pUuid || !pData)
+				break;
+			pChunk->m_Type = CHUNK_EX;
+			mem_copy(&pChunk->m_Uuid, pUuid, sizeof(CUuid));
+			pChunk->m_pData = pData;
+			pChunk->m_DataSize = Size;
+			return true;
+		}
+		}
+		break;
+	}
+
+	if(!m_Finished && !m_Error)
+	{
+		log_error("teehistorian", "malformed chunk at tick %d", m_Tick);
+		m_Error = true;
+	}
+	return false;
+}
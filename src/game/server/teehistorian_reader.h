@@ -0,0 +1,115 @@
+#ifndef GAME_SERVER_TEEHISTORIAN_READER_H
+#define GAME_SERVER_TEEHISTORIAN_READER_H
+
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <generated/protocol.h>
+
+typedef struct _json_value json_value;
+
+// Reads the chunks written by CTeeHistorian back, resolving the implicit
+// ticks and the position and input diffs.
+class CTeeHistorianReader
+{
+public:
+	enum
+	{
+		CHUNK_PLAYER,
+		CHUNK_PLAYER_OLD,
+		CHUNK_INPUT,
+		CHUNK_MESSAGE,
+		CHUNK_JOIN,
+		CHUNK_DROP,
+		CHUNK_CONSOLE_COMMAND,
+		CHUNK_EX,
+		CHUNK_FINISH,
+
+		MAX_ARGS = 16,
+	};
+
+	class CChunk
+	{
+	public:
+		int m_Type;
+		// tick the chunk was recorded in, player chunks describe the state at
+		// the end of it and all other chunks happened after it
+		int m_Tick;
+		int m_ClientId;
+
+		// CHUNK_PLAYER, absolute position
+		int m_X;
+		int m_Y;
+
+		// CHUNK_INPUT, absolute input
+		CNetObj_PlayerInput m_Input;
+
+		// CHUNK_MESSAGE and CHUNK_EX
+		const unsigned char *m_pData;
+		int m_DataSize;
+		// CHUNK_EX
+		CUuid m_Uuid;
+
+		// CHUNK_DROP reason and CHUNK_CONSOLE_COMMAND command
+		const char *m_pString;
+		// CHUNK_CONSOLE_COMMAND
+		int m_FlagMask;
+		int m_NumArgs;
+		const char *m_apArgs[MAX_ARGS];
+	};
+
+	CTeeHistorianReader();
+	~CTeeHistorianReader();
+
+	/**
+	 * Parses the header of a complete teehistorian file.
+	 *
+	 * @param pData File contents, must stay valid while the reader is used.
+	 * @param DataSize Size of the file contents.
+	 *
+	 * @return `true` on success, `false` if the header is invalid.
+	 */
+	bool Init(const void *pData, int DataSize);
+
+	/**
+	 * Reads the next chunk.
+	 *
+	 * @param pChunk Receives the chunk, pointers in it point into the file
+	 * data or stay valid until the next call.
+	 *
+	 * @return `true` if a chunk was read, `false` at the end of the file or
+	 * on malformed input, check @link Error @endlink to tell them apart.
+	 */
+	bool Next(CChunk *pChunk);
+
+	bool Error() const { return m_Error; }
+	const json_value *Header() const { return m_pHeader; }
+	// string value of a top level header field, empty if missing
+	const char *HeaderString(const char *pName) const;
+
+private:
+	json_value *m_pHeader;
+	CUnpacker m_Unpacker;
+	bool m_Error;
+	bool m_Finished;
+
+	int m_Tick;
+	int m_LastPlayerClientId;
+
+	class CPlayerState
+	{
+	public:
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+		bool m_HaveInput;
+		CNetObj_PlayerInput m_Input;
+	};
+	CPlayerState m_aPlayers[MAX_CLIENTS];
+
+	void ReadPlayerTick(int ClientId);
+	bool ReadClientId(int *pClientId);
+};
+
+#endif
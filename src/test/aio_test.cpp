@@ -8,21 +8,32 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 static const int BUF_SIZE = 64 * 1024;
 
-class Async : public ::testing::Test
+typedef ASYNCIO *(*FAioNew)(IOHANDLE io);
+
+class Async : public ::testing::TestWithParam<FAioNew>
 {
 protected:
 	ASYNCIO *m_pAio;
 	CTestInfo m_Info;
-	bool Delete;
+	bool Delete = false;
 
 	void SetUp() override
 	{
 		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
 		ASSERT_TRUE(File);
-		m_pAio = aio_new(File);
-		Delete = false;
+		m_pAio = GetParam()(File);
+		if(!m_pAio)
+		{
+			io_close(File);
+			Delete = true;
+			GTEST_SKIP() << "backend not available";
+		}
 	}
 
 	~Async()
@@ -39,36 +50,42 @@ protected:
 	}
 
 	void Expect(const char *pOutput)
+	{
+		Expect(std::string(pOutput));
+	}
+
+	void Expect(const std::string &Output)
 	{
 		aio_close(m_pAio);
 		aio_wait(m_pAio);
+		EXPECT_EQ(aio_error(m_pAio), 0);
 		aio_free(m_pAio);
 
-		char aBuf[BUF_SIZE];
+		std::vector<char> vBuf(Output.size() + 1);
 		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
 		ASSERT_TRUE(File);
-		int Read = io_read(File, aBuf, sizeof(aBuf));
+		unsigned Read = io_read(File, vBuf.data(), vBuf.size());
 		io_close(File);
 
-		ASSERT_EQ(str_length(pOutput), Read);
-		ASSERT_TRUE(mem_comp(aBuf, pOutput, Read) == 0);
+		ASSERT_EQ(Output.size(), Read);
+		ASSERT_TRUE(mem_comp(vBuf.data(), Output.data(), Read) == 0);
 		Delete = true;
 	}
 };
 
-TEST_F(Async, Empty)
+TEST_P(Async, Empty)
 {
 	Expect("");
 }
 
-TEST_F(Async, Simple)
+TEST_P(Async, Simple)
 {
 	static const char TEXT[] = "a\n";
 	Write(TEXT);
 	Expect(TEXT);
 }
 
-TEST_F(Async, Long)
+TEST_P(Async, Long)
 {
 	char aText[BUF_SIZE + 1];
 	for(unsigned i = 0; i < sizeof(aText) - 1; i++)
@@ -80,7 +97,7 @@ TEST_F(Async, Long)
 	Expect(aText);
 }
 
-TEST_F(Async, Pieces)
+TEST_P(Async, Pieces)
 {
 	char aText[BUF_SIZE + 1];
 	for(unsigned i = 0; i < sizeof(aText) - 1; i++)
@@ -95,7 +112,7 @@ TEST_F(Async, Pieces)
 	Expect(aText);
 }
 
-TEST_F(Async, Mixed)
+TEST_P(Async, Mixed)
 {
 	char aText[BUF_SIZE + 1];
 	for(unsigned i = 0; i < sizeof(aText) - 1; i++)
@@ -111,7 +128,7 @@ TEST_F(Async, Mixed)
 	Expect(aText);
 }
 
-TEST_F(Async, NonDivisor)
+TEST_P(Async, NonDivisor)
 {
 	static const int NUM_LETTERS = 13;
 	static const int SIZE = BUF_SIZE / NUM_LETTERS * NUM_LETTERS;
@@ -128,7 +145,7 @@ TEST_F(Async, NonDivisor)
 	Expect(aText);
 }
 
-TEST_F(Async, Transaction)
+TEST_P(Async, Transaction)
 {
 	static const int NUM_LETTERS = 13;
 	static const int SIZE = BUF_SIZE / NUM_LETTERS * NUM_LETTERS;
@@ -149,3 +166,65 @@ TEST_F(Async, Transaction)
 	}
 	Expect(aText);
 }
+
+TEST_P(Async, Large)
+{
+	// grows the buffer while writes are in flight
+	std::string Text;
+	for(int i = 0; i < 64; i++)
+	{
+		std::string Chunk(BUF_SIZE + i * 997, 'a' + i % 26);
+		Write(Chunk.c_str());
+		Text += Chunk;
+	}
+	Expect(Text);
+}
+
+TEST_P(Async, Threads)
+{
+	static const int NUM_THREADS = 4;
+	static const int NUM_LINES = 2000;
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NUM_THREADS; t++)
+	{
+		vThreads.emplace_back([this, t]() {
+			for(int i = 0; i < NUM_LINES; i++)
+			{
+				char aLine[32];
+				str_format(aLine, sizeof(aLine), "%d %05d\n", t, i);
+				Write(aLine);
+			}
+		});
+	}
+	for(std::thread &Thread : vThreads)
+	{
+		Thread.join();
+	}
+	aio_close(m_pAio);
+	aio_wait(m_pAio);
+	EXPECT_EQ(aio_error(m_pAio), 0);
+	aio_free(m_pAio);
+
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	std::vector<char> vBuf(NUM_THREADS * NUM_LINES * 8 + 1);
+	const unsigned Read = io_read(File, vBuf.data(), vBuf.size());
+	io_close(File);
+	ASSERT_EQ(Read, (unsigned)NUM_THREADS * NUM_LINES * 8);
+
+	// lines of every thread are complete and in order
+	int aNext[NUM_THREADS] = {0};
+	for(unsigned Pos = 0; Pos < Read; Pos += 8)
+	{
+		const int Thread = vBuf[Pos] - '0';
+		ASSERT_TRUE(Thread >= 0 && Thread < NUM_THREADS);
+		ASSERT_EQ(vBuf[Pos + 7], '\n');
+		EXPECT_EQ(str_toint(std::string(&vBuf[Pos + 2], 5).c_str()), aNext[Thread]);
+		aNext[Thread]++;
+	}
+	Delete = true;
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, Async, ::testing::Values(aio_new_thread, aio_new_io_uring), [](const ::testing::TestParamInfo<FAioNew> &Info) -> std::string {
+	return Info.param == aio_new_thread ? "Thread" : "IoUring";
+});
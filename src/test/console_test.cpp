@@ -0,0 +1,110 @@
+#include <base/str.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+static void ConCount(IConsole::IResult *pResult, void *pUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+}
+
+TEST(Console, FindCommand)
+{
+	int ServerCalls = 0;
+	int ClientCalls = 0;
+	auto pConsole = CreateConsole(CFGFLAG_SERVER);
+	pConsole->Register("hide_start", "", CFGFLAG_SERVER, ConCount, &ServerCalls, "");
+	pConsole->Register("hide_start", "", CFGFLAG_CLIENT, ConCount, &ClientCalls, "");
+
+	pConsole->ExecuteLine("hide_start", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("HIDE_Start", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("hide_star", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("hide_start_", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ServerCalls, 2);
+	EXPECT_EQ(ClientCalls, 0);
+
+	pConsole->ExecuteLineFlag("hide_start", CFGFLAG_CLIENT, IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ServerCalls, 2);
+	EXPECT_EQ(ClientCalls, 1);
+
+	// registering again replaces the command
+	int NewServerCalls = 0;
+	pConsole->Register("Hide_Start", "", CFGFLAG_SERVER, ConCount, &NewServerCalls, "");
+	pConsole->ExecuteLine("hide_start", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ServerCalls, 2);
+	EXPECT_EQ(NewServerCalls, 1);
+
+	ASSERT_NE(pConsole->GetCommandInfo("HIDE_START", CFGFLAG_CLIENT, false), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("hide_start", CFGFLAG_CLIENT, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("hide_stop", CFGFLAG_SERVER, false), nullptr);
+}
+
+TEST(Console, TempCommands)
+{
+	auto pConsole = CreateConsole(CFGFLAG_CLIENT);
+	std::vector<std::string> vNames;
+	for(int i = 0; i < 1000; i++)
+	{
+		vNames.push_back("temp_" + std::to_string(i));
+		pConsole->RegisterTemp(vNames.back().c_str(), "", CFGFLAG_SERVER, "");
+	}
+	for(const std::string &Name : vNames)
+	{
+		EXPECT_NE(pConsole->GetCommandInfo(Name.c_str(), CFGFLAG_SERVER, true), nullptr) << Name;
+	}
+
+	for(int i = 0; i < 1000; i += 2)
+	{
+		pConsole->DeregisterTemp(vNames[i].c_str());
+	}
+	for(int i = 0; i < 1000; i++)
+	{
+		EXPECT_EQ(pConsole->GetCommandInfo(vNames[i].c_str(), CFGFLAG_SERVER, true) != nullptr, i % 2 == 1) << vNames[i];
+	}
+
+	// recycled commands
+	pConsole->RegisterTemp("recycled", "", CFGFLAG_SERVER, "");
+	EXPECT_NE(pConsole->GetCommandInfo("recycled", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo(vNames[0].c_str(), CFGFLAG_SERVER, true), nullptr);
+
+	pConsole->DeregisterTempAll();
+	for(const std::string &Name : vNames)
+	{
+		EXPECT_EQ(pConsole->GetCommandInfo(Name.c_str(), CFGFLAG_SERVER, true), nullptr) << Name;
+	}
+	EXPECT_EQ(pConsole->GetCommandInfo("recycled", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("exec", CFGFLAG_SERVER, false), nullptr);
+}
+
+TEST(Console, ManyCommands)
+{
+	std::vector<std::string> vNames;
+	for(int i = 0; i < 1000; i++)
+	{
+		vNames.push_back("sv_hide_setting_" + std::to_string(i));
+	}
+	std::vector<int> vCalls(vNames.size(), 0);
+
+	auto pConsole = CreateConsole(CFGFLAG_SERVER);
+	for(size_t i = 0; i < vNames.size(); i++)
+	{
+		pConsole->Register(vNames[i].c_str(), "?i[value]", CFGFLAG_SERVER, ConCount, &vCalls[i], "");
+	}
+
+	// a config with 10k lines
+	for(int Line = 0; Line < 10000; Line++)
+	{
+		char aLine[64];
+		str_format(aLine, sizeof(aLine), "%s %d", vNames[(Line * 7) % vNames.size()].c_str(), Line);
+		pConsole->ExecuteLine(aLine, IConsole::CLIENT_ID_UNSPECIFIED);
+	}
+	for(size_t i = 0; i < vNames.size(); i++)
+	{
+		EXPECT_EQ(vCalls[i], 10) << vNames[i];
+	}
+}
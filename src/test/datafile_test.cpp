@@ -1,13 +1,20 @@
 #include "test.h"
 
+#include <base/io.h>
+#include <base/mem.h>
+
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <game/mapitems_ex.h>
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +119,67 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, ParallelFinish)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+	char aParallelFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aParallelFilename, sizeof(aParallelFilename), "-parallel.map");
+
+	std::vector<std::vector<uint8_t>> vvData;
+	uint32_t Seed = 1;
+	for(int i = 0; i < 24; i++)
+	{
+		std::vector<uint8_t> vData((i + 1) * 3000);
+		for(uint8_t &Byte : vData)
+		{
+			Seed = Seed * 1103515245 + 12345;
+			Byte = (Seed >> 16) % (i + 2);
+		}
+		vvData.push_back(std::move(vData));
+	}
+
+	CJobPool JobPool;
+	JobPool.Init(3);
+	for(bool Parallel : {false, true})
+	{
+		const char *pFilename = Parallel ? aParallelFilename : Info.m_aFilename;
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), pFilename));
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			EXPECT_EQ(Writer.AddData(vvData[i].size(), vvData[i].data(), i % 2 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT), (int)i);
+		}
+		Writer.Finish(Parallel ? &JobPool : nullptr);
+	}
+
+	void *apFiles[2];
+	unsigned aFileSizes[2];
+	ASSERT_TRUE(pStorage->ReadFile(Info.m_aFilename, IStorage::TYPE_SAVE, &apFiles[0], &aFileSizes[0]));
+	ASSERT_TRUE(pStorage->ReadFile(aParallelFilename, IStorage::TYPE_SAVE, &apFiles[1], &aFileSizes[1]));
+	ASSERT_EQ(aFileSizes[0], aFileSizes[1]);
+	EXPECT_EQ(mem_comp(apFiles[0], apFiles[1], aFileSizes[0]), 0);
+	free(apFiles[0]);
+	free(apFiles[1]);
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), aParallelFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)vvData[i].size());
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), vvData[i].size()), 0);
+		}
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aParallelFilename, IStorage::TYPE_SAVE);
+	}
+}
@@ -1,5 +1,7 @@
 #include <base/str.h>
 
+#include <game/editor/editor_history.h>
+
 #include <gtest/gtest.h>
 
 bool is_letter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
@@ -95,3 +97,113 @@ TEST(Editor, QuickActionNames)
 #include <game/editor/quick_actions.h>
 #undef REGISTER_QUICK_ACTION
 }
+
+// Reports the size of the object it refers to, like the delete actions that
+// count the deleted layer, group or envelope.
+class CTestHistoryAction
+{
+public:
+	CTestHistoryAction(int Id, size_t MemoryUsage) :
+		m_Id(Id), m_ObjectSize(MemoryUsage) {}
+
+	size_t MemoryUsage() const { return m_ObjectSize; }
+
+	int m_Id;
+	size_t m_ObjectSize;
+};
+
+static std::vector<std::shared_ptr<CTestHistoryAction>> RecordTestHistory(CHistoryStacks<CTestHistoryAction> &History, const std::vector<size_t> &vMemoryUsages)
+{
+	std::vector<std::shared_ptr<CTestHistoryAction>> vpActions;
+	for(size_t i = 0; i < vMemoryUsages.size(); i++)
+	{
+		vpActions.push_back(std::make_shared<CTestHistoryAction>(i, vMemoryUsages[i]));
+		History.PushAction(vpActions.back());
+	}
+	return vpActions;
+}
+
+TEST(Editor, HistoryMemoryUnlimited)
+{
+	CHistoryStacks<CTestHistoryAction> History;
+	RecordTestHistory(History, {100, 200, 300});
+	History.TrimMemory(0);
+	EXPECT_EQ(History.m_vpUndoActions.size(), 3);
+	EXPECT_EQ(History.MemoryUsage(), 600);
+}
+
+TEST(Editor, HistoryMemoryWithinBudget)
+{
+	CHistoryStacks<CTestHistoryAction> History;
+	RecordTestHistory(History, {100, 200, 300});
+	History.TrimMemory(600);
+	EXPECT_EQ(History.m_vpUndoActions.size(), 3);
+	EXPECT_EQ(History.MemoryUsage(), 600);
+}
+
+TEST(Editor, HistoryMemoryDropsOldest)
+{
+	CHistoryStacks<CTestHistoryAction> History;
+	RecordTestHistory(History, {100, 200, 300, 50});
+	History.TrimMemory(400);
+	ASSERT_EQ(History.m_vpUndoActions.size(), 2);
+	EXPECT_EQ(History.m_vpUndoActions[0]->m_Id, 2);
+	EXPECT_EQ(History.m_vpUndoActions[1]->m_Id, 3);
+	EXPECT_EQ(History.MemoryUsage(), 350);
+}
+
+TEST(Editor, HistoryMemoryKeepsNewest)
+{
+	CHistoryStacks<CTestHistoryAction> History;
+	RecordTestHistory(History, {100, 200, 1000});
+	History.TrimMemory(500);
+	ASSERT_EQ(History.m_vpUndoActions.size(), 1);
+	EXPECT_EQ(History.m_vpUndoActions[0]->m_Id, 2);
+	EXPECT_EQ(History.MemoryUsage(), 1000);
+}
+
+TEST(Editor, HistoryMemoryUndoResizeClearRedo)
+{
+	// a deleted layer is restored by the undo and then shrunk, dropping the
+	// redo action must subtract the size it had when it was recorded
+	CHistoryStacks<CTestHistoryAction> History;
+	auto vpActions = RecordTestHistory(History, {100, 5000});
+	History.MoveToRedo();
+	vpActions[1]->m_ObjectSize = 10;
+	EXPECT_EQ(History.MemoryUsage(), 5100);
+
+	History.PushAction(std::make_shared<CTestHistoryAction>(2, 50));
+	EXPECT_TRUE(History.m_vpRedoActions.empty());
+	EXPECT_EQ(History.MemoryUsage(), 150);
+
+	// growing the restored object must not make the counter wrap
+	auto pDelete = std::make_shared<CTestHistoryAction>(3, 300);
+	History.PushAction(pDelete);
+	History.MoveToRedo();
+	pDelete->m_ObjectSize = 1 << 20;
+	History.PushAction(std::make_shared<CTestHistoryAction>(4, 20));
+	EXPECT_EQ(History.MemoryUsage(), 170);
+}
+
+TEST(Editor, HistoryMemoryUndoRedoResizeTrim)
+{
+	CHistoryStacks<CTestHistoryAction> History;
+	auto vpActions = RecordTestHistory(History, {300, 100, 200});
+	History.MoveToRedo();
+	History.MoveToRedo();
+	History.MoveToRedo();
+	EXPECT_EQ(History.MemoryUsage(), 600);
+	History.MoveToUndo();
+	History.MoveToUndo();
+	History.MoveToUndo();
+	EXPECT_EQ(History.MemoryUsage(), 600);
+
+	// the layer of the oldest action was resized while it was in the map
+	vpActions[0]->m_ObjectSize = 1 << 20;
+	History.TrimMemory(350);
+	ASSERT_EQ(History.m_vpUndoActions.size(), 2);
+	EXPECT_EQ(History.MemoryUsage(), 300);
+
+	History.ClearActions();
+	EXPECT_EQ(History.MemoryUsage(), 0);
+}
@@ -0,0 +1,92 @@
+#include <game/prng.h>
+#include <game/server/eventhandler.h>
+
+#include <generated/protocol.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static std::vector<int> CollectBruteForce(const std::vector<vec2> &vPositions, vec2 ViewPos, vec2 ShowDistance)
+{
+	std::vector<int> vResult;
+	for(int i = 0; i < (int)vPositions.size(); i++)
+	{
+		if(absolute(ViewPos.x - vPositions[i].x) <= ShowDistance.x && absolute(ViewPos.y - vPositions[i].y) <= ShowDistance.y)
+			vResult.push_back(i);
+	}
+	return vResult;
+}
+
+TEST(EventHandler, Grow)
+{
+	CEventHandler Events;
+	for(int i = 0; i < 1000; i++)
+	{
+		CNetEvent_SoundWorld *pEvent = Events.Create<CNetEvent_SoundWorld>();
+		ASSERT_TRUE(pEvent);
+		pEvent->m_X = i;
+		pEvent->m_Y = -i;
+		pEvent->m_SoundId = i;
+	}
+	EXPECT_EQ(Events.NumEvents(), 1000);
+	EXPECT_EQ(Events.NumDroppedCreate(), 0);
+
+	std::vector<int> vVisible;
+	Events.CollectEvents(vec2(0.0f, 0.0f), vec2(10.0f, 10.0f), &vVisible);
+	ASSERT_EQ(vVisible.size(), 11u);
+	for(int i = 0; i <= 10; i++)
+		EXPECT_EQ(vVisible[i], i);
+
+	Events.Clear();
+	EXPECT_EQ(Events.NumEvents(), 0);
+	Events.CollectEvents(vec2(0.0f, 0.0f), vec2(10.0f, 10.0f), &vVisible);
+	EXPECT_TRUE(vVisible.empty());
+}
+
+TEST(EventHandler, DropWhenFull)
+{
+	CEventHandler Events;
+	int Created = 0;
+	while(Events.Create<CNetEvent_Spawn>())
+		Created++;
+	EXPECT_GT(Created, 128);
+	EXPECT_EQ(Events.NumDroppedCreate(), 1);
+	EXPECT_FALSE(Events.Create<CNetEvent_Spawn>());
+	EXPECT_EQ(Events.NumDroppedCreate(), 2);
+
+	Events.Clear();
+	EXPECT_TRUE(Events.Create<CNetEvent_Spawn>());
+	EXPECT_EQ(Events.NumDroppedCreate(), 2);
+}
+
+TEST(EventHandler, CollectMatchesBruteForce)
+{
+	uint64_t aSeed[2] = {1, 2};
+	CPrng Prng;
+	Prng.Seed(aSeed);
+
+	CEventHandler Events;
+	for(int Tick = 0; Tick < 10; Tick++)
+	{
+		Events.Clear();
+		std::vector<vec2> vPositions;
+		for(int i = 0; i < 50 + Tick * 300; i++)
+		{
+			CNetEvent_Explosion *pEvent = Events.Create<CNetEvent_Explosion>();
+			ASSERT_TRUE(pEvent);
+			pEvent->m_X = (int)(Prng.RandomBits() % 40000) - 20000;
+			pEvent->m_Y = (int)(Prng.RandomBits() % 40000) - 20000;
+			vPositions.emplace_back(pEvent->m_X, pEvent->m_Y);
+		}
+
+		std::vector<int> vVisible;
+		for(int View = 0; View < 64; View++)
+		{
+			vec2 ViewPos((int)(Prng.RandomBits() % 44000) - 22000, (int)(Prng.RandomBits() % 44000) - 22000);
+			vec2 ShowDistance = View % 8 == 0 ? vec2(30000.0f, 30000.0f) : vec2(1000.0f + View * 10, 800.0f + View * 5);
+			Events.CollectEvents(ViewPos, ShowDistance, &vVisible);
+			EXPECT_EQ(vVisible, CollectBruteForce(vPositions, ViewPos, ShowDistance));
+		}
+	}
+}
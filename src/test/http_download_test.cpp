@@ -0,0 +1,325 @@
+#include "test.h"
+
+#include <base/hash.h>
+#include <base/io.h>
+#include <base/net.h>
+#include <base/secure.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/shared/config.h>
+#include <engine/shared/http.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Serves one file over HTTP/1.1, one request per connection
+class CTestHttpServer
+{
+	NETSOCKET m_Socket = nullptr;
+	std::thread m_Thread;
+	std::vector<std::thread> m_vConnections;
+	std::atomic<bool> m_Stop{false};
+
+	void Serve(NETSOCKET Socket)
+	{
+		std::string Request;
+		char aBuf[1024];
+		while(Request.find("\r\n\r\n") == std::string::npos)
+		{
+			const int Bytes = net_tcp_recv(Socket, aBuf, sizeof(aBuf));
+			if(Bytes <= 0)
+			{
+				net_tcp_close(Socket);
+				return;
+			}
+			Request.append(aBuf, Bytes);
+		}
+		m_NumRequests++;
+
+		int64_t Start = 0;
+		int64_t End = m_vFile.size() - 1;
+		const size_t RangePos = Request.find("Range: bytes=");
+		const bool Ranged = m_Ranges && RangePos != std::string::npos;
+		if(Ranged)
+		{
+			sscanf(Request.c_str() + RangePos, "Range: bytes=%" SCNd64 "-%" SCNd64, &Start, &End);
+		}
+
+		char aHeader[256];
+		if(m_DropRequests > 0)
+		{
+			m_DropRequests--;
+			net_tcp_close(Socket);
+			return;
+		}
+		if(m_FailRequests > 0)
+		{
+			m_FailRequests--;
+			str_copy(aHeader, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+			net_tcp_send(Socket, aHeader, str_length(aHeader));
+			net_tcp_close(Socket);
+			return;
+		}
+		if(Ranged)
+		{
+			char aContentRange[128] = "";
+			if(m_ContentRange)
+				str_format(aContentRange, sizeof(aContentRange), "Content-Range: bytes %" PRId64 "-%" PRId64 "/%d\r\n", Start, End, (int)m_vFile.size());
+			str_format(aHeader, sizeof(aHeader), "HTTP/1.1 206 Partial Content\r\nContent-Length: %" PRId64 "\r\n%sConnection: close\r\n\r\n", End - Start + 1, aContentRange);
+		}
+		else
+		{
+			str_format(aHeader, sizeof(aHeader), "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", (int)m_vFile.size());
+		}
+		net_tcp_send(Socket, aHeader, str_length(aHeader));
+		m_ServedBytes += End - Start + 1;
+
+		// limit the bandwidth of every connection
+		const int ChunkSize = 16 * 1024;
+		for(int64_t Offset = Start; Offset <= End && !m_Stop; Offset += ChunkSize)
+		{
+			const int Size = std::min<int64_t>(ChunkSize, End - Offset + 1);
+			if(net_tcp_send(Socket, m_vFile.data() + Offset, Size) != Size)
+				break;
+			if(m_BytesPerSecond)
+				std::this_thread::sleep_for(std::chrono::microseconds((int64_t)Size * 1000000 / m_BytesPerSecond));
+		}
+		net_tcp_close(Socket);
+	}
+
+public:
+	std::vector<unsigned char> m_vFile;
+	bool m_Ranges = true;
+	bool m_ContentRange = true;
+	int64_t m_BytesPerSecond = 0;
+	// close the connection without a response
+	std::atomic<int> m_DropRequests{0};
+	// respond with 500 Internal Server Error
+	std::atomic<int> m_FailRequests{0};
+	std::atomic<int> m_NumRequests{0};
+	std::atomic<int64_t> m_ServedBytes{0};
+	char m_aUrl[64];
+
+	bool Start()
+	{
+		NETADDR Addr;
+		net_addr_from_str(&Addr, "127.0.0.1");
+		Addr.port = 18300 + secure_rand_below(1000);
+		while(true)
+		{
+			m_Socket = net_tcp_create(Addr);
+			if(m_Socket && net_tcp_listen(m_Socket, 16) == 0)
+				break;
+			if(m_Socket)
+				net_tcp_close(m_Socket);
+			m_Socket = nullptr;
+			if(++Addr.port >= 19400)
+				return false;
+		}
+		str_format(m_aUrl, sizeof(m_aUrl), "http://127.0.0.1:%d/map.map", Addr.port);
+		net_set_non_blocking(m_Socket);
+		m_Thread = std::thread([this]() {
+			while(!m_Stop)
+			{
+				NETSOCKET Client;
+				NETADDR ClientAddr;
+				if(net_tcp_accept(m_Socket, &Client, &ClientAddr) < 0)
+				{
+					net_socket_read_wait(m_Socket, std::chrono::milliseconds(10));
+					continue;
+				}
+				net_set_blocking(Client);
+				m_vConnections.emplace_back(&CTestHttpServer::Serve, this, Client);
+			}
+		});
+		return true;
+	}
+
+	~CTestHttpServer()
+	{
+		m_Stop = true;
+		if(m_Thread.joinable())
+			m_Thread.join();
+		for(std::thread &Connection : m_vConnections)
+			Connection.join();
+		if(m_Socket)
+			net_tcp_close(m_Socket);
+	}
+};
+
+class CHttpRangedDownloadTest : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	std::unique_ptr<IStorage> m_pStorage;
+	CHttp m_Http;
+	CTestHttpServer m_Server;
+	SHA256_DIGEST m_Sha256;
+
+	void SetUp() override
+	{
+		m_Info.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_Info.CreateTestStorage();
+		ASSERT_TRUE(m_pStorage);
+		g_Config.m_HttpAllowInsecure = 1;
+		ASSERT_TRUE(m_Http.Init(std::chrono::seconds{1}));
+
+		std::mt19937 Rng(0);
+		m_Server.m_vFile.resize(5 * 64 * 1024 + 123);
+		for(unsigned char &Byte : m_Server.m_vFile)
+			Byte = Rng();
+		m_Sha256 = sha256(m_Server.m_vFile.data(), m_Server.m_vFile.size());
+		ASSERT_TRUE(m_Server.Start());
+	}
+
+	void TearDown() override
+	{
+		g_Config.m_HttpAllowInsecure = 0;
+	}
+
+	std::shared_ptr<CHttpRangedDownload> Download(int Connections, CJobPool *pJobPool = nullptr)
+	{
+		auto pDownload = std::make_shared<CHttpRangedDownload>(m_Server.m_aUrl, m_pStorage.get(), "map.map.part", "map.map.tmp", IStorage::TYPE_SAVE, m_Server.m_vFile.size(), m_Sha256);
+		pDownload->Timeout(CTimeout{2000, 0, 0, 0});
+		pDownload->Connections(Connections);
+		pDownload->PieceSize(64 * 1024);
+		pDownload->JobPool(pJobPool);
+		pDownload->Start(&m_Http);
+		const int64_t Timeout = time_get() + time_freq() * 20;
+		while(!pDownload->Done() && time_get() < Timeout)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return pDownload;
+	}
+
+	std::vector<unsigned char> ReadFile(const char *pFilename)
+	{
+		void *pData;
+		unsigned Size;
+		if(!m_pStorage->ReadFile(pFilename, IStorage::TYPE_SAVE, &pData, &Size))
+			return {};
+		std::vector<unsigned char> vData((unsigned char *)pData, (unsigned char *)pData + Size);
+		free(pData);
+		return vData;
+	}
+};
+
+TEST_F(CHttpRangedDownloadTest, Download)
+{
+	auto pDownload = Download(4);
+	EXPECT_EQ(pDownload->State(), EHttpState::DONE);
+	EXPECT_EQ(pDownload->Current(), m_Server.m_vFile.size());
+	EXPECT_EQ(ReadFile("map.map.tmp"), m_Server.m_vFile);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.part", IStorage::TYPE_SAVE));
+	EXPECT_EQ(m_Server.m_NumRequests, 6);
+	m_pStorage->RemoveFile("map.map.tmp", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, DownloadJobPool)
+{
+	CJobPool JobPool;
+	JobPool.Init(2);
+	auto pDownload = Download(4, &JobPool);
+	EXPECT_EQ(pDownload->State(), EHttpState::DONE);
+	EXPECT_EQ(pDownload->Current(), m_Server.m_vFile.size());
+	EXPECT_EQ(ReadFile("map.map.tmp"), m_Server.m_vFile);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.part", IStorage::TYPE_SAVE));
+	JobPool.Shutdown();
+	m_pStorage->RemoveFile("map.map.tmp", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, Retry)
+{
+	m_Server.m_DropRequests = 2;
+	auto pDownload = Download(2);
+	EXPECT_EQ(pDownload->State(), EHttpState::DONE);
+	EXPECT_EQ(ReadFile("map.map.tmp"), m_Server.m_vFile);
+	m_pStorage->RemoveFile("map.map.tmp", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, Resume)
+{
+	const int PartSize = 100000;
+	IOHANDLE File = m_pStorage->OpenFile("map.map.part", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, m_Server.m_vFile.data(), PartSize);
+	io_close(File);
+
+	auto pDownload = Download(3);
+	EXPECT_EQ(pDownload->State(), EHttpState::DONE);
+	EXPECT_EQ(pDownload->ResumedSize(), PartSize);
+	EXPECT_EQ(m_Server.m_ServedBytes, (int64_t)m_Server.m_vFile.size() - PartSize);
+	EXPECT_EQ(ReadFile("map.map.tmp"), m_Server.m_vFile);
+	m_pStorage->RemoveFile("map.map.tmp", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, Corrupt)
+{
+	// a corrupt part file is discarded after the SHA256 check failed
+	IOHANDLE File = m_pStorage->OpenFile("map.map.part", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, "corrupt", 7);
+	io_close(File);
+
+	auto pDownload = Download(2);
+	EXPECT_EQ(pDownload->State(), EHttpState::ERROR);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.part", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.tmp", IStorage::TYPE_SAVE));
+}
+
+TEST_F(CHttpRangedDownloadTest, NoRanges)
+{
+	m_Server.m_Ranges = false;
+	auto pDownload = Download(2);
+	EXPECT_EQ(pDownload->State(), EHttpState::ERROR);
+	// not retried, at most the first request of every connection was sent
+	EXPECT_LE(m_Server.m_NumRequests, 2);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.tmp", IStorage::TYPE_SAVE));
+	m_pStorage->RemoveFile("map.map.part", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, NoContentRange)
+{
+	m_Server.m_ContentRange = false;
+	auto pDownload = Download(2);
+	EXPECT_EQ(pDownload->State(), EHttpState::ERROR);
+	EXPECT_LE(m_Server.m_NumRequests, 2);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.tmp", IStorage::TYPE_SAVE));
+	m_pStorage->RemoveFile("map.map.part", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, ErrorStatus)
+{
+	m_Server.m_FailRequests = 1;
+	auto pDownload = Download(1);
+	EXPECT_EQ(pDownload->State(), EHttpState::ERROR);
+	EXPECT_EQ(m_Server.m_NumRequests, 1);
+	EXPECT_FALSE(m_pStorage->FileExists("map.map.tmp", IStorage::TYPE_SAVE));
+	m_pStorage->RemoveFile("map.map.part", IStorage::TYPE_SAVE);
+}
+
+TEST_F(CHttpRangedDownloadTest, Abort)
+{
+	m_Server.m_BytesPerSecond = 256 * 1024;
+	auto pDownload = std::make_shared<CHttpRangedDownload>(m_Server.m_aUrl, m_pStorage.get(), "map.map.part", "map.map.tmp", IStorage::TYPE_SAVE, m_Server.m_vFile.size(), m_Sha256);
+	pDownload->Connections(1);
+	pDownload->PieceSize(64 * 1024);
+	pDownload->Start(&m_Http);
+	while(pDownload->Current() < 128 * 1024)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	pDownload->Abort();
+	EXPECT_EQ(pDownload->State(), EHttpState::ABORTED);
+
+	// the completed pieces are kept
+	const std::vector<unsigned char> vPart = ReadFile("map.map.part");
+	EXPECT_GE(vPart.size(), 64u * 1024);
+	EXPECT_TRUE(std::equal(vPart.begin(), vPart.end(), m_Server.m_vFile.begin()));
+	m_pStorage->RemoveFile("map.map.part", IStorage::TYPE_SAVE);
+}
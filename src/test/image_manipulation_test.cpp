@@ -0,0 +1,227 @@
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/gfx/image_manipulation.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Straightforward per-pixel implementations the optimized ones must match exactly
+
+static void ReferenceDilate(int w, int h, const uint8_t *pSrc, uint8_t *pDest)
+{
+	const int aDirX[] = {0, -1, 1, 0};
+	const int aDirY[] = {-1, 0, 0, 1};
+
+	int m = 0;
+	for(int y = 0; y < h; y++)
+	{
+		for(int x = 0; x < w; x++, m += 4)
+		{
+			for(int i = 0; i < 4; ++i)
+				pDest[m + i] = pSrc[m + i];
+			if(pSrc[m + 3] > 10)
+				continue;
+
+			for(int c = 0; c < 4; c++)
+			{
+				const int ClampedX = std::clamp(x + aDirX[c], 0, w - 1);
+				const int ClampedY = std::clamp(y + aDirY[c], 0, h - 1);
+				const int SrcIndex = ClampedY * w * 4 + ClampedX * 4;
+				if(pSrc[SrcIndex + 3] > 10)
+				{
+					for(int p = 0; p < 3; ++p)
+						pDest[m + p] = pSrc[SrcIndex + p];
+					pDest[m + 3] = 255;
+					break;
+				}
+			}
+		}
+	}
+}
+
+static void ReferenceDilateImage(uint8_t *pImage, int w, int h)
+{
+	const size_t Size = (size_t)w * h * 4;
+	std::vector<uint8_t> vOriginal(pImage, pImage + Size);
+	std::vector<uint8_t> vBuffer0(Size);
+	std::vector<uint8_t> vBuffer1(Size);
+	ReferenceDilate(w, h, vOriginal.data(), vBuffer0.data());
+	for(int i = 0; i < 5; i++)
+	{
+		ReferenceDilate(w, h, vBuffer0.data(), vBuffer1.data());
+		ReferenceDilate(w, h, vBuffer1.data(), vBuffer0.data());
+	}
+	for(size_t m = 0; m < Size; m += 4)
+	{
+		if(vOriginal[m + 3] == 0)
+			mem_copy(&vOriginal[m], &vBuffer0[m], 3);
+	}
+	mem_copy(pImage, vOriginal.data(), Size);
+}
+
+static float ReferenceCubicHermite(float A, float B, float C, float D, float t)
+{
+	float a = -A / 2.0f + (3.0f * B) / 2.0f - (3.0f * C) / 2.0f + D / 2.0f;
+	float b = A - (5.0f * B) / 2.0f + 2.0f * C - D / 2.0f;
+	float c = -A / 2.0f + C / 2.0f;
+	float d = B;
+
+	return (a * t * t * t) + (b * t * t) + (c * t) + d;
+}
+
+static std::vector<uint8_t> ReferenceResize(const uint8_t *pSource, int SW, int SH, int W, int H, int BPP)
+{
+	std::vector<uint8_t> vResult((size_t)W * H * BPP);
+	for(int y = 0; y < H; ++y)
+	{
+		for(int x = 0; x < W; ++x)
+		{
+			float X = ((float)x / (float)(W - 1) * SW) - 0.5f;
+			float Y = ((float)y / (float)(H - 1) * SH) - 0.5f;
+			for(int i = 0; i < BPP; i++)
+			{
+				float aRows[4];
+				for(int r = 0; r < 4; ++r)
+				{
+					float aColumns[4];
+					for(int c = 0; c < 4; ++c)
+					{
+						const int SampleX = std::clamp((int)X + c - 1, 0, SW - 1);
+						const int SampleY = std::clamp((int)Y + r - 1, 0, SH - 1);
+						aColumns[c] = pSource[((size_t)SampleY * SW + SampleX) * BPP + i];
+					}
+					aRows[r] = ReferenceCubicHermite(aColumns[0], aColumns[1], aColumns[2], aColumns[3], X - std::floor(X));
+				}
+				vResult[((size_t)y * W + x) * BPP + i] = (uint8_t)std::clamp<float>(ReferenceCubicHermite(aRows[0], aRows[1], aRows[2], aRows[3], Y - std::floor(Y)), 0.0f, 255.0f);
+			}
+		}
+	}
+	return vResult;
+}
+
+// Mostly transparent pixels with a few low alpha values around the dilate threshold
+static std::vector<uint8_t> RandomImage(int w, int h, int BPP, unsigned Seed)
+{
+	std::mt19937 Rng(Seed);
+	std::vector<uint8_t> vImage((size_t)w * h * BPP);
+	for(uint8_t &Value : vImage)
+		Value = Rng();
+	if(BPP == 4)
+	{
+		for(size_t i = 3; i < vImage.size(); i += 4)
+		{
+			const unsigned Kind = Rng() % 4;
+			vImage[i] = Kind == 0 ? 0 : Kind == 1 ? Rng() % 20 : vImage[i];
+		}
+	}
+	return vImage;
+}
+
+TEST(ImageManipulation, DilateImage)
+{
+	const int aaSizes[][2] = {{1, 1}, {1, 7}, {7, 1}, {2, 2}, {16, 16}, {61, 37}};
+	for(const auto &aSize : aaSizes)
+	{
+		std::vector<uint8_t> vImage = RandomImage(aSize[0], aSize[1], 4, aSize[0] * 100 + aSize[1]);
+		std::vector<uint8_t> vExpected = vImage;
+		DilateImage(vImage.data(), aSize[0], aSize[1]);
+		ReferenceDilateImage(vExpected.data(), aSize[0], aSize[1]);
+		EXPECT_EQ(vImage, vExpected) << aSize[0] << "x" << aSize[1];
+	}
+}
+
+TEST(ImageManipulation, DilateImageSub)
+{
+	const int Width = 64;
+	const int Height = 48;
+	std::vector<uint8_t> vImage = RandomImage(Width, Height, 4, 1);
+	std::vector<uint8_t> vExpected = vImage;
+	DilateImageSub(vImage.data(), Width, Height, 16, 8, 32, 24);
+
+	std::vector<uint8_t> vSub((size_t)32 * 24 * 4);
+	for(int y = 0; y < 24; y++)
+		mem_copy(&vSub[(size_t)y * 32 * 4], &vExpected[((size_t)(y + 8) * Width + 16) * 4], 32 * 4);
+	ReferenceDilateImage(vSub.data(), 32, 24);
+	for(int y = 0; y < 24; y++)
+		mem_copy(&vExpected[((size_t)(y + 8) * Width + 16) * 4], &vSub[(size_t)y * 32 * 4], 32 * 4);
+	EXPECT_EQ(vImage, vExpected);
+}
+
+TEST(ImageManipulation, ClearTransparentPixels)
+{
+	std::vector<uint8_t> vImage = RandomImage(33, 17, 4, 2);
+	std::vector<uint8_t> vExpected = vImage;
+	for(size_t i = 0; i < vExpected.size(); i += 4)
+	{
+		if(vExpected[i + 3] == 0)
+			vExpected[i] = vExpected[i + 1] = vExpected[i + 2] = 0;
+	}
+	ClearTransparentPixels(vImage.data(), 33, 17);
+	EXPECT_EQ(vImage, vExpected);
+}
+
+TEST(ImageManipulation, CopyOpaquePixels)
+{
+	const std::vector<uint8_t> vSource = RandomImage(33, 17, 4, 3);
+	std::vector<uint8_t> vExpected(vSource.size(), 0);
+	for(size_t i = 0; i < vExpected.size(); i += 4)
+	{
+		if(vSource[i + 3] > 0)
+			mem_copy(&vExpected[i], &vSource[i], 4);
+	}
+	std::vector<uint8_t> vImage(vSource.size(), 0xff);
+	CopyOpaquePixels(vImage.data(), vSource.data(), 33, 17);
+	EXPECT_EQ(vImage, vExpected);
+}
+
+TEST(ImageManipulation, ConvertToRgba)
+{
+	const CImageInfo::EImageFormat aFormats[] = {CImageInfo::FORMAT_RGB, CImageInfo::FORMAT_RA, CImageInfo::FORMAT_R};
+	for(const CImageInfo::EImageFormat Format : aFormats)
+	{
+		const int BPP = CImageInfo::PixelSize(Format);
+		std::vector<uint8_t> vSource = RandomImage(13, 7, BPP, BPP);
+		CImageInfo Image;
+		Image.m_Width = 13;
+		Image.m_Height = 7;
+		Image.m_Format = Format;
+		Image.m_pData = vSource.data();
+
+		std::vector<uint8_t> vExpected;
+		for(size_t i = 0; i < vSource.size(); i += BPP)
+		{
+			if(Format == CImageInfo::FORMAT_RGB)
+				vExpected.insert(vExpected.end(), {vSource[i], vSource[i + 1], vSource[i + 2], 255});
+			else if(Format == CImageInfo::FORMAT_RA)
+				vExpected.insert(vExpected.end(), {vSource[i], vSource[i], vSource[i], vSource[i + 1]});
+			else
+				vExpected.insert(vExpected.end(), {255, 255, 255, vSource[i]});
+		}
+
+		std::vector<uint8_t> vResult(vExpected.size());
+		EXPECT_FALSE(ConvertToRgba(vResult.data(), Image));
+		EXPECT_EQ(vResult, vExpected) << (int)Format;
+		Image.m_pData = nullptr;
+	}
+}
+
+TEST(ImageManipulation, ResizeImage)
+{
+	const int aaSizes[][4] = {{16, 16, 8, 8}, {16, 16, 37, 21}, {31, 9, 12, 30}, {1, 5, 4, 2}};
+	for(const auto &aSize : aaSizes)
+	{
+		for(int BPP = 1; BPP <= 4; BPP++)
+		{
+			const std::vector<uint8_t> vSource = RandomImage(aSize[0], aSize[1], BPP, BPP);
+			uint8_t *pResult = ResizeImage(vSource.data(), aSize[0], aSize[1], aSize[2], aSize[3], BPP);
+			const std::vector<uint8_t> vResult(pResult, pResult + (size_t)aSize[2] * aSize[3] * BPP);
+			free(pResult);
+			EXPECT_EQ(vResult, ReferenceResize(vSource.data(), aSize[0], aSize[1], aSize[2], aSize[3], BPP)) << aSize[0] << "x" << aSize[1] << " -> " << aSize[2] << "x" << aSize[3] << " BPP " << BPP;
+		}
+	}
+}
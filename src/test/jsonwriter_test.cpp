@@ -212,3 +212,31 @@ TYPED_TEST(JsonWriters, Small)
 	this->Impl.m_pJson->WriteIntValue(std::numeric_limits<int>::min());
 	this->Impl.Expect("-2147483648\n");
 }
+
+TYPED_TEST(JsonWriters, RawValue)
+{
+	CJsonStringWriter Inner(2);
+	Inner.BeginObject();
+	Inner.WriteAttribute("a");
+	Inner.WriteIntValue(1);
+	Inner.EndObject();
+	std::string InnerOutput = Inner.GetOutputString();
+	InnerOutput.pop_back(); // trailing newline
+
+	this->Impl.m_pJson->BeginObject();
+	this->Impl.m_pJson->WriteAttribute("raw");
+	this->Impl.m_pJson->BeginArray();
+	this->Impl.m_pJson->WriteRawValue(InnerOutput.c_str());
+	this->Impl.m_pJson->WriteRawValue("true");
+	this->Impl.m_pJson->EndArray();
+	this->Impl.m_pJson->EndObject();
+	this->Impl.Expect(
+		"{\n"
+		"\t\"raw\": [\n"
+		"\t\t{\n"
+		"\t\t\t\"a\": 1\n"
+		"\t\t},\n"
+		"\t\ttrue\n"
+		"\t]\n"
+		"}\n");
+}
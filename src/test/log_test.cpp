@@ -0,0 +1,120 @@
+#include <base/log.h>
+#include <base/logger.h>
+#include <base/str.h>
+
+#include <gtest/gtest.h>
+
+#include <cinttypes>
+#include <string>
+#include <thread>
+#include <vector>
+
+[[gnu::format(printf, 1, 2)]] static std::string Format(const char *pFormat, ...)
+{
+	char aBuf[4096];
+	va_list Args;
+	va_start(Args, pFormat);
+	str_format_v(aBuf, sizeof(aBuf), pFormat, Args);
+	va_end(Args);
+	return aBuf;
+}
+
+static std::vector<std::string> Messages(CMemoryLogger &Logger)
+{
+	std::vector<std::string> vMessages;
+	for(const CLogMessage &Message : Logger.Lines())
+		vMessages.emplace_back(Message.Message());
+	return vMessages;
+}
+
+TEST(LogDeferred, Formats)
+{
+	CMemoryLogger Logger;
+	CLogScope LogScope(&Logger);
+	std::vector<std::string> vExpected;
+	log_start_deferred(&Logger);
+
+	char aString[] = "changed after logging";
+	const char *pNull = nullptr;
+	int Value = 0;
+#define CHECK(...) \
+	do \
+	{ \
+		log_info("test", __VA_ARGS__); \
+		vExpected.push_back(Format(__VA_ARGS__)); \
+	} while(0)
+	CHECK("plain text");
+	CHECK("%d %i %u %x %X %o %%", -42, 7, 4000000000u, 0xbeefu, 0xbeefu, 8u);
+	CHECK("%hhd %hd %ld %lld %zu %" PRId64 " %" PRIu64, (signed char)-5, (short)-300, -70000L, -5000000000LL, (size_t)123, (int64_t)-1, (uint64_t)-1);
+	CHECK("%5d|%-5d|%05d|%+d|%*d|%-*d", 1, 2, 3, 4, 6, 5, 6, 6);
+	CHECK("%.2f %8.3e %g %a %f", 3.14159, 12345.678, 0.0001, 1.5, -0.0);
+	CHECK("%c%c %s %.3s %.*s %10s|%-10s|", 'o', 'k', aString, "truncated", 2, "star", "right", "left");
+	CHECK("%s", pNull);
+	CHECK("%p", (void *)&Value);
+	CHECK("ünïcödé %s", "ẃörds");
+	CHECK("%s", std::string(1000, 'x').c_str());
+	str_copy(aString, "xxx");
+
+	// formatted eagerly
+	CHECK("%2$s %1$s", "world", "hello");
+
+	log_stop_deferred();
+#undef CHECK
+	EXPECT_EQ(Messages(Logger), vExpected);
+}
+
+TEST(LogDeferred, Metadata)
+{
+	CMemoryLogger Logger;
+	CLogScope LogScope(&Logger);
+	log_start_deferred(&Logger);
+	log_log_color(LEVEL_WARN, LOG_COLOR{1, 2, 3}, "system", "message");
+	log_stop_deferred();
+
+	const std::vector<CLogMessage> vLines = Logger.Lines();
+	ASSERT_EQ(vLines.size(), 1u);
+	EXPECT_EQ(vLines[0].m_Level, LEVEL_WARN);
+	EXPECT_TRUE(vLines[0].m_HaveColor);
+	EXPECT_EQ(vLines[0].m_Color.b, 3);
+	EXPECT_STREQ(vLines[0].m_aSystem, "system");
+	EXPECT_STREQ(vLines[0].Message(), "message");
+	EXPECT_TRUE(str_endswith(vLines[0].m_aLine, " W system: message"));
+}
+
+TEST(LogDeferred, Threads)
+{
+	CMemoryLogger Logger;
+	log_start_deferred(&Logger);
+	const int NumThreads = 4;
+	const int NumMessages = 20000;
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NumThreads; t++)
+	{
+		vThreads.emplace_back([&, t]() {
+			CLogScope LogScope(&Logger);
+			for(int i = 0; i < NumMessages; i++)
+				log_info("test", "%d %d", t, i);
+		});
+	}
+	for(std::thread &Thread : vThreads)
+		Thread.join();
+	log_stop_deferred();
+
+	// messages of every thread arrive in order, dropped ones are reported
+	std::vector<int> vNext(NumThreads, 0);
+	int Received = 0;
+	for(const std::string &Message : Messages(Logger))
+	{
+		int Thread, Index;
+		if(sscanf(Message.c_str(), "%d %d", &Thread, &Index) != 2)
+		{
+			EXPECT_TRUE(str_startswith(Message.c_str(), "dropped ")) << Message;
+			continue;
+		}
+		ASSERT_TRUE(Thread >= 0 && Thread < NumThreads);
+		EXPECT_GT(Index, vNext[Thread] - 1);
+		vNext[Thread] = Index + 1;
+		Received++;
+	}
+	EXPECT_EQ(Received + (int)log_deferred_dropped(), NumThreads * NumMessages);
+}
@@ -0,0 +1,517 @@
+#include "gameworld_test.h"
+
+#include <base/time.h>
+
+#include <engine/server/map_transfer.h>
+#include <engine/server/server.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+static int64_t Ms(int64_t Milliseconds)
+{
+	return time_freq() * Milliseconds / 1000;
+}
+
+// Sends and acknowledges the chunks with a constant round trip time, returns
+// the time of the last acknowledgement
+static int64_t Simulate(CMapTransferWindow &Window, int NumChunks, int64_t Now, int64_t Rtt)
+{
+	std::deque<std::pair<int, int64_t>> vSent;
+	while(true)
+	{
+		int Chunk;
+		while((Chunk = Window.NextChunk(NumChunks)) >= 0)
+		{
+			Window.OnSent(Chunk, Now);
+			vSent.emplace_back(Chunk, Now);
+			EXPECT_LE(Window.InFlight(), std::max(Window.Window(), (int)CMapTransferWindow::MIN_WINDOW));
+		}
+		if(vSent.empty())
+			return Now;
+		Now = std::max(Now, vSent.front().second + Rtt);
+		Window.OnRequest(vSent.front().first + 1, 0, Now);
+		vSent.pop_front();
+	}
+}
+
+TEST(MapTransferWindow, Grow)
+{
+	CMapTransferWindow Window;
+	EXPECT_EQ(Window.NextChunk(100), -1);
+	Window.OnRequest(0, 4, 0);
+	EXPECT_TRUE(Window.Active());
+	EXPECT_EQ(Window.Window(), 4);
+	Simulate(Window, 200, 0, Ms(50));
+	EXPECT_EQ(Window.Window(), (int)CMapTransferWindow::MAX_WINDOW);
+	EXPECT_NEAR(Window.SmoothedRtt(), Ms(50), Ms(1));
+}
+
+TEST(MapTransferWindow, Backoff)
+{
+	CMapTransferWindow Window;
+	Window.OnRequest(0, CMapTransferWindow::MAX_WINDOW, 0);
+	int64_t Now = Simulate(Window, 100, 0, Ms(50));
+	EXPECT_EQ(Window.Window(), (int)CMapTransferWindow::MAX_WINDOW);
+
+	// the chunks queue up, the window shrinks at most once per round trip
+	Now = Simulate(Window, 101, Now, Ms(300));
+	EXPECT_EQ(Window.Window(), CMapTransferWindow::MAX_WINDOW * 7 / 10);
+	Now = Simulate(Window, 160, Now, Ms(300));
+	EXPECT_LT(Window.Window(), CMapTransferWindow::MAX_WINDOW * 7 / 10);
+	EXPECT_GE(Window.Window(), (int)CMapTransferWindow::MIN_WINDOW);
+	const int Shrunk = Window.Window();
+	Simulate(Window, 400, Now, Ms(50));
+	EXPECT_GT(Window.Window(), Shrunk);
+}
+
+TEST(MapTransferWindow, Restart)
+{
+	CMapTransferWindow Window;
+	Window.OnRequest(0, 8, 0);
+	for(int i = 0; i < 8; i++)
+		Window.OnSent(Window.NextChunk(100), 0);
+	EXPECT_EQ(Window.NextChunk(100), -1);
+	Window.OnRequest(1, 8, Ms(10));
+	EXPECT_EQ(Window.NextChunk(100), 8);
+
+	// the client started over
+	Window.OnRequest(0, 8, Ms(20));
+	EXPECT_EQ(Window.InFlight(), 0);
+	EXPECT_EQ(Window.NextChunk(100), 0);
+	EXPECT_EQ(Window.NextChunk(0), -1);
+
+	Window.Reset();
+	EXPECT_FALSE(Window.Active());
+	EXPECT_EQ(Window.NextChunk(100), -1);
+}
+
+TEST(MapTransferLimiter, Rate)
+{
+	CMapTransferLimiter Limiter;
+	EXPECT_TRUE(Limiter.Consume(1000, 0));
+	Limiter.SetRate(100000, 0);
+	EXPECT_TRUE(Limiter.Limited());
+	int64_t Sent = 0;
+	for(int64_t Now = 0; Now <= Ms(10000); Now += Ms(1))
+	{
+		while(Limiter.Consume(1000, Now))
+			Sent += 1000;
+	}
+	EXPECT_GE(Sent, 100000 * 10 - 1000);
+	EXPECT_LE(Sent, 100000 * 10 + 100000 / 10 + 1000);
+	Limiter.SetRate(0, 0);
+	EXPECT_FALSE(Limiter.Limited());
+}
+
+// Simulates a map download through a link with latency, seeded loss and a
+// bandwidth limit towards the client. Both sides deliver vital chunks like
+// CNetConnection: only the next sequence is accepted, a chunk after a gap is
+// dropped and makes the receiver request a resend of the whole unacknowledged
+// buffer, and the oldest unacknowledged chunk is resent after a second.
+class CSimulatedTransfer
+{
+	class CChunk
+	{
+	public:
+		int m_Sequence;
+		// the chunk index of map data or the requested chunk
+		int m_Data;
+	};
+
+	class CPacket
+	{
+	public:
+		std::vector<CChunk> m_vChunks;
+		int m_Ack;
+		bool m_Resend;
+		int64_t m_DeliverTime;
+	};
+
+	class CConnection
+	{
+		class CUnacked
+		{
+		public:
+			int m_Sequence;
+			int m_Data;
+			int64_t m_LastSendTime;
+		};
+
+		int m_Sequence = 0;
+		int m_Ack = 0;
+		bool m_AckPending = false;
+		bool m_ResendRequested = false;
+		int m_BufferSize = 0;
+		std::deque<CUnacked> m_vUnacked;
+		std::vector<CChunk> m_vQueued;
+
+	public:
+		int m_ChunkSize = 0;
+		int m_Resent = 0;
+		int m_Unbuffered = 0;
+
+		void Queue(int Data, int64_t Now)
+		{
+			m_Sequence++;
+			// like in CNetConnection the chunk is sent once and can never
+			// be resent if it does not fit into the resend buffer
+			if(m_BufferSize + m_ChunkSize <= NET_CONN_BUFFERSIZE)
+			{
+				m_vUnacked.push_back({m_Sequence, Data, Now});
+				m_BufferSize += m_ChunkSize;
+			}
+			else
+				m_Unbuffered++;
+			m_vQueued.push_back({m_Sequence, Data});
+		}
+
+		void Resend(int64_t Now)
+		{
+			for(CUnacked &Unacked : m_vUnacked)
+			{
+				m_vQueued.push_back({Unacked.m_Sequence, Unacked.m_Data});
+				Unacked.m_LastSendTime = Now;
+				m_Resent++;
+			}
+		}
+
+		void Update(int64_t Now)
+		{
+			if(!m_vUnacked.empty() && Now - m_vUnacked.front().m_LastSendTime > RESEND_MS)
+			{
+				m_vQueued.push_back({m_vUnacked.front().m_Sequence, m_vUnacked.front().m_Data});
+				m_vUnacked.front().m_LastSendTime = Now;
+				m_Resent++;
+			}
+		}
+
+		// Returns the data of the chunks delivered in order.
+		std::vector<int> Receive(const CPacket &Packet, int64_t Now)
+		{
+			while(!m_vUnacked.empty() && m_vUnacked.front().m_Sequence <= Packet.m_Ack)
+			{
+				m_vUnacked.pop_front();
+				m_BufferSize -= m_ChunkSize;
+			}
+			if(Packet.m_Resend)
+				Resend(Now);
+
+			std::vector<int> vData;
+			for(const CChunk &Chunk : Packet.m_vChunks)
+			{
+				if(Chunk.m_Sequence == m_Ack + 1)
+				{
+					m_Ack++;
+					vData.push_back(Chunk.m_Data);
+				}
+				else if(Chunk.m_Sequence > m_Ack)
+					m_ResendRequested = true;
+				m_AckPending = true;
+			}
+			return vData;
+		}
+
+		// Moves the queued chunks into packets of at most `ChunksPerPacket`
+		// chunks, sends a bare ack or resend request if nothing is queued.
+		std::vector<CPacket> Flush(int ChunksPerPacket)
+		{
+			std::vector<CPacket> vPackets;
+			for(size_t i = 0; i < m_vQueued.size(); i += ChunksPerPacket)
+			{
+				CPacket Packet;
+				Packet.m_vChunks.assign(m_vQueued.begin() + i, m_vQueued.begin() + std::min(m_vQueued.size(), i + ChunksPerPacket));
+				vPackets.push_back(Packet);
+			}
+			if(vPackets.empty() && (m_AckPending || m_ResendRequested))
+				vPackets.emplace_back();
+			for(CPacket &Packet : vPackets)
+			{
+				Packet.m_Ack = m_Ack;
+				Packet.m_Resend = m_ResendRequested;
+			}
+			m_vQueued.clear();
+			m_AckPending = false;
+			m_ResendRequested = false;
+			return vPackets;
+		}
+	};
+
+	std::mt19937 m_Rng{0};
+	int64_t m_ClientLinkFreeUs = 0;
+	std::vector<CPacket> m_vToClient;
+	std::vector<CPacket> m_vToServer;
+
+	bool Lost()
+	{
+		if((int)(m_Rng() % 100) >= m_LossPercent)
+			return false;
+		m_Dropped++;
+		return true;
+	}
+
+	void SendToServer(CPacket Packet, int64_t Now)
+	{
+		if(Lost())
+			return;
+		Packet.m_DeliverTime = Now + m_LatencyMs;
+		m_vToServer.push_back(Packet);
+	}
+
+	void SendToClient(CPacket Packet, int64_t Now)
+	{
+		int64_t DepartTime = Now;
+		if(m_BytesPerSecond)
+		{
+			const int Queued = std::count_if(m_vToClient.begin(), m_vToClient.end(), [&](const CPacket &Queue) {
+				return Queue.m_DeliverTime - m_LatencyMs > Now;
+			});
+			if(Queued >= m_QueuePackets)
+			{
+				m_Dropped++;
+				return;
+			}
+			const int Size = NET_PACKETHEADERSIZE + Packet.m_vChunks.size() * (NET_MAX_CHUNKHEADERSIZE + CHUNK_SIZE);
+			m_ClientLinkFreeUs = std::max(Now * 1000, m_ClientLinkFreeUs) + Size * 1000000 / m_BytesPerSecond;
+			DepartTime = (m_ClientLinkFreeUs + 999) / 1000;
+		}
+		if(Lost())
+			return;
+		Packet.m_DeliverTime = DepartTime + m_LatencyMs;
+		m_vToClient.push_back(Packet);
+	}
+
+	// Removes the packets due at `Now` from `vPackets` and returns them in
+	// the order they were sent.
+	static std::vector<CPacket> Due(std::vector<CPacket> &vPackets, int64_t Now)
+	{
+		std::vector<CPacket> vDue;
+		for(const CPacket &Packet : vPackets)
+			if(Packet.m_DeliverTime <= Now)
+				vDue.push_back(Packet);
+		vPackets.erase(std::remove_if(vPackets.begin(), vPackets.end(), [Now](const CPacket &Packet) { return Packet.m_DeliverTime <= Now; }), vPackets.end());
+		return vDue;
+	}
+
+public:
+	enum
+	{
+		CHUNK_SIZE = NET_MAX_CHUNK_SIZE - 128,
+		RESEND_MS = 1000,
+	};
+
+	int m_LatencyMs = 0;
+	int m_LossPercent = 0;
+	int64_t m_BytesPerSecond = 0;
+	int m_QueuePackets = 0;
+	int m_Dropped = 0;
+	int m_Resent = 0;
+	int m_Unbuffered = 0;
+	int m_MinWindow = CMapTransferWindow::MAX_WINDOW;
+	int m_MaxWindow = 0;
+
+	// Returns the simulated duration in milliseconds or -1 if the download
+	// did not finish within a minute.
+	int64_t Run(int NumChunks)
+	{
+		CMapTransferWindow Window;
+		CConnection Server;
+		CConnection Client;
+		Server.m_ChunkSize = CHUNK_SIZE;
+		Client.m_ChunkSize = 8;
+		Client.Queue(0, 0);
+		for(int64_t Now = 0; Now < 60 * 1000; Now++)
+		{
+			for(const CPacket &Packet : Due(m_vToServer, Now))
+				for(int Chunk : Server.Receive(Packet, Now))
+					Window.OnRequest(Chunk, 15, Ms(Now));
+			int Chunk;
+			while((Chunk = Window.NextChunk(NumChunks)) >= 0)
+			{
+				Server.Queue(Chunk, Now);
+				Window.OnSent(Chunk, Ms(Now));
+				m_MinWindow = std::min(m_MinWindow, Window.Window());
+				m_MaxWindow = std::max(m_MaxWindow, Window.Window());
+			}
+			Server.Update(Now);
+			// a map chunk fills a packet
+			for(const CPacket &Packet : Server.Flush(1))
+				SendToClient(Packet, Now);
+
+			for(const CPacket &Packet : Due(m_vToClient, Now))
+			{
+				// the client requests the next chunk after every received one
+				for(int Received : Client.Receive(Packet, Now))
+				{
+					if(Received + 1 == NumChunks)
+					{
+						m_Resent = Server.m_Resent + Client.m_Resent;
+						m_Unbuffered = Server.m_Unbuffered + Client.m_Unbuffered;
+						return Now;
+					}
+					Client.Queue(Received + 1, Now);
+				}
+			}
+			Client.Update(Now);
+			for(const CPacket &Packet : Client.Flush(NET_MAX_PAYLOAD / 16))
+				SendToServer(Packet, Now);
+		}
+		return -1;
+	}
+};
+
+TEST(MapTransferSimulation, Latency)
+{
+	CSimulatedTransfer Transfer;
+	Transfer.m_LatencyMs = 25;
+	EXPECT_GT(Transfer.Run(200), 0);
+	EXPECT_EQ(Transfer.m_MaxWindow, (int)CMapTransferWindow::MAX_WINDOW);
+	EXPECT_EQ(Transfer.m_Resent, 0);
+	EXPECT_EQ(Transfer.m_Unbuffered, 0);
+}
+
+TEST(MapTransferSimulation, Loss)
+{
+	CSimulatedTransfer Transfer;
+	Transfer.m_LatencyMs = 10;
+	Transfer.m_LossPercent = 2;
+	EXPECT_GT(Transfer.Run(200), 0);
+	EXPECT_GT(Transfer.m_Dropped, 0);
+	EXPECT_GT(Transfer.m_Resent, 0);
+	EXPECT_EQ(Transfer.m_Unbuffered, 0);
+}
+
+TEST(MapTransferSimulation, SlowClient)
+{
+	// the window shrinks before the link towards the client overflows
+	CSimulatedTransfer Transfer;
+	Transfer.m_LatencyMs = 10;
+	Transfer.m_BytesPerSecond = 256 * 1024;
+	Transfer.m_QueuePackets = 12;
+	EXPECT_GT(Transfer.Run(200), 0);
+	EXPECT_LT(Transfer.m_MinWindow, Transfer.m_QueuePackets);
+	EXPECT_EQ(Transfer.m_Unbuffered, 0);
+}
+
+// Feeds map data requests of a connecting client through the server.
+class CTestMapTransfer : public CTestGameWorld
+{
+public:
+	int m_FastDownload;
+	int m_WindowAdaptive;
+	int m_Window;
+	int m_DownloadRate;
+
+	CTestMapTransfer()
+	{
+		CConfig *pConfig = m_pServer->Config();
+		m_FastDownload = pConfig->m_SvFastDownload;
+		m_WindowAdaptive = pConfig->m_SvMapWindowAdaptive;
+		m_Window = pConfig->m_SvMapWindow;
+		m_DownloadRate = pConfig->m_SvMapDownloadRate;
+		pConfig->m_SvFastDownload = 1;
+		pConfig->m_SvMapWindowAdaptive = 1;
+		pConfig->m_SvMapWindow = 2;
+		pConfig->m_SvMapDownloadRate = 0;
+	}
+
+	~CTestMapTransfer() override
+	{
+		CConfig *pConfig = m_pServer->Config();
+		pConfig->m_SvFastDownload = m_FastDownload;
+		pConfig->m_SvMapWindowAdaptive = m_WindowAdaptive;
+		pConfig->m_SvMapWindow = m_Window;
+		pConfig->m_SvMapDownloadRate = m_DownloadRate;
+	}
+
+	void Connect(int ClientId)
+	{
+		m_pServer->AddDebugClient(ClientId, false);
+		m_pServer->m_aClients[ClientId].m_State = CServer::CClient::STATE_CONNECTING;
+	}
+
+	void Request(int ClientId, int Chunk)
+	{
+		// system message id and flag like the client packs them
+		CPacker Msg;
+		Msg.Reset();
+		Msg.AddInt((NETMSG_REQUEST_MAP_DATA << 1) | 1);
+		Msg.AddInt(Chunk);
+		CNetChunk Packet;
+		Packet.m_ClientId = ClientId;
+		Packet.m_Address = NETADDR_ZEROED;
+		Packet.m_Flags = NET_CHUNKFLAG_VITAL;
+		Packet.m_DataSize = Msg.Size();
+		Packet.m_pData = Msg.Data();
+		m_pServer->ProcessClientPacket(&Packet);
+	}
+
+	const CMapTransferWindow &Transfer(int ClientId) const
+	{
+		return m_pServer->m_aClients[ClientId].m_MapTransfer;
+	}
+
+	int NumChunks() const
+	{
+		const int ChunkSize = NET_MAX_CHUNK_SIZE - 128;
+		return (m_pServer->m_aCurrentMapSize[CServer::MAP_TYPE_SIX] + ChunkSize - 1) / ChunkSize;
+	}
+};
+
+TEST_F(CTestMapTransfer, Pump)
+{
+	Connect(0);
+	Request(0, 0);
+	EXPECT_TRUE(Transfer(0).Active());
+	// the request only starts the transfer, the pump sends the window
+	EXPECT_EQ(Transfer(0).InFlight(), 0);
+	m_pServer->PumpMapTransfers();
+	EXPECT_EQ(Transfer(0).InFlight(), std::min(2, NumChunks()));
+	EXPECT_EQ(Transfer(0).NextChunk(NumChunks()), -1);
+
+	for(int Chunk = 1; Chunk < NumChunks(); Chunk++)
+	{
+		Request(0, Chunk);
+		m_pServer->PumpMapTransfers();
+		EXPECT_EQ(Transfer(0).NextChunk(NumChunks()), -1);
+		EXPECT_GE(Transfer(0).InFlight(), std::min(2, NumChunks() - Chunk));
+	}
+	EXPECT_EQ(Transfer(0).InFlight(), 1);
+}
+
+TEST_F(CTestMapTransfer, PumpOnlyConnecting)
+{
+	Connect(0);
+	Connect(1);
+	Request(0, 0);
+	Request(1, 0);
+	m_pServer->m_aClients[1].m_State = CServer::CClient::STATE_READY;
+	m_pServer->PumpMapTransfers();
+	EXPECT_EQ(Transfer(0).InFlight(), std::min(2, NumChunks()));
+	EXPECT_EQ(Transfer(1).InFlight(), 0);
+}
+
+TEST_F(CTestMapTransfer, PumpRateLimit)
+{
+	// the bucket starts empty
+	m_pServer->Config()->m_SvMapDownloadRate = 1;
+	Connect(0);
+	Request(0, 0);
+	m_pServer->PumpMapTransfers();
+	EXPECT_EQ(Transfer(0).InFlight(), 0);
+}
+
+TEST_F(CTestMapTransfer, RequestWithoutAdaptiveWindow)
+{
+	m_pServer->Config()->m_SvMapWindowAdaptive = 0;
+	Connect(0);
+	Request(0, 0);
+	EXPECT_FALSE(Transfer(0).Active());
+}
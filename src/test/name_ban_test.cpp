@@ -2,6 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <string>
+
 TEST(NameBan, Empty)
 {
 	CNameBans Bans;
@@ -78,3 +82,68 @@ TEST(NameBan, UnbanNotFound)
 	CNameBans Bans;
 	Bans.Unban("abc");
 }
+
+TEST(NameBan, MatchesLinearSearch)
+{
+	// names from a small alphabet, so that many of them are close to each other
+	const char *apParts[] = {"a", "b", "A", "B", "l", "I", "0", "O", "ä", " ", "ab", "xy"};
+	std::mt19937 Rng(1);
+	const auto &&RandomName = [&](int MaxParts) {
+		std::string Name;
+		const int NumParts = Rng() % (MaxParts + 1);
+		for(int i = 0; i < NumParts; i++)
+			Name += apParts[Rng() % std::size(apParts)];
+		return Name;
+	};
+
+	CNameBans Bans;
+	std::vector<CNameBan> vReference;
+	for(int Round = 0; Round < 500; Round++)
+	{
+		const std::string Name = RandomName(6);
+		if(Rng() % 4 == 0)
+		{
+			Bans.Unban(Name.c_str());
+			vReference.erase(std::remove_if(vReference.begin(), vReference.end(), [&](const CNameBan &Ban) { return Name == Ban.m_aName; }), vReference.end());
+		}
+		else
+		{
+			const int Distance = (int)(Rng() % 4) - 1;
+			const bool IsSubstring = Rng() % 3 == 0;
+			Bans.Ban(Name.c_str(), "", Distance, IsSubstring);
+			auto It = std::find_if(vReference.begin(), vReference.end(), [&](const CNameBan &Ban) { return Name == Ban.m_aName; });
+			if(It == vReference.end())
+				vReference.emplace_back(Name.c_str(), "", Distance, IsSubstring);
+			else
+			{
+				It->m_Distance = Distance;
+				It->m_IsSubstring = IsSubstring;
+			}
+		}
+
+		for(int Query = 0; Query < 10; Query++)
+		{
+			const std::string Player = RandomName(8);
+			char aTrimmed[MAX_NAME_LENGTH];
+			str_copy(aTrimmed, str_utf8_skip_whitespaces(Player.c_str()));
+			str_utf8_trim_right(aTrimmed);
+			int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+			const int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+			int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+			const CNameBan *pExpected = nullptr;
+			for(const CNameBan &Ban : vReference)
+			{
+				if(str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer)) <= Ban.m_Distance ||
+					(Ban.m_IsSubstring && str_utf8_find_nocase(Player.c_str(), Ban.m_aName)))
+					pExpected = &Ban;
+			}
+
+			const CNameBan *pBan = Bans.IsBanned(Player.c_str());
+			ASSERT_EQ(pBan != nullptr, pExpected != nullptr) << "'" << Player << "'";
+			if(pBan)
+			{
+				EXPECT_STREQ(pBan->m_aName, pExpected->m_aName) << "'" << Player << "'";
+			}
+		}
+	}
+}
@@ -1,7 +1,21 @@
+#include "gameworld_test.h"
+
+#include <engine/message.h>
+#include <engine/server/register.h>
 #include <engine/server/server.h>
+#include <engine/shared/jsonwriter.h>
+#include <engine/shared/masterserver.h>
+#include <engine/shared/packer.h>
+
+#include <generated/protocol7.h>
+
+#include <game/server/player.h>
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 TEST(Server, StrHideIps)
 {
 	char aLine[512];
@@ -59,3 +73,219 @@ TEST(Server, StrHideIps)
 	EXPECT_STREQ(aLine, "<{<{a}>}>");
 	EXPECT_STREQ(aLineWithoutIps, "XXX}>}>");
 }
+
+class CTestServerInfoRegister : public IRegister
+{
+public:
+	void Update() override {}
+	void OnConfigChange() override {}
+	bool OnPacket(const CNetChunk *pPacket) override { return false; }
+	void OnNewInfo(const char *pInfo) override { m_Info = pInfo; }
+	void OnShutdown() override {}
+
+	std::string m_Info;
+};
+
+class CTestServerInfo : public CTestGameWorld
+{
+public:
+	CTestServerInfoRegister *m_pRegister;
+
+	CTestServerInfo()
+	{
+		// owned by the server
+		m_pRegister = new CTestServerInfoRegister();
+		m_pServer->m_pRegister = m_pRegister;
+	}
+
+	void AddClient(int ClientId, bool Sixup, const char *pName, const char *pClan, int Country)
+	{
+		CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+		m_pServer->AddDebugClient(ClientId, Sixup);
+		// debug dummies are not part of the server info
+		Client.m_DebugDummy = false;
+		GameServer()->OnClientConnected(ClientId, nullptr);
+		Client.m_State = CServer::CClient::STATE_INGAME;
+		m_pServer->SetClientName(ClientId, pName);
+		m_pServer->SetClientClan(ClientId, pClan);
+		m_pServer->SetClientCountry(ClientId, Country);
+		GameServer()->OnClientEnter(ClientId);
+	}
+
+	// client entry like the server info packed all clients before they had their own entries
+	void PackClient(CPacker &Packer, int ClientId, bool Extended)
+	{
+		const CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+		char aBuf[16];
+		Packer.AddString(m_pServer->ClientName(ClientId), MAX_NAME_LENGTH);
+		Packer.AddString(m_pServer->ClientClan(ClientId), MAX_CLAN_LENGTH);
+		str_format(aBuf, sizeof(aBuf), "%d", Client.m_Country);
+		Packer.AddString(aBuf, 0);
+		int Score = FinishTime::NOT_FINISHED_TIMESCORE;
+		if(Client.m_Score.has_value())
+		{
+			Score = Client.m_Score.value();
+			if(Score == -FinishTime::NOT_FINISHED_TIMESCORE)
+				Score = FinishTime::NOT_FINISHED_TIMESCORE - 1;
+			else if(Score == 0)
+				Score = -1;
+			else
+				Score = -Score;
+		}
+		str_format(aBuf, sizeof(aBuf), "%d", Score);
+		Packer.AddString(aBuf, 0);
+		Packer.AddString(GameServer()->IsClientPlayer(ClientId) ? "1" : "0", 0);
+		if(Extended)
+			Packer.AddString("", 0); // extra info, reserved
+	}
+
+	std::vector<std::vector<uint8_t>> ExpectedServerInfo(int Type)
+	{
+		// the info without clients is unaffected by the entries and starts the first packet
+		std::vector<uint8_t> vPrefix = m_pServer->m_aServerInfoCache[Type * 2].m_vCache.front().m_vData;
+		if(Type == SERVERINFO_64_LEGACY)
+			vPrefix.pop_back(); // offset 0
+
+		std::vector<std::vector<uint8_t>> vvChunks;
+		CPacker Packer;
+		Packer.Reset();
+		Packer.AddRaw(vPrefix.data(), vPrefix.size());
+		if(Type == SERVERINFO_64_LEGACY)
+			Packer.AddInt(0);
+
+		int NumStored = 0;
+		int NumInChunk = 0;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_pServer->m_aClients[i].IncludedInServerInfo())
+				continue;
+			if(Type == SERVERINFO_VANILLA && NumStored == VANILLA_MAX_CLIENTS)
+				break;
+			if(Type == SERVERINFO_64_LEGACY && NumInChunk == 24)
+			{
+				vvChunks.emplace_back(Packer.Data(), Packer.Data() + Packer.Size());
+				Packer.Reset();
+				Packer.AddRaw(vPrefix.data(), vPrefix.size());
+				Packer.AddInt(NumStored);
+				NumInChunk = 0;
+			}
+			const int PreviousSize = Packer.Size();
+			PackClient(Packer, i, Type == SERVERINFO_EXTENDED);
+			if(Type == SERVERINFO_EXTENDED && Packer.Size() >= NET_MAX_PAYLOAD - 18)
+			{
+				vvChunks.emplace_back(Packer.Data(), Packer.Data() + PreviousSize);
+				Packer.Reset();
+				char aBuf[16];
+				str_format(aBuf, sizeof(aBuf), "%d", (int)vvChunks.size());
+				Packer.AddString(aBuf, 0);
+				Packer.AddString("", 0); // extra info, reserved
+				PackClient(Packer, i, true);
+			}
+			NumStored++;
+			NumInChunk++;
+		}
+		vvChunks.emplace_back(Packer.Data(), Packer.Data() + Packer.Size());
+		return vvChunks;
+	}
+
+	std::string ExpectedRegisterClients()
+	{
+		CJsonStringWriter JsonWriter;
+		JsonWriter.BeginObject();
+		JsonWriter.WriteAttribute("clients");
+		JsonWriter.BeginArray();
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_pServer->m_aClients[i].IncludedInServerInfo())
+				continue;
+			JsonWriter.BeginObject();
+			JsonWriter.WriteAttribute("name");
+			JsonWriter.WriteStrValue(m_pServer->ClientName(i));
+			JsonWriter.WriteAttribute("clan");
+			JsonWriter.WriteStrValue(m_pServer->ClientClan(i));
+			JsonWriter.WriteAttribute("country");
+			JsonWriter.WriteIntValue(m_pServer->m_aClients[i].m_Country);
+			JsonWriter.WriteAttribute("score");
+			JsonWriter.WriteIntValue(m_pServer->m_aClients[i].m_Score.value_or(FinishTime::NOT_FINISHED_TIMESCORE));
+			JsonWriter.WriteAttribute("is_player");
+			JsonWriter.WriteBoolValue(GameServer()->IsClientPlayer(i));
+			GameServer()->OnUpdatePlayerServerInfo(&JsonWriter, i);
+			JsonWriter.EndObject();
+		}
+		JsonWriter.EndArray();
+		JsonWriter.EndObject();
+		return JsonWriter.GetOutputString();
+	}
+
+	void ExpectServerInfo()
+	{
+		m_pServer->UpdateServerInfo(false);
+
+		for(int Type : {SERVERINFO_VANILLA, SERVERINFO_64_LEGACY, SERVERINFO_EXTENDED})
+		{
+			const std::vector<std::vector<uint8_t>> vvExpected = ExpectedServerInfo(Type);
+			const std::vector<CServer::CCache::CCacheChunk> &vActual = m_pServer->m_aServerInfoCache[Type * 2 + 1].m_vCache;
+			ASSERT_EQ(vActual.size(), vvExpected.size()) << "Type=" << Type;
+			for(size_t i = 0; i < vvExpected.size(); i++)
+				EXPECT_EQ(vActual[i].m_vData, vvExpected[i]) << "Type=" << Type << " Chunk=" << i;
+		}
+
+		// compare the clients array, which is the end of the register info
+		const std::string Expected = ExpectedRegisterClients();
+		const char *pClients = "\t\"clients\": [";
+		const size_t ActualStart = m_pRegister->m_Info.find(pClients);
+		ASSERT_NE(ActualStart, std::string::npos);
+		EXPECT_EQ(m_pRegister->m_Info.substr(ActualStart), Expected.substr(Expected.find(pClients)));
+	}
+
+	void ChangeSkin7(int ClientId, const char *pBody)
+	{
+		protocol7::CNetMsg_Cl_SkinChange Msg;
+		const char *apSkinPartNames[protocol7::NUM_SKINPARTS] = {pBody, "", "", "standard", "standard", "standard"};
+		for(int Part = 0; Part < protocol7::NUM_SKINPARTS; Part++)
+		{
+			Msg.m_apSkinPartNames[Part] = apSkinPartNames[Part];
+			Msg.m_aUseCustomColors[Part] = 0;
+			Msg.m_aSkinPartColors[Part] = 0;
+		}
+		CMsgPacker Packer(&Msg);
+		Msg.Pack(&Packer);
+		CUnpacker Unpacker;
+		Unpacker.Reset(Packer.Data(), Packer.Size());
+		GameServer()->m_apPlayers[ClientId]->m_LastChangeInfo = 0;
+		GameServer()->OnMessage(protocol7::NETMSGTYPE_CL_SKINCHANGE, &Unpacker, ClientId);
+	}
+};
+
+TEST_F(CTestServerInfo, SplicedEntries)
+{
+	char aName[MAX_NAME_LENGTH];
+	char aClan[MAX_CLAN_LENGTH];
+	// enough clients to split the legacy and extended info into several packets
+	for(int i = 0; i < 60; i++)
+	{
+		str_format(aName, sizeof(aName), "%s %d", i % 4 == 0 ? "Long player" : "Player", i);
+		str_format(aClan, sizeof(aClan), "%s", i % 3 == 0 ? "" : "Clan name");
+		AddClient(i, i % 5 == 0, aName, aClan, i % 2 == 0 ? -1 : 276);
+		if(i % 7 == 0)
+			m_pServer->SetClientScore(i, i * 100);
+		else if(i % 7 == 1)
+			m_pServer->SetClientScore(i, 0);
+	}
+	GameServer()->m_apPlayers[3]->SetTeam(TEAM_SPECTATORS, false);
+	ExpectServerInfo();
+
+	m_pServer->SetClientName(1, "Renamed");
+	m_pServer->SetClientClan(2, "New clan");
+	m_pServer->SetClientCountry(4, 40);
+	m_pServer->SetClientScore(6, -FinishTime::NOT_FINISHED_TIMESCORE);
+	GameServer()->m_apPlayers[8]->SetTeam(TEAM_SPECTATORS, false);
+	GameServer()->m_apPlayers[3]->SetTeam(TEAM_GAME, false);
+	ChangeSkin7(10, "kitty");
+	CServer::DelClientCallback(12, "Leaving", m_pServer);
+	ExpectServerInfo();
+
+	AddClient(12, true, "Rejoined", "", 0);
+	ChangeSkin7(15, "bear");
+	ExpectServerInfo();
+}
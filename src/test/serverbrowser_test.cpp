@@ -1,16 +1,22 @@
 #include "test.h"
 
+#include <base/mem.h>
 #include <base/net.h>
 
+#include <engine/client/serverbrowser.h>
+#include <engine/client/serverbrowser_http.h>
 #include <engine/client/serverbrowser_ping_cache.h>
 #include <engine/console.h>
 #include <engine/engine.h>
+#include <engine/favorites.h>
+#include <engine/friends.h>
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 TEST(ServerBrowser, PingCache)
 {
@@ -102,3 +108,258 @@ TEST(ServerBrowser, PingCache)
 	EXPECT_EQ(pPingCache->GetPing(&OtherLocalhost4, 1), 1337);
 	EXPECT_EQ(pPingCache->GetPing(&OtherLocalhost6, 1), 345);
 }
+
+TEST(ServerBrowser, SearchKeys)
+{
+	CServerInfo Info;
+	mem_zero(&Info, sizeof(Info));
+	str_copy(Info.m_aName, "HideRemake | ÄÖÜ Ⱥrena");
+	str_copy(Info.m_aMap, "Multeasymap");
+	str_copy(Info.m_aGameType, "Hide&Seek");
+	Info.m_NumClients = 2;
+	str_copy(Info.m_aClients[0].m_aName, "nameless tee");
+	str_copy(Info.m_aClients[0].m_aClan, "ΣΑΣ");
+	str_copy(Info.m_aClients[1].m_aName, "(connecting)");
+
+	CServerSearchKeys Keys;
+	Keys.Update(Info);
+	ASSERT_EQ(Keys.m_vClientNames.size(), 2u);
+	ASSERT_EQ(Keys.m_vClientClans.size(), 2u);
+
+	const char *apNeedles[] = {"hide", "HIDE", "äöü", "ⱥRENA", "ȺRENA", "remake |", "arena", "map", "MULTEASYMAP", "&seek", "TEE", "σας", "(Connecting)", "x"};
+	for(const char *pNeedle : apNeedles)
+	{
+		char aFolded[128];
+		str_utf8_tolower(pNeedle, aFolded, sizeof(aFolded));
+		EXPECT_EQ(CServerSearchKeys::Matches(Keys.m_aName, aFolded), str_utf8_find_nocase(Info.m_aName, pNeedle) != nullptr) << pNeedle;
+		EXPECT_EQ(CServerSearchKeys::Matches(Keys.m_aMap, aFolded), str_utf8_find_nocase(Info.m_aMap, pNeedle) != nullptr) << pNeedle;
+		EXPECT_EQ(CServerSearchKeys::Matches(Keys.m_aGameType, aFolded), str_utf8_find_nocase(Info.m_aGameType, pNeedle) != nullptr) << pNeedle;
+		for(int p = 0; p < Info.m_NumClients; p++)
+		{
+			EXPECT_EQ(CServerSearchKeys::Matches(Keys.m_vClientNames[p].c_str(), aFolded), str_utf8_find_nocase(Info.m_aClients[p].m_aName, pNeedle) != nullptr) << pNeedle;
+			EXPECT_EQ(CServerSearchKeys::Matches(Keys.m_vClientClans[p].c_str(), aFolded), str_utf8_find_nocase(Info.m_aClients[p].m_aClan, pNeedle) != nullptr) << pNeedle;
+		}
+	}
+}
+
+class CTestFriends : public IFriends
+{
+public:
+	void Init(bool Foes) override {}
+	int NumFriends() const override { return 0; }
+	const CFriendInfo *GetFriend(int Index) const override { return nullptr; }
+	int GetFriendState(const char *pName, const char *pClan) const override { return str_comp(pName, "friend") == 0 ? FRIEND_PLAYER : FRIEND_NO; }
+	bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const override { return GetFriendState(pName, pClan) != FRIEND_NO; }
+	void AddFriend(const char *pName, const char *pClan) override {}
+	void RemoveFriend(const char *pName, const char *pClan) override {}
+};
+
+class CTestFavorites : public IFavorites
+{
+public:
+	void OnConfigSave(IConfigManager *pConfigManager) override {}
+	TRISTATE IsFavorite(const NETADDR *pAddrs, int NumAddrs) const override { return TRISTATE::NONE; }
+	TRISTATE IsPingAllowed(const NETADDR *pAddrs, int NumAddrs) const override { return TRISTATE::NONE; }
+	void Add(const NETADDR *pAddrs, int NumAddrs) override {}
+	void AllowPing(const NETADDR *pAddrs, int NumAddrs, bool AllowPing) override {}
+	void Remove(const NETADDR *pAddrs, int NumAddrs) override {}
+	void AllEntries(const CEntry **ppEntries, int *pNumEntries) override { *pNumEntries = 0; }
+};
+
+class CTestServerBrowserView : public CServerBrowser
+{
+	CTestFriends m_Friends;
+	CTestFavorites m_Favorites;
+
+public:
+	CTestServerBrowserView()
+	{
+		m_pFriends = &m_Friends;
+		m_pFavorites = &m_Favorites;
+	}
+
+	void AddServer(int Port)
+	{
+		NETADDR Addr;
+		ASSERT_FALSE(net_addr_from_str(&Addr, "127.0.0.1"));
+		Addr.port = Port;
+		Add(&Addr, 1);
+	}
+
+	void SetServerInfo(int ServerIndex, const CServerInfo &Info)
+	{
+		SetInfo(m_vpServerlist[ServerIndex], Info);
+		MarkDirty(m_vpServerlist[ServerIndex]);
+	}
+
+	void FullSort() { Sort(); }
+	void IncrementalSort() { UpdateDirty(); }
+
+	std::vector<int> SortedServers() const
+	{
+		std::vector<int> vServers;
+		for(int i = 0; i < NumSortedServers(); i++)
+			vServers.push_back(SortedGet(i)->m_ServerIndex);
+		return vServers;
+	}
+};
+
+TEST(ServerBrowser, IncrementalSort)
+{
+	static const char *const s_apNames[] = {"alpha", "beta", "gamma", "Alpha", "friend"};
+	unsigned Seed = 1;
+	auto &&Random = [&Seed](int Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 16) % Max);
+	};
+	auto &&RandomInfo = [&](int Index) {
+		CServerInfo Info;
+		mem_zero(&Info, sizeof(Info));
+		Info.m_ServerIndex = Index;
+		str_copy(Info.m_aName, s_apNames[Random(4)]);
+		str_copy(Info.m_aMap, s_apNames[Random(4)]);
+		str_copy(Info.m_aGameType, Random(2) ? "DM" : "DDraceNetwork");
+		Info.m_Latency = Random(5) * 50;
+		Info.m_Flags = Random(4) == 0 ? SERVER_FLAG_PASSWORD : 0;
+		Info.m_MaxClients = Info.m_MaxPlayers = 8;
+		Info.m_NumClients = Random(9);
+		Info.m_NumPlayers = Random(Info.m_NumClients + 1);
+		Info.m_NumReceivedClients = Info.m_NumClients;
+		for(int c = 0; c < Info.m_NumClients; c++)
+		{
+			str_copy(Info.m_aClients[c].m_aName, s_apNames[Random(5)]);
+			Info.m_aClients[c].m_Player = c < Info.m_NumPlayers;
+		}
+		return Info;
+	};
+
+	const CConfig DefaultConfig = g_Config;
+	for(int Sort = IServerBrowser::SORT_NAME; Sort <= IServerBrowser::SORT_NUMFRIENDS; Sort++)
+	{
+		for(int Variant = 0; Variant < 4; Variant++)
+		{
+			g_Config.m_BrSort = Sort;
+			g_Config.m_BrSortOrder = Variant & 1;
+			g_Config.m_BrFilterEmpty = Variant & 2 ? 1 : 0;
+			g_Config.m_BrFilterPw = Variant & 2 ? 1 : 0;
+			str_copy(g_Config.m_BrFilterString, Variant == 3 ? "a" : "");
+			// a lone quote or an empty pair of quotes is ignored
+			str_copy(g_Config.m_BrExcludeString, Variant == 3 ? "\"beta\";\";\"\"" : "");
+
+			// the incremental view receives only the changes, the other one is sorted from scratch
+			CTestServerBrowserView Incremental;
+			CTestServerBrowserView Full;
+			const int NumServers = 64;
+			for(int i = 0; i < NumServers; i++)
+			{
+				const CServerInfo Info = RandomInfo(i);
+				Incremental.AddServer(8303 + i);
+				Full.AddServer(8303 + i);
+				Incremental.SetServerInfo(i, Info);
+				Full.SetServerInfo(i, Info);
+			}
+			Incremental.FullSort();
+
+			for(int Round = 0; Round < 20; Round++)
+			{
+				const int NumChanges = 1 + Random(8);
+				for(int Change = 0; Change < NumChanges; Change++)
+				{
+					const int ServerIndex = Random(NumServers);
+					const CServerInfo Info = RandomInfo(ServerIndex);
+					Incremental.SetServerInfo(ServerIndex, Info);
+					Full.SetServerInfo(ServerIndex, Info);
+				}
+				Incremental.IncrementalSort();
+				Full.FullSort();
+				ASSERT_EQ(Incremental.SortedServers(), Full.SortedServers()) << "sort=" << Sort << " variant=" << Variant << " round=" << Round;
+				ASSERT_EQ(Incremental.NumSortedPlayers(), Full.NumSortedPlayers()) << "sort=" << Sort << " variant=" << Variant << " round=" << Round;
+			}
+		}
+	}
+	g_Config = DefaultConfig;
+}
+
+static bool ParseServerList(const char *pList, size_t PartSize, std::vector<CServerInfo> *pvServers)
+{
+	CServerListParser Parser;
+	const size_t Length = str_length(pList);
+	for(size_t Offset = 0; Offset < Length; Offset += PartSize)
+	{
+		if(Parser.Feed(pList + Offset, minimum(PartSize, Length - Offset)))
+		{
+			return true;
+		}
+	}
+	if(Parser.Finish())
+	{
+		return true;
+	}
+	*pvServers = Parser.Servers();
+	return false;
+}
+
+TEST(ServerBrowser, ServerListParser)
+{
+	const char *pList = R"({
+		"unrelated": [{"servers": 1}, "]", -1.5e3, true],
+		"servers": [
+			{
+				"addresses": ["tw-0.6+udp://127.0.0.1:8303", "tw-0.7+udp://127.0.0.1:8303"],
+				"location": "eu",
+				"info": {"max_clients": 64, "max_players": 64, "passworded": false, "game_type": "hide\\\"seek", "name": "HideRemake {1}", "map": {"name": "Multeasymap"}, "version": "0.6.4", "clients": []}
+			},
+			{
+				"addresses": ["tw-0.7+udp://127.0.0.2:8303"],
+				"info": {"max_clients": "invalid"}
+			},
+			{
+				"addresses": ["tw-0.7+udp://127.0.0.3:8303", "unknown://127.0.0.3"],
+				"info": {"max_clients": 16, "max_players": 8, "passworded": true, "game_type": "DM", "name": "second", "map": {"name": "dm1"}, "version": "0.7.5", "clients": [{"name": "nameless tee", "clan": "", "country": -1, "score": 0, "is_player": true}]}
+			}
+		],
+		"communities": null
+	})";
+
+	for(size_t PartSize : {(size_t)1, (size_t)7, (size_t)64, (size_t)str_length(pList)})
+	{
+		std::vector<CServerInfo> vServers;
+		ASSERT_FALSE(ParseServerList(pList, PartSize, &vServers)) << PartSize;
+		ASSERT_EQ(vServers.size(), 2u);
+		EXPECT_STREQ(vServers[0].m_aName, "HideRemake {1}");
+		EXPECT_STREQ(vServers[0].m_aGameType, "hide\\\"seek");
+		EXPECT_EQ(vServers[0].m_Location, CServerInfo::LOC_EUROPE);
+		EXPECT_EQ(vServers[0].m_NumAddresses, 1);
+		EXPECT_STREQ(vServers[1].m_aName, "second");
+		EXPECT_EQ(vServers[1].m_NumAddresses, 1);
+		EXPECT_EQ(vServers[1].m_NumClients, 1);
+		EXPECT_EQ(vServers[1].m_Location, CServerInfo::LOC_UNKNOWN);
+	}
+
+	std::vector<CServerInfo> vServers;
+	EXPECT_FALSE(ParseServerList(R"({"servers": []})", 3, &vServers));
+	EXPECT_TRUE(vServers.empty());
+	// servers with invalid info are skipped
+	EXPECT_FALSE(ParseServerList(R"({"servers": [{"addresses": [1]}]})", 3, &vServers));
+	EXPECT_TRUE(vServers.empty());
+
+	const char *apInvalid[] = {
+		"",
+		"[]",
+		"{}",
+		R"({"servers": {}})",
+		R"({"servers": [1]})",
+		R"({"servers": [{"addresses": "tw-0.6+udp://127.0.0.1:8303"}]})",
+		R"({"servers": [{"addresses": [], "location": "xx"}]})",
+		R"({"servers": [{"addresses": [], "info": {]}])",
+		R"({"servers": [{"addresses": []},]})",
+		R"({"servers": []} trailing)",
+		R"({"servers": [], "other": })",
+		R"({"servers": [{"addresses": []})",
+	};
+	for(const char *pInvalid : apInvalid)
+	{
+		EXPECT_TRUE(ParseServerList(pInvalid, 1, &vServers)) << pInvalid;
+		EXPECT_TRUE(ParseServerList(pInvalid, 1024, &vServers)) << pInvalid;
+	}
+}
@@ -0,0 +1,176 @@
+#include <base/mem.h>
+#include <base/thread.h>
+#include <base/time.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot_decoder.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+// Builds snapshots and their compressed deltas like the server does
+class CSnapshotDecoderTest : public ::testing::Test
+{
+protected:
+	CSnapshotDecoder m_Decoder;
+	CSnapshotDelta m_Delta;
+	CSnapshotStorage m_SentStorage;
+
+	void SetUp() override
+	{
+		m_Decoder.Init();
+	}
+
+	static std::vector<unsigned char> BuildSnapshot(int NumPlayers, int Tick)
+	{
+		CSnapshotBuilder Builder;
+		Builder.Init();
+		for(int Id = 0; Id < NumPlayers; Id++)
+		{
+			int *pItem = (int *)Builder.NewItem(1, Id, 8 * sizeof(int));
+			for(int i = 0; i < 8; i++)
+				pItem[i] = i == 0 ? Id : Tick * (i + Id);
+		}
+		std::vector<unsigned char> vSnapshot(CSnapshot::MAX_SIZE);
+		vSnapshot.resize(Builder.Finish(vSnapshot.data()));
+		return vSnapshot;
+	}
+
+	CSnapshotDecoder::CJob *Submit(int Conn, int GameTick, int DeltaTick, const std::vector<unsigned char> &vSnapshot, unsigned Crc)
+	{
+		const CSnapshot *pDeltaShot = CSnapshot::EmptySnapshot();
+		if(DeltaTick >= 0)
+		{
+			EXPECT_GE(m_SentStorage.Get(DeltaTick, nullptr, &pDeltaShot, nullptr), 0);
+		}
+		unsigned char aDeltaData[CSnapshot::MAX_SIZE];
+		const int DeltaSize = m_Delta.CreateDelta(pDeltaShot, (const CSnapshot *)vSnapshot.data(), aDeltaData);
+		m_SentStorage.Add(GameTick, 0, vSnapshot.size(), vSnapshot.data(), 0, nullptr);
+
+		CSnapshotDecoder::CJob *pJob = m_Decoder.NewJob();
+		EXPECT_NE(pJob, nullptr);
+		pJob->m_Conn = Conn;
+		pJob->m_GameTick = GameTick;
+		pJob->m_DeltaTick = DeltaTick;
+		pJob->m_PurgeTick = DeltaTick;
+		pJob->m_CheckCrc = true;
+		pJob->m_Crc = Crc;
+		pJob->m_Sixup = false;
+		pJob->m_ReceiveTime = 0;
+		pJob->m_DataSize = DeltaSize ? CVariableInt::Compress(aDeltaData, DeltaSize, pJob->m_aData, sizeof(pJob->m_aData)) : 0;
+		m_Decoder.Submit();
+		return pJob;
+	}
+
+	CSnapshotDecoder::CJob *WaitDecoded()
+	{
+		const int64_t Timeout = time_get() + time_freq() * 10;
+		CSnapshotDecoder::CJob *pJob;
+		while(!(pJob = m_Decoder.DecodedJob()) && time_get() < Timeout)
+			thread_yield();
+		EXPECT_NE(pJob, nullptr);
+		return pJob;
+	}
+
+	void ExpectDecoded(const std::vector<unsigned char> &vSnapshot)
+	{
+		CSnapshotDecoder::CJob *pJob = WaitDecoded();
+		ASSERT_NE(pJob, nullptr);
+		EXPECT_TRUE(m_Decoder.IsCurrent(pJob));
+		EXPECT_EQ(pJob->m_Result, CSnapshotDecoder::RESULT_SUCCESS);
+		ASSERT_EQ(pJob->m_SnapSize, (int)vSnapshot.size());
+		EXPECT_EQ(mem_comp(pJob->m_aSnapshot, vSnapshot.data(), vSnapshot.size()), 0);
+		m_Decoder.PopDecodedJob();
+	}
+};
+
+TEST_F(CSnapshotDecoderTest, Deltas)
+{
+	std::vector<std::vector<unsigned char>> vvSnapshots;
+	for(int Tick = 1; Tick <= 50; Tick++)
+	{
+		vvSnapshots.push_back(BuildSnapshot(64, Tick));
+		Submit(0, Tick, Tick > 1 ? Tick - 1 : -1, vvSnapshots.back(), ((const CSnapshot *)vvSnapshots.back().data())->Crc());
+		// decoded out of step with the submissions
+		if(Tick % 5 == 0)
+		{
+			for(const std::vector<unsigned char> &vSnapshot : vvSnapshots)
+				ExpectDecoded(vSnapshot);
+			vvSnapshots.clear();
+		}
+	}
+	EXPECT_EQ(m_Decoder.DecodedJob(), nullptr);
+
+	uint64_t Rate, Updates;
+	m_Decoder.DataRate(1, &Rate, &Updates);
+	EXPECT_GT(Updates, 0u);
+}
+
+TEST_F(CSnapshotDecoderTest, Errors)
+{
+	const std::vector<unsigned char> vFirst = BuildSnapshot(4, 1);
+	Submit(0, 1, -1, vFirst, ((const CSnapshot *)vFirst.data())->Crc());
+	ExpectDecoded(vFirst);
+
+	const std::vector<unsigned char> vSecond = BuildSnapshot(4, 2);
+	Submit(0, 2, 1, vSecond, ((const CSnapshot *)vSecond.data())->Crc() + 1);
+	CSnapshotDecoder::CJob *pJob = WaitDecoded();
+	ASSERT_NE(pJob, nullptr);
+	EXPECT_EQ(pJob->m_Result, CSnapshotDecoder::RESULT_CRC_MISMATCH);
+	m_Decoder.PopDecodedJob();
+
+	// the dummy connection has its own snapshots
+	Submit(1, 2, 1, vSecond, ((const CSnapshot *)vSecond.data())->Crc());
+	pJob = WaitDecoded();
+	ASSERT_NE(pJob, nullptr);
+	EXPECT_EQ(pJob->m_Result, CSnapshotDecoder::RESULT_MISSING_DELTA);
+	m_Decoder.PopDecodedJob();
+
+	pJob = m_Decoder.NewJob();
+	ASSERT_NE(pJob, nullptr);
+	pJob->m_Conn = 0;
+	pJob->m_GameTick = 3;
+	pJob->m_DeltaTick = 1;
+	pJob->m_PurgeTick = 1;
+	pJob->m_CheckCrc = false;
+	pJob->m_Sixup = false;
+	// truncated delta header
+	pJob->m_DataSize = 1;
+	mem_zero(pJob->m_aData, pJob->m_DataSize);
+	m_Decoder.Submit();
+	pJob = WaitDecoded();
+	ASSERT_NE(pJob, nullptr);
+	EXPECT_EQ(pJob->m_Result, CSnapshotDecoder::RESULT_UNPACK_FAILED);
+	m_Decoder.PopDecodedJob();
+}
+
+TEST_F(CSnapshotDecoderTest, Reset)
+{
+	const std::vector<unsigned char> vFirst = BuildSnapshot(4, 1);
+	Submit(0, 1, -1, vFirst, ((const CSnapshot *)vFirst.data())->Crc());
+	m_Decoder.Reset(0);
+	CSnapshotDecoder::CJob *pJob = WaitDecoded();
+	ASSERT_NE(pJob, nullptr);
+	EXPECT_FALSE(m_Decoder.IsCurrent(pJob));
+	m_Decoder.PopDecodedJob();
+
+	// snapshots decoded before the reset can't be used as delta
+	const std::vector<unsigned char> vSecond = BuildSnapshot(4, 2);
+	Submit(0, 2, 1, vSecond, ((const CSnapshot *)vSecond.data())->Crc());
+	pJob = WaitDecoded();
+	ASSERT_NE(pJob, nullptr);
+	EXPECT_TRUE(m_Decoder.IsCurrent(pJob));
+	EXPECT_EQ(pJob->m_Result, CSnapshotDecoder::RESULT_MISSING_DELTA);
+	m_Decoder.PopDecodedJob();
+}
+
+TEST_F(CSnapshotDecoderTest, Full)
+{
+	const std::vector<unsigned char> vSnapshot = BuildSnapshot(1, 1);
+	for(int i = 0; i < CSnapshotDecoder::MAX_JOBS; i++)
+		Submit(0, i + 1, -1, vSnapshot, ((const CSnapshot *)vSnapshot.data())->Crc());
+	EXPECT_EQ(m_Decoder.NewJob(), nullptr);
+	ExpectDecoded(vSnapshot);
+	EXPECT_NE(m_Decoder.NewJob(), nullptr);
+}
@@ -0,0 +1,108 @@
+#include <engine/shared/substring_matcher.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static std::vector<std::tuple<int, int, int>> FindAll(const CSubstringMatcher &Matcher, const char *pText)
+{
+	std::vector<std::tuple<int, int, int>> vMatches;
+	Matcher.FindAll(pText, [&](int Pattern, const char *pStart, const char *pEnd) {
+		vMatches.emplace_back(Pattern, pStart - pText, pEnd - pText);
+	});
+	return vMatches;
+}
+
+TEST(SubstringMatcher, Empty)
+{
+	CSubstringMatcher Matcher;
+	// nothing to build without patterns
+	EXPECT_TRUE(FindAll(Matcher, "abc").empty());
+	Matcher.Build();
+	EXPECT_TRUE(FindAll(Matcher, "").empty());
+	EXPECT_TRUE(FindAll(Matcher, "abc").empty());
+
+	EXPECT_EQ(Matcher.Add(""), 0);
+	Matcher.Build();
+	EXPECT_TRUE(FindAll(Matcher, "abc").empty());
+}
+
+TEST(SubstringMatcher, Overlapping)
+{
+	CSubstringMatcher Matcher;
+	EXPECT_EQ(Matcher.Add("he"), 0);
+	EXPECT_EQ(Matcher.Add("she"), 1);
+	EXPECT_EQ(Matcher.Add("his"), 2);
+	EXPECT_EQ(Matcher.Add("hers"), 3);
+	Matcher.Build();
+	EXPECT_EQ(Matcher.NumPatterns(), 4);
+
+	const std::vector<std::tuple<int, int, int>> vExpected = {{1, 1, 4}, {0, 2, 4}, {3, 2, 6}};
+	EXPECT_EQ(FindAll(Matcher, "ushers"), vExpected);
+}
+
+TEST(SubstringMatcher, Nocase)
+{
+	CSubstringMatcher Matcher;
+	Matcher.Add("ÄbC");
+	Matcher.Add("x");
+	Matcher.Build();
+
+	const std::vector<std::tuple<int, int, int>> vExpected = {{0, 1, 5}, {1, 5, 6}, {1, 6, 7}};
+	EXPECT_EQ(FindAll(Matcher, "-äBcXx"), vExpected);
+	EXPECT_TRUE(FindAll(Matcher, "abc").empty());
+}
+
+TEST(SubstringMatcher, MatchesFindNocase)
+{
+	const char *apPatterns[] = {"ab", "b", "bab", "Ö", "aö", "abab"};
+	const char *apTexts[] = {"", "a", "abab", "BABAB", "aÖab", "öÖ", "xyz"};
+
+	CSubstringMatcher Matcher;
+	for(const char *pPattern : apPatterns)
+		Matcher.Add(pPattern);
+	Matcher.Build();
+
+	for(const char *pText : apTexts)
+	{
+		std::vector<bool> vFound(std::size(apPatterns), false);
+		Matcher.FindAll(pText, [&](int Pattern, const char *, const char *) { vFound[Pattern] = true; });
+		for(size_t i = 0; i < std::size(apPatterns); i++)
+			EXPECT_EQ(vFound[i], str_utf8_find_nocase(pText, apPatterns[i]) != nullptr) << pText << " " << apPatterns[i];
+	}
+}
+
+TEST(SubstringMatcher, LargeWordList)
+{
+	std::mt19937 Rng(0);
+	auto &&RandomWord = [&](int Length) {
+		std::string Word;
+		for(int i = 0; i < Length; i++)
+			Word += (char)((Rng() % 2 ? 'a' : 'A') + Rng() % 8);
+		return Word;
+	};
+
+	std::vector<std::string> vWords;
+	CSubstringMatcher Matcher;
+	for(int i = 0; i < 20000; i++)
+	{
+		vWords.push_back(RandomWord(3 + Rng() % 6));
+		EXPECT_EQ(Matcher.Add(vWords.back().c_str()), i);
+	}
+	Matcher.Build();
+
+	for(int i = 0; i < 3; i++)
+	{
+		const std::string Text = RandomWord(60);
+		std::vector<bool> vFound(vWords.size(), false);
+		Matcher.FindAll(Text.c_str(), [&](int Pattern, const char *pStart, const char *pEnd) {
+			EXPECT_EQ(str_utf8_comp_nocase_num(pStart, vWords[Pattern].c_str(), pEnd - pStart), 0);
+			vFound[Pattern] = true;
+		});
+		for(size_t Word = 0; Word < vWords.size(); Word++)
+			EXPECT_EQ(vFound[Word], str_utf8_find_nocase(Text.c_str(), vWords[Word].c_str()) != nullptr) << Text << " " << vWords[Word];
+	}
+}
@@ -8,6 +8,7 @@
 
 #include <game/gamecore.h>
 #include <game/server/teehistorian.h>
+#include <game/server/teehistorian_reader.h>
 
 #include <gtest/gtest.h>
 
@@ -908,3 +909,72 @@ TEST_F(TeeHistorian, PrevGameUuid)
 	EXPECT_STREQ(JsonPrevGameUuid, "fe19c218-f555-4002-a273-126c59ccc17a");
 	json_value_free(pJson);
 }
+
+TEST_F(TeeHistorian, ReaderRoundTrip)
+{
+	CNetObj_PlayerInput Input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	Tick(1);
+	Player(0, 1, 2);
+	Player(3, 10, 20);
+	Inputs();
+	m_TH.RecordPlayerInput(3, 1, &Input);
+	Tick(2);
+	Player(0, 2, 1);
+	DeadPlayer(3);
+	Inputs();
+	Input.m_Direction = -1;
+	m_TH.RecordPlayerInput(3, 1, &Input);
+	Tick(5);
+	Player(0, 4, 4);
+	m_TH.RecordPlayerDrop(3, "bye");
+	Finish();
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Init(m_vBuffer.data(), m_vBuffer.size()));
+	EXPECT_STREQ(Reader.HeaderString("version"), "2");
+
+	CTeeHistorianReader::CChunk Chunk;
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_PLAYER);
+	EXPECT_EQ(Chunk.m_Tick, 1);
+	EXPECT_EQ(Chunk.m_ClientId, 0);
+	EXPECT_EQ(Chunk.m_X, 1);
+	EXPECT_EQ(Chunk.m_Y, 2);
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_PLAYER);
+	EXPECT_EQ(Chunk.m_ClientId, 3);
+	EXPECT_EQ(Chunk.m_X, 10);
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_INPUT);
+	EXPECT_EQ(Chunk.m_Tick, 1);
+	EXPECT_EQ(Chunk.m_Input.m_Direction, 1);
+	EXPECT_EQ(Chunk.m_Input.m_PlayerFlags, 7);
+
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_PLAYER);
+	EXPECT_EQ(Chunk.m_Tick, 2);
+	EXPECT_EQ(Chunk.m_X, 2);
+	EXPECT_EQ(Chunk.m_Y, 1);
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_PLAYER_OLD);
+	EXPECT_EQ(Chunk.m_Tick, 2);
+	EXPECT_EQ(Chunk.m_ClientId, 3);
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_INPUT);
+	EXPECT_EQ(Chunk.m_Input.m_Direction, -1);
+	EXPECT_EQ(Chunk.m_Input.m_TargetX, 2);
+
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_PLAYER);
+	EXPECT_EQ(Chunk.m_Tick, 5);
+	EXPECT_EQ(Chunk.m_X, 4);
+	EXPECT_EQ(Chunk.m_Y, 4);
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_DROP);
+	EXPECT_EQ(Chunk.m_ClientId, 3);
+	EXPECT_STREQ(Chunk.m_pString, "bye");
+	ASSERT_TRUE(Reader.Next(&Chunk));
+	EXPECT_EQ(Chunk.m_Type, CTeeHistorianReader::CHUNK_FINISH);
+	EXPECT_FALSE(Reader.Next(&Chunk));
+	EXPECT_FALSE(Reader.Error());
+}
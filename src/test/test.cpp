@@ -27,13 +27,25 @@ CTestInfo::CTestInfo()
 		if(aTestCaseName[i] == '/')
 		{
 			aTestCaseName[i] = '-';
-			aTestCaseName[i + 1] = '\0';
-			str_append(aTestCaseName, pTestInfo->type_param());
-			break;
+			// value-parameterized tests have no type parameter
+			if(pTestInfo->type_param())
+			{
+				aTestCaseName[i + 1] = '\0';
+				str_append(aTestCaseName, pTestInfo->type_param());
+				break;
+			}
 		}
 	}
+	// Value-parameterized tests have test names like "TestName/Param".
+	char aTestName[128];
+	str_copy(aTestName, pTestInfo->name());
+	for(char &Character : aTestName)
+	{
+		if(Character == '/')
+			Character = '-';
+	}
 	str_format(m_aFilenamePrefix, sizeof(m_aFilenamePrefix), "%s.%s-%d",
-		aTestCaseName, pTestInfo->name(), process_id());
+		aTestCaseName, aTestName, process_id());
 	Filename(m_aFilename, sizeof(m_aFilename), ".tmp");
 }
 
@@ -0,0 +1,252 @@
+#ifndef TOOLS_MAP_BATCH_H
+#define TOOLS_MAP_BATCH_H
+
+#include <base/dbg.h>
+#include <base/fs.h>
+#include <base/io.h>
+#include <base/log.h>
+#include <base/math.h>
+#include <base/str.h>
+#include <base/time.h>
+
+#include <engine/shared/jobs.h>
+#include <engine/shared/jsonwriter.h>
+#include <engine/shared/linereader.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Batch mode shared by the map tools that turn one map into another:
+
+	<tool> --batch [--jobs <n>] [--summary <file>] <destination directory> <map directory|map list file|map>...
+
+	Every source map is written to `<destination directory>/<map name>.map` by
+	the same function the tool uses for a single map, so the outputs are
+	identical. The maps are processed concurrently by a bounded number of
+	workers, which share one job pool for compressing the written data.
+	The summary is a JSON file with the result and duration of every map.
+*/
+
+// Processes one map, returns `true` on success.
+typedef std::function<bool(IStorage *pStorage, CJobPool *pJobPool, const char *pSourceMap, const char *pDestinationMap)> FMapBatchProcess;
+
+class CMapBatchEntry
+{
+public:
+	std::string m_Source;
+	std::string m_Destination;
+	bool m_Success = false;
+	int64_t m_DurationUs = 0;
+	const char *m_pError = nullptr;
+};
+
+inline bool IsMapBatchCommand(int argc, const char **argv)
+{
+	return argc >= 2 && str_comp(argv[1], "--batch") == 0;
+}
+
+inline void MapBatchUsage(const char *pToolName)
+{
+	log_error(pToolName, "Usage: %s --batch [--jobs <n>] [--summary <file>] <destination directory> <map directory|map list file|map>...", pToolName);
+}
+
+static int MapBatchListdirCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	if(!IsDir && str_endswith(pName, ".map"))
+		((std::vector<std::string> *)pUser)->emplace_back(pName);
+	return 0;
+}
+
+inline bool AddMapBatchSource(const char *pToolName, const char *pSource, std::vector<std::string> &vSources)
+{
+	if(fs_is_dir(pSource))
+	{
+		std::vector<std::string> vNames;
+		fs_listdir(pSource, MapBatchListdirCallback, IStorage::TYPE_ABSOLUTE, &vNames);
+		// listing order depends on the file system
+		std::sort(vNames.begin(), vNames.end());
+		for(const std::string &Name : vNames)
+			vSources.push_back(std::string(pSource) + "/" + Name);
+		return true;
+	}
+	if(str_endswith(pSource, ".map"))
+	{
+		vSources.emplace_back(pSource);
+		return true;
+	}
+
+	// list file with one map path per line
+	CLineReader LineReader;
+	if(!LineReader.OpenFile(io_open(pSource, IOFLAG_READ)))
+	{
+		log_error(pToolName, "Failed to open map list '%s'", pSource);
+		return false;
+	}
+	while(const char *pLine = LineReader.Get())
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_copy(aPath, str_utf8_skip_whitespaces(pLine));
+		str_utf8_trim_right(aPath);
+		if(aPath[0] != '\0' && aPath[0] != '#')
+			vSources.emplace_back(aPath);
+	}
+	return true;
+}
+
+inline bool WriteMapBatchSummary(const char *pToolName, const char *pFilename, const std::vector<CMapBatchEntry> &vEntries)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+	if(!File)
+	{
+		log_error(pToolName, "Failed to open summary '%s' for writing", pFilename);
+		return false;
+	}
+
+	CJsonFileWriter Writer(File);
+	Writer.BeginObject();
+	Writer.WriteAttribute("tool");
+	Writer.WriteStrValue(pToolName);
+	Writer.WriteAttribute("maps");
+	Writer.BeginArray();
+	for(const CMapBatchEntry &Entry : vEntries)
+	{
+		Writer.BeginObject();
+		Writer.WriteAttribute("source");
+		Writer.WriteStrValue(Entry.m_Source.c_str());
+		Writer.WriteAttribute("destination");
+		Writer.WriteStrValue(Entry.m_Destination.c_str());
+		Writer.WriteAttribute("success");
+		Writer.WriteBoolValue(Entry.m_Success);
+		Writer.WriteAttribute("duration_us");
+		Writer.WriteIntValue((int)minimum<int64_t>(Entry.m_DurationUs, std::numeric_limits<int>::max()));
+		Writer.WriteAttribute("error");
+		if(Entry.m_pError)
+			Writer.WriteStrValue(Entry.m_pError);
+		else
+			Writer.WriteNullValue();
+		Writer.EndObject();
+	}
+	Writer.EndArray();
+	Writer.EndObject();
+	return true;
+}
+
+/**
+ * Runs the batch mode of a map tool.
+ *
+ * @param pToolName Name of the tool used for logging.
+ * @param argc Number of arguments, including the program name and `--batch`.
+ * @param argv Arguments, including the program name and `--batch`.
+ * @param pStorage Storage passed to the processing function.
+ * @param DestinationType Storage type the processing function writes the
+ * destination map with, used to create the destination directory.
+ * @param Process Function processing a single map, called concurrently.
+ *
+ * @return `0` if all maps were processed successfully, `-1` otherwise.
+ */
+inline int RunMapBatch(const char *pToolName, int argc, const char **argv, IStorage *pStorage, int DestinationType, const FMapBatchProcess &Process)
+{
+	int NumWorkers = std::max(1, (int)std::thread::hardware_concurrency());
+	const char *pSummary = nullptr;
+	int Arg = 2;
+	while(Arg < argc && str_startswith(argv[Arg], "--"))
+	{
+		if(str_comp(argv[Arg], "--jobs") == 0 && Arg + 1 < argc && str_toint(argv[Arg + 1], &NumWorkers) && NumWorkers > 0)
+			Arg += 2;
+		else if(str_comp(argv[Arg], "--summary") == 0 && Arg + 1 < argc)
+		{
+			pSummary = argv[Arg + 1];
+			Arg += 2;
+		}
+		else
+		{
+			MapBatchUsage(pToolName);
+			return -1;
+		}
+	}
+	if(argc - Arg < 2)
+	{
+		MapBatchUsage(pToolName);
+		return -1;
+	}
+
+	const char *pDestinationDir = argv[Arg++];
+	std::vector<std::string> vSources;
+	for(; Arg < argc; Arg++)
+	{
+		if(!AddMapBatchSource(pToolName, argv[Arg], vSources))
+			return -1;
+	}
+	char aDestinationPath[IO_MAX_PATH_LENGTH];
+	if(DestinationType == IStorage::TYPE_ABSOLUTE)
+		str_copy(aDestinationPath, pDestinationDir);
+	else
+		pStorage->GetCompletePath(DestinationType, pDestinationDir, aDestinationPath, sizeof(aDestinationPath));
+	if(fs_makedir_rec_for(aDestinationPath) != 0 || fs_makedir(aDestinationPath) != 0)
+	{
+		log_error(pToolName, "Failed to create destination directory '%s'", pDestinationDir);
+		return -1;
+	}
+
+	std::vector<CMapBatchEntry> vEntries(vSources.size());
+	std::set<std::string> DestinationNames;
+	for(size_t i = 0; i < vSources.size(); i++)
+	{
+		char aName[IO_MAX_PATH_LENGTH];
+		IStorage::StripPathAndExtension(vSources[i].c_str(), aName, sizeof(aName));
+		vEntries[i].m_Source = vSources[i];
+		vEntries[i].m_Destination = std::string(pDestinationDir) + "/" + aName + ".map";
+		// later maps with the same name would overwrite the earlier output
+		if(!DestinationNames.insert(aName).second)
+			vEntries[i].m_pError = "duplicate map name";
+	}
+
+	CJobPool JobPool;
+	JobPool.Init(NumWorkers);
+
+	NumWorkers = minimum<int>(NumWorkers, vEntries.size());
+	std::atomic<size_t> NextEntry(0);
+	auto &&Work = [&]() {
+		size_t Index;
+		while((Index = NextEntry.fetch_add(1)) < vEntries.size())
+		{
+			CMapBatchEntry &Entry = vEntries[Index];
+			if(Entry.m_pError)
+				continue;
+			const std::chrono::nanoseconds StartTime = time_get_nanoseconds();
+			Entry.m_Success = Process(pStorage, &JobPool, Entry.m_Source.c_str(), Entry.m_Destination.c_str());
+			Entry.m_DurationUs = std::chrono::duration_cast<std::chrono::microseconds>(time_get_nanoseconds() - StartTime).count();
+			if(!Entry.m_Success)
+				Entry.m_pError = "processing failed";
+		}
+	};
+	std::vector<std::thread> vWorkers;
+	for(int i = 1; i < NumWorkers; i++)
+		vWorkers.emplace_back(Work);
+	Work();
+	for(std::thread &Worker : vWorkers)
+		Worker.join();
+	JobPool.Shutdown();
+
+	const size_t NumFailed = std::count_if(vEntries.begin(), vEntries.end(), [](const CMapBatchEntry &Entry) { return !Entry.m_Success; });
+	for(const CMapBatchEntry &Entry : vEntries)
+	{
+		if(!Entry.m_Success)
+			log_error(pToolName, "Failed to process '%s': %s", Entry.m_Source.c_str(), Entry.m_pError);
+	}
+	log_info(pToolName, "Processed %d maps, %d failed", (int)vEntries.size(), (int)NumFailed);
+
+	if(pSummary && !WriteMapBatchSummary(pToolName, pSummary, vEntries))
+		return -1;
+	return NumFailed == 0 ? 0 : -1;
+}
+
+#endif
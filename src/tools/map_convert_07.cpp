@@ -7,28 +7,53 @@
 
 #include <engine/gfx/image_loader.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <game/gamecore.h>
 #include <game/mapitems.h>
 
+#include "map_batch.h"
+
+#include <algorithm>
+#include <thread>
+
 /*
 	Usage: map_convert_07 <source map filepath> <dest map filepath>
+	       map_convert_07 --batch [--jobs <n>] [--summary <file>] <dest directory> <map directory|map list file|map>...
 */
 
-static CDataFileReader g_DataReader;
-static CDataFileWriter g_DataWriter;
+class CMapConverter
+{
+	CDataFileReader m_DataReader;
+	CDataFileWriter m_DataWriter;
+
+	// new image data (set by ReplaceImageItem)
+	int m_aNewDataSize[MAX_MAPIMAGES];
+	void *m_apNewData[MAX_MAPIMAGES];
 
-// global new image data (set by ReplaceImageItem)
-static int g_aNewDataSize[MAX_MAPIMAGES];
-static void *g_apNewData[MAX_MAPIMAGES];
+	int m_Index = 0;
+	int m_NextDataItemId = -1;
 
-static int g_Index = 0;
-static int g_NextDataItemId = -1;
+	int m_aImageIds[MAX_MAPIMAGES] = {};
+	int m_NumImages = 0;
 
-static int g_aImageIds[MAX_MAPIMAGES];
+	bool CheckImageDimensions(void *pLayerItem, int LayerType, const char *pFilename);
+	void *ReplaceImageItem(int Index, CMapItemImage *pImgItem, CMapItemImage *pNewImgItem);
 
-static bool CheckImageDimensions(void *pLayerItem, int LayerType, const char *pFilename)
+public:
+	~CMapConverter();
+
+	bool Convert(IStorage *pStorage, CJobPool *pJobPool, const char *pSourceFilename, const char *pDestFilename);
+};
+
+CMapConverter::~CMapConverter()
+{
+	for(int Index = 0; Index < m_Index; Index++)
+		free(m_apNewData[Index]);
+}
+
+bool CMapConverter::CheckImageDimensions(void *pLayerItem, int LayerType, const char *pFilename)
 {
 	if(LayerType != MAPITEMTYPE_LAYER)
 		return true;
@@ -41,8 +66,16 @@ static bool CheckImageDimensions(void *pLayerItem, int LayerType, const char *pF
 	if(pTMap->m_Image == -1)
 		return true;
 
+	if(pTMap->m_Image < 0 || pTMap->m_Image >= m_NumImages)
+	{
+		char aTileLayerName[12];
+		IntsToStr(pTMap->m_aName, std::size(pTMap->m_aName), aTileLayerName, std::size(aTileLayerName));
+		dbg_msg("map_convert_07", "%s: Tile layer \"%s\" uses invalid image index %d.", pFilename, aTileLayerName, pTMap->m_Image);
+		return false;
+	}
+
 	int Type;
-	void *pItem = g_DataReader.GetItem(g_aImageIds[pTMap->m_Image], &Type);
+	void *pItem = m_DataReader.GetItem(m_aImageIds[pTMap->m_Image], &Type);
 	if(Type != MAPITEMTYPE_IMAGE)
 		return true;
 
@@ -54,17 +87,17 @@ static bool CheckImageDimensions(void *pLayerItem, int LayerType, const char *pF
 	char aTileLayerName[12];
 	IntsToStr(pTMap->m_aName, std::size(pTMap->m_aName), aTileLayerName, std::size(aTileLayerName));
 
-	const char *pName = g_DataReader.GetDataString(pImgItem->m_ImageName);
+	const char *pName = m_DataReader.GetDataString(pImgItem->m_ImageName);
 	dbg_msg("map_convert_07", "%s: Tile layer \"%s\" uses image \"%s\" with width %d, height %d, which is not divisible by 16. This is not supported in Teeworlds 0.7. Please scale the image and replace it manually.", pFilename, aTileLayerName, pName == nullptr ? "(error)" : pName, pImgItem->m_Width, pImgItem->m_Height);
 	return false;
 }
 
-static void *ReplaceImageItem(int Index, CMapItemImage *pImgItem, CMapItemImage *pNewImgItem)
+void *CMapConverter::ReplaceImageItem(int Index, CMapItemImage *pImgItem, CMapItemImage *pNewImgItem)
 {
 	if(!pImgItem->m_External)
 		return pImgItem;
 
-	const char *pName = g_DataReader.GetDataString(pImgItem->m_ImageName);
+	const char *pName = m_DataReader.GetDataString(pImgItem->m_ImageName);
 	if(pName == nullptr || pName[0] == '\0')
 	{
 		dbg_msg("map_convert_07", "failed to load name of image %d", Index);
@@ -94,78 +127,36 @@ static void *ReplaceImageItem(int Index, CMapItemImage *pImgItem, CMapItemImage
 	pNewImgItem->m_Width = ImgInfo.m_Width;
 	pNewImgItem->m_Height = ImgInfo.m_Height;
 	pNewImgItem->m_External = false;
-	pNewImgItem->m_ImageData = g_NextDataItemId++;
+	pNewImgItem->m_ImageData = m_NextDataItemId++;
 
-	g_apNewData[g_Index] = ImgInfo.m_pData;
-	g_aNewDataSize[g_Index] = ImgInfo.DataSize();
-	g_Index++;
+	m_apNewData[m_Index] = ImgInfo.m_pData;
+	m_aNewDataSize[m_Index] = ImgInfo.DataSize();
+	m_Index++;
 
 	return (void *)pNewImgItem;
 }
 
-int main(int argc, const char **argv)
+bool CMapConverter::Convert(IStorage *pStorage, CJobPool *pJobPool, const char *pSourceFilename, const char *pDestFilename)
 {
-	CCmdlineFix CmdlineFix(&argc, &argv);
-	log_set_global_logger_default();
-
-	if(argc < 2 || argc > 3)
-	{
-		dbg_msg("map_convert_07", "Invalid arguments");
-		dbg_msg("map_convert_07", "Usage: map_convert_07 <source map filepath> [<dest map filepath>]");
-		return -1;
-	}
-
-	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
-	if(!pStorage)
-	{
-		log_error("map_convert_07", "Error creating basic storage");
-		return -1;
-	}
-
-	const char *pSourceFilename = argv[1];
-	char aDestFilename[IO_MAX_PATH_LENGTH];
-
-	if(argc == 3)
-	{
-		str_copy(aDestFilename, argv[2], sizeof(aDestFilename));
-	}
-	else
-	{
-		char aBuf[IO_MAX_PATH_LENGTH];
-		IStorage::StripPathAndExtension(pSourceFilename, aBuf, sizeof(aBuf));
-		str_format(aDestFilename, sizeof(aDestFilename), "data/maps7/%s.map", aBuf);
-		if(fs_makedir("data") != 0)
-		{
-			dbg_msg("map_convert_07", "failed to create data directory");
-			return -1;
-		}
-
-		if(fs_makedir("data/maps7") != 0)
-		{
-			dbg_msg("map_convert_07", "failed to create data/maps7 directory");
-			return -1;
-		}
-	}
-
-	if(!g_DataReader.Open(pStorage.get(), pSourceFilename, IStorage::TYPE_ABSOLUTE))
+	if(!m_DataReader.Open(pStorage, pSourceFilename, IStorage::TYPE_ABSOLUTE))
 	{
 		dbg_msg("map_convert_07", "failed to open source map. filename='%s'", pSourceFilename);
-		return -1;
+		return false;
 	}
 
-	if(!g_DataWriter.Open(pStorage.get(), aDestFilename, IStorage::TYPE_ABSOLUTE))
+	if(!m_DataWriter.Open(pStorage, pDestFilename, IStorage::TYPE_ABSOLUTE))
 	{
-		dbg_msg("map_convert_07", "failed to open destination map. filename='%s'", aDestFilename);
-		return -1;
+		dbg_msg("map_convert_07", "failed to open destination map. filename='%s'", pDestFilename);
+		return false;
 	}
 
-	g_NextDataItemId = g_DataReader.NumData();
+	m_NextDataItemId = m_DataReader.NumData();
 
 	size_t i = 0;
-	for(int Index = 0; Index < g_DataReader.NumItems(); Index++)
+	for(int Index = 0; Index < m_DataReader.NumItems(); Index++)
 	{
 		int Type;
-		g_DataReader.GetItem(Index, &Type);
+		m_DataReader.GetItem(Index, &Type);
 		if(Type == MAPITEMTYPE_IMAGE)
 		{
 			if(i >= MAX_MAPIMAGES)
@@ -173,19 +164,20 @@ int main(int argc, const char **argv)
 				dbg_msg("map_convert_07", "map uses more images than the client maximum of %" PRIzu ". filename='%s'", MAX_MAPIMAGES, pSourceFilename);
 				break;
 			}
-			g_aImageIds[i] = Index;
+			m_aImageIds[i] = Index;
 			i++;
 		}
 	}
+	m_NumImages = i;
 
 	bool Success = true;
 
 	// add all items
-	for(int Index = 0; Index < g_DataReader.NumItems(); Index++)
+	for(int Index = 0; Index < m_DataReader.NumItems(); Index++)
 	{
 		int Type, Id;
 		CUuid Uuid;
-		void *pItem = g_DataReader.GetItem(Index, &Type, &Id, &Uuid);
+		void *pItem = m_DataReader.GetItem(Index, &Type, &Id, &Uuid);
 
 		// Filter ITEMTYPE_EX items, they will be automatically added again.
 		if(Type == ITEMTYPE_EX)
@@ -193,7 +185,7 @@ int main(int argc, const char **argv)
 			continue;
 		}
 
-		int Size = g_DataReader.GetItemSize(Index);
+		int Size = m_DataReader.GetItemSize(Index);
 		Success &= CheckImageDimensions(pItem, Type, pSourceFilename);
 
 		CMapItemImage NewImageItem;
@@ -201,27 +193,84 @@ int main(int argc, const char **argv)
 		{
 			pItem = ReplaceImageItem(Index, (CMapItemImage *)pItem, &NewImageItem);
 			if(!pItem)
-				return -1;
+				return false;
 			Size = sizeof(CMapItemImage);
 			NewImageItem.m_Version = 1;
 		}
-		g_DataWriter.AddItem(Type, Id, Size, pItem, &Uuid);
+		m_DataWriter.AddItem(Type, Id, Size, pItem, &Uuid);
 	}
 
 	// add all data
-	for(int Index = 0; Index < g_DataReader.NumData(); Index++)
+	for(int Index = 0; Index < m_DataReader.NumData(); Index++)
+	{
+		void *pData = m_DataReader.GetData(Index);
+		int Size = m_DataReader.GetDataSize(Index);
+		m_DataWriter.AddData(Size, pData);
+	}
+
+	for(int Index = 0; Index < m_Index; Index++)
+	{
+		m_DataWriter.AddData(m_aNewDataSize[Index], m_apNewData[Index]);
+	}
+
+	m_DataReader.Close();
+	m_DataWriter.Finish(pJobPool);
+	return Success;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if((argc < 2 || argc > 3) && !IsMapBatchCommand(argc, argv))
+	{
+		dbg_msg("map_convert_07", "Invalid arguments");
+		dbg_msg("map_convert_07", "Usage: map_convert_07 <source map filepath> [<dest map filepath>]");
+		MapBatchUsage("map_convert_07");
+		return -1;
+	}
+
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error("map_convert_07", "Error creating basic storage");
+		return -1;
+	}
+
+	if(IsMapBatchCommand(argc, argv))
 	{
-		void *pData = g_DataReader.GetData(Index);
-		int Size = g_DataReader.GetDataSize(Index);
-		g_DataWriter.AddData(Size, pData);
+		return RunMapBatch("map_convert_07", argc, argv, pStorage.get(), IStorage::TYPE_ABSOLUTE, [](IStorage *pBatchStorage, CJobPool *pJobPool, const char *pSourceMap, const char *pDestinationMap) {
+			return CMapConverter().Convert(pBatchStorage, pJobPool, pSourceMap, pDestinationMap);
+		});
 	}
 
-	for(int Index = 0; Index < g_Index; Index++)
+	const char *pSourceFilename = argv[1];
+	char aDestFilename[IO_MAX_PATH_LENGTH];
+
+	if(argc == 3)
+	{
+		str_copy(aDestFilename, argv[2], sizeof(aDestFilename));
+	}
+	else
 	{
-		g_DataWriter.AddData(g_aNewDataSize[Index], g_apNewData[Index]);
+		char aBuf[IO_MAX_PATH_LENGTH];
+		IStorage::StripPathAndExtension(pSourceFilename, aBuf, sizeof(aBuf));
+		str_format(aDestFilename, sizeof(aDestFilename), "data/maps7/%s.map", aBuf);
+		if(fs_makedir("data") != 0)
+		{
+			dbg_msg("map_convert_07", "failed to create data directory");
+			return -1;
+		}
+
+		if(fs_makedir("data/maps7") != 0)
+		{
+			dbg_msg("map_convert_07", "failed to create data/maps7 directory");
+			return -1;
+		}
 	}
 
-	g_DataReader.Close();
-	g_DataWriter.Finish();
-	return Success ? 0 : -1;
+	CJobPool JobPool;
+	JobPool.Init(std::max(1, (int)std::thread::hardware_concurrency() - 1));
+	return CMapConverter().Convert(pStorage.get(), &JobPool, pSourceFilename, aDestFilename) ? 0 : -1;
 }
@@ -4,46 +4,18 @@
 
 #include <engine/gfx/image_manipulation.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <game/mapitems.h>
 
+#include "map_batch.h"
+
 #include <algorithm>
 #include <cstdint>
+#include <thread>
 #include <vector>
 
-static void ClearTransparentPixels(uint8_t *pImg, int Width, int Height)
-{
-	for(int y = 0; y < Height; ++y)
-	{
-		for(int x = 0; x < Width; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			if(pImg[Index + 3] == 0)
-			{
-				pImg[Index + 0] = 0;
-				pImg[Index + 1] = 0;
-				pImg[Index + 2] = 0;
-			}
-		}
-	}
-}
-
-static void CopyOpaquePixels(uint8_t *pDestImg, uint8_t *pSrcImg, int Width, int Height)
-{
-	for(int y = 0; y < Height; ++y)
-	{
-		for(int x = 0; x < Width; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			if(pSrcImg[Index + 3] > 0)
-				mem_copy(&pDestImg[Index], &pSrcImg[Index], sizeof(uint8_t) * 4);
-			else
-				mem_zero(&pDestImg[Index], sizeof(uint8_t) * 4);
-		}
-	}
-}
-
 static void ClearPixelsTile(uint8_t *pImg, int Width, int Height, int TileIndex)
 {
 	int WTile = Width / 16;
@@ -53,14 +25,7 @@ static void ClearPixelsTile(uint8_t *pImg, int Width, int Height, int TileIndex)
 
 	for(int y = StartY; y < StartY + HTile; ++y)
 	{
-		for(int x = StartX; x < StartX + WTile; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			pImg[Index + 0] = 0;
-			pImg[Index + 1] = 0;
-			pImg[Index + 2] = 0;
-			pImg[Index + 3] = 0;
-		}
+		mem_zero(&pImg[((size_t)y * Width + StartX) * 4], (size_t)WTile * 4);
 	}
 }
 
@@ -77,50 +42,20 @@ static void GetImageSHA256(uint8_t *pImgBuff, int ImgSize, int Width, int Height
 	free(pNewImgBuff);
 }
 
-int main(int argc, const char **argv)
+static bool OptimizeMap(IStorage *pStorage, CJobPool *pJobPool, const char *pSourceMap, const char *pDestinationMap)
 {
-	CCmdlineFix CmdlineFix(&argc, &argv);
-	log_set_global_logger_default();
-
-	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
-	if(!pStorage)
-	{
-		log_error("map_optimize", "Error creating basic storage");
-		return -1;
-	}
-	if(argc <= 1 || argc > 3)
-	{
-		dbg_msg("map_optimize", "Usage: map_optimize <source map filepath> [<dest map filepath>]");
-		return -1;
-	}
-
-	char aFilename[IO_MAX_PATH_LENGTH];
-	if(argc == 3)
-	{
-		str_format(aFilename, sizeof(aFilename), "out/%s", argv[2]);
-
-		fs_makedir_rec_for(aFilename);
-	}
-	else
-	{
-		fs_makedir("out");
-		char aBuff[IO_MAX_PATH_LENGTH];
-		IStorage::StripPathAndExtension(argv[1], aBuff, sizeof(aBuff));
-		str_format(aFilename, sizeof(aFilename), "out/%s.map", aBuff);
-	}
-
 	CDataFileReader Reader;
-	if(!Reader.Open(pStorage.get(), argv[1], IStorage::TYPE_ABSOLUTE))
+	if(!Reader.Open(pStorage, pSourceMap, IStorage::TYPE_ABSOLUTE))
 	{
-		dbg_msg("map_optimize", "Failed to open source file.");
-		return -1;
+		dbg_msg("map_optimize", "Failed to open source file '%s'.", pSourceMap);
+		return false;
 	}
 
 	CDataFileWriter Writer;
-	if(!Writer.Open(pStorage.get(), aFilename, IStorage::TYPE_ABSOLUTE))
+	if(!Writer.Open(pStorage, pDestinationMap, IStorage::TYPE_ABSOLUTE))
 	{
-		dbg_msg("map_optimize", "Failed to open target file.");
-		return -1;
+		dbg_msg("map_optimize", "Failed to open target file '%s'.", pDestinationMap);
+		return false;
 	}
 
 	int aImageFlags[MAX_MAPIMAGES] = {
@@ -323,7 +258,47 @@ int main(int argc, const char **argv)
 	}
 
 	Reader.Close();
-	Writer.Finish();
+	Writer.Finish(pJobPool);
+
+	return true;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error("map_optimize", "Error creating basic storage");
+		return -1;
+	}
+	if(IsMapBatchCommand(argc, argv))
+		return RunMapBatch("map_optimize", argc, argv, pStorage.get(), IStorage::TYPE_ABSOLUTE, OptimizeMap);
+	if(argc <= 1 || argc > 3)
+	{
+		dbg_msg("map_optimize", "Usage: map_optimize <source map filepath> [<dest map filepath>]");
+		MapBatchUsage("map_optimize");
+		return -1;
+	}
+
+	char aFilename[IO_MAX_PATH_LENGTH];
+	if(argc == 3)
+	{
+		str_format(aFilename, sizeof(aFilename), "out/%s", argv[2]);
+
+		fs_makedir_rec_for(aFilename);
+	}
+	else
+	{
+		fs_makedir("out");
+		char aBuff[IO_MAX_PATH_LENGTH];
+		IStorage::StripPathAndExtension(argv[1], aBuff, sizeof(aBuff));
+		str_format(aFilename, sizeof(aFilename), "out/%s.map", aBuff);
+	}
 
-	return 0;
+	CJobPool JobPool;
+	JobPool.Init(std::max(1, (int)std::thread::hardware_concurrency() - 1));
+	return OptimizeMap(pStorage.get(), &JobPool, argv[1], aFilename) ? 0 : -1;
 }
@@ -6,17 +6,23 @@
 #include <base/system.h>
 
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
+#include "map_batch.h"
+
+#include <algorithm>
+#include <thread>
+
 static const char *TOOL_NAME = "map_resave";
 
-static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStorage *pStorage)
+static bool ResaveMap(IStorage *pStorage, CJobPool *pJobPool, const char *pSourceMap, const char *pDestinationMap)
 {
 	CDataFileReader Reader;
 	if(!Reader.Open(pStorage, pSourceMap, IStorage::TYPE_ABSOLUTE))
 	{
 		log_error(TOOL_NAME, "Failed to open source map '%s' for reading", pSourceMap);
-		return -1;
+		return false;
 	}
 
 	CDataFileWriter Writer;
@@ -24,7 +30,7 @@ static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStora
 	{
 		log_error(TOOL_NAME, "Failed to open destination map '%s' for writing", pDestinationMap);
 		Reader.Close();
-		return -1;
+		return false;
 	}
 
 	// add all items
@@ -53,9 +59,9 @@ static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStora
 	}
 
 	Reader.Close();
-	Writer.Finish();
+	Writer.Finish(pJobPool);
 	log_info(TOOL_NAME, "Resaved '%s' to '%s'", pSourceMap, pDestinationMap);
-	return 0;
+	return true;
 }
 
 int main(int argc, const char **argv)
@@ -63,9 +69,10 @@ int main(int argc, const char **argv)
 	CCmdlineFix CmdlineFix(&argc, &argv);
 	log_set_global_logger_default();
 
-	if(argc != 3)
+	if(argc != 3 && !IsMapBatchCommand(argc, argv))
 	{
 		log_error(TOOL_NAME, "Usage: %s <source map> <destination map>", TOOL_NAME);
+		MapBatchUsage(TOOL_NAME);
 		return -1;
 	}
 
@@ -76,5 +83,10 @@ int main(int argc, const char **argv)
 		return -1;
 	}
 
-	return ResaveMap(argv[1], argv[2], pStorage.get());
+	if(IsMapBatchCommand(argc, argv))
+		return RunMapBatch(TOOL_NAME, argc, argv, pStorage.get(), IStorage::TYPE_SAVE, ResaveMap);
+
+	CJobPool JobPool;
+	JobPool.Init(std::max(1, (int)std::thread::hardware_concurrency() - 1));
+	return ResaveMap(pStorage.get(), &JobPool, argv[1], argv[2]) ? 0 : -1;
 }
@@ -0,0 +1,550 @@
+#include <base/logger.h>
+#include <base/os.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/external/json-parser/json.h>
+#include <engine/map.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/server.h>
+#include <engine/shared/config.h>
+#include <engine/shared/json.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/storage.h>
+
+#include <game/prng.h>
+#include <game/server/entities/character.h>
+#include <game/server/gamecontext.h>
+#include <game/server/player.h>
+#include <game/server/teehistorian_reader.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "teehistorian_replay";
+
+#define UUID(id, name) static const CUuid UUID_##id = CalculateUuid(name);
+#include <engine/shared/teehistorian_ex_chunks.h>
+#undef UUID
+
+bool IsInterrupted()
+{
+	return false;
+}
+
+std::vector<std::string> FetchAndroidServerCommandQueue()
+{
+	return {};
+}
+
+class CReplay
+{
+	class CRecordedPlayer
+	{
+	public:
+		bool m_Alive = false;
+		int m_X = 0;
+		int m_Y = 0;
+	};
+
+	class CTickTimings
+	{
+	public:
+		int m_Tick;
+		int64_t m_OnTick;
+		int64_t m_OnSnap;
+		int64_t m_DoSnapshot;
+	};
+
+	CServer *m_pServer;
+	CGameContext *m_pGameServer;
+	IConsole *m_pConsole;
+
+	CRecordedPlayer m_aRecorded[MAX_CLIENTS];
+	bool m_aJoinSixup[MAX_CLIENTS] = {};
+	// DDNet versions of the players joining a slot, in join order
+	std::vector<int> m_avJoinVersions[MAX_CLIENTS];
+	size_t m_aNumJoins[MAX_CLIENTS] = {};
+	CPrng m_Prng;
+
+	int m_VerifiedTick = -1;
+	int m_NumDivergedTicks = 0;
+	std::vector<CTickTimings> m_vTimings;
+
+	void Verify();
+	void Tick();
+	void Join(int ClientId);
+	void Drop(int ClientId, const char *pReason);
+	void Input(int ClientId, const CNetObj_PlayerInput *pInput);
+	void Message(int ClientId, const unsigned char *pData, int DataSize);
+	void ConsoleCommand(const CTeeHistorianReader::CChunk &Chunk);
+	void Extra(const CTeeHistorianReader::CChunk &Chunk);
+
+public:
+	CReplay(CServer *pServer, CGameContext *pGameServer, IConsole *pConsole) :
+		m_pServer(pServer), m_pGameServer(pGameServer), m_pConsole(pConsole)
+	{
+	}
+
+	void CollectVersions(unsigned char *pData, int DataSize);
+	bool SeedPrng(const char *pDescription);
+	bool Run(CTeeHistorianReader *pReader);
+	int NumDivergedTicks() const { return m_NumDivergedTicks; }
+	void PrintTimings() const;
+	bool WriteTimings(IStorage *pStorage, const char *pFilename) const;
+};
+
+void CReplay::CollectVersions(unsigned char *pData, int DataSize)
+{
+	// the version is only recorded once the game knows it, but the server
+	// already needs it when the player joins
+	CTeeHistorianReader Reader;
+	if(!Reader.Init(pData, DataSize))
+		return;
+	CTeeHistorianReader::CChunk Chunk;
+	while(Reader.Next(&Chunk))
+	{
+		if(Chunk.m_Type == CTeeHistorianReader::CHUNK_JOIN)
+		{
+			m_avJoinVersions[Chunk.m_ClientId].push_back(VERSION_NONE);
+		}
+		else if(Chunk.m_Type == CTeeHistorianReader::CHUNK_EX && (Chunk.m_Uuid == UUID_TEEHISTORIAN_DDNETVER || Chunk.m_Uuid == UUID_TEEHISTORIAN_DDNETVER_OLD))
+		{
+			CUnpacker Unpacker;
+			Unpacker.Reset(Chunk.m_pData, Chunk.m_DataSize);
+			const int ClientId = Unpacker.GetInt();
+			if(Chunk.m_Uuid == UUID_TEEHISTORIAN_DDNETVER)
+				Unpacker.GetRaw(sizeof(CUuid));
+			const int Version = Unpacker.GetInt();
+			if(!Unpacker.Error() && ClientId >= 0 && ClientId < MAX_CLIENTS && !m_avJoinVersions[ClientId].empty())
+				m_avJoinVersions[ClientId].back() = Version;
+		}
+	}
+}
+
+bool CReplay::SeedPrng(const char *pDescription)
+{
+	const char *pSeed = str_startswith(pDescription, "pcg-xsh-rr:");
+	if(!pSeed || str_length(pSeed) != 2 * 16 + 1 || pSeed[16] != ':')
+		return false;
+
+	uint64_t aSeed[2];
+	for(int i = 0; i < 2; i++)
+	{
+		char aHex[16 + 1];
+		str_copy(aHex, pSeed + i * (16 + 1));
+		unsigned char aBytes[8];
+		if(str_hex_decode(aBytes, sizeof(aBytes), aHex) != 0)
+			return false;
+		aSeed[i] = 0;
+		for(unsigned char Byte : aBytes)
+			aSeed[i] = (aSeed[i] << 8) | Byte;
+	}
+	m_Prng.Seed(aSeed);
+	m_pGameServer->m_World.m_Core.m_pPrng = &m_Prng;
+	return true;
+}
+
+void CReplay::Verify()
+{
+	if(m_VerifiedTick == m_pServer->Tick())
+		return;
+	m_VerifiedTick = m_pServer->Tick();
+
+	int NumDiverged = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CRecordedPlayer &Recorded = m_aRecorded[i];
+		CPlayer *pPlayer = m_pGameServer->m_apPlayers[i];
+		CCharacter *pCharacter = pPlayer ? pPlayer->GetCharacter() : nullptr;
+		CNetObj_CharacterCore Core;
+		if(pCharacter)
+			pCharacter->GetCore().Write(&Core);
+
+		if(Recorded.m_Alive == (pCharacter != nullptr) && (!pCharacter || (Core.m_X == Recorded.m_X && Core.m_Y == Recorded.m_Y)))
+			continue;
+
+		if(m_NumDivergedTicks < 10)
+		{
+			if(!pCharacter)
+				log_error(TOOL_NAME, "tick=%d cid=%d expected alive at (%d, %d), got dead", m_pServer->Tick(), i, Recorded.m_X, Recorded.m_Y);
+			else if(!Recorded.m_Alive)
+				log_error(TOOL_NAME, "tick=%d cid=%d expected dead, got alive at (%d, %d)", m_pServer->Tick(), i, Core.m_X, Core.m_Y);
+			else
+				log_error(TOOL_NAME, "tick=%d cid=%d expected (%d, %d), got (%d, %d)", m_pServer->Tick(), i, Recorded.m_X, Recorded.m_Y, Core.m_X, Core.m_Y);
+		}
+		NumDiverged++;
+	}
+	if(NumDiverged)
+		m_NumDivergedTicks++;
+}
+
+void CReplay::Tick()
+{
+	CTickTimings Timings;
+	m_pServer->DoGameTick();
+	Timings.m_Tick = m_pServer->Tick();
+	Timings.m_OnTick = m_pServer->m_OnTickDuration;
+
+	const int64_t SnapshotStart = time_get();
+	m_pServer->DoSnapshot();
+	Timings.m_DoSnapshot = time_get() - SnapshotStart;
+	Timings.m_OnSnap = m_pServer->m_OnSnapDuration;
+	m_vTimings.push_back(Timings);
+}
+
+void CReplay::Join(int ClientId)
+{
+	CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+	if(Client.m_State != CServer::CClient::STATE_EMPTY)
+		Drop(ClientId, "replaced by join");
+
+	m_pServer->AddDebugClient(ClientId, m_aJoinSixup[ClientId]);
+	m_aJoinSixup[ClientId] = false;
+
+	const std::vector<int> &vVersions = m_avJoinVersions[ClientId];
+	const size_t Join = m_aNumJoins[ClientId]++;
+	if(Join < vVersions.size() && vVersions[Join] != VERSION_NONE)
+	{
+		Client.m_DDNetVersion = vVersions[Join];
+		Client.m_GotDDNetVersionPacket = true;
+		Client.m_DDNetVersionSettled = true;
+	}
+
+	// the ready message is not recorded, it always follows the join closely
+	Client.m_State = CServer::CClient::STATE_READY;
+	m_pGameServer->OnClientConnected(ClientId, nullptr);
+}
+
+void CReplay::Drop(int ClientId, const char *pReason)
+{
+	if(m_pServer->m_aClients[ClientId].m_State != CServer::CClient::STATE_EMPTY)
+		CServer::DelClientCallback(ClientId, pReason, m_pServer);
+}
+
+void CReplay::Input(int ClientId, const CNetObj_PlayerInput *pInput)
+{
+	CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+	if(Client.m_State != CServer::CClient::STATE_INGAME)
+		return;
+
+	// inputs are recorded when they are applied at the start of the next tick
+	CServer::CClient::CInput *pSlot = &Client.m_aInputs[Client.m_CurrentInput];
+	pSlot->m_GameTick = m_pServer->Tick() + 1;
+	mem_zero(pSlot->m_aData, sizeof(pSlot->m_aData));
+	mem_copy(pSlot->m_aData, pInput, minimum(sizeof(*pInput), sizeof(pSlot->m_aData)));
+	Client.m_LatestInput = *pSlot;
+	Client.m_CurrentInput = (Client.m_CurrentInput + 1) % std::size(Client.m_aInputs);
+}
+
+void CReplay::Message(int ClientId, const unsigned char *pData, int DataSize)
+{
+	if(m_pServer->m_aClients[ClientId].m_State < CServer::CClient::STATE_READY)
+		return;
+
+	CUnpacker Unpacker;
+	Unpacker.Reset(pData, DataSize);
+	CMsgPacker Packer(NETMSG_EX, true);
+	int Msg;
+	bool Sys;
+	CUuid Uuid;
+	if(UnpackMessageId(&Msg, &Sys, &Uuid, &Unpacker, &Packer) == UNPACKMESSAGE_ERROR || Sys)
+		return;
+	m_pGameServer->OnMessage(Msg, &Unpacker, ClientId);
+}
+
+void CReplay::ConsoleCommand(const CTeeHistorianReader::CChunk &Chunk)
+{
+	// Commands of the server itself and chat commands are caused by replayed
+	// state or messages already, only rcon commands are inputs of their own.
+	// They run with full access since the authentication is not replayed.
+	if(Chunk.m_ClientId < 0 || (Chunk.m_FlagMask & CFGFLAG_CHAT))
+		return;
+
+	char aLine[IConsole::CMDLINE_LENGTH];
+	str_copy(aLine, Chunk.m_pString);
+	for(int i = 0; i < Chunk.m_NumArgs; i++)
+	{
+		char aArg[IConsole::CMDLINE_LENGTH];
+		char *pDst = aArg;
+		str_escape(&pDst, Chunk.m_apArgs[i], aArg + sizeof(aArg));
+		str_append(aLine, " \"");
+		str_append(aLine, aArg);
+		str_append(aLine, "\"");
+	}
+	m_pConsole->ExecuteLineFlag(aLine, Chunk.m_FlagMask, IConsole::CLIENT_ID_UNSPECIFIED, false);
+}
+
+void CReplay::Extra(const CTeeHistorianReader::CChunk &Chunk)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(Chunk.m_pData, Chunk.m_DataSize);
+	if(Chunk.m_Uuid == UUID_TEEHISTORIAN_JOINVER7)
+	{
+		const int ClientId = Unpacker.GetInt();
+		if(!Unpacker.Error() && ClientId >= 0 && ClientId < MAX_CLIENTS)
+			m_aJoinSixup[ClientId] = true;
+	}
+	else if(Chunk.m_Uuid == UUID_TEEHISTORIAN_PLAYER_READY)
+	{
+		const int ClientId = Unpacker.GetInt();
+		if(Unpacker.Error() || ClientId < 0 || ClientId >= MAX_CLIENTS || m_pServer->m_aClients[ClientId].m_State != CServer::CClient::STATE_READY)
+			return;
+		m_pServer->m_aClients[ClientId].m_State = CServer::CClient::STATE_INGAME;
+		m_pGameServer->OnClientEnter(ClientId);
+	}
+}
+
+bool CReplay::Run(CTeeHistorianReader *pReader)
+{
+	CTeeHistorianReader::CChunk Chunk;
+	while(pReader->Next(&Chunk))
+	{
+		while(m_pServer->Tick() < Chunk.m_Tick)
+		{
+			Verify();
+			Tick();
+		}
+
+		if(Chunk.m_Type == CTeeHistorianReader::CHUNK_PLAYER)
+		{
+			m_aRecorded[Chunk.m_ClientId].m_Alive = true;
+			m_aRecorded[Chunk.m_ClientId].m_X = Chunk.m_X;
+			m_aRecorded[Chunk.m_ClientId].m_Y = Chunk.m_Y;
+			continue;
+		}
+		if(Chunk.m_Type == CTeeHistorianReader::CHUNK_PLAYER_OLD)
+		{
+			m_aRecorded[Chunk.m_ClientId].m_Alive = false;
+			continue;
+		}
+
+		// the player data of a tick is complete once anything else happens
+		Verify();
+		switch(Chunk.m_Type)
+		{
+		case CTeeHistorianReader::CHUNK_INPUT: Input(Chunk.m_ClientId, &Chunk.m_Input); break;
+		case CTeeHistorianReader::CHUNK_MESSAGE: Message(Chunk.m_ClientId, Chunk.m_pData, Chunk.m_DataSize); break;
+		case CTeeHistorianReader::CHUNK_JOIN: Join(Chunk.m_ClientId); break;
+		case CTeeHistorianReader::CHUNK_DROP: Drop(Chunk.m_ClientId, Chunk.m_pString); break;
+		case CTeeHistorianReader::CHUNK_CONSOLE_COMMAND: ConsoleCommand(Chunk); break;
+		case CTeeHistorianReader::CHUNK_EX: Extra(Chunk); break;
+		}
+	}
+	Verify();
+	return !pReader->Error();
+}
+
+static void PrintDurations(const char *pName, std::vector<int64_t> vDurations)
+{
+	if(vDurations.empty())
+		return;
+	std::sort(vDurations.begin(), vDurations.end());
+	int64_t Sum = 0;
+	for(int64_t Duration : vDurations)
+		Sum += Duration;
+	const auto &&Micros = [](int64_t Duration) { return Duration * 1000000.0 / time_freq(); };
+	log_info(TOOL_NAME, "%-10s mean=%8.1fus median=%8.1fus p99=%8.1fus max=%8.1fus",
+		pName,
+		Micros(Sum) / vDurations.size(),
+		Micros(vDurations[vDurations.size() / 2]),
+		Micros(vDurations[vDurations.size() * 99 / 100]),
+		Micros(vDurations.back()));
+}
+
+void CReplay::PrintTimings() const
+{
+	std::vector<int64_t> vOnTick, vOnSnap, vDoSnapshot;
+	for(const CTickTimings &Timings : m_vTimings)
+	{
+		vOnTick.push_back(Timings.m_OnTick);
+		vOnSnap.push_back(Timings.m_OnSnap);
+		vDoSnapshot.push_back(Timings.m_DoSnapshot);
+	}
+	log_info(TOOL_NAME, "replayed %d ticks", (int)m_vTimings.size());
+	PrintDurations("OnTick", vOnTick);
+	PrintDurations("OnSnap", vOnSnap);
+	PrintDurations("DoSnapshot", vDoSnapshot);
+}
+
+bool CReplay::WriteTimings(IStorage *pStorage, const char *pFilename) const
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_ABSOLUTE);
+	if(!File)
+	{
+		log_error(TOOL_NAME, "failed to open '%s' for writing", pFilename);
+		return false;
+	}
+	const char *pHeader = "tick,on_tick_us,on_snap_us,do_snapshot_us\n";
+	io_write(File, pHeader, str_length(pHeader));
+	for(const CTickTimings &Timings : m_vTimings)
+	{
+		char aLine[128];
+		str_format(aLine, sizeof(aLine), "%d,%.1f,%.1f,%.1f\n",
+			Timings.m_Tick,
+			Timings.m_OnTick * 1000000.0 / time_freq(),
+			Timings.m_OnSnap * 1000000.0 / time_freq(),
+			Timings.m_DoSnapshot * 1000000.0 / time_freq());
+		io_write(File, aLine, str_length(aLine));
+	}
+	io_close(File);
+	return true;
+}
+
+static void ApplyConfig(const CTeeHistorianReader &Reader, IConsole *pConsole)
+{
+	const json_value &Config = *json_object_get(Reader.Header(), "config");
+	if(Config.type != json_object)
+		return;
+	for(unsigned i = 0; i < Config.u.object.length; i++)
+	{
+		const json_value &Value = *Config.u.object.values[i].value;
+		if(Value.type != json_string)
+			continue;
+		char aValue[IConsole::CMDLINE_LENGTH];
+		char *pDst = aValue;
+		str_escape(&pDst, Value.u.string.ptr, aValue + sizeof(aValue));
+		char aLine[IConsole::CMDLINE_LENGTH];
+		str_format(aLine, sizeof(aLine), "%s \"%s\"", Config.u.object.values[i].name, aValue);
+		pConsole->ExecuteLine(aLine, IConsole::CLIENT_ID_UNSPECIFIED);
+	}
+}
+
+static void ApplyTuning(const CTeeHistorianReader &Reader, CTuningParams *pTuning)
+{
+	// tuning values are recorded as integers in hundredths
+	const json_value &Tuning = *json_object_get(Reader.Header(), "tuning");
+#define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) \
+	{ \
+		const json_value &Param = *json_object_get(&Tuning, #ScriptName); \
+		if(Param.type == json_string) \
+			pTuning->m_##Name.Set(str_toint(Param.u.string.ptr)); \
+	}
+#include <game/tuning.h>
+#undef MACRO_TUNING_PARAM
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	const char *pTimingsFile = nullptr;
+	int FirstArg = 1;
+	if(argc > 2 && str_comp(argv[1], "--timings") == 0)
+	{
+		pTimingsFile = argv[2];
+		FirstArg = 3;
+	}
+	if(argc <= FirstArg)
+	{
+		log_error(TOOL_NAME, "Usage: %s [--timings <csv file>] <teehistorian file> [<console commands>...]", TOOL_NAME);
+		return -1;
+	}
+	const char *pFilename = argv[FirstArg];
+
+	CServer *pServer = CreateServer();
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	pKernel->RegisterInterface(pServer);
+
+	std::shared_ptr<CFutureLogger> pFutureLogger = std::make_shared<CFutureLogger>();
+	pFutureLogger->Set(std::shared_ptr<ILogger>(log_logger_noop()));
+	IEngine *pEngine = CreateEngine(GAME_NAME, pFutureLogger);
+	pKernel->RegisterInterface(pEngine);
+
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::SERVER, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating server storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_ECON).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	IEngineAntibot *pEngineAntibot = CreateEngineAntibot();
+	pKernel->RegisterInterface(pEngineAntibot);
+	pKernel->RegisterInterface(static_cast<IAntibot *>(pEngineAntibot), false);
+	CGameContext *pGameServer = (CGameContext *)CreateGameServer();
+	pKernel->RegisterInterface(static_cast<IGameServer *>(pGameServer));
+
+	pEngine->Init();
+	pConsole->Init();
+	pConfigManager->Init();
+	pServer->RegisterCommands();
+
+	void *pData;
+	unsigned DataSize;
+	if(!pStorage->ReadFile(pFilename, IStorage::TYPE_ALL_OR_ABSOLUTE, &pData, &DataSize))
+	{
+		log_error(TOOL_NAME, "Failed to read '%s'", pFilename);
+		return -1;
+	}
+	CTeeHistorianReader Reader;
+	if(!Reader.Init(pData, DataSize))
+	{
+		free(pData);
+		return -1;
+	}
+
+	CReplay Replay(pServer, pGameServer, pConsole);
+	Replay.CollectVersions((unsigned char *)pData, DataSize);
+
+	ApplyConfig(Reader, pConsole);
+	if(argc > FirstArg + 1)
+		pConsole->ParseArguments(argc - FirstArg - 1, &argv[FirstArg + 1]);
+	// never record the replay itself
+	g_Config.m_SvTeeHistorian = 0;
+
+	if(!pServer->LoadMap(Reader.HeaderString("map_name")))
+	{
+		log_error(TOOL_NAME, "Failed to load map '%s'", Reader.HeaderString("map_name"));
+		free(pData);
+		return -1;
+	}
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(pServer->m_aCurrentMapSha256[CServer::MAP_TYPE_SIX], aSha256, sizeof(aSha256));
+	if(str_comp(aSha256, Reader.HeaderString("map_sha256")) != 0)
+		log_warn(TOOL_NAME, "map sha256 %s differs from the recorded %s", aSha256, Reader.HeaderString("map_sha256"));
+
+	pServer->m_RunServer = CServer::RUNNING;
+	pServer->m_AuthManager.Init();
+	for(auto &Client : pServer->m_aClients)
+	{
+		Client.m_HasPersistentData = false;
+		Client.m_pPersistentData = malloc(pGameServer->PersistentClientDataSize());
+	}
+	pServer->m_pPersistentData = malloc(pGameServer->PersistentDataSize());
+	pServer->Antibot()->Init();
+	pGameServer->OnInit(nullptr);
+	ApplyTuning(Reader, pGameServer->GlobalTuning());
+	if(!Replay.SeedPrng(Reader.HeaderString("prng_description")))
+		log_warn(TOOL_NAME, "unknown prng '%s', random events will not be reproduced", Reader.HeaderString("prng_description"));
+
+	const bool Success = Replay.Run(&Reader);
+	Replay.PrintTimings();
+	if(pTimingsFile)
+		Replay.WriteTimings(pStorage, pTimingsFile);
+
+	pGameServer->OnShutdown(nullptr);
+	pServer->DbPool()->OnShutdown();
+	free(pData);
+
+	if(!Success)
+	{
+		log_error(TOOL_NAME, "Replay stopped at a malformed chunk");
+		return -1;
+	}
+	if(Replay.NumDivergedTicks())
+	{
+		log_error(TOOL_NAME, "Player states diverged in %d ticks", Replay.NumDivergedTicks());
+		return 1;
+	}
+	log_info(TOOL_NAME, "All recorded player states were reproduced");
+	return 0;
+}